@@ -34,6 +34,7 @@
 #include "pgp-key.h"
 #include <string>
 #include <list>
+#include <vector>
 #include <map>
 #include <unordered_map>
 #include <memory>
@@ -56,6 +57,11 @@ typedef enum pgp_sig_import_status_t {
 } pgp_sig_import_status_t;
 
 typedef std::unordered_map<pgp_fingerprint_t, std::list<pgp_key_t>::iterator> pgp_key_fp_map_t;
+/* Secondary indexes: the same keyid, grip or userid may be shared by a number of keys, so
+ * fingerprints are stored in the order of addition to the keystore. */
+typedef std::unordered_map<pgp_key_id_t, std::vector<pgp_fingerprint_t>>   pgp_key_id_map_t;
+typedef std::unordered_map<pgp_key_grip_t, std::vector<pgp_fingerprint_t>> pgp_key_grip_map_t;
+typedef std::unordered_map<std::string, std::vector<pgp_fingerprint_t>>    pgp_key_uid_map_t;
 
 namespace rnp {
 class KeyStore {
@@ -64,6 +70,20 @@ class KeyStore {
     pgp_sig_import_status_t import_subkey_signature(pgp_key_t &            key,
                                                     const pgp_signature_t &sig);
     bool                    refresh_subkey_grips(pgp_key_t &key);
+    void                    reset_validity(pgp_key_t &key);
+    void                    index_key(const pgp_key_t &key);
+    void                    unindex_key(const pgp_key_t &key);
+    static void             unindex_fp(pgp_key_uid_map_t &       index,
+                                       const std::string &       value,
+                                       const pgp_fingerprint_t &fp);
+    pgp_key_t *             search_index(const std::vector<pgp_fingerprint_t> &fps,
+                                         const KeySearch &                     search,
+                                         pgp_key_t *                           after);
+    bool                    write_g10(bool incremental);
+
+    bool keys_removed_{}; /* keys were removed since the last load/save */
+    /* G10 key files which were indexed but not loaded yet, see index_g10() */
+    std::unordered_map<pgp_key_grip_t, std::string> lazy_g10_;
 
   public:
     std::string            path;
@@ -71,9 +91,16 @@ class KeyStore {
     rnp::SecurityContext & secctx;
     bool                   disable_validation =
       false; /* do not automatically validate keys, added to this key store */
+    size_t threads = 0; /* number of threads used to build and validate keys in load_pgp() */
+    bool   lazy_validation =
+      false; /* keys are not validated on addition, but on the first use via revalidate() */
 
     std::list<pgp_key_t>                     keys;
     pgp_key_fp_map_t                         keybyfp;
+    pgp_key_id_map_t                         keybyid;
+    pgp_key_grip_map_t                       keybygrip;
+    pgp_key_uid_map_t                        keybyuid;
+    pgp_key_uid_map_t                        keybyemail; /* see uid_emails() */
     std::vector<std::unique_ptr<kbx_blob_t>> blobs;
 
     ~KeyStore();
@@ -99,7 +126,9 @@ class KeyStore {
     bool load(pgp_source_t &src, const KeyProvider *key_provider = nullptr);
 
     /**
-     * @brief Load all keys from the source, assuming openpgp format.
+     * @brief Load all keys from the source, assuming openpgp format. If more than one thread
+     *        is set then keys are built and their self-signatures are verified on the worker
+     *        threads, while keys are still added in the original order.
      *
      * @param src source to load the keys from.
      * @param skiperrors ignore key parsing errors, allowing to skip malformed/unsupported
@@ -125,31 +154,96 @@ class KeyStore {
      */
     bool load_g10(pgp_source_t &src, const KeyProvider *key_provider = nullptr);
 
+    /**
+     * @brief Index keys of the g10 directory without loading them. Key files are named by
+     *        the key grip, so each key is loaded by load_lazy() once it is requested.
+     *
+     * @param dir directory with key files.
+     * @return true on success or false if directory cannot be read.
+     */
+    bool index_g10(const std::string &dir);
+
+    /**
+     * @brief Load the indexed g10 key, if it was not loaded yet.
+     *
+     * @param grip key grip.
+     * @param key_provider provider of the public key part, see load_g10().
+     * @return pointer to the loaded key or nullptr if there is no such key file or it
+     *         failed to load.
+     */
+    pgp_key_t *load_lazy(const pgp_key_grip_t &grip, const KeyProvider *key_provider);
+
+    /**
+     * @brief Get the number of indexed but not yet loaded keys.
+     */
+    size_t lazy_count() const;
+
+    /**
+     * @brief Check whether key with the grip is indexed but not loaded yet.
+     */
+    bool lazy_indexed(const pgp_key_grip_t &grip) const;
+
     /**
      * @brief Write keystore to the path.
+     *
+     * @param incremental write only files of the keys, changed since the last load or save.
+     *                    Used only for G10, GPG/KBX keystore is always written as a whole:
+     *                    changes are appended to the file by the caller, see write(dst, changed),
+     *                    which is also responsible for the compaction via the full write.
      */
-    bool write();
+    bool write(bool incremental = false);
 
     /**
      * @brief Write keystore to the dest.
+     *
+     * @param changed write only primary keys, which (or which subkeys) were changed since the
+     *                last load or save, so output may be appended to the existing keystore.
      */
-    bool write(pgp_dest_t &dst);
+    bool write(pgp_dest_t &dst, bool changed = false);
 
     /**
      * @brief Write keystore to the dest in pgp format.
      */
-    bool write_pgp(pgp_dest_t &dst);
+    bool write_pgp(pgp_dest_t &dst, bool changed = false);
 
     /**
-     * @brief Write keystore to the dest in kbx format.
+     * @brief Write keystore to the dest in kbx format. Header and X.509 blobs are not written
+     *        if only changed keys are requested.
      *
      */
-    bool write_kbx(pgp_dest_t &dst);
+    bool write_kbx(pgp_dest_t &dst, bool changed = false);
+
+    /**
+     * @brief Check whether changes since the last load or save may be appended to the stored
+     *        keystore, i.e. no keys were removed and no key packets were removed or replaced.
+     */
+    bool appendable() const;
+
+    /**
+     * @brief Check whether primary key or any of its subkeys was changed since the last load
+     *        or save.
+     */
+    bool changed(const pgp_key_t &primary) const;
+
+    /**
+     * @brief Mark all keys as not changed, i.e. after keystore was loaded or saved.
+     */
+    void mark_clean();
 
     void clear();
 
     size_t key_count() const;
 
+    /**
+     * @brief Approximate amount of memory used by the keys and the indexes, in bytes.
+     */
+    size_t memory_usage() const;
+
+    /**
+     * @brief Drop cached data of all keys, which is recreated on demand.
+     */
+    void release_caches() const noexcept;
+
     pgp_key_t *      get_key(const pgp_fingerprint_t &fpr);
     const pgp_key_t *get_key(const pgp_fingerprint_t &fpr) const;
 
@@ -251,6 +345,43 @@ class KeyStore {
      */
     pgp_key_t *primary_key(const pgp_key_t &subkey);
 
+    /**
+     * @brief Get the lowercased <email> parts of the userid, used as keys of the email index.
+     *        Each part starts with '<' and ends with the first '>' after it, so any
+     *        '<'-starting and '>'-ending substring of the userid without angle brackets
+     *        inside is one of them.
+     *
+     * @param uid userid string.
+     * @return vector of the <email> parts, may be empty.
+     */
+    static std::vector<std::string> uid_emails(const std::string &uid);
+
+    /**
+     * @brief Update userid and email indexes for the key, which userids were added outside
+     *        of the keystore (i.e. via pgp_key_t::add_uid()).
+     *
+     * @param key key from this keystore.
+     */
+    void index_uids(const pgp_key_t &key);
+
+    /**
+     * @brief Remove userid with all of its signatures from the key, updating the userid and
+     *        email indexes.
+     *
+     * @param key key from this keystore.
+     * @param idx index of the userid.
+     * @return true if userid was removed or false if index is out of range.
+     */
+    bool remove_uid(pgp_key_t &key, size_t idx);
+
+    /**
+     * @brief Search for the key. Keyid, grip and userid searches are resolved via the
+     *        secondary indexes, fingerprint search via the main one.
+     *
+     * @param search search parameters.
+     * @param after if not nullptr then search will continue after this key.
+     * @return pointer to the found key or nullptr.
+     */
     pgp_key_t *search(const KeySearch &search, pgp_key_t *after = nullptr);
 };
 } // namespace rnp
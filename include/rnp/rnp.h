@@ -52,6 +52,9 @@ typedef uint32_t rnp_result_t;
 #define RNP_KEY_REMOVE_SECRET (1U << 1)
 #define RNP_KEY_REMOVE_SUBKEYS (1U << 2)
 
+#define RNP_KEY_SEARCH_SECRET (1U << 0)
+#define RNP_KEY_SEARCH_SUBKEYS (1U << 1)
+
 #define RNP_KEY_UNLOAD_PUBLIC (1U << 0)
 #define RNP_KEY_UNLOAD_SECRET (1U << 1)
 
@@ -82,6 +85,9 @@ typedef uint32_t rnp_result_t;
 #define RNP_LOAD_SAVE_PERMISSIVE (1U << 8)
 #define RNP_LOAD_SAVE_SINGLE (1U << 9)
 #define RNP_LOAD_SAVE_BASE64 (1U << 10)
+#define RNP_LOAD_SAVE_INCREMENTAL (1U << 11)
+#define RNP_LOAD_SAVE_LAZY (1U << 12)
+#define RNP_LOAD_SAVE_MARK_CLEAN (1U << 13)
 
 /**
  * Flags for the rnp_key_remove_signatures
@@ -99,6 +105,7 @@ typedef uint32_t rnp_result_t;
  */
 #define RNP_OUTPUT_FILE_OVERWRITE (1U << 0)
 #define RNP_OUTPUT_FILE_RANDOM (1U << 1)
+#define RNP_OUTPUT_FILE_APPEND (1U << 2)
 
 /**
  * Flags for default key selection.
@@ -257,6 +264,7 @@ typedef struct rnp_op_verify_st *          rnp_op_verify_t;
 typedef struct rnp_op_verify_signature_st *rnp_op_verify_signature_t;
 typedef struct rnp_op_encrypt_st *         rnp_op_encrypt_t;
 typedef struct rnp_identifier_iterator_st *rnp_identifier_iterator_t;
+typedef struct rnp_key_search_st *         rnp_key_search_t;
 typedef struct rnp_uid_handle_st *         rnp_uid_handle_t;
 typedef struct rnp_signature_handle_st *   rnp_signature_handle_t;
 typedef struct rnp_sig_subpacket_st *      rnp_sig_subpacket_t;
@@ -383,7 +391,30 @@ typedef void (*rnp_key_signatures_cb)(rnp_ffi_t              ffi,
                                       rnp_signature_handle_t sig,
                                       uint32_t *             action);
 
+/**
+ * @brief callback used to report back the status of each imported key from the function
+ *        rnp_import_keys_stream().
+ * @param ffi
+ * @param app_ctx custom context, provided by application.
+ * @param fingerprint hexadecimal fingerprint of the primary key or subkey.
+ * @param public_status status of the public key, one of "new", "updated", "unchanged", "none".
+ * @param secret_status status of the secret key, same possible values as for public.
+ */
+typedef void (*rnp_import_key_cb)(rnp_ffi_t   ffi,
+                                  void *      app_ctx,
+                                  const char *fingerprint,
+                                  const char *public_status,
+                                  const char *secret_status);
+
 /** create the top-level object used for interacting with the library
+ *
+ *  The same ffi object may be used from different threads: key lookup (rnp_locate_key()),
+ *  keys export and saving, verification and decryption may run concurrently, while keys
+ *  loading, import, generation, modification, removal, locking, unlocking and signing are
+ *  serialized against them. Secret keys are decrypted to the temporary copies during the
+ *  decryption, so keyring is not modified.
+ *  Key and signature handles, as well as operation objects, must not be shared between
+ *  threads, and key handle must not be used once the key is removed by another thread.
  *
  *  @param ffi pointer that will be set to the created ffi object
  *  @param pub_format the format of the public keyring, RNP_KEYSTORE_GPG or other
@@ -425,6 +456,63 @@ RNP_API rnp_result_t rnp_ffi_set_pass_provider(rnp_ffi_t       ffi,
                                                rnp_password_cb getpasscb,
                                                void *          getpasscb_ctx);
 
+/**
+ * @brief Set the number of threads used to load keys via rnp_load_keys(). If more than one
+ *        thread is set then keys of the OpenPGP (GPG) keyring are built and their
+ *        self-signatures are verified on the worker threads, while keys are still added to
+ *        the keyring in the original order. Keyring is parsed on the caller's thread.
+ *
+ * @param ffi initialized ffi object, cannot be NULL.
+ * @param threads number of threads. 0 or 1 (default) means that all of the processing is done
+ *                in the caller's thread. Large values are limited to the number of CPU cores
+ *                or 64, whichever is greater, while values above PTRDIFF_MAX (i.e. negative
+ *                ones, casted to size_t) are rejected.
+ * @return RNP_SUCCESS on success, or any other value on error.
+ */
+RNP_API rnp_result_t rnp_ffi_set_load_threads(rnp_ffi_t ffi, size_t threads);
+
+/**
+ * @brief Enable or disable lazy key validation. If enabled then keys, loaded via
+ *        rnp_load_keys() or imported via rnp_import_keys(), are not validated immediately:
+ *        primary key with all of its subkeys is validated on the first use, i.e. once it is
+ *        located, searched, or requested for signing, encryption or verification. This
+ *        significantly speeds up loading of the large keyrings, if only a few keys are used.
+ *        Keys, added before enabling, are not affected.
+ *
+ * @param ffi initialized ffi object, cannot be NULL.
+ * @param lazy true to defer key validation up to the first use, false (default) to validate
+ *             keys once they are loaded.
+ * @return RNP_SUCCESS on success, or any other value on error.
+ */
+RNP_API rnp_result_t rnp_ffi_set_lazy_validation(rnp_ffi_t ffi, bool lazy);
+
+/**
+ * @brief Enable in-memory cache of the symmetric keys, derived from passwords via the
+ *        iterated and salted S2K, so secret key unlocking and password-based decryption with
+ *        the same password and S2K parameters would not repeat slow key derivation.
+ *        Derived keys are kept in the secure memory and are identified by the HMAC of the
+ *        password and S2K parameters (including salt), keyed with the random per-ffi secret,
+ *        never by the password itself. Only keys which successfully decrypted data are
+ *        cached. Cache is disabled by default.
+ *
+ * @param ffi initialized ffi object, cannot be NULL.
+ * @param max_entries maximum number of cached keys, least recently used ones are evicted
+ *                    first. 0 disables the cache and removes all of the cached keys.
+ * @param ttl number of seconds after which cached key expires. 0 means that keys do not
+ *            expire and are kept until evicted or flushed.
+ * @return RNP_SUCCESS on success, or any other value on error.
+ */
+RNP_API rnp_result_t rnp_ffi_set_s2k_cache(rnp_ffi_t ffi, size_t max_entries, uint32_t ttl);
+
+/**
+ * @brief Remove all of the keys from the cache, enabled via rnp_ffi_set_s2k_cache(). Cache
+ *        stays enabled with the same limits.
+ *
+ * @param ffi initialized ffi object, cannot be NULL.
+ * @return RNP_SUCCESS on success, or any other value on error.
+ */
+RNP_API rnp_result_t rnp_ffi_flush_s2k_cache(rnp_ffi_t ffi);
+
 /* Operations on key rings */
 
 /** retrieve the default homedir (example: /home/user/.rnp)
@@ -656,6 +744,12 @@ RNP_API rnp_result_t rnp_set_timestamp(rnp_ffi_t ffi, uint64_t time);
  * @param format the key format of the data (GPG, KBX, G10). Must not be NULL.
  * @param input source to read from.
  * @param flags the flags. See RNP_LOAD_SAVE_*.
+ *              RNP_LOAD_SAVE_LAZY: only for G10 secret keys. Key files of the directory are
+ *              indexed by grip (which is the file name) without reading them, and each
+ *              secret key is loaded the first time it is requested, i.e. by key lookup or
+ *              during decryption/signing. Keys, which were not loaded yet, are not counted by
+ *              rnp_get_secret_key_count() and are not listed by the identifier iterator.
+ *              Public keys must be loaded before the secret ones are requested.
  * @return RNP_SUCCESS on success, or any other value on error
  */
 RNP_API rnp_result_t rnp_load_keys(rnp_ffi_t   ffi,
@@ -718,6 +812,27 @@ RNP_API rnp_result_t rnp_import_keys(rnp_ffi_t   ffi,
                                      uint32_t    flags,
                                      char **     results);
 
+/** import keys to the keyring one by one, reporting status of each key via the callback.
+ *  Unlike rnp_import_keys() whole input is not loaded to memory before the import, so this
+ *  should be used to import large amounts of keys, like keyserver dumps. Each key is merged
+ *  into the keyring as soon as it is read, so in case of error keys, read before it, stay
+ *  imported.
+ *  Note: this will work only with keys in OpenPGP format, use rnp_load_keys for other formats.
+ * @param ffi
+ * @param input source to read from. Cannot be NULL.
+ * @param flags see RNP_LOAD_SAVE_* constants. Meaning is the same as for rnp_import_keys(),
+ *              except that RNP_LOAD_SAVE_SINGLE is not allowed.
+ * @param cb callback which will be called for each imported primary key or subkey. May be
+ *           NULL.
+ * @param app_ctx custom context which will be passed to the callback.
+ * @return RNP_SUCCESS on success, or any other value on error.
+ */
+RNP_API rnp_result_t rnp_import_keys_stream(rnp_ffi_t         ffi,
+                                            rnp_input_t       input,
+                                            uint32_t          flags,
+                                            rnp_import_key_cb cb,
+                                            void *            app_ctx);
+
 /** import standalone signatures to the keyring and receive JSON list of the updated
  * signatures.
  *
@@ -765,11 +880,29 @@ RNP_API rnp_result_t rnp_import_signatures(rnp_ffi_t   ffi,
 /** save keys
  *
  * Note that for G10, the output must be a directory (which must already exist).
+ * Once keys are saved to the directory, appended to the file with RNP_LOAD_SAVE_INCREMENTAL,
+ * or saved with RNP_LOAD_SAVE_MARK_CLEAN flag, they are considered as not changed for the
+ * subsequent incremental save. Other saves (i.e. export to the file) do not change this.
  *
  * @param ffi
  * @param format the key format of the data (GPG, KBX, G10). Must not be NULL.
  * @param output the output destination to write to.
  * @param flags the flags. See RNP_LOAD_SAVE_*.
+ *              If RNP_LOAD_SAVE_INCREMENTAL is specified then only keys, changed since
+ *              those were loaded or saved, will be written. For G10 only files of the
+ *              changed keys are written to the directory. For GPG and KBX changed keys (with
+ *              all of their subkeys) are written as new key blocks, which should be appended
+ *              to the keyring file they were loaded from (see RNP_OUTPUT_FILE_APPEND), and
+ *              will be merged with the existing ones on load. If keys were removed, or some
+ *              of their packets were removed or replaced (i.e. key was protected with a new
+ *              password), RNP_ERROR_BAD_STATE is returned and keyring must be saved without
+ *              this flag. Since appended key blocks duplicate the previous ones, keyring
+ *              should be occasionally saved without this flag to compact it. File output
+ *              must be opened with RNP_OUTPUT_FILE_APPEND, otherwise
+ *              RNP_ERROR_BAD_PARAMETERS is returned.
+ *              If RNP_LOAD_SAVE_MARK_CLEAN is specified then output is considered to be the
+ *              keyring storage, so saved keys are considered as not changed afterwards.
+ *              Should be used for the full save of the keyring file.
  * @return RNP_SUCCESS on success, or any other value on error
  */
 RNP_API rnp_result_t rnp_save_keys(rnp_ffi_t    ffi,
@@ -780,6 +913,29 @@ RNP_API rnp_result_t rnp_save_keys(rnp_ffi_t    ffi,
 RNP_API rnp_result_t rnp_get_public_key_count(rnp_ffi_t ffi, size_t *count);
 RNP_API rnp_result_t rnp_get_secret_key_count(rnp_ffi_t ffi, size_t *count);
 
+/** Get the approximate amount of memory used by the loaded keys, including their userids,
+ *  signatures and lookup indexes. Cached data, which may be released via rnp_release_memory(),
+ *  is not counted.
+ *
+ * @param ffi
+ * @param flags choose which keyrings should be counted: RNP_LOAD_SAVE_PUBLIC_KEYS and/or
+ *              RNP_LOAD_SAVE_SECRET_KEYS.
+ * @param usage on success amount of memory in bytes will be stored here.
+ * @return RNP_SUCCESS on success, or any other value on error.
+ */
+RNP_API rnp_result_t rnp_get_memory_usage(rnp_ffi_t ffi, uint32_t flags, size_t *usage);
+
+/** Release memory, used by the cached data of the loaded keys (backend key objects, created
+ *  from the key material on the first use). Cached data is recreated on demand, so this only
+ *  affects performance of the subsequent operations. Key handles remain valid.
+ *
+ * @param ffi
+ * @param flags choose which keyrings should be processed: RNP_LOAD_SAVE_PUBLIC_KEYS and/or
+ *              RNP_LOAD_SAVE_SECRET_KEYS.
+ * @return RNP_SUCCESS on success, or any other value on error.
+ */
+RNP_API rnp_result_t rnp_release_memory(rnp_ffi_t ffi, uint32_t flags);
+
 /** Search for the key
  *  Note: only valid userids are checked while searching by userid.
  *
@@ -2976,7 +3132,8 @@ RNP_API rnp_result_t rnp_op_sign_signature_set_expiration_time(rnp_op_sign_signa
 
 /** @brief Set data compression parameters. Makes sense only for embedded signatures.
  *  @param op opaque signing context. Must be initialized with rnp_op_sign_create function
- *  @param compression compression algorithm (zlib, zip, bzip2)
+ *  @param compression compression algorithm (zlib, zip, bzip2), or "auto". See the
+ *         rnp_op_encrypt_set_compression() for the details.
  *  @param level compression level, 0-9. 0 disables compression.
  *  @return RNP_SUCCESS or error code if failed
  */
@@ -3039,6 +3196,19 @@ RNP_API rnp_result_t rnp_op_sign_set_file_name(rnp_op_sign_t op, const char *fil
  */
 RNP_API rnp_result_t rnp_op_sign_set_file_mtime(rnp_op_sign_t op, uint32_t mtime);
 
+/**
+ * @brief Set the number of threads used to hash the data. If more than one thread is
+ *        requested and signatures use different hash algorithms then each of the hashes is
+ *        calculated on its own thread.
+ *
+ * @param op opaque signing context. Must be initialized with rnp_op_sign_create function
+ * @param threads number of threads. 0 or 1 (default) means that all of the processing is done
+ *                in the caller's thread. Large values are limited to the number of CPU cores
+ *                or 64, whichever is greater.
+ * @return RNP_SUCCESS or error code if failed
+ */
+RNP_API rnp_result_t rnp_op_sign_set_threads(rnp_op_sign_t op, size_t threads);
+
 /** @brief Execute previously initialized signing operation.
  *  @param op opaque signing context. Must be successfully initialized with one of the
  *         rnp_op_sign_*_create functions. At least one signing key should be added.
@@ -3107,6 +3277,22 @@ RNP_API rnp_result_t rnp_op_verify_detached_create(rnp_op_verify_t *op,
  */
 RNP_API rnp_result_t rnp_op_verify_set_flags(rnp_op_verify_t op, uint32_t flags);
 
+/**
+ * @brief Set the number of threads used to decrypt AEAD-protected data (AEAD-encrypted
+ *        packet or SEIPDv2). If more than one thread is requested then AEAD chunks are read
+ *        ahead, decrypted and authenticated in parallel, while output is still produced in
+ *        order and only for the already authenticated chunks.
+ *        If signatures use different hash algorithms then each of the hashes is calculated
+ *        on its own thread as well. Other data is always processed in the caller's thread.
+ *
+ * @param op pointer to opaque verification context.
+ * @param threads number of threads. 0 or 1 (default) means that all of the processing is done
+ *                in the caller's thread. Large values are limited to the number of CPU cores
+ *                or 64, whichever is greater.
+ * @return RNP_SUCCESS or error code if failed
+ */
+RNP_API rnp_result_t rnp_op_verify_set_threads(rnp_op_verify_t op, size_t threads);
+
 /** @brief Execute previously initialized verification operation.
  *  @param op opaque verification context. Must be successfully initialized.
  *  @return RNP_SUCCESS if data was processed successfully and output may be used. By default
@@ -3413,6 +3599,19 @@ RNP_API void rnp_buffer_clear(void *ptr, size_t size);
  */
 RNP_API rnp_result_t rnp_input_from_path(rnp_input_t *input, const char *path);
 
+/**
+ * @brief Initialize input struct to read from a path, memory-mapping the file contents.
+ *        This avoids copying of the data for the large files. If file is not a regular one
+ *        or could not be mapped then behaves the same way as rnp_input_from_path().
+ *        Note: contents of the file should not be changed while input is in use.
+ *
+ * @param input pointer to the input opaque structure
+ * @param path path of the file to read from
+ * @return RNP_SUCCESS if operation succeeded and input struct is ready to read, or error code
+ *         otherwise
+ */
+RNP_API rnp_result_t rnp_input_from_path_mmap(rnp_input_t *input, const char *path);
+
 /**
  * @brief Initialize input struct to read from the stdin
  *
@@ -3477,6 +3676,9 @@ RNP_API rnp_result_t rnp_output_to_path(rnp_output_t *output, const char *path);
  *        allows additional options to be specified.
  *        When RNP_OUTPUT_FILE_RANDOM flag is included then you may want to call
  *        rnp_output_finish() to make sure that final rename succeeded.
+ *        When RNP_OUTPUT_FILE_APPEND flag is included then data is appended to the end of
+ *        existing file, which is not removed if output is discarded. This flag cannot be
+ *        combined with the other ones.
  * @param output pointer to the opaque output structure. After use you must free it using the
  *               rnp_output_destroy() function.
  * @param path path to the file.
@@ -3743,6 +3945,25 @@ RNP_API rnp_result_t rnp_op_encrypt_set_aead(rnp_op_encrypt_t op, const char *al
  */
 RNP_API rnp_result_t rnp_op_encrypt_set_aead_bits(rnp_op_encrypt_t op, int bits);
 
+/**
+ * @brief Set the number of threads used to encrypt data in AEAD mode. If more than one thread
+ *        is requested then AEAD chunks are encrypted in parallel and written out in order.
+ *        Output is the same as for the single-threaded encryption. If data is signed as well
+ *        and signatures use different hash algorithms then each of the hashes is calculated
+ *        on its own thread.
+ *        ZIP and ZLIB compression is done in parallel as well: input is split to the blocks
+ *        which are compressed independently, using the previous block's tail as the
+ *        dictionary, and then joined to a single valid stream. Compression ratio could be
+ *        slightly lower than for the single-threaded compression.
+ *
+ * @param op opaque encrypting context. Must be allocated and initialized.
+ * @param threads number of threads. 0 or 1 (default) means that all of the processing is done
+ *                in the caller's thread. Large values are limited to the number of CPU cores
+ *                or 64, whichever is greater.
+ * @return RNP_SUCCESS or error code if failed
+ */
+RNP_API rnp_result_t rnp_op_encrypt_set_threads(rnp_op_encrypt_t op, size_t threads);
+
 /**
  * @brief set the compression algorithm and level for the inner raw data
  *
@@ -3750,6 +3971,10 @@ RNP_API rnp_result_t rnp_op_encrypt_set_aead_bits(rnp_op_encrypt_t op, int bits)
  * @param compression compression algorithm name. Can be one of the "Uncompressed", "ZIP",
  *        "ZLIB", "BZip2". Please note that ZIP is not PkWare's ZIP file format but just a
  *        DEFLATE compressed data (RFC 1951).
+ *        Also may be "auto": then the first 64KB of data are checked via the fast trial
+ *        compression and, if data looks incompressible (i.e. already compressed or
+ *        encrypted), compression is not used at all. Otherwise default algorithm (ZIP) is
+ *        used with the specified level.
  * @param level 0 - 9, where 0 is no compression and 9 is maximum compression level.
  * @return RNP_SUCCESS on success, or any other value on error
  */
@@ -3971,6 +4196,49 @@ RNP_API rnp_result_t rnp_identifier_iterator_next(rnp_identifier_iterator_t it,
  */
 RNP_API rnp_result_t rnp_identifier_iterator_destroy(rnp_identifier_iterator_t it);
 
+/**
+ * @brief Search for the keys matching the query. Query is compiled once, and keystore
+ *        indexes are used where possible, so this is much faster than iterating over all of
+ *        the identifiers and checking each key separately.
+ *
+ * @param ffi initialized FFI object.
+ * @param search on success search object will be stored here. Must be destroyed via the
+ *               rnp_key_search_destroy() call.
+ * @param query search query. May be NULL or empty string to return all of the keys. Hex
+ *              string of 8 or 16 characters is matched against the key ids, 40 or 64
+ *              characters - against the fingerprints and grips. Query in form <email>
+ *              matches userids, containing it (case-insensitive). Any other query is used as
+ *              case-insensitive extended regular expression, matched against the primary
+ *              key's userids. If hex query doesn't match any key id, fingerprint or grip,
+ *              then it is checked against the userids as well.
+ * @param flags combination of the following flags:
+ *              RNP_KEY_SEARCH_SECRET : return only keys which have secret part,
+ *              RNP_KEY_SEARCH_SUBKEYS : return matching subkeys as well.
+ * @return RNP_SUCCESS or error code if failed.
+ */
+RNP_API rnp_result_t rnp_key_search_create(rnp_ffi_t         ffi,
+                                           rnp_key_search_t *search,
+                                           const char *      query,
+                                           uint32_t          flags);
+
+/**
+ * @brief Get the next key found by the search.
+ *
+ * @param search search object.
+ * @param handle on success key handle will be stored here, or NULL if there are no more
+ *               keys. Must be destroyed via the rnp_key_handle_destroy() call.
+ * @return RNP_SUCCESS or error code if failed.
+ */
+RNP_API rnp_result_t rnp_key_search_next(rnp_key_search_t search, rnp_key_handle_t *handle);
+
+/**
+ * @brief Destroy the search object.
+ *
+ * @param search search object, may be NULL.
+ * @return RNP_SUCCESS or error code if failed.
+ */
+RNP_API rnp_result_t rnp_key_search_destroy(rnp_key_search_t search);
+
 /** Read from input and write to output
  *
  *  @param input stream to read data from
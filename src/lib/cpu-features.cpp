@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2025 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "cpu-features.hpp"
+#if defined(RNP_X86_SIMD) && !defined(__GNUC__) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace rnp {
+namespace cpu {
+
+#if defined(RNP_X86_SIMD) && !defined(__GNUC__) && !defined(__clang__)
+namespace {
+struct Features {
+    bool ssse3{};
+    bool avx2{};
+    bool pclmul{};
+
+    Features()
+    {
+        int regs[4] = {};
+        __cpuid(regs, 0);
+        int maxleaf = regs[0];
+        __cpuid(regs, 1);
+        ssse3 = regs[2] & (1 << 9);
+        pclmul = regs[2] & (1 << 1);
+        bool osavx = (regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) &&
+                     ((_xgetbv(0) & 0x06) == 0x06);
+        if (osavx && (maxleaf >= 7)) {
+            __cpuidex(regs, 7, 0);
+            avx2 = regs[1] & (1 << 5);
+        }
+    }
+};
+
+const Features &
+features() noexcept
+{
+    static const Features features;
+    return features;
+}
+} // namespace
+
+bool
+has_ssse3() noexcept
+{
+    return features().ssse3;
+}
+
+bool
+has_avx2() noexcept
+{
+    return features().avx2;
+}
+
+bool
+has_pclmul() noexcept
+{
+    return features().pclmul;
+}
+#elif defined(RNP_X86_SIMD)
+bool
+has_ssse3() noexcept
+{
+    static const bool res = (__builtin_cpu_init(), __builtin_cpu_supports("ssse3"));
+    return res;
+}
+
+bool
+has_avx2() noexcept
+{
+    static const bool res = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+    return res;
+}
+
+bool
+has_pclmul() noexcept
+{
+    static const bool res = (__builtin_cpu_init(), __builtin_cpu_supports("pclmul"));
+    return res;
+}
+#else
+bool
+has_ssse3() noexcept
+{
+    return false;
+}
+
+bool
+has_avx2() noexcept
+{
+    return false;
+}
+
+bool
+has_pclmul() noexcept
+{
+    return false;
+}
+#endif
+
+} // namespace cpu
+} // namespace rnp
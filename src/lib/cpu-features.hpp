@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2025 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RNP_CPU_FEATURES_HPP_
+#define RNP_CPU_FEATURES_HPP_
+
+/* x86 SIMD kernels are compiled via per-function target attributes (GCC/Clang) or as is
+ * (MSVC), and selected at runtime via the functions below. */
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if defined(__GNUC__) || defined(__clang__)
+#define RNP_X86_SIMD 1
+#define RNP_TARGET(features) __attribute__((target(features)))
+#elif defined(_MSC_VER)
+#define RNP_X86_SIMD 1
+#define RNP_TARGET(features)
+#endif
+#endif
+
+/* NEON is mandatory on AArch64 so no runtime check is required */
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define RNP_ARM_NEON 1
+/* PMULL is optional, so it is used only if enabled for the whole build */
+#if defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES)
+#define RNP_ARM_PMULL 1
+#endif
+#endif
+
+namespace rnp {
+namespace cpu {
+
+/* Runtime checks for the CPU (and OS, where applicable) support of the instruction sets.
+ * Always return false on non-x86 platforms. */
+bool has_ssse3() noexcept;
+bool has_avx2() noexcept;
+bool has_pclmul() noexcept;
+
+} // namespace cpu
+} // namespace rnp
+
+#endif
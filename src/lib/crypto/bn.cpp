@@ -28,6 +28,7 @@
 #include <botan/ffi.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <exception>
 #include "utils.h"
 
 /* essentiually, these are just wrappers around the botan functions */
@@ -57,7 +58,7 @@ mpi2bn(const pgp::mpi *val)
     if (!res) {
         return NULL;
     }
-    if (botan_mp_from_bin(res->mp, val->mpi, val->len)) {
+    if (botan_mp_from_bin(res->mp, val->data(), val->bytes())) {
         bn_free(res);
         res = NULL;
     }
@@ -67,13 +68,19 @@ mpi2bn(const pgp::mpi *val)
 bool
 bn2mpi(const bignum_t *bn, pgp::mpi *val)
 {
-    val->len = bn_num_bytes(*bn);
-    if (val->len > PGP_MPINT_SIZE) {
+    size_t len = bn_num_bytes(*bn);
+    if (len > PGP_MPINT_SIZE) {
         RNP_LOG("Too large MPI.");
-        val->len = 0;
+        val->forget();
         return false;
     }
-    return bn_bn2bin(bn, val->mpi) == 0;
+    try {
+        val->resize(len);
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what()); // LCOV_EXCL_LINE
+        return false;            // LCOV_EXCL_LINE
+    }
+    return bn_bn2bin(bn, val->data()) == 0;
 }
 
 bignum_t *
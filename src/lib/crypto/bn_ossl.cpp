@@ -26,6 +26,7 @@
 
 #include <stdlib.h>
 #include <assert.h>
+#include <exception>
 #include "bn.h"
 #include "logging.h"
 
@@ -51,7 +52,7 @@ mpi2bn(const pgp::mpi *val)
     if (!res) {
         return NULL;
     }
-    if (!BN_bin2bn(val->mpi, val->len, res)) {
+    if (!BN_bin2bn(val->data(), val->bytes(), res)) {
         bn_free(res);
         res = NULL;
     }
@@ -61,8 +62,19 @@ mpi2bn(const pgp::mpi *val)
 bool
 bn2mpi(const bignum_t *bn, pgp::mpi *val)
 {
-    val->len = bn_num_bytes(*bn);
-    return bn_bn2bin(bn, val->mpi) == 0;
+    size_t len = bn_num_bytes(*bn);
+    if (len > PGP_MPINT_SIZE) {
+        RNP_LOG("Too large MPI.");
+        val->forget();
+        return false;
+    }
+    try {
+        val->resize(len);
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what()); // LCOV_EXCL_LINE
+        return false;            // LCOV_EXCL_LINE
+    }
+    return bn_bn2bin(bn, val->data()) == 0;
 }
 
 bignum_t *
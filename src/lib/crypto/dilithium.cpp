@@ -47,27 +47,29 @@ pgp_dilithium_private_key_t::sign(rnp::RNG *rng, const uint8_t *msg, size_t msg_
     assert(is_initialized_);
     auto priv_key = botan_key();
 
-    auto                 signer = Botan::PK_Signer(priv_key, *rng->obj(), "");
+    auto                 signer = Botan::PK_Signer(*priv_key, *rng->obj(), "");
     std::vector<uint8_t> signature = signer.sign_message(msg, msg_len, *rng->obj());
     // std::vector<uint8_t> signature;
 
     return signature;
 }
 
-Botan::Dilithium_PublicKey
+std::shared_ptr<Botan::Dilithium_PublicKey>
 pgp_dilithium_public_key_t::botan_key() const
 {
-    return Botan::Dilithium_PublicKey(
-      key_encoded_, rnp_dilithium_param_to_botan_dimension(dilithium_param_));
+    return cache_.get<Botan::Dilithium_PublicKey>(false, [this]() {
+        return std::make_shared<Botan::Dilithium_PublicKey>(
+          key_encoded_, rnp_dilithium_param_to_botan_dimension(dilithium_param_));
+    });
 }
 
-Botan::Dilithium_PrivateKey
+std::shared_ptr<Botan::Dilithium_PrivateKey>
 pgp_dilithium_private_key_t::botan_key() const
 {
-    Botan::secure_vector<uint8_t> priv_sv(key_encoded_.data(),
-                                          key_encoded_.data() + key_encoded_.size());
-    return Botan::Dilithium_PrivateKey(
-      priv_sv, rnp_dilithium_param_to_botan_dimension(this->dilithium_param_));
+    return cache_.get<Botan::Dilithium_PrivateKey>(true, [this]() {
+        return std::make_shared<Botan::Dilithium_PrivateKey>(
+          key_encoded_, rnp_dilithium_param_to_botan_dimension(this->dilithium_param_));
+    });
 }
 
 bool
@@ -79,8 +81,13 @@ pgp_dilithium_public_key_t::verify_signature(const uint8_t *msg,
     assert(is_initialized_);
     auto pub_key = botan_key();
 
-    auto verificator = Botan::PK_Verifier(pub_key, "");
-    return verificator.verify_message(msg, msg_len, signature, signature_len);
+    return verifier_.use(
+      [&pub_key]() {
+          return std::unique_ptr<Botan::PK_Verifier>(new Botan::PK_Verifier(*pub_key, ""));
+      },
+      [&](Botan::PK_Verifier &verificator) {
+          return verificator.verify_message(msg, msg_len, signature, signature_len);
+      });
 }
 
 std::pair<pgp_dilithium_public_key_t, pgp_dilithium_private_key_t>
@@ -104,7 +111,7 @@ pgp_dilithium_public_key_t::is_valid(rnp::RNG *rng) const
     }
 
     auto key = botan_key();
-    return key.check_key(*(rng->obj()), false);
+    return key->check_key(*(rng->obj()), false);
 }
 
 bool
@@ -115,7 +122,7 @@ pgp_dilithium_private_key_t::is_valid(rnp::RNG *rng) const
     }
 
     auto key = botan_key();
-    return key.check_key(*(rng->obj()), false);
+    return key->check_key(*(rng->obj()), false);
 }
 
 bool
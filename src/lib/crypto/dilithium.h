@@ -32,6 +32,7 @@
 #include <vector>
 #include <repgp/repgp_def.h>
 #include "crypto/rng.h"
+#include "crypto/key_cache.hpp"
 #include <botan/dilithium.h>
 #include <botan/pubkey.h>
 
@@ -62,11 +63,12 @@ class pgp_dilithium_private_key_t {
     };
 
   private:
-    Botan::Dilithium_PrivateKey botan_key() const;
+    std::shared_ptr<Botan::Dilithium_PrivateKey> botan_key() const;
 
     Botan::secure_vector<uint8_t> key_encoded_;
     dilithium_parameter_e         dilithium_param_;
     bool                          is_initialized_ = false;
+    mutable rnp::KeyCache         cache_;
 };
 
 class pgp_dilithium_public_key_t {
@@ -99,11 +101,13 @@ class pgp_dilithium_public_key_t {
     };
 
   private:
-    Botan::Dilithium_PublicKey botan_key() const;
+    std::shared_ptr<Botan::Dilithium_PublicKey> botan_key() const;
 
-    std::vector<uint8_t>  key_encoded_;
-    dilithium_parameter_e dilithium_param_;
-    bool                  is_initialized_ = false;
+    std::vector<uint8_t>                     key_encoded_;
+    dilithium_parameter_e                    dilithium_param_;
+    bool                                     is_initialized_ = false;
+    mutable rnp::KeyCache                    cache_;
+    mutable rnp::OpCache<Botan::PK_Verifier> verifier_;
 };
 
 std::pair<pgp_dilithium_public_key_t, pgp_dilithium_private_key_t> dilithium_generate_keypair(
@@ -166,7 +166,8 @@ dsa_sign(rnp::RNG *           rng,
 
     size_t z_len = 0;
 
-    memset(sig, 0, sizeof(*sig));
+    sig->r.forget();
+    sig->s.forget();
     size_t q_order = key->q.bytes();
     if ((2 * q_order) > sizeof(sign_buf)) {
         RNP_LOG("wrong q order");
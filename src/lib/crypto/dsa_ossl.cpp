@@ -239,13 +239,14 @@ dsa_sign(rnp::RNG *           rng,
         RNP_LOG("Failed to initialize signing: %lu", ERR_peek_last_error());
         goto done;
     }
-    sig->s.len = PGP_MPINT_SIZE;
-    if (EVP_PKEY_sign(ctx, sig->s.mpi, &sig->s.len, hash, hash_len) <= 0) {
+    uint8_t sigbuf[PGP_MPINT_SIZE];
+    size_t  siglen;
+    siglen = sizeof(sigbuf);
+    if (EVP_PKEY_sign(ctx, sigbuf, &siglen, hash, hash_len) <= 0) {
         RNP_LOG("Signing failed: %lu", ERR_peek_last_error());
-        sig->s.len = 0;
         goto done;
     }
-    if (!dsa_decode_sig(&sig->s.mpi[0], sig->s.len, *sig)) {
+    if (!dsa_decode_sig(sigbuf, siglen, *sig)) {
         RNP_LOG("Failed to parse DSA sig: %lu", ERR_peek_last_error());
         goto done;
     }
@@ -282,11 +283,12 @@ dsa_verify(const pgp_dsa_signature_t *sig,
         RNP_LOG("Failed to initialize verify: %lu", ERR_peek_last_error());
         goto done;
     }
-    pgp::mpi sigbuf;
-    if (!dsa_encode_sig(sigbuf.mpi, &sigbuf.len, *sig)) {
+    uint8_t sigbuf[PGP_MPINT_SIZE];
+    size_t  siglen;
+    if (!dsa_encode_sig(sigbuf, &siglen, *sig)) {
         goto done;
     }
-    if (EVP_PKEY_verify(ctx, sigbuf.mpi, sigbuf.len, hash, hash_len) <= 0) {
+    if (EVP_PKEY_verify(ctx, sigbuf, siglen, hash, hash_len) <= 0) {
         ret = RNP_ERROR_SIGNATURE_INVALID;
     } else {
         ret = RNP_SUCCESS;
@@ -68,20 +68,20 @@ x25519_generate(rnp::RNG *rng, pgp_ec_key_t *key)
     if (botan_privkey_x25519_get_privkey(pr_key, keyle.data())) {
         goto end;
     }
+    key->x.resize(32);
     for (int i = 0; i < 32; i++) {
-        key->x.mpi[31 - i] = keyle[i];
+        key->x[31 - i] = keyle[i];
     }
-    key->x.len = 32;
     /* botan doesn't tweak secret key bits, so we should do that here */
     if (!x25519_tweak_bits(*key)) {
         goto end;
     }
 
-    if (botan_pubkey_x25519_get_pubkey(pu_key, &key->p.mpi[1])) {
+    key->p.resize(33);
+    if (botan_pubkey_x25519_get_pubkey(pu_key, &key->p[1])) {
         goto end;
     }
-    key->p.len = 33;
-    key->p.mpi[0] = 0x40;
+    key->p[0] = 0x40;
 
     ret = RNP_SUCCESS;
 end:
@@ -176,11 +176,11 @@ ec_generate(rnp::RNG *             rng,
      * Note: Generated pk/sk may not always have exact number of bytes
      *       which is important when converting to octet-string
      */
-    memset(key->p.mpi, 0, sizeof(key->p.mpi));
-    key->p.mpi[0] = 0x04;
-    bn_bn2bin(px, &key->p.mpi[1 + filed_byte_size - x_bytes]);
-    bn_bn2bin(py, &key->p.mpi[1 + filed_byte_size + (filed_byte_size - y_bytes)]);
-    key->p.len = 2 * filed_byte_size + 1;
+    key->p.forget();
+    key->p.resize(2 * filed_byte_size + 1);
+    key->p[0] = 0x04;
+    bn_bn2bin(px, &key->p[1 + filed_byte_size - x_bytes]);
+    bn_bn2bin(py, &key->p[1 + filed_byte_size + (filed_byte_size - y_bytes)]);
     /* secret key value */
     bn2mpi(x, &key->x);
     ret = RNP_SUCCESS;
@@ -103,19 +103,20 @@ static bool
 ec_write_raw_seckey(EVP_PKEY *pkey, pgp_ec_key_t *key)
 {
     /* EdDSA and X25519 keys are saved in a different way */
-    static_assert(sizeof(key->x.mpi) > 32, "mpi is too small.");
-    key->x.len = sizeof(key->x.mpi);
-    if (EVP_PKEY_get_raw_private_key(pkey, key->x.mpi, &key->x.len) <= 0) {
+    size_t len = 32;
+    key->x.resize(len);
+    if (EVP_PKEY_get_raw_private_key(pkey, key->x.data(), &len) <= 0) {
         /* LCOV_EXCL_START */
         RNP_LOG("Failed get raw private key: %lu", ERR_peek_last_error());
+        key->x.forget();
         return false;
         /* LCOV_EXCL_END */
     }
-    assert(key->x.len == 32);
+    assert(len == 32);
     if (EVP_PKEY_id(pkey) == EVP_PKEY_X25519) {
         /* in OpenSSL private key is exported as little-endian, while MPI is big-endian */
         for (size_t i = 0; i < 16; i++) {
-            std::swap(key->x.mpi[i], key->x.mpi[31 - i]);
+            std::swap(key->x[i], key->x[31 - i]);
         }
     }
     return true;
@@ -186,13 +187,13 @@ ec_load_raw_key(const pgp::mpi &keyp, const pgp::mpi *keyx, int nid)
 {
     if (!keyx) {
         /* as per RFC, EdDSA & 25519 keys must use 0x40 byte for encoding */
-        if ((keyp.bytes() != 33) || (keyp.mpi[0] != 0x40)) {
+        if ((keyp.bytes() != 33) || (keyp[0] != 0x40)) {
             RNP_LOG("Invalid 25519 public key.");
             return NULL;
         }
 
         EVP_PKEY *evpkey =
-          EVP_PKEY_new_raw_public_key(nid, NULL, &keyp.mpi[1], keyp.bytes() - 1);
+          EVP_PKEY_new_raw_public_key(nid, NULL, &keyp[1], keyp.bytes() - 1);
         if (!evpkey) {
             RNP_LOG("Failed to load public key: %lu", ERR_peek_last_error()); // LCOV_EXCL_LINE
         }
@@ -201,24 +202,24 @@ ec_load_raw_key(const pgp::mpi &keyp, const pgp::mpi *keyx, int nid)
 
     EVP_PKEY *evpkey = NULL;
     if (nid == EVP_PKEY_X25519) {
-        if (keyx->len != 32) {
+        if (keyx->bytes() != 32) {
             RNP_LOG("Invalid 25519 secret key");
             return NULL;
         }
         /* need to reverse byte order since in mpi we have big-endian */
         rnp::secure_array<uint8_t, 32> prkey;
         for (int i = 0; i < 32; i++) {
-            prkey[i] = keyx->mpi[31 - i];
+            prkey[i] = (*keyx)[31 - i];
         }
-        evpkey = EVP_PKEY_new_raw_private_key(nid, NULL, prkey.data(), keyx->len);
+        evpkey = EVP_PKEY_new_raw_private_key(nid, NULL, prkey.data(), keyx->bytes());
     } else {
-        if (keyx->len > 32) {
+        if (keyx->bytes() > 32) {
             RNP_LOG("Invalid Ed25519 secret key");
             return NULL;
         }
-        /* keyx->len may be smaller then 32 as high byte is random and could become 0 */
+        /* keyx may be smaller then 32 bytes as high byte is random and could become 0 */
         rnp::secure_array<uint8_t, 32> prkey{};
-        memcpy(prkey.data() + 32 - keyx->len, keyx->mpi, keyx->len);
+        memcpy(prkey.data() + 32 - keyx->bytes(), keyx->data(), keyx->bytes());
         evpkey = EVP_PKEY_new_raw_private_key(nid, NULL, prkey.data(), 32);
     }
     if (!evpkey) {
@@ -236,7 +237,7 @@ ec_build_params(const pgp::mpi &p, bignum_t *x, const char *curve)
         return NULL;
     }
     if (!OSSL_PARAM_BLD_push_utf8_string(bld, OSSL_PKEY_PARAM_GROUP_NAME, curve, 0) ||
-        !OSSL_PARAM_BLD_push_octet_string(bld, OSSL_PKEY_PARAM_PUB_KEY, p.mpi, p.len) ||
+        !OSSL_PARAM_BLD_push_octet_string(bld, OSSL_PKEY_PARAM_PUB_KEY, p.data(), p.bytes()) ||
         (x && !OSSL_PARAM_BLD_push_BN(bld, OSSL_PKEY_PARAM_PRIV_KEY, x))) {
         /* LCOV_EXCL_START */
         OSSL_PARAM_BLD_free(bld);
@@ -332,7 +333,7 @@ ec_load_key(const pgp::mpi &keyp, const pgp::mpi *keyx, pgp_curve_t curve)
         goto done;
         /* LCOV_EXCL_END */
     }
-    if (EC_POINT_oct2point(EC_KEY_get0_group(ec), p, keyp.mpi, keyp.len, NULL) <= 0) {
+    if (EC_POINT_oct2point(EC_KEY_get0_group(ec), p, keyp.data(), keyp.bytes(), NULL) <= 0) {
         /* LCOV_EXCL_START */
         RNP_LOG("Failed to decode point: %lu", ERR_peek_last_error());
         goto done;
@@ -386,13 +387,22 @@ done:
 #endif
 }
 
+std::shared_ptr<EVP_PKEY>
+ec_load_key(const pgp_ec_key_t &key, pgp_curve_t curve, bool secret, rnp::KeyCache *cache)
+{
+    return rnp::KeyCache::load<EVP_PKEY>(cache, secret, [&key, curve, secret]() {
+        return std::shared_ptr<EVP_PKEY>(ec_load_key(key.p, secret ? &key.x : NULL, curve),
+                                         EVP_PKEY_free);
+    });
+}
+
 rnp_result_t
 ec_validate_key(const pgp_ec_key_t &key, bool secret)
 {
     if (key.curve == PGP_CURVE_25519) {
         /* No key check implementation for x25519 in the OpenSSL yet, so just basic size checks
          */
-        if ((key.p.bytes() != 33) || (key.p.mpi[0] != 0x40)) {
+        if ((key.p.bytes() != 33) || (key.p[0] != 0x40)) {
             return RNP_ERROR_BAD_PARAMETERS;
         }
         if (secret && key.x.bytes() != 32) {
@@ -434,16 +444,17 @@ ec_write_pubkey(EVP_PKEY *pkey, pgp::mpi &mpi, pgp_curve_t curve)
 {
     if (ec_is_raw_key(curve)) {
         /* EdDSA and X25519 keys are saved in a different way */
-        mpi.len = sizeof(mpi.mpi) - 1;
-        if (EVP_PKEY_get_raw_public_key(pkey, &mpi.mpi[1], &mpi.len) <= 0) {
+        size_t len = 32;
+        mpi.resize(len + 1);
+        if (EVP_PKEY_get_raw_public_key(pkey, &mpi[1], &len) <= 0) {
             /* LCOV_EXCL_START */
             RNP_LOG("Failed get raw public key: %lu", ERR_peek_last_error());
+            mpi.forget();
             return false;
             /* LCOV_EXCL_END */
         }
-        assert(mpi.len == 32);
-        mpi.mpi[0] = 0x40;
-        mpi.len++;
+        assert(len == 32);
+        mpi[0] = 0x40;
         return true;
     }
 #if defined(CRYPTO_BACKEND_OPENSSL3)
@@ -466,10 +477,10 @@ ec_write_pubkey(EVP_PKEY *pkey, pgp::mpi &mpi, pgp_curve_t curve)
     size_t xlen = qx.bytes();
     size_t ylen = qy.bytes();
     assert((xlen <= flen) && (ylen <= flen));
-    memset(mpi.mpi, 0, sizeof(mpi.mpi));
-    mpi.mpi[0] = 0x04;
-    mpi.len = 2 * flen + 1;
-    return qx.bin(&mpi.mpi[1 + flen - xlen]) && qy.bin(&mpi.mpi[1 + 2 * flen - ylen]);
+    mpi.forget();
+    mpi.resize(2 * flen + 1);
+    mpi[0] = 0x04;
+    return qx.bin(&mpi[1 + flen - xlen]) && qy.bin(&mpi[1 + 2 * flen - ylen]);
 #else
     const EC_KEY *ec = EVP_PKEY_get0_EC_KEY(pkey);
     if (!ec) {
@@ -486,11 +497,18 @@ ec_write_pubkey(EVP_PKEY *pkey, pgp::mpi &mpi, pgp_curve_t curve)
         /* LCOV_EXCL_END */
     }
     /* call below adds leading zeroes if needed */
-    mpi.len = EC_POINT_point2oct(
-      EC_KEY_get0_group(ec), p, POINT_CONVERSION_UNCOMPRESSED, mpi.mpi, sizeof(mpi.mpi), NULL);
-    if (!mpi.len) {
+    size_t len = EC_POINT_point2oct(
+      EC_KEY_get0_group(ec), p, POINT_CONVERSION_UNCOMPRESSED, NULL, 0, NULL);
+    mpi.resize(len);
+    if (!len || !EC_POINT_point2oct(EC_KEY_get0_group(ec),
+                                    p,
+                                    POINT_CONVERSION_UNCOMPRESSED,
+                                    mpi.data(),
+                                    len,
+                                    NULL)) {
         RNP_LOG("Failed to encode public key: %lu", ERR_peek_last_error()); // LCOV_EXCL_LINE
+        return false;                                                        // LCOV_EXCL_LINE
     }
-    return mpi.len;
+    return true;
 #endif
 }
@@ -29,10 +29,17 @@
 
 #include "types.h"
 #include "ec.h"
+#include "key_cache.hpp"
 #include <openssl/evp.h>
 
 EVP_PKEY *ec_load_key(const pgp::mpi &keyp, const pgp::mpi *keyx, pgp_curve_t curve);
 
+/* Same as above, but reuses the EVP_PKEY object from the cache if it is not NULL */
+std::shared_ptr<EVP_PKEY> ec_load_key(const pgp_ec_key_t &key,
+                                      pgp_curve_t         curve,
+                                      bool                secret,
+                                      rnp::KeyCache *     cache);
+
 rnp_result_t ec_validate_key(const pgp_ec_key_t &key, bool secret);
 
 EVP_PKEY *ec_generate_pkey(const pgp_pubkey_alg_t alg_id, const pgp_curve_t curve);
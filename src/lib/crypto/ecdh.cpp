@@ -47,8 +47,8 @@ compute_kek(uint8_t *              kek,
             const botan_privkey_t  ec_prvkey,
             const pgp_hash_alg_t   hash_alg)
 {
-    const uint8_t *p = ec_pubkey->mpi;
-    uint8_t        p_len = ec_pubkey->len;
+    const uint8_t *p = ec_pubkey->data();
+    uint8_t        p_len = ec_pubkey->bytes();
 
     if (curve_desc->rnp_curve_id == PGP_CURVE_25519) {
         if ((p_len != 33) || (p[0] != 0x40)) {
@@ -90,26 +90,26 @@ ecdh_load_public_key(botan_pubkey_t *pubkey, const pgp_ec_key_t *key)
     }
 
     if (curve->rnp_curve_id == PGP_CURVE_25519) {
-        if ((key->p.len != 33) || (key->p.mpi[0] != 0x40)) {
+        if ((key->p.bytes() != 33) || (key->p[0] != 0x40)) {
             return false;
         }
         rnp::secure_array<uint8_t, 32> pkey;
-        memcpy(pkey.data(), key->p.mpi + 1, 32);
+        memcpy(pkey.data(), &key->p[1], 32);
         return !botan_pubkey_load_x25519(pubkey, pkey.data());
     }
 
-    if (!key->p.bytes() || (key->p.mpi[0] != 0x04)) {
+    const size_t curve_order = BITS_TO_BYTES(curve->bitlen);
+    if ((key->p.bytes() != 2 * curve_order + 1) || (key->p[0] != 0x04)) {
         RNP_LOG("Failed to load public key");
         return false;
     }
 
-    botan_mp_t   px = NULL;
-    botan_mp_t   py = NULL;
-    const size_t curve_order = BITS_TO_BYTES(curve->bitlen);
+    botan_mp_t px = NULL;
+    botan_mp_t py = NULL;
 
     if (botan_mp_init(&px) || botan_mp_init(&py) ||
-        botan_mp_from_bin(px, &key->p.mpi[1], curve_order) ||
-        botan_mp_from_bin(py, &key->p.mpi[1 + curve_order], curve_order)) {
+        botan_mp_from_bin(px, &key->p[1], curve_order) ||
+        botan_mp_from_bin(py, &key->p[1 + curve_order], curve_order)) {
         goto end;
     }
 
@@ -132,14 +132,14 @@ ecdh_load_secret_key(botan_privkey_t *seckey, const pgp_ec_key_t *key)
     }
 
     if (curve->rnp_curve_id == PGP_CURVE_25519) {
-        if (key->x.len != 32) {
+        if (key->x.bytes() != 32) {
             RNP_LOG("wrong x25519 key");
             return false;
         }
         /* need to reverse byte order since in mpi we have big-endian */
         rnp::secure_array<uint8_t, 32> prkey;
         for (int i = 0; i < 32; i++) {
-            prkey[i] = key->x.mpi[31 - i];
+            prkey[i] = key->x[31 - i];
         }
         return !botan_privkey_load_x25519(seckey, prkey.data());
     }
@@ -273,19 +273,21 @@ ecdh_encrypt_pkcs5(rnp::RNG *               rng,
     }
 
     /* we need to prepend 0x40 for the x25519 */
+    size_t plen;
     if (key->curve == PGP_CURVE_25519) {
-        out->p.len = sizeof(out->p.mpi) - 1;
-        if (botan_pk_op_key_agreement_export_public(
-              eph_prv_key, out->p.mpi + 1, &out->p.len)) {
+        plen = 32;
+        out->p.resize(plen + 1);
+        if (botan_pk_op_key_agreement_export_public(eph_prv_key, &out->p[1], &plen)) {
             goto end;
         }
-        out->p.mpi[0] = 0x40;
-        out->p.len++;
+        out->p[0] = 0x40;
     } else {
-        out->p.len = sizeof(out->p.mpi);
-        if (botan_pk_op_key_agreement_export_public(eph_prv_key, out->p.mpi, &out->p.len)) {
+        plen = 2 * BITS_TO_BYTES(curve_desc->bitlen) + 1;
+        out->p.resize(plen);
+        if (botan_pk_op_key_agreement_export_public(eph_prv_key, out->p.data(), &plen)) {
             goto end;
         }
+        out->p.resize(plen);
     }
 
     // All OK
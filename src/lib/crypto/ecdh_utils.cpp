@@ -146,21 +146,21 @@ ecdh_set_params(pgp_ec_key_t *key, pgp_curve_t curve_id)
 bool
 x25519_tweak_bits(pgp_ec_key_t &key)
 {
-    if (key.x.len != 32) {
+    if (key.x.bytes() != 32) {
         return false;
     }
     /* MPI is big-endian, while raw x25519 key is little-endian */
-    key.x.mpi[31] &= 248; // zero 3 low bits
-    key.x.mpi[0] &= 127;  // zero high bit
-    key.x.mpi[0] |= 64;   // set high - 1 bit
+    key.x[31] &= 248; // zero 3 low bits
+    key.x[0] &= 127;  // zero high bit
+    key.x[0] |= 64;   // set high - 1 bit
     return true;
 }
 
 bool
 x25519_bits_tweaked(const pgp_ec_key_t &key)
 {
-    if (key.x.len != 32) {
+    if (key.x.bytes() != 32) {
         return false;
     }
-    return !(key.x.mpi[31] & 7) && (key.x.mpi[0] < 128) && (key.x.mpi[0] >= 64);
+    return !(key.x[31] & 7) && (key.x[0] < 128) && (key.x[0] >= 64);
 }
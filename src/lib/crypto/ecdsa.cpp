@@ -44,14 +44,15 @@ ecdsa_load_public_key(botan_pubkey_t *pubkey, const pgp_ec_key_t *keydata)
     }
     const size_t curve_order = BITS_TO_BYTES(curve->bitlen);
 
-    if (!keydata->p.bytes() || (keydata->p.mpi[0] != 0x04)) {
-        RNP_LOG("Failed to load public key: %zu, %02x", keydata->p.bytes(), keydata->p.mpi[0]);
+    /* mpi is sized exactly, so point must be checked before reading the coordinates */
+    if ((keydata->p.bytes() != 2 * curve_order + 1) || (keydata->p[0] != 0x04)) {
+        RNP_LOG("Failed to load public key: %zu", keydata->p.bytes());
         return false;
     }
 
     if (botan_mp_init(&px) || botan_mp_init(&py) ||
-        botan_mp_from_bin(px, &keydata->p.mpi[1], curve_order) ||
-        botan_mp_from_bin(py, &keydata->p.mpi[1 + curve_order], curve_order)) {
+        botan_mp_from_bin(px, &keydata->p[1], curve_order) ||
+        botan_mp_from_bin(py, &keydata->p[1 + curve_order], curve_order)) {
         goto end;
     }
 
@@ -84,6 +85,30 @@ ecdsa_load_secret_key(botan_privkey_t *seckey, const pgp_ec_key_t *keydata)
     return res;
 }
 
+static std::shared_ptr<botan_pubkey_struct>
+ecdsa_get_public_key(const pgp_ec_key_t *keydata, rnp::KeyCache *cache)
+{
+    return rnp::KeyCache::load<botan_pubkey_struct>(cache, false, [keydata]() {
+        botan_pubkey_t pubkey = NULL;
+        if (!ecdsa_load_public_key(&pubkey, keydata)) {
+            return std::shared_ptr<botan_pubkey_struct>();
+        }
+        return std::shared_ptr<botan_pubkey_struct>(pubkey, botan_pubkey_destroy);
+    });
+}
+
+static std::shared_ptr<botan_privkey_struct>
+ecdsa_get_secret_key(const pgp_ec_key_t *keydata, rnp::KeyCache *cache)
+{
+    return rnp::KeyCache::load<botan_privkey_struct>(cache, true, [keydata]() {
+        botan_privkey_t seckey = NULL;
+        if (!ecdsa_load_secret_key(&seckey, keydata)) {
+            return std::shared_ptr<botan_privkey_struct>();
+        }
+        return std::shared_ptr<botan_privkey_struct>(seckey, botan_privkey_destroy);
+    });
+}
+
 rnp_result_t
 ecdsa_validate_key(rnp::RNG *rng, const pgp_ec_key_t *key, bool secret)
 {
@@ -148,10 +173,10 @@ ecdsa_sign(rnp::RNG *          rng,
            pgp_hash_alg_t      hash_alg,
            const uint8_t *     hash,
            size_t              hash_len,
-           const pgp_ec_key_t *key)
+           const pgp_ec_key_t *key,
+           rnp::KeyCache *     cache)
 {
     botan_pk_op_sign_t     signer = NULL;
-    botan_privkey_t        b_key = NULL;
     rnp_result_t           ret = RNP_ERROR_GENERIC;
     uint8_t                out_buf[2 * MAX_CURVE_BYTELEN] = {0};
     const ec_curve_desc_t *curve = get_curve_desc(key->curve);
@@ -162,13 +187,14 @@ ecdsa_sign(rnp::RNG *          rng,
     }
     const size_t curve_order = BITS_TO_BYTES(curve->bitlen);
     size_t       sig_len = 2 * curve_order;
+    auto         b_key = ecdsa_get_secret_key(key, cache);
 
-    if (!ecdsa_load_secret_key(&b_key, key)) {
+    if (!b_key) {
         RNP_LOG("Can't load private key");
         goto end;
     }
 
-    if (botan_pk_op_sign_create(&signer, b_key, padding_str, 0)) {
+    if (botan_pk_op_sign_create(&signer, b_key.get(), padding_str, 0)) {
         goto end;
     }
 
@@ -187,7 +213,6 @@ ecdsa_sign(rnp::RNG *          rng,
         ret = RNP_SUCCESS;
     }
 end:
-    botan_privkey_destroy(b_key);
     botan_pk_op_sign_destroy(signer);
     return ret;
 }
@@ -197,9 +222,9 @@ ecdsa_verify(const pgp_ec_signature_t *sig,
              pgp_hash_alg_t            hash_alg,
              const uint8_t *           hash,
              size_t                    hash_len,
-             const pgp_ec_key_t *      key)
+             const pgp_ec_key_t *      key,
+             rnp::KeyCache *           cache)
 {
-    botan_pubkey_t       pub = NULL;
     botan_pk_op_verify_t verifier = NULL;
     rnp_result_t         ret = RNP_ERROR_SIGNATURE_INVALID;
     uint8_t              sign_buf[2 * MAX_CURVE_BYTELEN] = {0};
@@ -212,12 +237,13 @@ ecdsa_verify(const pgp_ec_signature_t *sig,
         return RNP_ERROR_BAD_PARAMETERS;
     }
     const size_t curve_order = BITS_TO_BYTES(curve->bitlen);
+    auto         pub = ecdsa_get_public_key(key, cache);
 
-    if (!ecdsa_load_public_key(&pub, key)) {
+    if (!pub) {
         goto end;
     }
 
-    if (botan_pk_op_verify_create(&verifier, pub, padding_str, 0)) {
+    if (botan_pk_op_verify_create(&verifier, pub.get(), padding_str, 0)) {
         goto end;
     }
 
@@ -241,7 +267,6 @@ ecdsa_verify(const pgp_ec_signature_t *sig,
         ret = RNP_SUCCESS;
     }
 end:
-    botan_pubkey_destroy(pub);
     botan_pk_op_verify_destroy(verifier);
     return ret;
 }
@@ -28,6 +28,7 @@
 #define ECDSA_H_
 
 #include "crypto/ec.h"
+#include "crypto/key_cache.hpp"
 
 rnp_result_t ecdsa_validate_key(rnp::RNG *rng, const pgp_ec_key_t *key, bool secret);
 
@@ -36,13 +37,15 @@ rnp_result_t ecdsa_sign(rnp::RNG *          rng,
                         pgp_hash_alg_t      hash_alg,
                         const uint8_t *     hash,
                         size_t              hash_len,
-                        const pgp_ec_key_t *key);
+                        const pgp_ec_key_t *key,
+                        rnp::KeyCache *     cache = NULL);
 
 rnp_result_t ecdsa_verify(const pgp_ec_signature_t *sig,
                           pgp_hash_alg_t            hash_alg,
                           const uint8_t *           hash,
                           size_t                    hash_len,
-                          const pgp_ec_key_t *      key);
+                          const pgp_ec_key_t *      key,
+                          rnp::KeyCache *           cache = NULL);
 
 const char *ecdsa_padding_str_for(pgp_hash_alg_t hash_alg);
 
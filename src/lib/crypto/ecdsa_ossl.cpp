@@ -90,7 +90,8 @@ ecdsa_sign(rnp::RNG *          rng,
            pgp_hash_alg_t      hash_alg,
            const uint8_t *     hash,
            size_t              hash_len,
-           const pgp_ec_key_t *key)
+           const pgp_ec_key_t *key,
+           rnp::KeyCache *     cache)
 {
     if (!key->x.bytes()) {
         RNP_LOG("private key not set");
@@ -98,7 +99,7 @@ ecdsa_sign(rnp::RNG *          rng,
     }
 
     /* Load secret key to DSA structure*/
-    EVP_PKEY *evpkey = ec_load_key(key->p, &key->x, key->curve);
+    auto evpkey = ec_load_key(*key, key->curve, true, cache);
     if (!evpkey) {
         RNP_LOG("Failed to load key");
         return RNP_ERROR_BAD_PARAMETERS;
@@ -106,7 +107,7 @@ ecdsa_sign(rnp::RNG *          rng,
 
     rnp_result_t ret = RNP_ERROR_GENERIC;
     /* init context and sign */
-    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(evpkey, NULL);
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(evpkey.get(), NULL);
     if (!ctx) {
         RNP_LOG("Context allocation failed: %lu", ERR_peek_last_error());
         goto done;
@@ -115,20 +116,20 @@ ecdsa_sign(rnp::RNG *          rng,
         RNP_LOG("Failed to initialize signing: %lu", ERR_peek_last_error());
         goto done;
     }
-    sig->s.len = PGP_MPINT_SIZE;
-    if (EVP_PKEY_sign(ctx, sig->s.mpi, &sig->s.len, hash, hash_len) <= 0) {
+    uint8_t sigbuf[PGP_MPINT_SIZE];
+    size_t  siglen;
+    siglen = sizeof(sigbuf);
+    if (EVP_PKEY_sign(ctx, sigbuf, &siglen, hash, hash_len) <= 0) {
         RNP_LOG("Signing failed: %lu", ERR_peek_last_error());
-        sig->s.len = 0;
         goto done;
     }
-    if (!ecdsa_decode_sig(&sig->s.mpi[0], sig->s.len, *sig)) {
+    if (!ecdsa_decode_sig(sigbuf, siglen, *sig)) {
         RNP_LOG("Failed to parse ECDSA sig: %lu", ERR_peek_last_error());
         goto done;
     }
     ret = RNP_SUCCESS;
 done:
     EVP_PKEY_CTX_free(ctx);
-    EVP_PKEY_free(evpkey);
     return ret;
 }
 
@@ -137,10 +138,11 @@ ecdsa_verify(const pgp_ec_signature_t *sig,
              pgp_hash_alg_t            hash_alg,
              const uint8_t *           hash,
              size_t                    hash_len,
-             const pgp_ec_key_t *      key)
+             const pgp_ec_key_t *      key,
+             rnp::KeyCache *           cache)
 {
     /* Load secret key to DSA structure*/
-    EVP_PKEY *evpkey = ec_load_key(key->p, NULL, key->curve);
+    auto evpkey = ec_load_key(*key, key->curve, false, cache);
     if (!evpkey) {
         RNP_LOG("Failed to load key");
         return RNP_ERROR_BAD_PARAMETERS;
@@ -148,7 +150,7 @@ ecdsa_verify(const pgp_ec_signature_t *sig,
 
     rnp_result_t ret = RNP_ERROR_SIGNATURE_INVALID;
     /* init context and sign */
-    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(evpkey, NULL);
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(evpkey.get(), NULL);
     if (!ctx) {
         RNP_LOG("Context allocation failed: %lu", ERR_peek_last_error());
         goto done;
@@ -157,15 +159,15 @@ ecdsa_verify(const pgp_ec_signature_t *sig,
         RNP_LOG("Failed to initialize verify: %lu", ERR_peek_last_error());
         goto done;
     }
-    pgp::mpi sigbuf;
-    if (!ecdsa_encode_sig(sigbuf.mpi, &sigbuf.len, *sig)) {
+    uint8_t sigbuf[PGP_MPINT_SIZE];
+    size_t  siglen;
+    if (!ecdsa_encode_sig(sigbuf, &siglen, *sig)) {
         goto done;
     }
-    if (EVP_PKEY_verify(ctx, sigbuf.mpi, sigbuf.len, hash, hash_len) > 0) {
+    if (EVP_PKEY_verify(ctx, sigbuf, siglen, hash, hash_len) > 0) {
         ret = RNP_SUCCESS;
     }
 done:
     EVP_PKEY_CTX_free(ctx);
-    EVP_PKEY_free(evpkey);
     return ret;
 }
@@ -38,10 +38,10 @@ eddsa_load_public_key(botan_pubkey_t *pubkey, const pgp_ec_key_t *keydata)
     /*
      * See draft-ietf-openpgp-rfc4880bis-01 section 13.3
      */
-    if ((keydata->p.bytes() != 33) || (keydata->p.mpi[0] != 0x40)) {
+    if ((keydata->p.bytes() != 33) || (keydata->p[0] != 0x40)) {
         return false;
     }
-    if (botan_pubkey_load_ed25519(pubkey, keydata->p.mpi + 1)) {
+    if (botan_pubkey_load_ed25519(pubkey, keydata->p.data() + 1)) {
         return false;
     }
 
@@ -67,6 +67,30 @@ eddsa_load_secret_key(botan_privkey_t *seckey, const pgp_ec_key_t *keydata)
     return true;
 }
 
+static std::shared_ptr<botan_pubkey_struct>
+eddsa_get_public_key(const pgp_ec_key_t *keydata, rnp::KeyCache *cache)
+{
+    return rnp::KeyCache::load<botan_pubkey_struct>(cache, false, [keydata]() {
+        botan_pubkey_t pubkey = NULL;
+        if (!eddsa_load_public_key(&pubkey, keydata)) {
+            return std::shared_ptr<botan_pubkey_struct>();
+        }
+        return std::shared_ptr<botan_pubkey_struct>(pubkey, botan_pubkey_destroy);
+    });
+}
+
+static std::shared_ptr<botan_privkey_struct>
+eddsa_get_secret_key(const pgp_ec_key_t *keydata, rnp::KeyCache *cache)
+{
+    return rnp::KeyCache::load<botan_privkey_struct>(cache, true, [keydata]() {
+        botan_privkey_t seckey = NULL;
+        if (!eddsa_load_secret_key(&seckey, keydata)) {
+            return std::shared_ptr<botan_privkey_struct>();
+        }
+        return std::shared_ptr<botan_privkey_struct>(seckey, botan_privkey_destroy);
+    });
+}
+
 rnp_result_t
 eddsa_validate_key(rnp::RNG *rng, const pgp_ec_key_t *key, bool secret)
 {
@@ -129,19 +153,20 @@ rnp_result_t
 eddsa_verify(const pgp_ec_signature_t *sig,
              const uint8_t *           hash,
              size_t                    hash_len,
-             const pgp_ec_key_t *      key)
+             const pgp_ec_key_t *      key,
+             rnp::KeyCache *           cache)
 {
-    botan_pubkey_t       eddsa = NULL;
     botan_pk_op_verify_t verify_op = NULL;
     rnp_result_t         ret = RNP_ERROR_SIGNATURE_INVALID;
     uint8_t              bn_buf[64] = {0};
+    auto                 eddsa = eddsa_get_public_key(key, cache);
 
-    if (!eddsa_load_public_key(&eddsa, key)) {
+    if (!eddsa) {
         ret = RNP_ERROR_BAD_PARAMETERS;
         goto done;
     }
 
-    if (botan_pk_op_verify_create(&verify_op, eddsa, "Pure", 0) != 0) {
+    if (botan_pk_op_verify_create(&verify_op, eddsa.get(), "Pure", 0) != 0) {
         goto done;
     }
 
@@ -161,7 +186,6 @@ eddsa_verify(const pgp_ec_signature_t *sig,
     }
 done:
     botan_pk_op_verify_destroy(verify_op);
-    botan_pubkey_destroy(eddsa);
     return ret;
 }
 
@@ -170,20 +194,21 @@ eddsa_sign(rnp::RNG *          rng,
            pgp_ec_signature_t *sig,
            const uint8_t *     hash,
            size_t              hash_len,
-           const pgp_ec_key_t *key)
+           const pgp_ec_key_t *key,
+           rnp::KeyCache *     cache)
 {
-    botan_privkey_t    eddsa = NULL;
     botan_pk_op_sign_t sign_op = NULL;
     rnp_result_t       ret = RNP_ERROR_SIGNING_FAILED;
     uint8_t            bn_buf[64] = {0};
     size_t             sig_size = sizeof(bn_buf);
+    auto               eddsa = eddsa_get_secret_key(key, cache);
 
-    if (!eddsa_load_secret_key(&eddsa, key)) {
+    if (!eddsa) {
         ret = RNP_ERROR_BAD_PARAMETERS;
         goto done;
     }
 
-    if (botan_pk_op_sign_create(&sign_op, eddsa, "Pure", 0) != 0) {
+    if (botan_pk_op_sign_create(&sign_op, eddsa.get(), "Pure", 0) != 0) {
         goto done;
     }
 
@@ -205,6 +230,5 @@ eddsa_sign(rnp::RNG *          rng,
     ret = RNP_SUCCESS;
 done:
     botan_pk_op_sign_destroy(sign_op);
-    botan_privkey_destroy(eddsa);
     return ret;
 }
@@ -32,6 +32,7 @@
 #define RNP_ED25519_H_
 
 #include "ec.h"
+#include "key_cache.hpp"
 
 rnp_result_t eddsa_validate_key(rnp::RNG *rng, const pgp_ec_key_t *key, bool secret);
 /*
@@ -43,12 +44,14 @@ rnp_result_t eddsa_generate(rnp::RNG *rng, pgp_ec_key_t *key);
 rnp_result_t eddsa_verify(const pgp_ec_signature_t *sig,
                           const uint8_t *           hash,
                           size_t                    hash_len,
-                          const pgp_ec_key_t *      key);
+                          const pgp_ec_key_t *      key,
+                          rnp::KeyCache *           cache = NULL);
 
 rnp_result_t eddsa_sign(rnp::RNG *          rng,
                         pgp_ec_signature_t *sig,
                         const uint8_t *     hash,
                         size_t              hash_len,
-                        const pgp_ec_key_t *key);
+                        const pgp_ec_key_t *key,
+                        rnp::KeyCache *     cache = NULL);
 
 #endif
@@ -40,7 +40,7 @@ rnp_result_t
 eddsa_validate_key(rnp::RNG *rng, const pgp_ec_key_t *key, bool secret)
 {
     /* Not implemented in the OpenSSL, so just do basic size checks. */
-    if ((key->p.bytes() != 33) || (key->p.mpi[0] != 0x40)) {
+    if ((key->p.bytes() != 33) || (key->p[0] != 0x40)) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
     if (secret && key->x.bytes() > 32) {
@@ -63,18 +63,19 @@ rnp_result_t
 eddsa_verify(const pgp_ec_signature_t *sig,
              const uint8_t *           hash,
              size_t                    hash_len,
-             const pgp_ec_key_t *      key)
+             const pgp_ec_key_t *      key,
+             rnp::KeyCache *           cache)
 {
     if ((sig->r.bytes() > 32) || (sig->s.bytes() > 32)) {
         RNP_LOG("Invalid EdDSA signature.");
         return RNP_ERROR_BAD_PARAMETERS;
     }
-    if ((key->p.bytes() != 33) || (key->p.mpi[0] != 0x40)) {
+    if ((key->p.bytes() != 33) || (key->p[0] != 0x40)) {
         RNP_LOG("Invalid EdDSA public key.");
         return RNP_ERROR_BAD_PARAMETERS;
     }
 
-    EVP_PKEY *evpkey = ec_load_key(key->p, NULL, PGP_CURVE_ED25519);
+    auto evpkey = ec_load_key(*key, PGP_CURVE_ED25519, false, cache);
     if (!evpkey) {
         RNP_LOG("Failed to load key");
         return RNP_ERROR_BAD_PARAMETERS;
@@ -89,7 +90,7 @@ eddsa_verify(const pgp_ec_signature_t *sig,
         RNP_LOG("Failed to allocate MD ctx: %lu", ERR_peek_last_error());
         goto done;
     }
-    if (EVP_DigestVerifyInit(md, &ctx, NULL, NULL, evpkey) <= 0) {
+    if (EVP_DigestVerifyInit(md, &ctx, NULL, NULL, evpkey.get()) <= 0) {
         RNP_LOG("Failed to initialize signing: %lu", ERR_peek_last_error());
         goto done;
     }
@@ -102,7 +103,6 @@ eddsa_verify(const pgp_ec_signature_t *sig,
 done:
     /* line below will also free ctx */
     EVP_MD_CTX_free(md);
-    EVP_PKEY_free(evpkey);
     return ret;
 }
 
@@ -111,13 +111,14 @@ eddsa_sign(rnp::RNG *          rng,
            pgp_ec_signature_t *sig,
            const uint8_t *     hash,
            size_t              hash_len,
-           const pgp_ec_key_t *key)
+           const pgp_ec_key_t *key,
+           rnp::KeyCache *     cache)
 {
     if (!key->x.bytes()) {
         RNP_LOG("private key not set");
         return RNP_ERROR_BAD_PARAMETERS;
     }
-    EVP_PKEY *evpkey = ec_load_key(key->p, &key->x, PGP_CURVE_ED25519);
+    auto evpkey = ec_load_key(*key, PGP_CURVE_ED25519, true, cache);
     if (!evpkey) {
         RNP_LOG("Failed to load private key: %lu", ERR_peek_last_error());
         return RNP_ERROR_BAD_PARAMETERS;
@@ -131,26 +132,23 @@ eddsa_sign(rnp::RNG *          rng,
         RNP_LOG("Failed to allocate MD ctx: %lu", ERR_peek_last_error());
         goto done;
     }
-    if (EVP_DigestSignInit(md, &ctx, NULL, NULL, evpkey) <= 0) {
+    if (EVP_DigestSignInit(md, &ctx, NULL, NULL, evpkey.get()) <= 0) {
         RNP_LOG("Failed to initialize signing: %lu", ERR_peek_last_error());
         goto done;
     }
-    static_assert((sizeof(sig->r.mpi) == PGP_MPINT_SIZE) && (PGP_MPINT_SIZE >= 64),
-                  "invalid mpi type/size");
-    sig->r.len = PGP_MPINT_SIZE;
-    if (EVP_DigestSign(md, sig->r.mpi, &sig->r.len, hash, hash_len) <= 0) {
+    uint8_t sigbuf[64];
+    size_t  siglen;
+    siglen = sizeof(sigbuf);
+    if (EVP_DigestSign(md, sigbuf, &siglen, hash, hash_len) <= 0) {
         RNP_LOG("Signing failed: %lu", ERR_peek_last_error());
-        sig->r.len = 0;
         goto done;
     }
-    assert(sig->r.len == 64);
-    sig->r.len = 32;
-    sig->s.len = 32;
-    memcpy(sig->s.mpi, &sig->r.mpi[32], 32);
+    assert(siglen == 64);
+    sig->r.from_mem(sigbuf, 32);
+    sig->s.from_mem(sigbuf + 32, 32);
     ret = RNP_SUCCESS;
 done:
     /* line below will also free ctx */
     EVP_MD_CTX_free(md);
-    EVP_PKEY_free(evpkey);
     return ret;
 }
@@ -103,8 +103,8 @@ elgamal_validate_key(const pgp_eg_key_t *key, bool secret)
     /* Use custom validation since we added some custom validation, and Botan has slow test for
      * prime for p */
     try {
-        Botan::BigInt p(key->p.mpi, key->p.len);
-        Botan::BigInt g(key->g.mpi, key->g.len);
+        Botan::BigInt p(key->p.data(), key->p.bytes());
+        Botan::BigInt g(key->g.data(), key->g.bytes());
 
         /* 1 < g < p */
         if ((g.cmp_word(1) != 1) || (g.cmp(p) != -1)) {
@@ -128,8 +128,8 @@ elgamal_validate_key(const pgp_eg_key_t *key, bool secret)
             return true;
         }
         /* check that g ^ x = y (mod p) */
-        Botan::BigInt y(key->y.mpi, key->y.len);
-        Botan::BigInt x(key->x.mpi, key->x.len);
+        Botan::BigInt y(key->y.data(), key->y.bytes());
+        Botan::BigInt x(key->x.data(), key->x.bytes());
         return Botan::power_mod(g, x, p) == y;
     } catch (const std::exception &e) {
         RNP_LOG("%s", e.what());
@@ -229,8 +229,8 @@ elgamal_decrypt_pkcs1(rnp::RNG *                rng,
     /* Botan expects ciphertext to be concatenated (g^k | encrypted m). Size must
      * be equal to twice the byte size of public key, potentially prepended with zeros.
      */
-    memcpy(&enc_buf[p_len - g_len], in->g.mpi, g_len);
-    memcpy(&enc_buf[2 * p_len - m_len], in->m.mpi, m_len);
+    memcpy(&enc_buf[p_len - g_len], in->g.data(), g_len);
+    memcpy(&enc_buf[2 * p_len - m_len], in->m.data(), m_len);
 
     *out_len = p_len;
     if (botan_pk_op_decrypt_create(&op_ctx, b_key, "PKCS1v15", 0) ||
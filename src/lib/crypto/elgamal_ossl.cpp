@@ -183,9 +183,9 @@ elgamal_encrypt_pkcs1(rnp::RNG *          rng,
                       size_t              in_len,
                       const pgp_eg_key_t *key)
 {
-    pgp::mpi mm = {};
-    mm.len = key->p.len;
-    if (!pkcs1v15_pad(mm.mpi, mm.len, in, in_len)) {
+    pgp::mpi mm;
+    mm.resize(key->p.bytes());
+    if (!pkcs1v15_pad(mm.data(), mm.bytes(), in, in_len)) {
         /* LCOV_EXCL_START */
         RNP_LOG("Failed to add PKCS1 v1.5 padding.");
         return RNP_ERROR_BAD_PARAMETERS;
@@ -291,7 +291,7 @@ elgamal_decrypt_pkcs1(rnp::RNG *                rng,
         return RNP_ERROR_OUT_OF_MEMORY;
         /* LCOV_EXCL_END */
     }
-    pgp::mpi     mm = {};
+    pgp::mpi     mm;
     size_t       padlen = 0;
     rnp_result_t ret = RNP_ERROR_GENERIC;
     BN_CTX_start(ctx);
@@ -349,15 +349,15 @@ elgamal_decrypt_pkcs1(rnp::RNG *                rng,
         /* LCOV_EXCL_END */
     }
     /* unpad, handling skipped leftmost 0 case */
-    if (!pkcs1v15_unpad(&padlen, mm.mpi, mm.len, mm.len == key->p.len - 1)) {
+    if (!pkcs1v15_unpad(&padlen, mm.data(), mm.bytes(), mm.bytes() == key->p.bytes() - 1)) {
         RNP_LOG("Unpad failed.");
         goto done;
     }
-    *out_len = mm.len - padlen;
-    memcpy(out, &mm.mpi[padlen], *out_len);
+    *out_len = mm.bytes() - padlen;
+    memcpy(out, &mm[padlen], *out_len);
     ret = RNP_SUCCESS;
 done:
-    secure_clear(mm.mpi, PGP_MPINT_SIZE);
+    /* mm is securely cleared in destructor */
     BN_MONT_CTX_free(mctx);
     BN_CTX_free(ctx);
     bn_free(p);
@@ -86,12 +86,28 @@ class CRC24 {
 };
 
 class HashList {
+    class Workers;
+    std::unique_ptr<Workers> workers_;
+    size_t                   threads_{};
+
   public:
     std::vector<std::unique_ptr<Hash>> hashes;
 
-    void        add_alg(pgp_hash_alg_t alg);
+    HashList();
+    ~HashList();
+
+    void add_alg(pgp_hash_alg_t alg);
+    /* Returned hash is up to date with all of the data passed via add() */
     const Hash *get(pgp_hash_alg_t alg) const;
     void        add(const void *buf, size_t len);
+    /**
+     * @brief Update hashes on up to the specified number of threads, distributing hashes
+     *        between them. Data passed to add() is collected to the blocks which are shared
+     *        between the threads, number of blocks waiting to be hashed is limited so add()
+     *        would block if hashing is slower than input. 0 or 1 means that hashes are
+     *        updated on the caller's thread, as well as if there is a single hash only.
+     */
+    void set_threads(size_t threads);
 };
 
 } // namespace rnp
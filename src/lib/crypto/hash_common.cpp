@@ -30,13 +30,18 @@
 #include "utils.h"
 #include "str-utils.h"
 #include "hash_sha1cd.hpp"
+#include "hash_crc24.hpp"
 #if defined(CRYPTO_BACKEND_BOTAN)
 #include "hash_botan.hpp"
 #endif
 #if defined(CRYPTO_BACKEND_OPENSSL)
 #include "hash_ossl.hpp"
-#include "hash_crc24.hpp"
 #endif
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 static const struct hash_alg_map_t {
     pgp_hash_alg_t type;
@@ -94,6 +99,9 @@ CRC24::create()
 #if defined(CRYPTO_BACKEND_OPENSSL)
     return CRC24_RNP::create();
 #elif defined(CRYPTO_BACKEND_BOTAN)
+    if (CRC24_RNP::accelerated()) {
+        return CRC24_RNP::create();
+    }
     return CRC24_Botan::create();
 #else
 #error "Crypto backend not specified"
@@ -119,7 +127,7 @@ Hash::add(const pgp::mpi &val)
 {
     size_t len = val.bytes();
     size_t idx = 0;
-    while ((idx < len) && (!val.mpi[idx])) {
+    while ((idx < len) && (!val[idx])) {
         idx++;
     }
 
@@ -129,11 +137,11 @@ Hash::add(const pgp::mpi &val)
     }
 
     add(len - idx);
-    if (val.mpi[idx] & 0x80) {
+    if (val[idx] & 0x80) {
         uint8_t padbyte = 0;
         add(&padbyte, 1);
     }
-    add(val.mpi + idx, len - idx);
+    add(val.data() + idx, len - idx);
 }
 
 Hash::~Hash()
@@ -170,17 +178,197 @@ Hash::size(pgp_hash_alg_t alg)
     return val;
 }
 
+/* Hashes are distributed between the threads, sharing the same blocks of data */
+class HashList::Workers {
+    typedef std::shared_ptr<const std::vector<uint8_t>> Block;
+
+    struct Worker {
+        std::vector<Hash *> hashes;
+        std::deque<Block>   blocks; /* block is removed from the queue once it is hashed */
+        std::thread       thread;
+    };
+
+    static const size_t BLOCK_SIZE = 65536;
+    static const size_t MAX_BLOCKS = 16;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<uint8_t>                 block_;
+    std::mutex                           lock_;
+    std::condition_variable              queued_;
+    std::condition_variable              hashed_;
+    std::exception_ptr                   error_;
+    bool                                 stop_{};
+
+    void   run(Worker &worker);
+    void   push();
+    void   stop();
+    size_t queued() const;
+
+  public:
+    Workers(const std::vector<std::unique_ptr<Hash>> &hashes, size_t threads);
+    ~Workers();
+
+    void add(const void *buf, size_t len);
+    void sync();
+};
+
+HashList::Workers::Workers(const std::vector<std::unique_ptr<Hash>> &hashes, size_t threads)
+{
+    block_.reserve(BLOCK_SIZE);
+    threads = std::max<size_t>(std::min(threads, hashes.size()), 1);
+    try {
+        for (size_t i = 0; i < threads; i++) {
+            workers_.emplace_back(new Worker());
+        }
+        for (size_t i = 0; i < hashes.size(); i++) {
+            workers_[i % threads]->hashes.push_back(hashes[i].get());
+        }
+        for (auto &worker : workers_) {
+            worker->thread = std::thread(&Workers::run, this, std::ref(*worker));
+        }
+    } catch (...) {
+        stop();
+        throw;
+    }
+}
+
+HashList::Workers::~Workers()
+{
+    stop();
+}
+
+void
+HashList::Workers::run(Worker &worker)
+{
+    std::unique_lock<std::mutex> lock(lock_);
+    while (true) {
+        queued_.wait(lock, [&]() { return stop_ || !worker.blocks.empty(); });
+        if (stop_) {
+            return;
+        }
+        auto block = worker.blocks.front();
+        lock.unlock();
+
+        std::exception_ptr err;
+        try {
+            for (auto hash : worker.hashes) {
+                hash->add(block->data(), block->size());
+            }
+        } catch (...) {
+            err = std::current_exception(); // LCOV_EXCL_LINE
+        }
+
+        lock.lock();
+        if (err && !error_) {
+            error_ = err; // LCOV_EXCL_LINE
+        }
+        worker.blocks.pop_front();
+        hashed_.notify_all();
+    }
+}
+
+/* Must be called with the lock held */
+size_t
+HashList::Workers::queued() const
+{
+    size_t res = 0;
+    for (auto &worker : workers_) {
+        res = std::max(res, worker->blocks.size());
+    }
+    return res;
+}
+
+void
+HashList::Workers::push()
+{
+    Block block = std::make_shared<const std::vector<uint8_t>>(std::move(block_));
+    block_ = std::vector<uint8_t>();
+    block_.reserve(BLOCK_SIZE);
+
+    std::unique_lock<std::mutex> lock(lock_);
+    hashed_.wait(lock, [&]() { return queued() < MAX_BLOCKS; });
+    if (error_) {
+        std::rethrow_exception(error_); // LCOV_EXCL_LINE
+    }
+    for (auto &worker : workers_) {
+        worker->blocks.push_back(block);
+    }
+    queued_.notify_all();
+}
+
+void
+HashList::Workers::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = true;
+    }
+    queued_.notify_all();
+    for (auto &worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void
+HashList::Workers::add(const void *buf, size_t len)
+{
+    auto data = static_cast<const uint8_t *>(buf);
+    while (len) {
+        size_t chunk = std::min(len, BLOCK_SIZE - block_.size());
+        block_.insert(block_.end(), data, data + chunk);
+        data += chunk;
+        len -= chunk;
+        if (block_.size() == BLOCK_SIZE) {
+            push();
+        }
+    }
+}
+
+void
+HashList::Workers::sync()
+{
+    if (!block_.empty()) {
+        push();
+    }
+    std::unique_lock<std::mutex> lock(lock_);
+    hashed_.wait(lock, [&]() { return !queued(); });
+    if (error_) {
+        std::rethrow_exception(error_); // LCOV_EXCL_LINE
+    }
+}
+
+HashList::HashList()
+{
+}
+
+HashList::~HashList()
+{
+    /* stop threads before hashes are destroyed */
+    workers_.reset();
+}
+
 void
 HashList::add_alg(pgp_hash_alg_t alg)
 {
-    if (!get(alg)) {
-        hashes.emplace_back(rnp::Hash::create(alg));
+    if (get(alg)) {
+        return;
+    }
+    /* workers are bound to the current list of hashes, so would be restarted on next add() */
+    if (workers_) {
+        workers_->sync();
+        workers_.reset();
     }
+    hashes.emplace_back(rnp::Hash::create(alg));
 }
 
 const Hash *
 HashList::get(pgp_hash_alg_t alg) const
 {
+    if (workers_) {
+        workers_->sync();
+    }
     for (auto &hash : hashes) {
         if (hash->alg() == alg) {
             return hash.get();
@@ -192,9 +380,26 @@ HashList::get(pgp_hash_alg_t alg) const
 void
 HashList::add(const void *buf, size_t len)
 {
+    if ((threads_ > 1) && (hashes.size() > 1)) {
+        if (!workers_) {
+            workers_.reset(new Workers(hashes, threads_));
+        }
+        workers_->add(buf, len);
+        return;
+    }
     for (auto &hash : hashes) {
         hash->add(buf, len);
     }
 }
 
+void
+HashList::set_threads(size_t threads)
+{
+    if (workers_ && (threads != threads_)) {
+        workers_->sync();
+        workers_.reset();
+    }
+    threads_ = threads;
+}
+
 } // namespace rnp
@@ -28,6 +28,12 @@
 #include <stddef.h>
 #include "utils.h"
 #include "hash_crc24.hpp"
+#include "cpu-features.hpp"
+#if defined(RNP_X86_SIMD)
+#include <immintrin.h>
+#elif defined(RNP_ARM_PMULL)
+#include <arm_neon.h>
+#endif
 
 static const uint32_t T0[256] = {
   0x00000000, 0x00FB4C86, 0x000DD58A, 0x00F6990C, 0x00E1E693, 0x001AAA15, 0x00EC3319,
@@ -217,7 +223,7 @@ LOAD32LE(uint32_t &x, const uint8_t y[4])
 }
 
 static uint32_t
-crc24_update(uint32_t crc, const uint8_t *in, size_t length)
+crc24_update_tables(uint32_t crc, const uint8_t *in, size_t length)
 {
     uint32_t d0, d1, d2, d3;
 
@@ -252,6 +258,191 @@ crc24_update(uint32_t crc, const uint8_t *in, size_t length)
      (x & 0xFF000000) >> 24)
 #endif
 
+/*
+ * Folding via the carry-less multiplication, see "Fast CRC Computation for Generic
+ * Polynomials Using PCLMULQDQ Instruction" by Intel. CRC24 is processed as 32-bit CRC with
+ * polynomial P * x^8. Bits are not reflected, so input is byte-swapped to get the
+ * polynomial coefficients in order. Folding leaves 128-bit value, congruent to the whole input
+ * modulo polynomial, which is then reduced via tables.
+ */
+#define CRC24_FOLD_MIN 64
+
+/* x^N mod (P * x^8) */
+#define CRC24_K128 0x64e4d700
+#define CRC24_K192 0x2c8c9d00
+#define CRC24_K512 0x467d2400
+#define CRC24_K576 0x1f428700
+
+typedef uint32_t crc24_fold_func_t(uint32_t crc, const uint8_t *in, size_t len);
+
+#if defined(RNP_X86_SIMD)
+RNP_TARGET("pclmul,ssse3")
+static inline __m128i
+crc24_fold_pclmul(__m128i acc, __m128i k)
+{
+    __m128i lo = _mm_clmulepi64_si128(acc, k, 0x00);
+    __m128i hi = _mm_clmulepi64_si128(acc, k, 0x11);
+    return _mm_xor_si128(lo, hi);
+}
+
+/* reverse bytes of the whole 128-bit value */
+RNP_TARGET("pclmul,ssse3")
+static inline __m128i
+crc24_bswap_pclmul(__m128i val)
+{
+    const __m128i bswap = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    return _mm_shuffle_epi8(val, bswap);
+}
+
+RNP_TARGET("pclmul,ssse3")
+static inline __m128i
+crc24_load_pclmul(const uint8_t *in)
+{
+    return crc24_bswap_pclmul(_mm_loadu_si128((const __m128i *) in));
+}
+
+/* len must be a multiple of 16 and at least 16 */
+RNP_TARGET("pclmul,ssse3")
+static uint32_t
+crc24_update_pclmul(uint32_t crc, const uint8_t *in, size_t len)
+{
+    const __m128i k1 = _mm_set_epi64x(CRC24_K192, CRC24_K128);
+    const __m128i k4 = _mm_set_epi64x(CRC24_K576, CRC24_K512);
+    /* initial value goes to the top bits of the first block */
+    __m128i acc = _mm_xor_si128(crc24_load_pclmul(in), _mm_set_epi32(BSWAP32(crc), 0, 0, 0));
+    in += 16;
+    len -= 16;
+    if (len >= 48) {
+        /* 4 independent accumulators, so multiplications may be pipelined */
+        __m128i acc1 = crc24_load_pclmul(in);
+        __m128i acc2 = crc24_load_pclmul(in + 16);
+        __m128i acc3 = crc24_load_pclmul(in + 32);
+        in += 48;
+        len -= 48;
+        while (len >= 64) {
+            acc = _mm_xor_si128(crc24_fold_pclmul(acc, k4), crc24_load_pclmul(in));
+            acc1 = _mm_xor_si128(crc24_fold_pclmul(acc1, k4), crc24_load_pclmul(in + 16));
+            acc2 = _mm_xor_si128(crc24_fold_pclmul(acc2, k4), crc24_load_pclmul(in + 32));
+            acc3 = _mm_xor_si128(crc24_fold_pclmul(acc3, k4), crc24_load_pclmul(in + 48));
+            in += 64;
+            len -= 64;
+        }
+        acc = _mm_xor_si128(crc24_fold_pclmul(acc, k1), acc1);
+        acc = _mm_xor_si128(crc24_fold_pclmul(acc, k1), acc2);
+        acc = _mm_xor_si128(crc24_fold_pclmul(acc, k1), acc3);
+    }
+    while (len >= 16) {
+        acc = _mm_xor_si128(crc24_fold_pclmul(acc, k1), crc24_load_pclmul(in));
+        in += 16;
+        len -= 16;
+    }
+    /* CRC of the remainder, as if it was the whole input, with zero initial value */
+    uint8_t rem[16];
+    _mm_storeu_si128((__m128i *) rem, crc24_bswap_pclmul(acc));
+    return crc24_update_tables(0, rem, sizeof(rem));
+}
+#endif
+
+#if defined(RNP_ARM_PMULL)
+static inline uint64x2_t
+crc24_fold_pmull(uint64x2_t acc, uint64x2_t k)
+{
+    poly64_t  acc_lo = (poly64_t) vgetq_lane_u64(acc, 0);
+    poly64_t  k_lo = (poly64_t) vgetq_lane_u64(k, 0);
+    poly128_t lo = vmull_p64(acc_lo, k_lo);
+    poly128_t hi = vmull_high_p64(vreinterpretq_p64_u64(acc), vreinterpretq_p64_u64(k));
+    return veorq_u64(vreinterpretq_u64_p128(lo), vreinterpretq_u64_p128(hi));
+}
+
+/* reverse bytes of the whole 128-bit value */
+static inline uint64x2_t
+crc24_bswap_pmull(uint8x16_t val)
+{
+    uint64x2_t res = vreinterpretq_u64_u8(vrev64q_u8(val));
+    return vextq_u64(res, res, 1);
+}
+
+static inline uint64x2_t
+crc24_load_pmull(const uint8_t *in)
+{
+    return crc24_bswap_pmull(vld1q_u8(in));
+}
+
+/* len must be a multiple of 16 and at least 16 */
+static uint32_t
+crc24_update_pmull(uint32_t crc, const uint8_t *in, size_t len)
+{
+    const uint64x2_t k1 = vcombine_u64(vcreate_u64(CRC24_K128), vcreate_u64(CRC24_K192));
+    const uint64x2_t k4 = vcombine_u64(vcreate_u64(CRC24_K512), vcreate_u64(CRC24_K576));
+    /* initial value goes to the top bits of the first block */
+    uint64x2_t init = vcombine_u64(vcreate_u64(0), vcreate_u64((uint64_t) BSWAP32(crc) << 32));
+    uint64x2_t acc = veorq_u64(crc24_load_pmull(in), init);
+    in += 16;
+    len -= 16;
+    if (len >= 48) {
+        /* 4 independent accumulators, so multiplications may be pipelined */
+        uint64x2_t acc1 = crc24_load_pmull(in);
+        uint64x2_t acc2 = crc24_load_pmull(in + 16);
+        uint64x2_t acc3 = crc24_load_pmull(in + 32);
+        in += 48;
+        len -= 48;
+        while (len >= 64) {
+            acc = veorq_u64(crc24_fold_pmull(acc, k4), crc24_load_pmull(in));
+            acc1 = veorq_u64(crc24_fold_pmull(acc1, k4), crc24_load_pmull(in + 16));
+            acc2 = veorq_u64(crc24_fold_pmull(acc2, k4), crc24_load_pmull(in + 32));
+            acc3 = veorq_u64(crc24_fold_pmull(acc3, k4), crc24_load_pmull(in + 48));
+            in += 64;
+            len -= 64;
+        }
+        acc = veorq_u64(crc24_fold_pmull(acc, k1), acc1);
+        acc = veorq_u64(crc24_fold_pmull(acc, k1), acc2);
+        acc = veorq_u64(crc24_fold_pmull(acc, k1), acc3);
+    }
+    while (len >= 16) {
+        acc = veorq_u64(crc24_fold_pmull(acc, k1), crc24_load_pmull(in));
+        in += 16;
+        len -= 16;
+    }
+    /* CRC of the remainder, as if it was the whole input, with zero initial value */
+    uint8_t rem[16];
+    vst1q_u8(rem, vreinterpretq_u8_u64(crc24_bswap_pmull(vreinterpretq_u8_u64(acc))));
+    return crc24_update_tables(0, rem, sizeof(rem));
+}
+#endif
+
+static crc24_fold_func_t *
+crc24_select_fold()
+{
+#if defined(RNP_X86_SIMD)
+    if (rnp::cpu::has_pclmul() && rnp::cpu::has_ssse3()) {
+        return crc24_update_pclmul;
+    }
+#elif defined(RNP_ARM_PMULL)
+    return crc24_update_pmull;
+#endif
+    return NULL;
+}
+
+static crc24_fold_func_t *
+crc24_fold()
+{
+    static crc24_fold_func_t *const fold = crc24_select_fold();
+    return fold;
+}
+
+static uint32_t
+crc24_update(uint32_t crc, const uint8_t *in, size_t length)
+{
+    auto fold = crc24_fold();
+    if (fold && (length >= CRC24_FOLD_MIN)) {
+        size_t flen = length & ~(size_t) 15;
+        crc = fold(crc, in, flen);
+        in += flen;
+        length -= flen;
+    }
+    return crc24_update_tables(crc, in, length);
+}
+
 static uint32_t
 crc24_final(uint32_t crc)
 {
@@ -275,6 +466,12 @@ CRC24_RNP::create()
     return std::unique_ptr<CRC24_RNP>(new CRC24_RNP());
 }
 
+bool
+CRC24_RNP::accelerated()
+{
+    return crc24_fold() != NULL;
+}
+
 void
 CRC24_RNP::add(const void *buf, size_t len)
 {
@@ -38,6 +38,8 @@ class CRC24_RNP : public CRC24 {
     virtual ~CRC24_RNP();
 
     static std::unique_ptr<CRC24_RNP> create();
+    /* Whether carry-less multiplication is available on the current CPU */
+    static bool accelerated();
 
     void                   add(const void *buf, size_t len) override;
     std::array<uint8_t, 3> finish() override;
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2024 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RNP_KEY_CACHE_HPP_
+#define RNP_KEY_CACHE_HPP_
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace rnp {
+/* Cache of the backend key objects (EVP_PKEY, botan_pubkey_t, etc) created from the key
+ * material. Loading of such object may be expensive (i.e. RSA CRT parameters calculation),
+ * so it is done once and reused by subsequent operations. Objects are type-erased and are
+ * destroyed by the deleter, passed by the backend. Cache is never copied along with the key
+ * material, and must be reset by the owner whenever the material changes. */
+class KeyCache {
+    std::mutex            lock_;
+    std::shared_ptr<void> pub_;
+    std::shared_ptr<void> sec_;
+
+  public:
+    KeyCache() = default;
+    KeyCache(const KeyCache &) : KeyCache(){};
+    KeyCache &
+    operator=(const KeyCache &src)
+    {
+        if (this != &src) {
+            clear();
+        }
+        return *this;
+    }
+
+    /* Get the cached object or create it via the loader() call, which must return
+     * std::shared_ptr<T>. Returned pointer stays valid even if cache is reset meanwhile. */
+    template <typename T, typename F>
+    std::shared_ptr<T>
+    get(bool secret, F loader)
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        auto &                      slot = secret ? sec_ : pub_;
+        if (!slot) {
+            slot = loader();
+        }
+        return std::static_pointer_cast<T>(slot);
+    }
+
+    /* Same as get(), but allows cache to be NULL, loading object each time then */
+    template <typename T, typename F>
+    static std::shared_ptr<T>
+    load(KeyCache *cache, bool secret, F loader)
+    {
+        return cache ? cache->get<T>(secret, loader) : loader();
+    }
+
+    bool
+    empty() noexcept
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        return !pub_ && !sec_;
+    }
+
+    void
+    clear_secret() noexcept
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        sec_.reset();
+    }
+
+    void
+    clear() noexcept
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        sec_.reset();
+        pub_.reset();
+    }
+};
+
+/* Mutex which serializes lazy validation of the key material, so concurrent operations with
+ * the same key do validation once. As the caches, it is never copied along with the key
+ * material. */
+class ValidityLock : public std::mutex {
+  public:
+    ValidityLock() = default;
+    ValidityLock(const ValidityLock &) : std::mutex(){};
+    ValidityLock &
+    operator=(const ValidityLock &)
+    {
+        return *this;
+    }
+};
+
+/* Lazily created backend operation object (verifier, KEM encryptor, etc), which is expensive
+ * to construct but keeps state between calls, so may be used by one thread at a time. If
+ * cached object is busy then temporary one is created instead of waiting. Object may refer
+ * to the key, so it must be declared after the corresponding KeyCache. */
+template <typename T> class OpCache {
+    std::mutex         lock_;
+    std::unique_ptr<T> op_;
+
+  public:
+    OpCache() = default;
+    OpCache(const OpCache &) : OpCache(){};
+    OpCache &
+    operator=(const OpCache &src)
+    {
+        if (this != &src) {
+            clear();
+        }
+        return *this;
+    }
+
+    /* Call func(T &) on the cached object, creating it via create() which must return
+     * std::unique_ptr<T>. Object is dropped if func() throws, as its state is unknown. */
+    template <typename C, typename F>
+    auto
+    use(C create, F func) -> decltype(func(std::declval<T &>()))
+    {
+        std::unique_lock<std::mutex> guard(lock_, std::try_to_lock);
+        if (!guard.owns_lock()) {
+            auto tmp = create();
+            return func(*tmp);
+        }
+        if (!op_) {
+            op_ = create();
+        }
+        try {
+            return func(*op_);
+        } catch (...) {
+            op_.reset();
+            throw;
+        }
+    }
+
+    void
+    clear() noexcept
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        op_.reset();
+    }
+};
+} // namespace rnp
+
+#endif
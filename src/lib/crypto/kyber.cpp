@@ -73,19 +73,22 @@ kyber_generate_keypair(rnp::RNG *rng, kyber_parameter_e kyber_param)
                                                   kyber_param));
 }
 
-Botan::Kyber_PublicKey
+std::shared_ptr<Botan::Kyber_PublicKey>
 pgp_kyber_public_key_t::botan_key() const
 {
-    return Botan::Kyber_PublicKey(key_encoded_,
-                                  rnp_kyber_param_to_botan_kyber_mode(kyber_mode_));
+    return cache_.get<Botan::Kyber_PublicKey>(false, [this]() {
+        return std::make_shared<Botan::Kyber_PublicKey>(
+          key_encoded_, rnp_kyber_param_to_botan_kyber_mode(kyber_mode_));
+    });
 }
 
-Botan::Kyber_PrivateKey
+std::shared_ptr<Botan::Kyber_PrivateKey>
 pgp_kyber_private_key_t::botan_key() const
 {
-    Botan::secure_vector<uint8_t> key_sv(key_encoded_.data(),
-                                         key_encoded_.data() + key_encoded_.size());
-    return Botan::Kyber_PrivateKey(key_sv, rnp_kyber_param_to_botan_kyber_mode(kyber_mode_));
+    return cache_.get<Botan::Kyber_PrivateKey>(true, [this]() {
+        return std::make_shared<Botan::Kyber_PrivateKey>(
+          key_encoded_, rnp_kyber_param_to_botan_kyber_mode(kyber_mode_));
+    });
 }
 
 kyber_encap_result_t
@@ -94,14 +97,20 @@ pgp_kyber_public_key_t::encapsulate(rnp::RNG *rng) const
     assert(is_initialized_);
     auto decoded_kyber_pub = botan_key();
 
-    Botan::PK_KEM_Encryptor       kem_enc(decoded_kyber_pub, "Raw", "base");
     Botan::secure_vector<uint8_t> encap_key;           // this has to go over the wire
     Botan::secure_vector<uint8_t> data_encryption_key; // this is the key used for
     // encryption of the payload data
-    kem_enc.encrypt(encap_key,
-                    data_encryption_key,
-                    *rng->obj(),
-                    key_share_size_from_kyber_param(kyber_mode_));
+    encryptor_.use(
+      [&decoded_kyber_pub]() {
+          return std::unique_ptr<Botan::PK_KEM_Encryptor>(
+            new Botan::PK_KEM_Encryptor(*decoded_kyber_pub, "Raw", "base"));
+      },
+      [&](Botan::PK_KEM_Encryptor &kem_enc) {
+          kem_enc.encrypt(encap_key,
+                          data_encryption_key,
+                          *rng->obj(),
+                          key_share_size_from_kyber_param(kyber_mode_));
+      });
     kyber_encap_result_t result;
     result.ciphertext.insert(
       result.ciphertext.end(), encap_key.data(), encap_key.data() + encap_key.size());
@@ -118,7 +127,7 @@ pgp_kyber_private_key_t::decapsulate(rnp::RNG *     rng,
 {
     assert(is_initialized_);
     auto                          decoded_kyber_priv = botan_key();
-    Botan::PK_KEM_Decryptor       kem_dec(decoded_kyber_priv, *rng->obj(), "Raw", "base");
+    Botan::PK_KEM_Decryptor       kem_dec(*decoded_kyber_priv, *rng->obj(), "Raw", "base");
     Botan::secure_vector<uint8_t> dec_shared_key = kem_dec.decrypt(
       ciphertext, ciphertext_len, key_share_size_from_kyber_param(kyber_mode_));
     return std::vector<uint8_t>(dec_shared_key.data(),
@@ -133,7 +142,7 @@ pgp_kyber_public_key_t::is_valid(rnp::RNG *rng) const
     }
 
     auto key = botan_key();
-    return key.check_key(*(rng->obj()), false);
+    return key->check_key(*(rng->obj()), false);
 }
 
 bool
@@ -144,5 +153,5 @@ pgp_kyber_private_key_t::is_valid(rnp::RNG *rng) const
     }
 
     auto key = botan_key();
-    return key.check_key(*(rng->obj()), false);
+    return key->check_key(*(rng->obj()), false);
 }
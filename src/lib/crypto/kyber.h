@@ -32,6 +32,7 @@
 #include <vector>
 #include <repgp/repgp_def.h>
 #include "crypto/rng.h"
+#include "crypto/key_cache.hpp"
 #include <botan/kyber.h>
 #include <botan/pubkey.h>
 
@@ -68,11 +69,12 @@ class pgp_kyber_private_key_t {
     }
 
   private:
-    Botan::Kyber_PrivateKey botan_key() const;
+    std::shared_ptr<Botan::Kyber_PrivateKey> botan_key() const;
 
     Botan::secure_vector<uint8_t> key_encoded_;
     kyber_parameter_e             kyber_mode_;
     bool                          is_initialized_ = false;
+    mutable rnp::KeyCache         cache_;
 };
 
 class pgp_kyber_public_key_t {
@@ -99,11 +101,13 @@ class pgp_kyber_public_key_t {
     };
 
   private:
-    Botan::Kyber_PublicKey botan_key() const;
+    std::shared_ptr<Botan::Kyber_PublicKey> botan_key() const;
 
-    std::vector<uint8_t> key_encoded_;
-    kyber_parameter_e    kyber_mode_;
-    bool                 is_initialized_ = false;
+    std::vector<uint8_t>                          key_encoded_;
+    kyber_parameter_e                             kyber_mode_;
+    bool                                          is_initialized_ = false;
+    mutable rnp::KeyCache                         cache_;
+    mutable rnp::OpCache<Botan::PK_KEM_Encryptor> encryptor_;
 };
 
 std::pair<pgp_kyber_public_key_t, pgp_kyber_private_key_t> kyber_generate_keypair(
@@ -24,26 +24,124 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+
 #include <string.h>
 #include <stdlib.h>
+#include <algorithm>
 #include "mpi.h"
 #include "mem.h"
+#include "types.h"
 #include "utils.h"
 
 namespace pgp {
 
+mpi::mpi(const mpi &src) : mpi()
+{
+    resize(src.len_);
+    memcpy(data(), src.data(), len_);
+}
+
+mpi::mpi(mpi &&src) noexcept : mpi()
+{
+    *this = std::move(src);
+}
+
+mpi &
+mpi::operator=(const mpi &src)
+{
+    if (&src == this) {
+        return *this;
+    }
+    forget();
+    resize(src.len_);
+    memcpy(data(), src.data(), len_);
+    return *this;
+}
+
+mpi &
+mpi::operator=(mpi &&src) noexcept
+{
+    if (&src == this) {
+        return *this;
+    }
+    forget();
+    if (src.on_heap()) {
+        heap_ = src.heap_;
+    } else {
+        memcpy(inline_, src.inline_, src.len_);
+        secure_clear(src.inline_, src.len_);
+    }
+    len_ = src.len_;
+    src.len_ = 0;
+    return *this;
+}
+
+mpi::~mpi()
+{
+    release();
+}
+
+void
+mpi::release() noexcept
+{
+    if (on_heap()) {
+        secure_clear(heap_, len_);
+        delete[] heap_;
+        heap_ = nullptr;
+    } else {
+        secure_clear(inline_, sizeof(inline_));
+    }
+}
+
+void
+mpi::resize(size_t len)
+{
+    if (len > PGP_MPINT_SIZE) {
+        RNP_LOG("Too large mpi: %zu", len);
+        throw rnp::rnp_exception(RNP_ERROR_BAD_PARAMETERS);
+    }
+    if (len == len_) {
+        return;
+    }
+    if ((len <= INLINE_SIZE) && !on_heap()) {
+        /* both old and new values are inline */
+        if (len > len_) {
+            memset(inline_ + len_, 0, len - len_);
+        } else {
+            secure_clear(inline_ + len, len_ - len);
+        }
+        len_ = len;
+        return;
+    }
+    if (len <= INLINE_SIZE) {
+        /* move value from the heap back to the inline storage */
+        uint8_t *old = heap_;
+        memcpy(inline_, old, len);
+        secure_clear(old, len_);
+        delete[] old;
+        len_ = len;
+        return;
+    }
+    uint8_t *buf = new uint8_t[len]();
+    memcpy(buf, data(), std::min(len, len_));
+    release();
+    heap_ = buf;
+    len_ = len;
+}
+
 size_t
 mpi::bits() const noexcept
 {
-    size_t  bits = 0;
-    size_t  idx = 0;
-    uint8_t bt;
+    size_t         bits = 0;
+    size_t         idx = 0;
+    uint8_t        bt;
+    const uint8_t *mpi = data();
 
-    for (idx = 0; (idx < len) && !mpi[idx]; idx++)
+    for (idx = 0; (idx < len_) && !mpi[idx]; idx++)
         ;
 
-    if (idx < len) {
-        for (bits = (len - idx - 1) << 3, bt = mpi[idx]; bt; bits++, bt = bt >> 1)
+    if (idx < len_) {
+        for (bits = (len_ - idx - 1) << 3, bt = mpi[idx]; bt; bits++, bt = bt >> 1)
             ;
     }
 
@@ -53,48 +151,55 @@ mpi::bits() const noexcept
 size_t
 mpi::bytes() const noexcept
 {
-    return len;
+    return len_;
 }
 
 bool
 mpi::from_mem(const void *mem, size_t mlen) noexcept
 {
-    if (mlen > sizeof(mpi)) {
+    if (mlen > PGP_MPINT_SIZE) {
         return false;
     }
 
-    memcpy(mpi, mem, mlen);
-    len = mlen;
+    try {
+        resize(mlen);
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what()); // LCOV_EXCL_LINE
+        return false;            // LCOV_EXCL_LINE
+    }
+    memcpy(data(), mem, mlen);
     return true;
 }
 
 void
 mpi::to_mem(void *mem) const noexcept
 {
-    memcpy(mem, mpi, len);
+    memcpy(mem, data(), len_);
 }
 
 bool
-mpi::operator==(const struct mpi &src) const
+mpi::operator==(const mpi &src) const
 {
-    size_t idx1 = 0;
-    size_t idx2 = 0;
+    size_t         idx1 = 0;
+    size_t         idx2 = 0;
+    const uint8_t *mpi1 = data();
+    const uint8_t *mpi2 = src.data();
 
-    for (idx1 = 0; (idx1 < this->len) && !this->mpi[idx1]; idx1++)
+    for (idx1 = 0; (idx1 < len_) && !mpi1[idx1]; idx1++)
         ;
 
-    for (idx2 = 0; (idx2 < src.len) && !src.mpi[idx2]; idx2++)
+    for (idx2 = 0; (idx2 < src.len_) && !mpi2[idx2]; idx2++)
         ;
 
-    return ((this->len - idx1) == (src.len - idx2) &&
-            !memcmp(this->mpi + idx1, src.mpi + idx2, this->len - idx1));
+    return ((len_ - idx1) == (src.len_ - idx2) &&
+            !memcmp(mpi1 + idx1, mpi2 + idx2, len_ - idx1));
 }
 
 void
 mpi::forget() noexcept
 {
-    secure_clear(mpi, sizeof(mpi));
-    len = 0;
+    release();
+    len_ = 0;
 }
 
 } // namespace pgp
@@ -35,22 +35,79 @@
 #define PGP_MPINT_BITS (16384)
 #define PGP_MPINT_SIZE (PGP_MPINT_BITS >> 3)
 
-/** multi-precision integer, used in signatures and public/secret keys */
 namespace pgp {
 
-typedef struct mpi {
-    /* Change this to vector once opaqueness is not required anymore */
-    uint8_t mpi[PGP_MPINT_SIZE];
-    size_t  len;
+/**
+ * @brief Multi-precision integer, used in signatures and public/secret keys.
+ *        Value is stored inline if it fits (i.e. EC points up to 521 bits and scalars), and
+ *        on the heap otherwise, taking exactly the needed amount of memory. Storage is
+ *        always securely cleared when it is released, since value may be a secret one.
+ */
+class mpi {
+  public:
+    /* Enough to hold uncompressed point of 256-bit curve, any 25519/448 point or scalar. */
+    static const size_t INLINE_SIZE = 72;
+
+  private:
+    size_t len_;
+    union {
+        uint8_t  inline_[INLINE_SIZE];
+        uint8_t *heap_;
+    };
+
+    bool
+    on_heap() const noexcept
+    {
+        return len_ > INLINE_SIZE;
+    }
+    void release() noexcept;
+
+  public:
+    mpi() noexcept : len_(0), inline_{} {};
+    mpi(const mpi &src);
+    mpi(mpi &&src) noexcept;
+    mpi &operator=(const mpi &src);
+    mpi &operator=(mpi &&src) noexcept;
+    ~mpi();
+
+    bool operator==(const mpi &src) const;
+
+    uint8_t *
+    data() noexcept
+    {
+        return on_heap() ? heap_ : inline_;
+    }
+
+    const uint8_t *
+    data() const noexcept
+    {
+        return on_heap() ? heap_ : inline_;
+    }
+
+    uint8_t &
+    operator[](size_t idx) noexcept
+    {
+        return data()[idx];
+    }
+
+    const uint8_t &
+    operator[](size_t idx) const noexcept
+    {
+        return data()[idx];
+    }
 
-    bool operator==(const struct mpi &src) const;
+    /**
+     * @brief Change length of the value, preserving the contents. New bytes are zeroed,
+     *        dropped ones are securely cleared. Throws if len exceeds PGP_MPINT_SIZE.
+     */
+    void resize(size_t len);
 
     bool   from_mem(const void *mem, size_t len) noexcept;
     void   to_mem(void *mem) const noexcept;
     size_t bits() const noexcept;
     size_t bytes() const noexcept;
     void   forget() noexcept;
-} mpi;
+};
 
 } // namespace pgp
 
@@ -32,7 +32,9 @@
 namespace rnp {
 RNG::RNG(Type type)
 {
-    if (botan_rng_init(&botan_rng, type == Type::DRBG ? "user" : NULL)) {
+    /* RNG is shared by all of the operations on the same FFI object, which may run
+     * concurrently, so serialized variant of the DRBG is used */
+    if (botan_rng_init(&botan_rng, type == Type::DRBG ? "user-threadsafe" : NULL)) {
         throw rnp::rnp_exception(RNP_ERROR_RNG);
     }
 #if defined(ENABLE_CRYPTO_REFRESH) || defined(ENABLE_PQC)
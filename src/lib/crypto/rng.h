@@ -60,7 +60,7 @@ class RNG {
      * @param type indicates which random generator to initialize.
      *             Possible values for Botan backend:
      *             - DRBG will initialize HMAC_DRBG, this generator is initialized on-demand
-     *               (when used for the first time)
+     *               (when used for the first time) and may be used from different threads
      *             - SYSTEM will initialize /dev/(u)random
      */
     RNG(Type type = Type::DRBG);
@@ -191,35 +191,62 @@ done:
     return res;
 }
 
+static std::shared_ptr<botan_pubkey_struct>
+rsa_get_public_key(const pgp_rsa_key_t *key, rnp::KeyCache *cache)
+{
+    return rnp::KeyCache::load<botan_pubkey_struct>(cache, false, [key]() {
+        botan_pubkey_t bkey = NULL;
+        if (!rsa_load_public_key(&bkey, key)) {
+            return std::shared_ptr<botan_pubkey_struct>();
+        }
+        return std::shared_ptr<botan_pubkey_struct>(bkey, botan_pubkey_destroy);
+    });
+}
+
+static std::shared_ptr<botan_privkey_struct>
+rsa_get_secret_key(const pgp_rsa_key_t *key, rnp::KeyCache *cache)
+{
+    return rnp::KeyCache::load<botan_privkey_struct>(cache, true, [key]() {
+        botan_privkey_t bkey = NULL;
+        if (!rsa_load_secret_key(&bkey, key)) {
+            return std::shared_ptr<botan_privkey_struct>();
+        }
+        return std::shared_ptr<botan_privkey_struct>(bkey, botan_privkey_destroy);
+    });
+}
+
 rnp_result_t
 rsa_encrypt_pkcs1(rnp::RNG *           rng,
                   pgp_rsa_encrypted_t *out,
                   const uint8_t *      in,
                   size_t               in_len,
-                  const pgp_rsa_key_t *key)
+                  const pgp_rsa_key_t *key,
+                  rnp::KeyCache *      cache)
 {
     rnp_result_t          ret = RNP_ERROR_GENERIC;
-    botan_pubkey_t        rsa_key = NULL;
     botan_pk_op_encrypt_t enc_op = NULL;
+    auto                  rsa_key = rsa_get_public_key(key, cache);
 
-    if (!rsa_load_public_key(&rsa_key, key)) {
+    if (!rsa_key) {
         RNP_LOG("failed to load key");
         return RNP_ERROR_OUT_OF_MEMORY;
     }
 
-    if (botan_pk_op_encrypt_create(&enc_op, rsa_key, "PKCS1v15", 0) != 0) {
+    if (botan_pk_op_encrypt_create(&enc_op, rsa_key.get(), "PKCS1v15", 0) != 0) {
         goto done;
     }
 
-    out->m.len = sizeof(out->m.mpi);
-    if (botan_pk_op_encrypt(enc_op, rng->handle(), out->m.mpi, &out->m.len, in, in_len)) {
-        out->m.len = 0;
+    size_t mlen;
+    mlen = PGP_MPINT_SIZE;
+    out->m.resize(mlen);
+    if (botan_pk_op_encrypt(enc_op, rng->handle(), out->m.data(), &mlen, in, in_len)) {
+        out->m.forget();
         goto done;
     }
+    out->m.resize(mlen);
     ret = RNP_SUCCESS;
 done:
     botan_pk_op_encrypt_destroy(enc_op);
-    botan_pubkey_destroy(rsa_key);
     return ret;
 }
 
@@ -228,14 +255,15 @@ rsa_verify_pkcs1(const pgp_rsa_signature_t *sig,
                  pgp_hash_alg_t             hash_alg,
                  const uint8_t *            hash,
                  size_t                     hash_len,
-                 const pgp_rsa_key_t *      key)
+                 const pgp_rsa_key_t *      key,
+                 rnp::KeyCache *            cache)
 {
     char                 padding_name[64] = {0};
-    botan_pubkey_t       rsa_key = NULL;
     botan_pk_op_verify_t verify_op = NULL;
     rnp_result_t         ret = RNP_ERROR_SIGNATURE_INVALID;
+    auto                 rsa_key = rsa_get_public_key(key, cache);
 
-    if (!rsa_load_public_key(&rsa_key, key)) {
+    if (!rsa_key) {
         RNP_LOG("failed to load key");
         return RNP_ERROR_OUT_OF_MEMORY;
     }
@@ -245,7 +273,7 @@ rsa_verify_pkcs1(const pgp_rsa_signature_t *sig,
              "EMSA-PKCS1-v1_5(Raw,%s)",
              rnp::Hash_Botan::name_backend(hash_alg));
 
-    if (botan_pk_op_verify_create(&verify_op, rsa_key, padding_name, 0) != 0) {
+    if (botan_pk_op_verify_create(&verify_op, rsa_key.get(), padding_name, 0) != 0) {
         goto done;
     }
 
@@ -253,14 +281,13 @@ rsa_verify_pkcs1(const pgp_rsa_signature_t *sig,
         goto done;
     }
 
-    if (botan_pk_op_verify_finish(verify_op, sig->s.mpi, sig->s.len) != 0) {
+    if (botan_pk_op_verify_finish(verify_op, sig->s.data(), sig->s.bytes()) != 0) {
         goto done;
     }
 
     ret = RNP_SUCCESS;
 done:
     botan_pk_op_verify_destroy(verify_op);
-    botan_pubkey_destroy(rsa_key);
     return ret;
 }
 
@@ -270,15 +297,16 @@ rsa_sign_pkcs1(rnp::RNG *           rng,
                pgp_hash_alg_t       hash_alg,
                const uint8_t *      hash,
                size_t               hash_len,
-               const pgp_rsa_key_t *key)
+               const pgp_rsa_key_t *key,
+               rnp::KeyCache *      cache)
 {
     if (!key->q.bytes()) {
         RNP_LOG("private key not set");
         return RNP_ERROR_GENERIC;
     }
 
-    botan_privkey_t rsa_key;
-    if (!rsa_load_secret_key(&rsa_key, key)) {
+    auto rsa_key = rsa_get_secret_key(key, cache);
+    if (!rsa_key) {
         RNP_LOG("failed to load key");
         return RNP_ERROR_OUT_OF_MEMORY;
     }
@@ -291,7 +319,7 @@ rsa_sign_pkcs1(rnp::RNG *           rng,
 
     rnp_result_t       ret = RNP_ERROR_GENERIC;
     botan_pk_op_sign_t sign_op;
-    if (botan_pk_op_sign_create(&sign_op, rsa_key, padding_name, 0) != 0) {
+    if (botan_pk_op_sign_create(&sign_op, rsa_key.get(), padding_name, 0) != 0) {
         goto done;
     }
 
@@ -299,15 +327,18 @@ rsa_sign_pkcs1(rnp::RNG *           rng,
         goto done;
     }
 
-    sig->s.len = sizeof(sig->s.mpi);
-    if (botan_pk_op_sign_finish(sign_op, rng->handle(), sig->s.mpi, &sig->s.len)) {
+    size_t slen;
+    slen = PGP_MPINT_SIZE;
+    sig->s.resize(slen);
+    if (botan_pk_op_sign_finish(sign_op, rng->handle(), sig->s.data(), &slen)) {
+        sig->s.forget();
         goto done;
     }
+    sig->s.resize(slen);
 
     ret = RNP_SUCCESS;
 done:
     botan_pk_op_sign_destroy(sign_op);
-    botan_privkey_destroy(rsa_key);
     return ret;
 }
 
@@ -316,15 +347,16 @@ rsa_decrypt_pkcs1(rnp::RNG *                 rng,
                   uint8_t *                  out,
                   size_t *                   out_len,
                   const pgp_rsa_encrypted_t *in,
-                  const pgp_rsa_key_t *      key)
+                  const pgp_rsa_key_t *      key,
+                  rnp::KeyCache *            cache)
 {
     if (!key->q.bytes()) {
         RNP_LOG("private key not set");
         return RNP_ERROR_GENERIC;
     }
 
-    botan_privkey_t rsa_key = NULL;
-    if (!rsa_load_secret_key(&rsa_key, key)) {
+    auto rsa_key = rsa_get_secret_key(key, cache);
+    if (!rsa_key) {
         RNP_LOG("failed to load key");
         return RNP_ERROR_OUT_OF_MEMORY;
     }
@@ -332,20 +364,19 @@ rsa_decrypt_pkcs1(rnp::RNG *                 rng,
     size_t                skip = 0;
     botan_pk_op_decrypt_t decrypt_op = NULL;
     rnp_result_t          ret = RNP_ERROR_GENERIC;
-    if (botan_pk_op_decrypt_create(&decrypt_op, rsa_key, "PKCS1v15", 0)) {
+    if (botan_pk_op_decrypt_create(&decrypt_op, rsa_key.get(), "PKCS1v15", 0)) {
         goto done;
     }
-    /* Skip trailing zeroes if any as Botan3 doesn't like m.len > e.len */
-    while ((in->m.len - skip > key->e.len) && !in->m.mpi[skip]) {
+    /* Skip trailing zeroes if any as Botan3 doesn't like m length > e length */
+    while ((in->m.bytes() - skip > key->e.bytes()) && !in->m[skip]) {
         skip++;
     }
     *out_len = PGP_MPINT_SIZE;
-    if (botan_pk_op_decrypt(decrypt_op, out, out_len, in->m.mpi + skip, in->m.len - skip)) {
+    if (botan_pk_op_decrypt(decrypt_op, out, out_len, in->m.data() + skip, in->m.bytes() - skip)) {
         goto done;
     }
     ret = RNP_SUCCESS;
 done:
-    botan_privkey_destroy(rsa_key);
     botan_pk_op_decrypt_destroy(decrypt_op);
     return ret;
 }
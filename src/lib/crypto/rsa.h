@@ -35,6 +35,7 @@
 #include <repgp/repgp_def.h>
 #include "crypto/rng.h"
 #include "crypto/mpi.h"
+#include "crypto/key_cache.hpp"
 
 typedef struct pgp_rsa_key_t {
     pgp::mpi n;
@@ -80,25 +81,29 @@ rnp_result_t rsa_encrypt_pkcs1(rnp::RNG *           rng,
                                pgp_rsa_encrypted_t *out,
                                const uint8_t *      in,
                                size_t               in_len,
-                               const pgp_rsa_key_t *key);
+                               const pgp_rsa_key_t *key,
+                               rnp::KeyCache *      cache = NULL);
 
 rnp_result_t rsa_decrypt_pkcs1(rnp::RNG *                 rng,
                                uint8_t *                  out,
                                size_t *                   out_len,
                                const pgp_rsa_encrypted_t *in,
-                               const pgp_rsa_key_t *      key);
+                               const pgp_rsa_key_t *      key,
+                               rnp::KeyCache *            cache = NULL);
 
 rnp_result_t rsa_verify_pkcs1(const pgp_rsa_signature_t *sig,
                               pgp_hash_alg_t             hash_alg,
                               const uint8_t *            hash,
                               size_t                     hash_len,
-                              const pgp_rsa_key_t *      key);
+                              const pgp_rsa_key_t *      key,
+                              rnp::KeyCache *            cache = NULL);
 
 rnp_result_t rsa_sign_pkcs1(rnp::RNG *           rng,
                             pgp_rsa_signature_t *sig,
                             pgp_hash_alg_t       hash_alg,
                             const uint8_t *      hash,
                             size_t               hash_len,
-                            const pgp_rsa_key_t *key);
+                            const pgp_rsa_key_t *key,
+                            rnp::KeyCache *      cache = NULL);
 
 #endif
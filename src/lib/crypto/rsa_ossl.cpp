@@ -114,8 +114,8 @@ rsa_load_secret_key(const pgp_rsa_key_t *key)
     return rsa;
 }
 
-static EVP_PKEY_CTX *
-rsa_init_context(const pgp_rsa_key_t *key, bool secret)
+static EVP_PKEY *
+rsa_load_key(const pgp_rsa_key_t *key, bool secret)
 {
     EVP_PKEY *evpkey = EVP_PKEY_new();
     if (!evpkey) {
@@ -124,25 +124,20 @@ rsa_init_context(const pgp_rsa_key_t *key, bool secret)
         return NULL;
         /* LCOV_EXCL_END */
     }
-    EVP_PKEY_CTX *ctx = NULL;
-    RSA *         rsakey = secret ? rsa_load_secret_key(key) : rsa_load_public_key(key);
+    RSA *rsakey = secret ? rsa_load_secret_key(key) : rsa_load_public_key(key);
     if (!rsakey) {
-        goto done;
+        EVP_PKEY_free(evpkey);
+        return NULL;
     }
     if (EVP_PKEY_set1_RSA(evpkey, rsakey) <= 0) {
         /* LCOV_EXCL_START */
         RNP_LOG("Failed to set key: %lu", ERR_peek_last_error());
-        goto done;
+        EVP_PKEY_free(evpkey);
+        evpkey = NULL;
         /* LCOV_EXCL_END */
     }
-    ctx = EVP_PKEY_CTX_new(evpkey, NULL);
-    if (!ctx) {
-        RNP_LOG("Context allocation failed: %lu", ERR_peek_last_error()); // LCOV_EXCL_LINE
-    }
-done:
     RSA_free(rsakey);
-    EVP_PKEY_free(evpkey);
-    return ctx;
+    return evpkey;
 }
 #else
 static OSSL_PARAM *
@@ -254,22 +249,24 @@ done:
     OSSL_PARAM_free(params);
     return res;
 }
+#endif
 
 static EVP_PKEY_CTX *
-rsa_init_context(const pgp_rsa_key_t *key, bool secret)
+rsa_init_context(const pgp_rsa_key_t *key, bool secret, rnp::KeyCache *cache = NULL)
 {
-    EVP_PKEY *pkey = rsa_load_key(key, secret);
+    auto pkey = rnp::KeyCache::load<EVP_PKEY>(cache, secret, [key, secret]() {
+        return std::shared_ptr<EVP_PKEY>(rsa_load_key(key, secret), EVP_PKEY_free);
+    });
     if (!pkey) {
         return NULL;
     }
-    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(pkey, NULL);
+    /* Context keeps own reference to the key so it may be dropped from the cache meanwhile */
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(pkey.get(), NULL);
     if (!ctx) {
         RNP_LOG("Context allocation failed: %s", ossl_latest_err()); // LCOV_EXCL_LINE
     }
-    EVP_PKEY_free(pkey);
     return ctx;
 }
-#endif
 
 rnp_result_t
 rsa_validate_key(rnp::RNG *rng, const pgp_rsa_key_t *key, bool secret)
@@ -370,10 +367,11 @@ rsa_encrypt_pkcs1(rnp::RNG *           rng,
                   pgp_rsa_encrypted_t *out,
                   const uint8_t *      in,
                   size_t               in_len,
-                  const pgp_rsa_key_t *key)
+                  const pgp_rsa_key_t *key,
+                  rnp::KeyCache *      cache)
 {
     rnp_result_t  ret = RNP_ERROR_GENERIC;
-    EVP_PKEY_CTX *ctx = rsa_init_context(key, false);
+    EVP_PKEY_CTX *ctx = rsa_init_context(key, false, cache);
     if (!ctx) {
         return ret;
     }
@@ -384,12 +382,15 @@ rsa_encrypt_pkcs1(rnp::RNG *           rng,
     if (!rsa_setup_context(ctx)) {
         goto done;
     }
-    out->m.len = sizeof(out->m.mpi);
-    if (EVP_PKEY_encrypt(ctx, out->m.mpi, &out->m.len, in, in_len) <= 0) {
+    size_t mlen;
+    mlen = PGP_MPINT_SIZE;
+    out->m.resize(mlen);
+    if (EVP_PKEY_encrypt(ctx, out->m.data(), &mlen, in, in_len) <= 0) {
         RNP_LOG("Encryption failed: %lu", ERR_peek_last_error());
-        out->m.len = 0;
+        out->m.forget();
         goto done;
     }
+    out->m.resize(mlen);
     ret = RNP_SUCCESS;
 done:
     EVP_PKEY_CTX_free(ctx);
@@ -401,10 +402,11 @@ rsa_verify_pkcs1(const pgp_rsa_signature_t *sig,
                  pgp_hash_alg_t             hash_alg,
                  const uint8_t *            hash,
                  size_t                     hash_len,
-                 const pgp_rsa_key_t *      key)
+                 const pgp_rsa_key_t *      key,
+                 rnp::KeyCache *            cache)
 {
     rnp_result_t  ret = RNP_ERROR_SIGNATURE_INVALID;
-    EVP_PKEY_CTX *ctx = rsa_init_context(key, false);
+    EVP_PKEY_CTX *ctx = rsa_init_context(key, false, cache);
     if (!ctx) {
         return ret;
     }
@@ -430,16 +432,15 @@ rsa_verify_pkcs1(const pgp_rsa_signature_t *sig,
         hash_len += hash_enc_size;
     }
     int res;
-    if (sig->s.len < key->n.len) {
+    if (sig->s.bytes() < key->n.bytes()) {
         /* OpenSSL doesn't like signatures smaller then N */
         pgp::mpi sn;
-        sn.len = key->n.len;
-        size_t diff = key->n.len - sig->s.len;
-        memset(sn.mpi, 0, diff);
-        memcpy(&sn.mpi[diff], sig->s.mpi, sig->s.len);
-        res = EVP_PKEY_verify(ctx, sn.mpi, sn.len, hash, hash_len);
+        sn.resize(key->n.bytes());
+        size_t diff = key->n.bytes() - sig->s.bytes();
+        memcpy(&sn[diff], sig->s.data(), sig->s.bytes());
+        res = EVP_PKEY_verify(ctx, sn.data(), sn.bytes(), hash, hash_len);
     } else {
-        res = EVP_PKEY_verify(ctx, sig->s.mpi, sig->s.len, hash, hash_len);
+        res = EVP_PKEY_verify(ctx, sig->s.data(), sig->s.bytes(), hash, hash_len);
     }
     if (res > 0) {
         ret = RNP_SUCCESS;
@@ -457,14 +458,15 @@ rsa_sign_pkcs1(rnp::RNG *           rng,
                pgp_hash_alg_t       hash_alg,
                const uint8_t *      hash,
                size_t               hash_len,
-               const pgp_rsa_key_t *key)
+               const pgp_rsa_key_t *key,
+               rnp::KeyCache *      cache)
 {
     rnp_result_t ret = RNP_ERROR_GENERIC;
     if (!key->q.bytes()) {
         RNP_LOG("private key not set");
         return ret;
     }
-    EVP_PKEY_CTX *ctx = rsa_init_context(key, true);
+    EVP_PKEY_CTX *ctx = rsa_init_context(key, true, cache);
     if (!ctx) {
         return ret;
     }
@@ -488,12 +490,15 @@ rsa_sign_pkcs1(rnp::RNG *           rng,
         hash = hash_enc_buf;
         hash_len += hash_enc_size;
     }
-    sig->s.len = PGP_MPINT_SIZE;
-    if (EVP_PKEY_sign(ctx, sig->s.mpi, &sig->s.len, hash, hash_len) <= 0) {
+    size_t slen;
+    slen = PGP_MPINT_SIZE;
+    sig->s.resize(slen);
+    if (EVP_PKEY_sign(ctx, sig->s.data(), &slen, hash, hash_len) <= 0) {
         RNP_LOG("Encryption failed: %lu", ERR_peek_last_error());
-        sig->s.len = 0;
+        sig->s.forget();
         goto done;
     }
+    sig->s.resize(slen);
     ret = RNP_SUCCESS;
 done:
     EVP_PKEY_CTX_free(ctx);
@@ -505,14 +510,15 @@ rsa_decrypt_pkcs1(rnp::RNG *                 rng,
                   uint8_t *                  out,
                   size_t *                   out_len,
                   const pgp_rsa_encrypted_t *in,
-                  const pgp_rsa_key_t *      key)
+                  const pgp_rsa_key_t *      key,
+                  rnp::KeyCache *            cache)
 {
     rnp_result_t ret = RNP_ERROR_GENERIC;
     if (!key->q.bytes()) {
         RNP_LOG("private key not set");
         return ret;
     }
-    EVP_PKEY_CTX *ctx = rsa_init_context(key, true);
+    EVP_PKEY_CTX *ctx = rsa_init_context(key, true, cache);
     if (!ctx) {
         return ret;
     }
@@ -524,7 +530,7 @@ rsa_decrypt_pkcs1(rnp::RNG *                 rng,
         goto done;
     }
     *out_len = PGP_MPINT_SIZE;
-    if (EVP_PKEY_decrypt(ctx, out, out_len, in->m.mpi, in->m.len) <= 0) {
+    if (EVP_PKEY_decrypt(ctx, out, out_len, in->m.data(), in->m.bytes()) <= 0) {
         RNP_LOG("Encryption failed: %lu", ERR_peek_last_error());
         *out_len = 0;
         goto done;
@@ -37,6 +37,7 @@
 #endif
 
 #include "crypto/s2k.h"
+#include "crypto/hash.hpp"
 #include "defaults.h"
 #include "rnp.h"
 #include "types.h"
@@ -47,7 +48,8 @@
 #endif
 
 bool
-pgp_s2k_derive_key(pgp_s2k_t *s2k, const char *password, uint8_t *key, int keysize)
+pgp_s2k_derive_key(
+  pgp_s2k_t *s2k, const char *password, uint8_t *key, int keysize, rnp::S2KCache *cache)
 {
     uint8_t *saltptr = NULL;
     unsigned iterations = 1;
@@ -70,14 +72,146 @@ pgp_s2k_derive_key(pgp_s2k_t *s2k, const char *password, uint8_t *key, int keysi
         return false;
     }
 
+    if (cache && cache->get(*s2k, password, key, keysize)) {
+        return true;
+    }
+
     if (pgp_s2k_iterated(s2k->hash_alg, key, keysize, password, saltptr, iterations)) {
         RNP_LOG("s2k failed");
         return false;
     }
-
     return true;
 }
 
+namespace rnp {
+/* Size of the SHA-256 input block, used for HMAC padding */
+#define S2K_CACHE_HMAC_BLOCK 64
+/* Size of the random HMAC key, must not exceed the block size */
+#define S2K_CACHE_SECRET_SIZE 32
+
+/* HMAC-SHA256 as per RFC 2104 */
+secure_vector<uint8_t>
+S2KCache::entry_id(const pgp_s2k_t &s2k, const char *password, size_t keysize) const
+{
+    uint8_t params[10];
+    params[0] = s2k.specifier;
+    params[1] = s2k.hash_alg;
+    write_uint32(params + 2, s2k.iterations);
+    write_uint32(params + 6, keysize);
+
+    secure_array<uint8_t, S2K_CACHE_HMAC_BLOCK> pad;
+    memcpy(pad.data(), secret_.data(), secret_.size());
+    for (size_t i = 0; i < pad.size(); i++) {
+        pad[i] ^= 0x36;
+    }
+    auto hash = Hash::create(PGP_HASH_SHA256);
+    hash->add(pad.data(), pad.size());
+    hash->add(params, sizeof(params));
+    hash->add(s2k.salt, PGP_SALT_SIZE);
+    hash->add(password, strlen(password));
+    secure_vector<uint8_t> id(hash->size());
+    hash->finish(id.data());
+
+    /* turn ipad into opad */
+    for (size_t i = 0; i < pad.size(); i++) {
+        pad[i] ^= 0x36 ^ 0x5c;
+    }
+    hash = Hash::create(PGP_HASH_SHA256);
+    hash->add(pad.data(), pad.size());
+    hash->add(id.data(), id.size());
+    hash->finish(id.data());
+    return id;
+}
+
+/* Must be called with the lock held */
+void
+S2KCache::expire()
+{
+    if (!ttl_) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    entries_.remove_if([now](const Entry &entry) { return entry.expires <= now; });
+}
+
+void
+S2KCache::set_limits(size_t max_entries, uint32_t ttl, RNG &rng)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (max_entries && secret_.empty()) {
+        secret_.resize(S2K_CACHE_SECRET_SIZE);
+        rng.get(secret_.data(), secret_.size());
+    }
+    max_entries_ = max_entries;
+    ttl_ = ttl;
+    if (entries_.size() > max_entries_) {
+        entries_.resize(max_entries_);
+    }
+}
+
+bool
+S2KCache::get(const pgp_s2k_t &s2k, const char *password, uint8_t *key, size_t keysize)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    /* only iterated S2K is slow enough to be cached */
+    if (!max_entries_ || (s2k.specifier != PGP_S2KS_ITERATED_AND_SALTED)) {
+        return false;
+    }
+    try {
+        expire();
+        auto id = entry_id(s2k, password, keysize);
+        for (auto it = entries_.begin(); it != entries_.end(); it++) {
+            if ((it->id != id) || (it->key.size() != keysize)) {
+                continue;
+            }
+            memcpy(key, it->key.data(), keysize);
+            entries_.splice(entries_.begin(), entries_, it);
+            return true;
+        }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what()); // LCOV_EXCL_LINE
+    }
+    return false;
+}
+
+void
+S2KCache::put(const pgp_s2k_t &s2k, const char *password, const uint8_t *key, size_t keysize)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!max_entries_ || (s2k.specifier != PGP_S2KS_ITERATED_AND_SALTED)) {
+        return;
+    }
+    try {
+        expire();
+        Entry entry;
+        entry.id = entry_id(s2k, password, keysize);
+        /* key which is already cached keeps its expiration time */
+        for (auto it = entries_.begin(); it != entries_.end(); it++) {
+            if ((it->id == entry.id) && (it->key.size() == keysize)) {
+                entries_.splice(entries_.begin(), entries_, it);
+                return;
+            }
+        }
+        entry.key.assign(key, key + keysize);
+        entry.expires = std::chrono::steady_clock::now() + std::chrono::seconds(ttl_);
+        entries_.remove_if([&entry](const Entry &item) { return item.id == entry.id; });
+        entries_.push_front(std::move(entry));
+        if (entries_.size() > max_entries_) {
+            entries_.pop_back();
+        }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what()); // LCOV_EXCL_LINE
+    }
+}
+
+void
+S2KCache::clear()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    entries_.clear();
+}
+} // namespace rnp
+
 #ifdef CRYPTO_BACKEND_BOTAN
 int
 pgp_s2k_iterated(pgp_hash_alg_t alg,
@@ -31,11 +31,52 @@
 #ifndef RNP_S2K_H_
 #define RNP_S2K_H_
 
+#include <chrono>
 #include <cstdint>
+#include <list>
+#include <mutex>
 #include "repgp/repgp_def.h"
+#include "mem.h"
+#include "rng.h"
 
 typedef struct pgp_s2k_t pgp_s2k_t;
 
+namespace rnp {
+/**
+ * @brief Cache of the keys, derived from password via the iterated and salted S2K, so slow
+ *        derivation is not repeated for the same password and S2K parameters. Entries are
+ *        identified by the HMAC-SHA256 of S2K parameters, key size and password, keyed with
+ *        the random secret of the cache, and expire after ttl seconds (0 means no
+ *        expiration). Least recently used entries are evicted first.
+ *        Cache is disabled until max_entries is set.
+ */
+class S2KCache {
+    struct Entry {
+        secure_vector<uint8_t>                id;
+        secure_vector<uint8_t>                key;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    std::list<Entry>       entries_; /* most recently used first */
+    size_t                 max_entries_{};
+    uint32_t               ttl_{};
+    secure_vector<uint8_t> secret_; /* HMAC key, generated once cache is enabled */
+    std::mutex             lock_;
+
+    secure_vector<uint8_t> entry_id(const pgp_s2k_t &s2k,
+                                    const char *     password,
+                                    size_t           keysize) const;
+    void                   expire();
+
+  public:
+    void set_limits(size_t max_entries, uint32_t ttl, RNG &rng);
+    bool get(const pgp_s2k_t &s2k, const char *password, uint8_t *key, size_t keysize);
+    /* Must be called only once the key is known to be correct, i.e. it decrypted data */
+    void put(const pgp_s2k_t &s2k, const char *password, const uint8_t *key, size_t keysize);
+    void clear();
+};
+} // namespace rnp
+
 int pgp_s2k_iterated(pgp_hash_alg_t alg,
                      uint8_t *      out,
                      size_t         output_len,
@@ -58,8 +99,15 @@ size_t pgp_s2k_compute_iters(pgp_hash_alg_t alg, size_t desired_msec, size_t tri
  *  @param password NULL-terminated password
  *  @param key buffer to store the derived key, must have at least keysize bytes
  *  @param keysize number of bytes in the key.
+ *  @param cache optional cache of the derived keys, used for iterated and salted S2K. Key is
+ *               only looked up in the cache, it's up to the caller to put it there once
+ *               it's known to be correct.
  *  @return true on success or false otherwise
  */
-bool pgp_s2k_derive_key(pgp_s2k_t *s2k, const char *password, uint8_t *key, int keysize);
+bool pgp_s2k_derive_key(pgp_s2k_t *     s2k,
+                        const char *    password,
+                        uint8_t *       key,
+                        int             keysize,
+                        rnp::S2KCache *cache = NULL);
 
 #endif
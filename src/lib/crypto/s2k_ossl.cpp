@@ -27,12 +27,46 @@
 #include <cstdint>
 #include <vector>
 #include <algorithm>
+#include <future>
 #include <openssl/evp.h>
 #include "hash.hpp"
 #include "s2k.h"
 #include "mem.h"
 #include "logging.h"
 
+/* Size of the buffer with repeated salt and password, hashed at once */
+#define S2K_STRIDE_SIZE 8192
+/* Minimum number of iterations to derive output blocks on separate threads */
+#define S2K_PARALLEL_ITERATIONS 65536
+
+/* Calculate single output block of the iterated and salted S2K: leading zeroes, then
+ * iterations bytes of repeated salt and password. Buffer must contain a whole number of
+ * unit-sized salt and password repetitions. */
+static bool
+s2k_hash_block(pgp_hash_alg_t                     alg,
+               const rnp::secure_vector<uint8_t> &buf,
+               size_t                             unit,
+               size_t                             iterations,
+               size_t                             zeroes,
+               uint8_t *                          out)
+{
+    auto hash = rnp::Hash::create(alg);
+    if (zeroes) {
+        std::vector<uint8_t> zero(zeroes, 0);
+        hash->add(zero.data(), zero.size());
+    }
+    if (unit) {
+        /* if iteration is 1 then still hash the whole data chunk */
+        size_t left = std::max(unit, iterations);
+        while (left) {
+            size_t to_hash = std::min(left, buf.size());
+            hash->add(buf.data(), to_hash);
+            left -= to_hash;
+        }
+    }
+    return hash->finish(out) == hash->size();
+}
+
 int
 pgp_s2k_iterated(pgp_hash_alg_t alg,
                  uint8_t *      out,
@@ -53,42 +87,49 @@ pgp_s2k_iterated(pgp_hash_alg_t alg,
     try {
         size_t pswd_len = strlen(password);
         size_t salt_len = salt ? PGP_SALT_SIZE : 0;
+        size_t unit = salt_len + pswd_len;
 
-        rnp::secure_vector<uint8_t> data(salt_len + pswd_len);
-        if (salt_len) {
-            memcpy(data.data(), salt, PGP_SALT_SIZE);
+        /* repeat salt and password as many times as fits the stride */
+        size_t                      reps = unit ? std::max<size_t>(1, S2K_STRIDE_SIZE / unit) : 0;
+        rnp::secure_vector<uint8_t> buf(unit * reps);
+        for (size_t i = 0; i < reps; i++) {
+            uint8_t *ptr = buf.data() + i * unit;
+            if (salt_len) {
+                memcpy(ptr, salt, PGP_SALT_SIZE);
+            }
+            memcpy(ptr + salt_len, password, pswd_len);
         }
-        memcpy(data.data() + salt_len, password, pswd_len);
-        size_t zeroes = 0;
 
-        while (output_len) {
-            /* create hash context */
-            auto hash = rnp::Hash::create(alg);
-            /* add leading zeroes */
-            for (size_t z = 0; z < zeroes; z++) {
-                uint8_t zero = 0;
-                hash->add(&zero, 1);
-            }
-            if (!data.empty()) {
-                /* if iteration is 1 then still hash the whole data chunk */
-                size_t left = std::max(data.size(), iterations);
-                while (left) {
-                    size_t to_hash = std::min(left, data.size());
-                    hash->add(data.data(), to_hash);
-                    left -= to_hash;
-                }
-            }
-            rnp::secure_vector<uint8_t> dgst(hash_len);
-            size_t                      out_cpy = std::min(dgst.size(), output_len);
-            if (hash->finish(dgst.data()) != dgst.size()) {
-                RNP_LOG("Unexpected digest size.");
-                return 1;
-            }
-            memcpy(out, dgst.data(), out_cpy);
-            output_len -= out_cpy;
-            out += out_cpy;
-            zeroes++;
+        /* each output block is hashed independently, so may be calculated in parallel */
+        size_t                         blocks = (output_len + hash_len - 1) / hash_len;
+        size_t                         local = blocks;
+        rnp::secure_vector<uint8_t>    dgst(blocks * hash_len);
+        std::vector<std::future<bool>> res;
+        if ((blocks > 1) && (iterations >= S2K_PARALLEL_ITERATIONS)) {
+            local = 1;
+        }
+        for (size_t i = local; i < blocks; i++) {
+            res.push_back(std::async(std::launch::async,
+                                     s2k_hash_block,
+                                     alg,
+                                     std::cref(buf),
+                                     unit,
+                                     iterations,
+                                     i,
+                                     dgst.data() + i * hash_len));
+        }
+        bool ok = true;
+        for (size_t i = 0; i < local; i++) {
+            ok = s2k_hash_block(alg, buf, unit, iterations, i, dgst.data() + i * hash_len) && ok;
+        }
+        for (auto &r : res) {
+            ok = r.get() && ok;
+        }
+        if (!ok) {
+            RNP_LOG("Unexpected digest size.");
+            return 1;
         }
+        memcpy(out, dgst.data(), output_len);
         return 0;
     } catch (const std::exception &e) {
         RNP_LOG("s2k failed: %s", e.what());
@@ -46,13 +46,13 @@ sm2_load_public_key(botan_pubkey_t *pubkey, const pgp_ec_key_t *keydata)
 
     const size_t sign_half_len = BITS_TO_BYTES(curve->bitlen);
     sz = keydata->p.bytes();
-    if (!sz || (sz != (2 * sign_half_len + 1)) || (keydata->p.mpi[0] != 0x04)) {
+    if (!sz || (sz != (2 * sign_half_len + 1)) || (keydata->p[0] != 0x04)) {
         goto end;
     }
 
     if (botan_mp_init(&px) || botan_mp_init(&py) ||
-        botan_mp_from_bin(px, &keydata->p.mpi[1], sign_half_len) ||
-        botan_mp_from_bin(py, &keydata->p.mpi[1 + sign_half_len], sign_half_len)) {
+        botan_mp_from_bin(px, &keydata->p[1], sign_half_len) ||
+        botan_mp_from_bin(py, &keydata->p[1 + sign_half_len], sign_half_len)) {
         goto end;
     }
     res = !botan_pubkey_load_sm2(pubkey, px, py, curve->botan_name);
@@ -255,8 +255,8 @@ sm2_verify(const pgp_ec_signature_t *sig,
         goto end;
     }
 
-    r_blen = sig->r.len;
-    s_blen = sig->s.len;
+    r_blen = sig->r.bytes();
+    s_blen = sig->s.bytes();
     if (!r_blen || (r_blen > sign_half_len) || !s_blen || (s_blen > sign_half_len) ||
         (sign_half_len > MAX_CURVE_BYTELEN)) {
         goto end;
@@ -326,10 +326,16 @@ sm2_encrypt(rnp::RNG *           rng,
         goto done;
     }
 
-    out->m.len = sizeof(out->m.mpi);
-    if (botan_pk_op_encrypt(enc_op, rng->handle(), out->m.mpi, &out->m.len, in, in_len) == 0) {
-        out->m.mpi[out->m.len++] = hash_algo;
+    /* ciphertext is followed by the hash algorithm byte */
+    out->m.resize(PGP_MPINT_SIZE);
+    ctext_len = PGP_MPINT_SIZE - 1;
+    if (botan_pk_op_encrypt(enc_op, rng->handle(), out->m.data(), &ctext_len, in, in_len) ==
+        0) {
+        out->m.resize(ctext_len + 1);
+        out->m[ctext_len] = hash_algo;
         ret = RNP_SUCCESS;
+    } else {
+        out->m.forget();
     }
 done:
     botan_pk_op_encrypt_destroy(enc_op);
@@ -360,7 +366,7 @@ sm2_decrypt(uint8_t *                  out,
         goto done;
     }
 
-    hash_id = in->m.mpi[in_len - 1];
+    hash_id = in->m[in_len - 1];
     hash_name = rnp::Hash_Botan::name_backend((pgp_hash_alg_t) hash_id);
     if (!hash_name) {
         RNP_LOG("Unknown hash used in SM2 ciphertext");
@@ -371,7 +377,7 @@ sm2_decrypt(uint8_t *                  out,
         goto done;
     }
 
-    if (botan_pk_op_decrypt(decrypt_op, out, out_len, in->m.mpi, in_len - 1) == 0) {
+    if (botan_pk_op_decrypt(decrypt_op, out, out_len, in->m.data(), in_len - 1) == 0) {
         ret = RNP_SUCCESS;
     }
 done:
@@ -157,31 +157,33 @@ pgp_sphincsplus_private_key_t::sign(rnp::RNG *                   rng,
     assert(is_initialized_);
     auto priv_key = botan_key();
 
-    auto signer = Botan::PK_Signer(priv_key, *rng->obj(), "");
+    auto signer = Botan::PK_Signer(*priv_key, *rng->obj(), "");
     sig->sig = signer.sign_message(msg, msg_len, *rng->obj());
     sig->param = param();
 
     return RNP_SUCCESS;
 }
 
-Botan::SphincsPlus_PublicKey
+std::shared_ptr<Botan::SphincsPlus_PublicKey>
 pgp_sphincsplus_public_key_t::botan_key() const
 {
-    return Botan::SphincsPlus_PublicKey(
-      key_encoded_,
-      rnp_sphincsplus_params_to_botan_param(this->sphincsplus_param_),
-      rnp_sphincsplus_hash_func_to_botan_hash_func(this->sphincsplus_hash_func_));
+    return cache_.get<Botan::SphincsPlus_PublicKey>(false, [this]() {
+        return std::make_shared<Botan::SphincsPlus_PublicKey>(
+          key_encoded_,
+          rnp_sphincsplus_params_to_botan_param(this->sphincsplus_param_),
+          rnp_sphincsplus_hash_func_to_botan_hash_func(this->sphincsplus_hash_func_));
+    });
 }
 
-Botan::SphincsPlus_PrivateKey
+std::shared_ptr<Botan::SphincsPlus_PrivateKey>
 pgp_sphincsplus_private_key_t::botan_key() const
 {
-    Botan::secure_vector<uint8_t> priv_sv(key_encoded_.data(),
-                                          key_encoded_.data() + key_encoded_.size());
-    return Botan::SphincsPlus_PrivateKey(
-      priv_sv,
-      rnp_sphincsplus_params_to_botan_param(this->sphincsplus_param_),
-      rnp_sphincsplus_hash_func_to_botan_hash_func(this->sphincsplus_hash_func_));
+    return cache_.get<Botan::SphincsPlus_PrivateKey>(true, [this]() {
+        return std::make_shared<Botan::SphincsPlus_PrivateKey>(
+          key_encoded_,
+          rnp_sphincsplus_params_to_botan_param(this->sphincsplus_param_),
+          rnp_sphincsplus_hash_func_to_botan_hash_func(this->sphincsplus_hash_func_));
+    });
 }
 
 rnp_result_t
@@ -192,7 +194,7 @@ pgp_sphincsplus_public_key_t::verify(const pgp_sphincsplus_signature_t *sig,
     assert(is_initialized_);
     auto pub_key = botan_key();
 
-    auto verificator = Botan::PK_Verifier(pub_key, "");
+    auto verificator = Botan::PK_Verifier(*pub_key, "");
     if (verificator.verify_message(msg, msg_len, sig->sig.data(), sig->sig.size())) {
         return RNP_SUCCESS;
     }
@@ -248,7 +250,7 @@ pgp_sphincsplus_public_key_t::is_valid(rnp::RNG *rng) const
     }
 
     auto key = botan_key();
-    return key.check_key(*(rng->obj()), false);
+    return key->check_key(*(rng->obj()), false);
 }
 
 bool
@@ -259,7 +261,7 @@ pgp_sphincsplus_private_key_t::is_valid(rnp::RNG *rng) const
     }
 
     auto key = botan_key();
-    return key.check_key(*(rng->obj()), false);
+    return key->check_key(*(rng->obj()), false);
 }
 
 rnp_result_t
@@ -101,17 +101,19 @@ class pgp_sphincsplus_private_key_t {
     secure_clear()
     {
         is_initialized_ = false;
+        cache_.clear();
         Botan::zap(key_encoded_);
     };
 
   private:
-    Botan::SphincsPlus_PrivateKey botan_key() const;
+    std::shared_ptr<Botan::SphincsPlus_PrivateKey> botan_key() const;
 
     Botan::secure_vector<uint8_t> key_encoded_;
     pgp_pubkey_alg_t              pk_alg_;
     sphincsplus_parameter_t       sphincsplus_param_;
     sphincsplus_hash_func_t       sphincsplus_hash_func_;
     bool                          is_initialized_ = false;
+    mutable rnp::KeyCache         cache_;
 };
 
 class pgp_sphincsplus_public_key_t {
@@ -163,13 +165,14 @@ class pgp_sphincsplus_public_key_t {
     };
 
   private:
-    Botan::SphincsPlus_PublicKey botan_key() const;
+    std::shared_ptr<Botan::SphincsPlus_PublicKey> botan_key() const;
 
     std::vector<uint8_t>    key_encoded_;
     pgp_pubkey_alg_t        pk_alg_;
     sphincsplus_parameter_t sphincsplus_param_;
     sphincsplus_hash_func_t sphincsplus_hash_func_;
     bool                    is_initialized_ = false;
+    mutable rnp::KeyCache   cache_;
 };
 
 std::pair<pgp_sphincsplus_public_key_t, pgp_sphincsplus_private_key_t>
@@ -32,6 +32,8 @@
 #include <unordered_set>
 #include <crypto/mem.h>
 #include "sec_profile.hpp"
+#include "crypto/s2k.h"
+#include "rwlock.hpp"
 
 struct rnp_key_handle_st {
     rnp_ffi_t  ffi;
@@ -109,6 +111,10 @@ struct rnp_ffi_st {
     rnp::KeyProvider        key_provider;
     pgp_password_provider_t pass_provider;
     rnp::SecurityContext    context;
+    rnp::S2KCache           s2k_cache;
+    size_t                  load_threads; /* threads used to load keys, see rnp_load_keys() */
+    rnp::RWLock             lock; /* shared for lookup and processing, exclusive for changes */
+    std::mutex              vlock; /* serializes key validation, done under the shared lock */
 
     rnp_ffi_st(pgp_key_store_format_t pub_fmt, pgp_key_store_format_t sec_fmt);
     ~rnp_ffi_st();
@@ -142,6 +148,7 @@ struct rnp_output_st {
     rnp_output_closer_t *closer;
     void *               app_ctx;
     bool                 keep;
+    bool                 append; /* file was opened with RNP_OUTPUT_FILE_APPEND */
 };
 
 struct rnp_op_generate_st {
@@ -252,6 +259,14 @@ struct rnp_identifier_iterator_st {
     }
 };
 
+struct rnp_key_search_st {
+    rnp_ffi_t                      ffi;
+    std::vector<pgp_fingerprint_t> fps; /* fingerprints of the found keys */
+    size_t                         idx;
+
+    rnp_key_search_st(rnp_ffi_t affi) : ffi(affi), idx(0){};
+};
+
 struct rnp_decryption_kp_param_t {
     rnp_op_verify_t op;
     bool            has_hidden; /* key provider had hidden keyid request */
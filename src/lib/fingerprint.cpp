@@ -95,7 +95,7 @@ pgp_keyid(pgp_key_id_t &keyid, const pgp_key_pkt_t &key)
         }
         auto & rsa = dynamic_cast<const pgp::RSAKeyMaterial &>(*key.material);
         size_t n = rsa.n().bytes();
-        (void) memcpy(keyid.data(), rsa.n().mpi + n - keyid.size(), keyid.size());
+        (void) memcpy(keyid.data(), rsa.n().data() + n - keyid.size(), keyid.size());
         return RNP_SUCCESS;
     }
     case PGP_V4:
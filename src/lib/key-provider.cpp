@@ -150,6 +150,12 @@ KeyIDSearch::KeyIDSearch(const pgp_key_id_t &keyid)
     keyid_ = keyid;
 }
 
+const pgp_key_id_t &
+KeyIDSearch::get_keyid() const
+{
+    return keyid_;
+}
+
 bool
 KeyFingerprintSearch::matches(const pgp_key_t &key) const
 {
@@ -204,6 +210,12 @@ KeyGripSearch::KeyGripSearch(const pgp_key_grip_t &grip)
     grip_ = grip;
 }
 
+const pgp_key_grip_t &
+KeyGripSearch::get_grip() const
+{
+    return grip_;
+}
+
 bool
 KeyUIDSearch::matches(const pgp_key_t &key) const
 {
@@ -228,6 +240,12 @@ KeyUIDSearch::KeyUIDSearch(const std::string &uid)
     uid_ = uid;
 }
 
+const std::string &
+KeyUIDSearch::get_uid() const
+{
+    return uid_;
+}
+
 pgp_key_t *
 KeyProvider::request_key(const KeySearch &search, pgp_op_t op, bool secret) const
 {
@@ -73,6 +73,7 @@ class KeyIDSearch : public KeySearch {
     bool              hidden() const;
 
     KeyIDSearch(const pgp_key_id_t &keyid);
+    const pgp_key_id_t &get_keyid() const;
 };
 
 class KeyFingerprintSearch : public KeySearch {
@@ -96,6 +97,7 @@ class KeyGripSearch : public KeySearch {
     std::string       value() const;
 
     KeyGripSearch(const pgp_key_grip_t &grip);
+    const pgp_key_grip_t &get_grip() const;
 };
 
 class KeyUIDSearch : public KeySearch {
@@ -107,6 +109,7 @@ class KeyUIDSearch : public KeySearch {
     std::string       value() const;
 
     KeyUIDSearch(const std::string &uid);
+    const std::string &get_uid() const;
 };
 
 class KeyProvider {
@@ -37,12 +37,12 @@ grip_hash_mpi(rnp::Hash &hash, const pgp::mpi &val, const char name, bool lzero
 {
     size_t len = val.bytes();
     size_t idx = 0;
-    for (idx = 0; (idx < len) && !val.mpi[idx]; idx++)
+    for (idx = 0; (idx < len) && !val[idx]; idx++)
         ;
 
     if (name) {
         size_t hlen = idx >= len ? 0 : len - idx;
-        if ((len > idx) && lzero && (val.mpi[idx] & 0x80)) {
+        if ((len > idx) && lzero && (val[idx] & 0x80)) {
             hlen++;
         }
 
@@ -53,11 +53,11 @@ grip_hash_mpi(rnp::Hash &hash, const pgp::mpi &val, const char name, bool lzero
 
     if (idx < len) {
         /* gcrypt prepends mpis with zero if higher bit is set */
-        if (lzero && (val.mpi[idx] & 0x80)) {
+        if (lzero && (val[idx] & 0x80)) {
             uint8_t zero = 0;
             hash.add(&zero, 1);
         }
-        hash.add(val.mpi + idx, len - idx);
+        hash.add(val.data() + idx, len - idx);
     }
     if (name) {
         hash.add(")", 1);
@@ -67,12 +67,14 @@ grip_hash_mpi(rnp::Hash &hash, const pgp::mpi &val, const char name, bool lzero
 void
 grip_hash_ecc_hex(rnp::Hash &hash, const char *hex, char name)
 {
-    pgp::mpi mpi = {};
-    mpi.len = rnp::hex_decode(hex, mpi.mpi, sizeof(mpi.mpi));
-    if (!mpi.len) {
+    pgp::mpi mpi;
+    mpi.resize(strlen(hex) / 2);
+    size_t len = rnp::hex_decode(hex, mpi.data(), mpi.bytes());
+    if (!len) {
         RNP_LOG("wrong hex mpi");
         throw rnp::rnp_exception(RNP_ERROR_BAD_PARAMETERS);
     }
+    mpi.resize(len);
 
     /* libgcrypt doesn't add leading zero when hashes ecc mpis */
     return grip_hash_mpi(hash, mpi, name, false);
@@ -88,21 +90,22 @@ grip_hash_ec(rnp::Hash &hash, const pgp_ec_key_t &key)
     }
 
     /* build uncompressed point from gx and gy */
-    pgp::mpi g = {};
-    g.mpi[0] = 0x04;
-    g.len = 1;
-    size_t len = rnp::hex_decode(desc->gx, g.mpi + g.len, sizeof(g.mpi) - g.len);
+    pgp::mpi g;
+    g.resize(1 + strlen(desc->gx) / 2 + strlen(desc->gy) / 2);
+    g[0] = 0x04;
+    size_t glen = 1;
+    size_t len = rnp::hex_decode(desc->gx, &g[glen], g.bytes() - glen);
     if (!len) {
         RNP_LOG("wrong x mpi");
         throw rnp::rnp_exception(RNP_ERROR_BAD_PARAMETERS);
     }
-    g.len += len;
-    len = rnp::hex_decode(desc->gy, g.mpi + g.len, sizeof(g.mpi) - g.len);
+    glen += len;
+    len = rnp::hex_decode(desc->gy, &g[glen], g.bytes() - glen);
     if (!len) {
         RNP_LOG("wrong y mpi");
         throw rnp::rnp_exception(RNP_ERROR_BAD_PARAMETERS);
     }
-    g.len += len;
+    g.resize(glen + len);
 
     /* p, a, b, g, n, q */
     grip_hash_ecc_hex(hash, desc->p, 'p');
@@ -112,12 +115,11 @@ grip_hash_ec(rnp::Hash &hash, const pgp_ec_key_t &key)
     grip_hash_ecc_hex(hash, desc->n, 'n');
 
     if ((key.curve == PGP_CURVE_ED25519) || (key.curve == PGP_CURVE_25519)) {
-        if (g.len < 1) {
+        if (key.p.bytes() < 1) {
             RNP_LOG("wrong 25519 p");
             throw rnp::rnp_exception(RNP_ERROR_BAD_PARAMETERS);
         }
-        g.len = key.p.len - 1;
-        memcpy(g.mpi, key.p.mpi + 1, g.len);
+        g.from_mem(key.p.data() + 1, key.p.bytes() - 1);
         grip_hash_mpi(hash, g, 'q', false);
     } else {
         grip_hash_mpi(hash, key.p, 'q', false);
@@ -146,6 +148,7 @@ KeyMaterial::secret() const noexcept
 bool
 KeyMaterial::valid() const
 {
+    std::lock_guard<std::mutex> guard(vlock_);
     return validity_.validated && validity_.valid;
 }
 
@@ -158,6 +161,7 @@ KeyMaterial::equals(const KeyMaterial &value) const noexcept
 void
 KeyMaterial::validate(rnp::SecurityContext &ctx, bool reset)
 {
+    std::lock_guard<std::mutex> guard(vlock_);
     if (!reset && validity_.validated) {
         return;
     }
@@ -180,24 +184,40 @@ KeyMaterial::validity() const noexcept
 void
 KeyMaterial::set_validity(const pgp_validity_t &val)
 {
+    std::lock_guard<std::mutex> guard(vlock_);
     validity_ = val;
 }
 
 void
 KeyMaterial::reset_validity()
 {
+    std::lock_guard<std::mutex> guard(vlock_);
     validity_.reset();
 }
 
 void
 KeyMaterial::clear_secret() noexcept
 {
+    cache_.clear_secret();
     secret_ = false;
 }
 
+void
+KeyMaterial::clear_cache() const noexcept
+{
+    cache_.clear();
+}
+
+bool
+KeyMaterial::cached() const noexcept
+{
+    return !cache_.empty();
+}
+
 bool
 KeyMaterial::finish_generate()
 {
+    cache_.clear();
     validity_.mark_valid();
     secret_ = true;
     return true;
@@ -406,6 +426,7 @@ RSAKeyMaterial::clear_secret() noexcept
 bool
 RSAKeyMaterial::parse(pgp_packet_body_t &pkt) noexcept
 {
+    cache_.clear();
     secret_ = false;
     return pkt.get(key_.n) && pkt.get(key_.e);
 }
@@ -417,6 +438,7 @@ RSAKeyMaterial::parse_secret(pgp_packet_body_t &pkt) noexcept
         RNP_LOG("failed to parse rsa secret key data");
         return false;
     }
+    cache_.clear_secret();
     secret_ = true;
     return true;
 }
@@ -458,7 +480,7 @@ RSAKeyMaterial::encrypt(rnp::SecurityContext &    ctx,
                         const uint8_t *           data,
                         size_t                    len) const
 {
-    return rsa_encrypt_pkcs1(&ctx.rng, &out.rsa, data, len, &key_);
+    return rsa_encrypt_pkcs1(&ctx.rng, &out.rsa, data, len, &key_, &cache_);
 }
 
 rnp_result_t
@@ -471,7 +493,7 @@ RSAKeyMaterial::decrypt(rnp::SecurityContext &          ctx,
         RNP_LOG("Non-encrypting RSA algorithm: %d\n", alg());
         return RNP_ERROR_BAD_PARAMETERS;
     }
-    return rsa_decrypt_pkcs1(&ctx.rng, out, &out_len, &in.rsa, &key_);
+    return rsa_decrypt_pkcs1(&ctx.rng, out, &out_len, &in.rsa, &key_, &cache_);
 }
 
 rnp_result_t
@@ -483,7 +505,7 @@ RSAKeyMaterial::verify(const rnp::SecurityContext &       ctx,
         RNP_LOG("RSA encrypt-only signature considered as invalid.");
         return RNP_ERROR_SIGNATURE_INVALID;
     }
-    return rsa_verify_pkcs1(&sig.rsa, sig.halg, hash.data(), hash.size(), &key_);
+    return rsa_verify_pkcs1(&sig.rsa, sig.halg, hash.data(), hash.size(), &key_, &cache_);
 }
 
 rnp_result_t
@@ -491,7 +513,8 @@ RSAKeyMaterial::sign(rnp::SecurityContext &             ctx,
                      pgp_signature_material_t &         sig,
                      const rnp::secure_vector<uint8_t> &hash) const
 {
-    return rsa_sign_pkcs1(&ctx.rng, &sig.rsa, sig.halg, hash.data(), hash.size(), &key_);
+    return rsa_sign_pkcs1(
+      &ctx.rng, &sig.rsa, sig.halg, hash.data(), hash.size(), &key_, &cache_);
 }
 
 void
@@ -501,6 +524,7 @@ RSAKeyMaterial::set_secret(const mpi &d, const mpi &p, const mpi &q, const mpi &
     key_.p = p;
     key_.q = q;
     key_.u = u;
+    cache_.clear_secret();
     secret_ = true;
 }
 
@@ -897,6 +921,7 @@ ECKeyMaterial::check_curve(size_t hash_len) const
 bool
 ECKeyMaterial::parse(pgp_packet_body_t &pkt) noexcept
 {
+    cache_.clear();
     secret_ = false;
     if (!pkt.get(key_.curve) || !pkt.get(key_.p)) {
         return false;
@@ -911,6 +936,7 @@ ECKeyMaterial::parse_secret(pgp_packet_body_t &pkt) noexcept
         RNP_LOG("failed to parse ecc secret key data");
         return false;
     }
+    cache_.clear_secret();
     secret_ = true;
     return true;
 }
@@ -947,6 +973,7 @@ void
 ECKeyMaterial::set_secret(const mpi &x)
 {
     key_.x = x;
+    cache_.clear_secret();
     secret_ = true;
 }
 
@@ -1001,7 +1028,7 @@ ECDSAKeyMaterial::verify(const rnp::SecurityContext &       ctx,
         RNP_LOG("Curve %d is not supported.", key_.curve);
         return RNP_ERROR_NOT_SUPPORTED;
     }
-    return ecdsa_verify(&sig.ecc, sig.halg, hash.data(), hash.size(), &key_);
+    return ecdsa_verify(&sig.ecc, sig.halg, hash.data(), hash.size(), &key_, &cache_);
 }
 
 rnp_result_t
@@ -1013,7 +1040,8 @@ ECDSAKeyMaterial::sign(rnp::SecurityContext &             ctx,
     if (ret) {
         return ret;
     }
-    return ecdsa_sign(&ctx.rng, &sig.ecc, sig.halg, hash.data(), hash.size(), &key_);
+    return ecdsa_sign(
+      &ctx.rng, &sig.ecc, sig.halg, hash.data(), hash.size(), &key_, &cache_);
 }
 
 pgp_hash_alg_t
@@ -1178,7 +1206,7 @@ EDDSAKeyMaterial::verify(const rnp::SecurityContext &       ctx,
                          const pgp_signature_material_t &   sig,
                          const rnp::secure_vector<uint8_t> &hash) const
 {
-    return eddsa_verify(&sig.ecc, hash.data(), hash.size(), &key_);
+    return eddsa_verify(&sig.ecc, hash.data(), hash.size(), &key_, &cache_);
 }
 
 rnp_result_t
@@ -1186,7 +1214,7 @@ EDDSAKeyMaterial::sign(rnp::SecurityContext &             ctx,
                        pgp_signature_material_t &         sig,
                        const rnp::secure_vector<uint8_t> &hash) const
 {
-    return eddsa_sign(&ctx.rng, &sig.ecc, hash.data(), hash.size(), &key_);
+    return eddsa_sign(&ctx.rng, &sig.ecc, hash.data(), hash.size(), &key_, &cache_);
 }
 
 bool
@@ -28,6 +28,7 @@
 #define RNP_KEY_MATERIAL_HPP_
 
 #include "types.h"
+#include "crypto/key_cache.hpp"
 
 typedef struct pgp_packet_body_t          pgp_packet_body_t;
 typedef struct rnp_keygen_crypto_params_t rnp_keygen_crypto_params_t;
@@ -36,10 +37,12 @@ typedef struct pgp_signature_material_t   pgp_signature_material_t;
 
 namespace pgp {
 class KeyMaterial {
-    pgp_validity_t validity_; /* key material validation status */
+    pgp_validity_t            validity_; /* key material validation status */
+    mutable rnp::ValidityLock vlock_;    /* serializes lazy validation */
   protected:
-    pgp_pubkey_alg_t alg_;    /* algorithm of the key */
-    bool             secret_; /* secret part of the key material is populated */
+    pgp_pubkey_alg_t      alg_;    /* algorithm of the key */
+    bool                  secret_; /* secret part of the key material is populated */
+    mutable rnp::KeyCache cache_;  /* backend key objects, loaded from the material */
 
     virtual void grip_update(rnp::Hash &hash) const = 0;
     virtual bool validate_material(rnp::SecurityContext &ctx, bool reset = true) = 0;
@@ -60,6 +63,8 @@ class KeyMaterial {
     bool                  valid() const;
     virtual bool          equals(const KeyMaterial &value) const noexcept;
     virtual void          clear_secret() noexcept;
+    void                  clear_cache() const noexcept;
+    bool                  cached() const noexcept;
     virtual bool          parse(pgp_packet_body_t &pkt) noexcept = 0;
     virtual bool          parse_secret(pgp_packet_body_t &pkt) noexcept = 0;
     virtual void          write(pgp_packet_body_t &pkt) const = 0;
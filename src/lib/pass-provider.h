@@ -31,6 +31,10 @@
 
 typedef struct pgp_key_t pgp_key_t;
 
+namespace rnp {
+class S2KCache;
+}
+
 typedef struct pgp_password_ctx_t {
     uint8_t          op;
     const pgp_key_t *key;
@@ -46,8 +50,11 @@ typedef bool pgp_password_callback_t(const pgp_password_ctx_t *ctx,
 typedef struct pgp_password_provider_t {
     pgp_password_callback_t *callback;
     void *                   userdata;
-    pgp_password_provider_t(pgp_password_callback_t *cb = NULL, void *ud = NULL)
-        : callback(cb), userdata(ud){};
+    rnp::S2KCache *          s2k_cache; /* optional cache of the keys derived from passwords */
+    pgp_password_provider_t(pgp_password_callback_t *cb = NULL,
+                            void *                   ud = NULL,
+                            rnp::S2KCache *          cache = NULL)
+        : callback(cb), userdata(ud), s2k_cache(cache){};
 } pgp_password_provider_t;
 
 bool pgp_request_password(const pgp_password_provider_t *provider,
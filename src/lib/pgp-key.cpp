@@ -75,12 +75,13 @@
 pgp_key_pkt_t *
 pgp_decrypt_seckey_pgp(const pgp_rawpacket_t &raw,
                        const pgp_key_pkt_t &  pubkey,
-                       const char *           password)
+                       const char *           password,
+                       rnp::S2KCache *        cache)
 {
     try {
         rnp::MemorySource src(raw.raw.data(), raw.raw.size(), false);
         auto              res = std::unique_ptr<pgp_key_pkt_t>(new pgp_key_pkt_t());
-        if (res->parse(src.src()) || decrypt_secret_key(res.get(), password)) {
+        if (res->parse(src.src()) || decrypt_secret_key(res.get(), password, cache)) {
             return NULL;
         }
         return res.release();
@@ -116,7 +117,8 @@ pgp_decrypt_seckey(const pgp_key_t &              key,
     switch (key.format) {
     case PGP_KEY_STORE_GPG:
     case PGP_KEY_STORE_KBX:
-        return pgp_decrypt_seckey_pgp(key.rawpkt(), key.pkt(), password.data());
+        return pgp_decrypt_seckey_pgp(
+          key.rawpkt(), key.pkt(), password.data(), provider.s2k_cache);
     case PGP_KEY_STORE_G10:
         return g10_decrypt_seckey(key.rawpkt(), key.pkt(), password.data());
     default:
@@ -260,6 +262,7 @@ pgp_key_t::write_sec_rawpkt(pgp_key_pkt_t &       seckey,
         }
 
         rawpkt_ = pgp_rawpacket_t((uint8_t *) memdst.memory(), memdst.writeb(), type());
+        mark_changed(true);
         return true;
     } catch (const std::exception &e) {
         RNP_LOG("%s", e.what());
@@ -639,8 +642,6 @@ pgp_subsig_t::pgp_subsig_t(const pgp_signature_t &pkt)
     if (sig.has_subpkt(PGP_SIG_SUBPKT_PREF_KEYSERV)) {
         prefs.key_server = sig.key_server();
     }
-    /* add signature rawpacket */
-    rawpkt = pgp_rawpacket_t(sig);
 }
 
 bool
@@ -680,11 +681,26 @@ pgp_subsig_t::expired(uint64_t at) const
     return expiration + sig.creation() < at;
 }
 
+pgp_rawpacket_t
+pgp_subsig_t::rawpkt() const
+{
+    return pgp_rawpacket_t(sig);
+}
+
+size_t
+pgp_subsig_t::memory_usage() const
+{
+    size_t res = sizeof(*this) + sig.hashed_data.capacity() + sig.material_buf.capacity();
+    for (auto &sub : sig.subpkts) {
+        res += sizeof(*sub) + sub->data().capacity();
+    }
+    return res;
+}
+
 pgp_userid_t::pgp_userid_t(const pgp_userid_pkt_t &uidpkt)
 {
     /* copy packet data */
     pkt = uidpkt;
-    rawpkt = pgp_rawpacket_t(uidpkt);
     /* populate uid string */
     if (uidpkt.tag == PGP_PKT_USER_ID) {
         str = std::string(uidpkt.uid, uidpkt.uid + uidpkt.uid_len);
@@ -748,6 +764,19 @@ pgp_userid_t::clear_sigs()
     sigs_.clear();
 }
 
+pgp_rawpacket_t
+pgp_userid_t::rawpkt() const
+{
+    return pgp_rawpacket_t(pkt);
+}
+
+size_t
+pgp_userid_t::memory_usage() const
+{
+    return sizeof(*this) + pkt.uid_len + str.capacity() +
+           sigs_.capacity() * sizeof(pgp_sig_id_t);
+}
+
 pgp_revoke_t::pgp_revoke_t(pgp_subsig_t &sig)
 {
     uid = sig.uid;
@@ -832,6 +861,7 @@ pgp_key_t::pgp_key_t(const pgp_key_t &src, bool pubonly)
     format = src.format;
     validity_ = src.validity_;
     valid_till_ = src.valid_till_;
+    change_ = src.change_;
 }
 
 pgp_key_t::pgp_key_t(const pgp_transferable_key_t &src) : pgp_key_t(src.key)
@@ -914,6 +944,7 @@ pgp_key_t::replace_sig(const pgp_sig_id_t &id, const pgp_signature_t &newsig)
 {
     /* save oldsig's uid */
     size_t uid = get_sig(id).uid;
+    mark_changed(true);
     /* delete first old sig since we may have theoretically the same sigid */
     pgp_sig_id_t oldid = id;
     sigs_map_.erase(oldid);
@@ -941,6 +972,7 @@ pgp_key_t::add_sig(const pgp_signature_t &sig, size_t uid, bool begin)
 {
     const pgp_sig_id_t sigid = sig.get_id();
     sigs_map_.erase(sigid);
+    mark_changed();
     pgp_subsig_t &res = sigs_map_.emplace(std::make_pair(sigid, sig)).first->second;
     res.uid = uid;
     if (uid == PGP_UID_NONE) {
@@ -969,6 +1001,7 @@ pgp_key_t::del_sig(const pgp_sig_id_t &sigid)
     if (!has_sig(sigid)) {
         return false;
     }
+    mark_changed(true);
     uint32_t uid = get_sig(sigid).uid;
     if (uid == PGP_UID_NONE) {
         /* signature over the key itself */
@@ -995,6 +1028,9 @@ pgp_key_t::del_sigs(const std::vector<pgp_sig_id_t> &sigs)
     for (auto &sig : sigs) {
         res += sigs_map_.erase(sig);
     }
+    if (res) {
+        mark_changed(true);
+    }
     /* rebuild vectors with signatures order */
     keysigs_.clear();
     for (auto &uid : uids_) {
@@ -1099,6 +1135,7 @@ pgp_key_t::del_uid(size_t idx)
     if (idx >= uids_.size()) {
         throw std::out_of_range("idx");
     }
+    mark_changed(true);
 
     std::vector<pgp_sig_id_t> newsigs;
     /* copy sigs which do not belong to uid */
@@ -1144,6 +1181,7 @@ pgp_key_t::add_uid(const pgp_transferable_userid_t &uid)
 {
     /* construct userid */
     uids_.emplace_back(uid.uid);
+    mark_changed();
     /* add certifications */
     for (auto &sig : uid.signatures) {
         add_sig(sig, uid_count() - 1);
@@ -1463,6 +1501,20 @@ pgp_key_t::validated() const noexcept
     return validity_.validated;
 }
 
+bool
+pgp_key_t::validity_published() const noexcept
+{
+    return published_.get();
+}
+
+void
+pgp_key_t::publish_validity() noexcept
+{
+    if (validity_.validated) {
+        published_.set();
+    }
+}
+
 uint64_t
 pgp_key_t::valid_till_common(bool expiry) const
 {
@@ -1614,6 +1666,57 @@ void
 pgp_key_t::set_rawpkt(const pgp_rawpacket_t &src)
 {
     rawpkt_ = src;
+    mark_changed(true);
+}
+
+pgp_key_change_t
+pgp_key_t::change() const noexcept
+{
+    return change_;
+}
+
+bool
+pgp_key_t::dirty() const noexcept
+{
+    return change_ != PGP_KEY_CHANGE_NONE;
+}
+
+void
+pgp_key_t::mark_changed(bool replaced) noexcept
+{
+    change_ = std::max(change_, replaced ? PGP_KEY_CHANGE_REPLACED : PGP_KEY_CHANGE_ADDED);
+}
+
+void
+pgp_key_t::mark_clean() noexcept
+{
+    change_ = PGP_KEY_CHANGE_NONE;
+}
+
+size_t
+pgp_key_t::memory_usage() const
+{
+    /* parsed key material takes roughly the same amount as the raw packet, so not counted */
+    size_t res = sizeof(*this) + rawpkt_.raw.capacity() + pkt_.hashed_len + pkt_.sec_len;
+    res += (sigs_.capacity() + keysigs_.capacity()) * sizeof(pgp_sig_id_t);
+    res += (subkey_fps_.capacity() + revokers_.capacity()) * sizeof(pgp_fingerprint_t);
+    res += (uids_.capacity() - uids_.size()) * sizeof(pgp_userid_t);
+    for (auto &uid : uids_) {
+        res += uid.memory_usage();
+    }
+    /* each map node keeps the key and the pointer to the next node */
+    for (auto &sig : sigs_map_) {
+        res += sizeof(pgp_sig_id_t) + sizeof(void *) + sig.second.memory_usage();
+    }
+    return res;
+}
+
+void
+pgp_key_t::release_caches() const noexcept
+{
+    if (pkt_.material) {
+        pkt_.material->clear_cache();
+    }
 }
 
 bool
@@ -1768,14 +1871,14 @@ pgp_key_t::write(pgp_dest_t &dst) const
 
     /* write signatures on key */
     for (auto &sigid : keysigs_) {
-        get_sig(sigid).rawpkt.write(dst);
+        get_sig(sigid).sig.write(dst);
     }
 
     /* write uids and their signatures */
     for (const auto &uid : uids_) {
-        uid.rawpkt.write(dst);
+        uid.pkt.write(dst);
         for (size_t idx = 0; idx < uid.sig_count(); idx++) {
-            get_sig(uid.get_sig(idx)).rawpkt.write(dst);
+            get_sig(uid.get_sig(idx)).sig.write(dst);
         }
     }
 }
@@ -2018,7 +2121,8 @@ pgp_key_t::is_binding(const pgp_subsig_t &sig) const
 void
 pgp_key_t::validate_sig(const pgp_key_t &           key,
                         pgp_subsig_t &              sig,
-                        const rnp::SecurityContext &ctx) const noexcept
+                        const rnp::SecurityContext &ctx,
+                        rnp::SigHashCache *         cache) const noexcept
 {
     sig.validity.reset();
 
@@ -2047,7 +2151,7 @@ pgp_key_t::validate_sig(const pgp_key_t &           key,
                 RNP_LOG("Userid not found");
                 return;
             }
-            validate_cert(sinfo, key.pkt(), key.get_uid(sig.uid).pkt, ctx);
+            validate_cert(sinfo, key.pkt(), key.get_uid(sig.uid).pkt, ctx, cache);
             break;
         }
         case PGP_SIG_SUBKEY:
@@ -2055,28 +2159,28 @@ pgp_key_t::validate_sig(const pgp_key_t &           key,
                 RNP_LOG("Invalid subkey binding's signer.");
                 return;
             }
-            validate_binding(sinfo, key, ctx);
+            validate_binding(sinfo, key, ctx, cache);
             break;
         case PGP_SIG_DIRECT:
             if (!is_signer(sig)) {
                 RNP_LOG("Invalid direct key signer.");
                 return;
             }
-            validate_direct(sinfo, ctx);
+            validate_direct(sinfo, ctx, cache);
             break;
         case PGP_SIG_REV_KEY:
             if (!is_signer(sig)) {
                 RNP_LOG("Invalid key revocation signer.");
                 return;
             }
-            validate_key_rev(sinfo, key.pkt(), ctx);
+            validate_key_rev(sinfo, key.pkt(), ctx, cache);
             break;
         case PGP_SIG_REV_SUBKEY:
             if (!is_signer(sig)) {
                 RNP_LOG("Invalid subkey revocation's signer.");
                 return;
             }
-            validate_sub_rev(sinfo, key.pkt(), ctx);
+            validate_sub_rev(sinfo, key.pkt(), ctx, cache);
             break;
         default:
             RNP_LOG("Unsupported key signature type: %d", (int) stype);
@@ -2161,23 +2265,25 @@ void
 pgp_key_t::validate_cert(pgp_signature_info_t &      sinfo,
                          const pgp_key_pkt_t &       key,
                          const pgp_userid_pkt_t &    uid,
-                         const rnp::SecurityContext &ctx) const
+                         const rnp::SecurityContext &ctx,
+                         rnp::SigHashCache *         cache) const
 {
-    auto hash = signature_hash_certification(*sinfo.sig, key, uid);
+    auto hash = signature_hash_certification(*sinfo.sig, key, uid, cache);
     validate_sig(sinfo, *hash, ctx);
 }
 
 void
 pgp_key_t::validate_binding(pgp_signature_info_t &      sinfo,
                             const pgp_key_t &           subkey,
-                            const rnp::SecurityContext &ctx) const
+                            const rnp::SecurityContext &ctx,
+                            rnp::SigHashCache *         cache) const
 {
     if (!is_primary() || !subkey.is_subkey()) {
         RNP_LOG("Invalid binding signature key type(s)");
         sinfo.valid = false;
         return;
     }
-    auto hash = signature_hash_binding(*sinfo.sig, pkt(), subkey.pkt());
+    auto hash = signature_hash_binding(*sinfo.sig, pkt(), subkey.pkt(), cache);
     validate_sig(sinfo, *hash, ctx);
     if (!sinfo.valid || !(sinfo.sig->key_flags() & PGP_KF_SIGN)) {
         return;
@@ -2204,7 +2310,7 @@ pgp_key_t::validate_binding(pgp_signature_info_t &      sinfo,
         return;
     }
 
-    hash = signature_hash_binding(*sub->signature(), pkt(), subkey.pkt());
+    hash = signature_hash_binding(*sub->signature(), pkt(), subkey.pkt(), cache);
     pgp_signature_info_t bindinfo = {};
     bindinfo.sig = sub->signature();
     bindinfo.signer_valid = true;
@@ -2216,31 +2322,37 @@ pgp_key_t::validate_binding(pgp_signature_info_t &      sinfo,
 void
 pgp_key_t::validate_sub_rev(pgp_signature_info_t &      sinfo,
                             const pgp_key_pkt_t &       subkey,
-                            const rnp::SecurityContext &ctx) const
+                            const rnp::SecurityContext &ctx,
+                            rnp::SigHashCache *         cache) const
 {
-    auto hash = signature_hash_binding(*sinfo.sig, pkt(), subkey);
+    auto hash = signature_hash_binding(*sinfo.sig, pkt(), subkey, cache);
     validate_sig(sinfo, *hash, ctx);
 }
 
 void
-pgp_key_t::validate_direct(pgp_signature_info_t &sinfo, const rnp::SecurityContext &ctx) const
+pgp_key_t::validate_direct(pgp_signature_info_t &      sinfo,
+                           const rnp::SecurityContext &ctx,
+                           rnp::SigHashCache *         cache) const
 {
-    auto hash = signature_hash_direct(*sinfo.sig, pkt());
+    auto hash = signature_hash_direct(*sinfo.sig, pkt(), cache);
     validate_sig(sinfo, *hash, ctx);
 }
 
 void
 pgp_key_t::validate_key_rev(pgp_signature_info_t &      sinfo,
                             const pgp_key_pkt_t &       key,
-                            const rnp::SecurityContext &ctx) const
+                            const rnp::SecurityContext &ctx,
+                            rnp::SigHashCache *         cache) const
 {
-    auto hash = signature_hash_direct(*sinfo.sig, key);
+    auto hash = signature_hash_direct(*sinfo.sig, key, cache);
     validate_sig(sinfo, *hash, ctx);
 }
 
 void
 pgp_key_t::validate_self_signatures(const rnp::SecurityContext &ctx)
 {
+    /* hashed key/userid prefixes are shared by the signatures of this key only */
+    rnp::SigHashCache cache;
     for (auto &sigid : sigs_) {
         auto &sig = get_sig(sigid);
         if (sig.validity.validated) {
@@ -2252,7 +2364,7 @@ pgp_key_t::validate_self_signatures(const rnp::SecurityContext &ctx)
 
         if (is_direct_self(sig) || is_self_cert(sig) || is_uid_revocation(sig) ||
             is_revocation(sig)) {
-            validate_sig(*this, sig, ctx);
+            validate_sig(*this, sig, ctx, &cache);
         }
     }
 }
@@ -2260,6 +2372,7 @@ pgp_key_t::validate_self_signatures(const rnp::SecurityContext &ctx)
 void
 pgp_key_t::validate_self_signatures(pgp_key_t &primary, const rnp::SecurityContext &ctx)
 {
+    rnp::SigHashCache cache;
     for (auto &sigid : sigs_) {
         pgp_subsig_t &sig = get_sig(sigid);
         if (sig.validity.validated) {
@@ -2267,7 +2380,7 @@ pgp_key_t::validate_self_signatures(pgp_key_t &primary, const rnp::SecurityConte
         }
 
         if (is_binding(sig) || is_revocation(sig)) {
-            primary.validate_sig(*this, sig, ctx);
+            primary.validate_sig(*this, sig, ctx, &cache);
         }
     }
 }
@@ -2386,6 +2499,7 @@ pgp_key_t::validate_subkey(pgp_key_t *primary, const rnp::SecurityContext &ctx)
 {
     /* consider subkey as valid on this level if it has valid primary key, has at least one
      * non-expired binding signature, and is not revoked. */
+    published_.clear();
     validity_.reset();
     validity_.validated = true;
     if (!primary || (!primary->valid() && !primary->expired())) {
@@ -2422,6 +2536,7 @@ pgp_key_t::validate_subkey(pgp_key_t *primary, const rnp::SecurityContext &ctx)
 void
 pgp_key_t::validate(rnp::KeyStore &keyring)
 {
+    published_.clear();
     validity_.reset();
     if (!is_subkey()) {
         validate_primary(keyring);
@@ -2467,12 +2582,20 @@ pgp_key_t::revalidate(rnp::KeyStore &keyring)
 void
 pgp_key_t::mark_valid()
 {
+    published_.clear();
     validity_.mark_valid();
     for (size_t i = 0; i < sig_count(); i++) {
         get_sig(i).validity.mark_valid();
     }
 }
 
+void
+pgp_key_t::reset_validity() noexcept
+{
+    published_.clear();
+    validity_.reset();
+}
+
 void
 pgp_key_t::sign_init(rnp::RNG &       rng,
                      pgp_signature_t &sig,
@@ -2851,6 +2974,7 @@ pgp_key_t::refresh_data(pgp_key_t *primary, const rnp::SecurityContext &ctx)
 void
 pgp_key_t::merge_validity(const pgp_validity_t &src)
 {
+    published_.clear();
     validity_.valid = validity_.valid && src.valid;
     /* We may safely leave validated status only if both merged keys are valid && validated.
      * Otherwise we'll need to revalidate. For instance, one validated but invalid key may add
@@ -2870,6 +2994,7 @@ pgp_key_t::merge(const pgp_key_t &src)
     if (src.is_secret() && !is_secret()) {
         pkt_ = src.pkt();
         rawpkt_ = src.rawpkt();
+        mark_changed();
         /* no subkey processing here - they are separated from the main key */
     }
 
@@ -2888,6 +3013,7 @@ pgp_key_t::merge(const pgp_key_t &src)
         if (uididx == PGP_UID_NONE) {
             uididx = uid_count();
             uids_.emplace_back(srcuid.pkt);
+            mark_changed();
         }
         /* add uid signatures */
         for (size_t idx = 0; idx < srcuid.sig_count(); idx++) {
@@ -2923,6 +3049,7 @@ pgp_key_t::merge(const pgp_key_t &src, pgp_key_t *primary)
     if (src.is_secret() && !is_secret()) {
         pkt_ = src.pkt();
         rawpkt_ = src.rawpkt();
+        mark_changed();
     }
 
     /* add subkey binding signatures */
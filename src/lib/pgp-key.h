@@ -56,6 +56,7 @@
 #include <stdio.h>
 #include <vector>
 #include <unordered_map>
+#include <atomic>
 #include "pass-provider.h"
 #include "../librepgp/stream-key.h"
 #include <rekey/rnp_key_store.h>
@@ -85,7 +86,6 @@ typedef struct pgp_subsig_t {
     uint32_t         uid{};         /* index in userid array in key for certification sig */
     pgp_signature_t  sig{};         /* signature packet */
     pgp_sig_id_t     sigid{};       /* signature identifier */
-    pgp_rawpacket_t  rawpkt{};      /* signature's rawpacket */
     uint8_t          trustlevel{};  /* level of trust */
     uint8_t          trustamount{}; /* amount of trust */
     uint8_t          key_flags{};   /* key flags for certification/direct key sig */
@@ -101,6 +101,10 @@ typedef struct pgp_subsig_t {
     bool is_cert() const;
     /** @brief Returns true if signature is expired */
     bool expired(uint64_t at) const;
+    /** @brief Raw packet, serialized from the parsed signature as it is not stored */
+    pgp_rawpacket_t rawpkt() const;
+    /** @brief Approximate amount of memory used by the signature, in bytes */
+    size_t memory_usage() const;
 } pgp_subsig_t;
 
 typedef std::unordered_map<pgp_sig_id_t, pgp_subsig_t> pgp_sig_map_t;
@@ -110,9 +114,8 @@ typedef struct pgp_userid_t {
   private:
     std::vector<pgp_sig_id_t> sigs_{}; /* all signatures related to this userid */
   public:
-    pgp_userid_pkt_t pkt{};    /* User ID or User Attribute packet as it was loaded */
-    pgp_rawpacket_t  rawpkt{}; /* Raw packet contents */
-    std::string      str{};    /* Human-readable representation of the userid */
+    pgp_userid_pkt_t pkt{}; /* User ID or User Attribute packet as it was loaded */
+    std::string      str{}; /* Human-readable representation of the userid */
     bool         valid{}; /* User ID is valid, i.e. has valid, non-expired self-signature */
     bool         revoked{};
     pgp_revoke_t revocation{};
@@ -126,14 +129,58 @@ typedef struct pgp_userid_t {
     void                replace_sig(const pgp_sig_id_t &id, const pgp_sig_id_t &newsig);
     bool                del_sig(const pgp_sig_id_t &id);
     void                clear_sigs();
+    /** @brief Raw packet, serialized from the userid packet as it is not stored */
+    pgp_rawpacket_t rawpkt() const;
+    /** @brief Approximate amount of memory used by the userid, in bytes */
+    size_t memory_usage() const;
 } pgp_userid_t;
 
 #define PGP_UID_NONE ((uint32_t) -1)
 
+/* Key's changes since the last keystore load or save. Order of elements is important. */
+typedef enum pgp_key_change_t {
+    PGP_KEY_CHANGE_NONE = 0, /* key was not changed */
+    PGP_KEY_CHANGE_ADDED,    /* key is new or packets were added to it */
+    PGP_KEY_CHANGE_REPLACED, /* some of key's packets were removed or replaced */
+} pgp_key_change_t;
+
 namespace rnp {
 class KeyStore;
 }
 
+/* Atomic flag, which is cleared on copy, so copied key must be published once again */
+class pgp_validity_flag_t {
+    std::atomic<bool> value_{};
+
+  public:
+    pgp_validity_flag_t() = default;
+    pgp_validity_flag_t(const pgp_validity_flag_t &){};
+    pgp_validity_flag_t &
+    operator=(const pgp_validity_flag_t &)
+    {
+        clear();
+        return *this;
+    }
+
+    bool
+    get() const noexcept
+    {
+        return value_.load(std::memory_order_acquire);
+    }
+
+    void
+    set() noexcept
+    {
+        value_.store(true, std::memory_order_release);
+    }
+
+    void
+    clear() noexcept
+    {
+        value_.store(false, std::memory_order_relaxed);
+    }
+};
+
 /* describes a user's key */
 struct pgp_key_t {
   private:
@@ -158,7 +205,9 @@ struct pgp_key_t {
     pgp_revoke_t    revocation_{}; /* revocation reason */
     std::vector<pgp_fingerprint_t> revokers_{};
     pgp_validity_t                 validity_{};   /* key's validity */
+    pgp_validity_flag_t            published_{};  /* validity was published to readers */
     uint64_t                       valid_till_{}; /* date till which key is/was valid */
+    pgp_key_change_t               change_{PGP_KEY_CHANGE_ADDED}; /* changes since load/save */
 
     pgp_subsig_t *latest_uid_selfcert(uint32_t uid);
     void          validate_primary(rnp::KeyStore &keyring);
@@ -259,6 +308,13 @@ struct pgp_key_t {
 
     bool valid() const noexcept;
     bool validated() const noexcept;
+    /**
+     * @brief Check whether validity was published via publish_validity() and was not changed
+     *        since then. Unlike validated(), may be called concurrently with the validation.
+     */
+    bool validity_published() const noexcept;
+    /** @brief Publish the validated state to the threads, which call validity_published() */
+    void publish_validity() noexcept;
     /** @brief return time till which key is considered to be valid */
     uint64_t valid_till() const noexcept;
     /** @brief check whether key was/will be valid at the specified time */
@@ -300,6 +356,19 @@ struct pgp_key_t {
     pgp_rawpacket_t &      rawpkt();
     const pgp_rawpacket_t &rawpkt() const;
     void                   set_rawpkt(const pgp_rawpacket_t &src);
+    /** @brief Get key's changes since the last keystore load or save. */
+    pgp_key_change_t change() const noexcept;
+    /** @brief Check whether key was changed since the last keystore load or save. */
+    bool dirty() const noexcept;
+    /** @brief Mark key as changed. Replaced state is never downgraded to added. */
+    void mark_changed(bool replaced = false) noexcept;
+    /** @brief Mark key as not changed, i.e. after it was loaded or saved. */
+    void mark_clean() noexcept;
+    /** @brief Approximate amount of memory used by the key, its userids and signatures, in
+     *         bytes. Caches are not counted. */
+    size_t memory_usage() const;
+    /** @brief Drop cached data (backend key objects), which is recreated on demand. */
+    void release_caches() const noexcept;
     /** @brief write secret key data to the rawpkt, optionally encrypting with password */
     bool write_sec_rawpkt(pgp_key_pkt_t &       seckey,
                           const std::string &   password,
@@ -407,10 +476,13 @@ struct pgp_key_t {
      * @param key key or subkey to which signature belongs.
      * @param sig signature to validate.
      * @param ctx Populated security context.
+     * @param cache optional cache of the key/userid hash prefixes, shared by the signatures
+     *              validated in a row.
      */
     void validate_sig(const pgp_key_t &           key,
                       pgp_subsig_t &              sig,
-                      const rnp::SecurityContext &ctx) const noexcept;
+                      const rnp::SecurityContext &ctx,
+                      rnp::SigHashCache *         cache = NULL) const noexcept;
 
     /**
      * @brief Validate signature, assuming that 'this' is a signing key.
@@ -431,48 +503,59 @@ struct pgp_key_t {
      * @param sinfo populated signature info. Validation results will be stored here.
      * @param key key packet to which certification belongs.
      * @param uid userid which is bound by certification to the key packet.
+     * @param cache optional cache of the key/userid hash prefixes.
      */
     void validate_cert(pgp_signature_info_t &      sinfo,
                        const pgp_key_pkt_t &       key,
                        const pgp_userid_pkt_t &    uid,
-                       const rnp::SecurityContext &ctx) const;
+                       const rnp::SecurityContext &ctx,
+                       rnp::SigHashCache *         cache = NULL) const;
 
     /**
      * @brief Validate subkey binding.
      *
      * @param sinfo populated signature info. Validation results will be stored here.
      * @param subkey subkey packet.
+     * @param cache optional cache of the key hash prefixes.
      */
     void validate_binding(pgp_signature_info_t &      sinfo,
                           const pgp_key_t &           subkey,
-                          const rnp::SecurityContext &ctx) const;
+                          const rnp::SecurityContext &ctx,
+                          rnp::SigHashCache *         cache = NULL) const;
 
     /**
      * @brief Validate subkey revocation.
      *
      * @param sinfo populated signature info. Validation results will be stored here.
      * @param subkey subkey packet.
+     * @param cache optional cache of the key hash prefixes.
      */
     void validate_sub_rev(pgp_signature_info_t &      sinfo,
                           const pgp_key_pkt_t &       subkey,
-                          const rnp::SecurityContext &ctx) const;
+                          const rnp::SecurityContext &ctx,
+                          rnp::SigHashCache *         cache = NULL) const;
 
     /**
      * @brief Validate direct-key signature.
      *
      * @param sinfo populated signature info. Validation results will be stored here.
+     * @param cache optional cache of the key hash prefixes.
      */
-    void validate_direct(pgp_signature_info_t &sinfo, const rnp::SecurityContext &ctx) const;
+    void validate_direct(pgp_signature_info_t &      sinfo,
+                         const rnp::SecurityContext &ctx,
+                         rnp::SigHashCache *         cache = NULL) const;
 
     /**
      * @brief Validate key revocation.
      *
      * @param sinfo populated signature info. Validation results will be stored here.
      * @param key key to which revocation belongs.
+     * @param cache optional cache of the key hash prefixes.
      */
     void validate_key_rev(pgp_signature_info_t &      sinfo,
                           const pgp_key_pkt_t &       key,
-                          const rnp::SecurityContext &ctx) const;
+                          const rnp::SecurityContext &ctx,
+                          rnp::SigHashCache *         cache = NULL) const;
 
     void validate_self_signatures(const rnp::SecurityContext &ctx);
     void validate_self_signatures(pgp_key_t &primary, const rnp::SecurityContext &ctx);
@@ -486,6 +569,9 @@ struct pgp_key_t {
     void validate_subkey(pgp_key_t *primary, const rnp::SecurityContext &ctx);
     void revalidate(rnp::KeyStore &keyring);
     void mark_valid();
+    /** @brief Drop key's validity status, so it would be validated again on the next use.
+     *         Already validated signatures are kept as is. */
+    void reset_validity() noexcept;
     /**
      * @brief Fill common signature parameters, assuming that current key is a signing one.
      * @param sig signature to init.
@@ -651,7 +737,8 @@ class KeyLocker {
 
 pgp_key_pkt_t *pgp_decrypt_seckey_pgp(const pgp_rawpacket_t &raw,
                                       const pgp_key_pkt_t &  key,
-                                      const char *           password);
+                                      const char *           password,
+                                      rnp::S2KCache *        cache = NULL);
 
 pgp_key_pkt_t *pgp_decrypt_seckey(const pgp_key_t &,
                                   const pgp_password_provider_t &,
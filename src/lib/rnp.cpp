@@ -59,6 +59,14 @@
 #include "version.h"
 #include "ffi-priv-types.h"
 #include "file-utils.h"
+#include "thread-pool.hpp"
+#include <algorithm>
+
+#ifndef RNP_USE_STD_REGEX
+#include <regex.h>
+#else
+#include <regex>
+#endif
 
 #define FFI_LOG(ffi, ...)            \
     do {                             \
@@ -98,6 +106,86 @@ call_key_callback(rnp_ffi_t ffi, const rnp::KeySearch &search, bool secret)
     return true;
 }
 
+/* Load secret keys which were indexed but not loaded yet, see RNP_LOAD_SAVE_LAZY. G10 files
+ * are named by grip, so searches of other types are resolved via the public keyring. */
+static pgp_key_t *
+ffi_load_lazy_key(rnp_ffi_t ffi, const rnp::KeySearch &search, pgp_key_t *after)
+{
+    /* lazy index is changed only under the exclusive lock, so may be checked here to avoid
+     * serializing readers on lookups of the keys, which have no key file */
+    std::vector<pgp_key_grip_t> grips;
+    if (search.type() == rnp::KeySearch::Type::Grip) {
+        auto &grip = static_cast<const rnp::KeyGripSearch &>(search).get_grip();
+        if (ffi->secring->lazy_indexed(grip)) {
+            grips.push_back(grip);
+        }
+    } else {
+        for (auto key = ffi->pubring->search(search); key;
+             key = ffi->pubring->search(search, key)) {
+            if (ffi->secring->lazy_indexed(key->grip())) {
+                grips.push_back(key->grip());
+            }
+        }
+    }
+    if (grips.empty()) {
+        return NULL;
+    }
+
+    /* loading modifies the keyring, so it is done under the exclusive lock. Upgrade from the
+     * shared side is served before other writers, and loading only adds keys, so the caller's
+     * keys, including after, stay in place. Key may be loaded meanwhile by another thread, so
+     * search is repeated anyway. */
+    rnp::WriteLock lock(ffi->lock);
+    for (auto &grip : grips) {
+        ffi->secring->load_lazy(grip, &ffi->key_provider);
+    }
+    return ffi->secring->search(search, after);
+}
+
+/* Validate the key if it was not validated yet. Caller must hold the shared lock. Validation
+ * changes only the key's own state, so instead of the exclusive lock it is serialized by the
+ * separate mutex, and keys, used by other readers, stay in place. Once key is validated, this
+ * is published to the readers, so they do not need the mutex anymore. */
+static bool
+ffi_validate_key(rnp_ffi_t ffi, pgp_key_t &key)
+{
+    if (key.validity_published()) {
+        return true;
+    }
+    std::lock_guard<std::mutex> guard(ffi->vlock);
+    if (key.validated()) {
+        key.publish_validity();
+        return true;
+    }
+    auto ks = (ffi->pubring->get_key(key.fp()) == &key) ? ffi->pubring : ffi->secring;
+    auto primary = key.is_subkey() ? ks->primary_key(key) : nullptr;
+    if (!ks->lazy_validation) {
+        key.validate(*ffi->pubring);
+    } else if (!primary || !primary->validated()) {
+        /* validation was deferred, so refresh the whole key with subkeys */
+        key.revalidate(*ks);
+    } else {
+        /* primary key is already validated and so may be used by another thread */
+        key.validate_subkey(primary, ks->secctx);
+        if (!key.refresh_data(primary, ks->secctx)) {
+            RNP_LOG("Failed to refresh subkey data");
+        }
+    }
+    key.publish_validity();
+    return key.validated();
+}
+
+/* Keys, added with deferred validation, are validated once they are requested via the FFI or
+ * the key provider. See rnp_ffi_set_lazy_validation(). */
+static pgp_key_t *
+ffi_deferred_key(rnp_ffi_t ffi, pgp_key_t *key)
+{
+    if (key && ffi->pubring->lazy_validation) {
+        ffi_validate_key(ffi, *key);
+    }
+    return key;
+}
+
 static pgp_key_t *
 find_key(rnp_ffi_t             ffi,
          const rnp::KeySearch &search,
@@ -107,11 +195,14 @@ find_key(rnp_ffi_t             ffi,
 {
     auto       ks = secret ? ffi->secring : ffi->pubring;
     pgp_key_t *key = ks->search(search, after);
+    if (!key && secret && ffi->secring->lazy_count()) {
+        key = ffi_load_lazy_key(ffi, search, after);
+    }
     if (!key && try_key_provider && call_key_callback(ffi, search, secret)) {
         // recurse and try the store search above once more
         return find_key(ffi, search, secret, false, after);
     }
-    return key;
+    return ffi_deferred_key(ffi, key);
 }
 
 static pgp_key_t *
@@ -624,6 +715,8 @@ rnp_ffi_st::rnp_ffi_st(pgp_key_store_format_t pub_fmt, pgp_key_store_format_t se
     key_provider.userdata = this;
     pass_provider.callback = rnp_password_cb_bounce;
     pass_provider.userdata = this;
+    pass_provider.s2k_cache = &s2k_cache;
+    load_threads = 0;
 }
 
 rnp::RNG &
@@ -735,6 +828,58 @@ try {
 }
 FFI_GUARD
 
+rnp_result_t
+rnp_ffi_set_load_threads(rnp_ffi_t ffi, size_t threads)
+try {
+    if (!ffi) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    /* such value is most likely a negative one, casted by the caller */
+    if (threads > (size_t) PTRDIFF_MAX) {
+        FFI_LOG(ffi, "Invalid number of threads: %zu", threads);
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    rnp::WriteLock lock(ffi->lock);
+    ffi->load_threads = rnp::ThreadPool::clamp_threads(threads);
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_ffi_set_lazy_validation(rnp_ffi_t ffi, bool lazy)
+try {
+    if (!ffi) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    rnp::WriteLock lock(ffi->lock);
+    ffi->pubring->lazy_validation = lazy;
+    ffi->secring->lazy_validation = lazy;
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_ffi_set_s2k_cache(rnp_ffi_t ffi, size_t max_entries, uint32_t ttl)
+try {
+    if (!ffi) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    ffi->s2k_cache.set_limits(max_entries, ttl, ffi->context.rng);
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_ffi_flush_s2k_cache(rnp_ffi_t ffi)
+try {
+    if (!ffi) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    ffi->s2k_cache.clear();
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
 static const char *
 operation_description(uint8_t op)
 {
@@ -1477,12 +1622,17 @@ do_load_keys(rnp_ffi_t              ffi,
         FFI_LOG(ffi, "Failed to create key store of format: %d", (int) format);
         return RNP_ERROR_BAD_PARAMETERS;
     }
+    tmp_store->threads = ffi->load_threads;
+    tmp_store->lazy_validation = ffi->pubring->lazy_validation;
 
     // load keys into our temporary store
     rnp_result_t tmpret = load_keys_from_input(ffi, input, tmp_store.get());
     if (tmpret) {
         return tmpret;
     }
+    // keyrings, loaded from scratch, match the stored ones, see rnp_save_keys()
+    bool pubempty = !ffi->pubring->key_count();
+    bool secempty = !ffi->secring->key_count();
     // go through all the loaded keys
     for (auto &key : tmp_store->keys) {
         // check that the key is the correct type and has not already been loaded
@@ -1529,6 +1679,12 @@ do_load_keys(rnp_ffi_t              ffi,
             return RNP_ERROR_GENERIC;
         }
     }
+    if (pubempty) {
+        ffi->pubring->mark_clean();
+    }
+    if (secempty) {
+        ffi->secring->mark_clean();
+    }
     // success, even if we didn't actually load any
     return RNP_SUCCESS;
 }
@@ -1568,12 +1724,27 @@ try {
         FFI_LOG(ffi, "invalid key store format: %s", format);
         return RNP_ERROR_BAD_PARAMETERS;
     }
+    bool lazy = extract_flag(flags, RNP_LOAD_SAVE_LAZY);
 
     // check for any unrecognized flags (not forward-compat, but maybe still a good idea)
     if (flags) {
         FFI_LOG(ffi, "unexpected flags remaining: 0x%X", flags);
         return RNP_ERROR_BAD_PARAMETERS;
     }
+    if (lazy && ((ks_format != PGP_KEY_STORE_G10) || input->src_directory.empty() ||
+                 (type == KEY_TYPE_PUBLIC))) {
+        FFI_LOG(ffi, "lazy loading is supported only for G10 secret keys directory");
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    rnp::WriteLock lock(ffi->lock);
+    if (lazy) {
+        if (ffi->secring->format != PGP_KEY_STORE_G10) {
+            FFI_LOG(ffi, "This key format conversion is not yet supported");
+            return RNP_ERROR_NOT_IMPLEMENTED;
+        }
+        return ffi->secring->index_g10(input->src_directory) ? RNP_SUCCESS :
+                                                               RNP_ERROR_BAD_FORMAT;
+    }
     return do_load_keys(ffi, input, ks_format, type);
 }
 FFI_GUARD
@@ -1589,6 +1760,7 @@ try {
         return RNP_ERROR_BAD_PARAMETERS;
     }
 
+    rnp::WriteLock lock(ffi->lock);
     if (flags & RNP_KEY_UNLOAD_PUBLIC) {
         ffi->pubring->clear();
     }
@@ -1679,6 +1851,32 @@ add_key_status(json_object *           keys,
     return RNP_SUCCESS;
 }
 
+/* Import key to the ffi's keyrings. Caller must hold the write lock. */
+static rnp_result_t
+ffi_import_key(rnp_ffi_t                ffi,
+               pgp_key_t &              key,
+               bool                     sec,
+               pgp_key_import_status_t &pub_status,
+               pgp_key_import_status_t &sec_status)
+{
+    // if we got here then we add public key itself or public part of the secret key
+    if (!ffi->pubring->import_key(key, true, &pub_status)) {
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    // import secret key part if available and requested
+    if (sec && key.is_secret()) {
+        if (!ffi->secring->import_key(key, false, &sec_status)) {
+            return RNP_ERROR_BAD_PARAMETERS;
+        }
+        // add uids, certifications and other stuff from the public key if any
+        pgp_key_t *expub = ffi->pubring->get_key(key.fp());
+        if (expub && !ffi->secring->import_key(*expub, true)) {
+            return RNP_ERROR_BAD_PARAMETERS;
+        }
+    }
+    return RNP_SUCCESS;
+}
+
 rnp_result_t
 rnp_import_keys(rnp_ffi_t ffi, rnp_input_t input, uint32_t flags, char **results)
 try {
@@ -1701,6 +1899,7 @@ try {
 
     rnp_result_t  ret = RNP_ERROR_GENERIC;
     rnp::KeyStore tmp_store(PGP_KEY_STORE_GPG, "", ffi->context);
+    tmp_store.lazy_validation = ffi->pubring->lazy_validation;
 
     /* check whether input is base64 */
     if (base64 && input->src.is_base64()) {
@@ -1743,27 +1942,17 @@ try {
         return RNP_ERROR_OUT_OF_MEMORY; // LCOV_EXCL_LINE
     }
 
-    // import keys to the main keystore.
+    // import keys to the main keystore. Parsing above doesn't need the lock.
+    rnp::WriteLock lock(ffi->lock);
     for (auto &key : tmp_store.keys) {
         pgp_key_import_status_t pub_status = PGP_KEY_IMPORT_STATUS_UNKNOWN;
         pgp_key_import_status_t sec_status = PGP_KEY_IMPORT_STATUS_UNKNOWN;
         if (!pub && key.is_public()) {
             continue;
         }
-        // if we got here then we add public key itself or public part of the secret key
-        if (!ffi->pubring->import_key(key, true, &pub_status)) {
-            return RNP_ERROR_BAD_PARAMETERS;
-        }
-        // import secret key part if available and requested
-        if (sec && key.is_secret()) {
-            if (!ffi->secring->import_key(key, false, &sec_status)) {
-                return RNP_ERROR_BAD_PARAMETERS;
-            }
-            // add uids, certifications and other stuff from the public key if any
-            pgp_key_t *expub = ffi->pubring->get_key(key.fp());
-            if (expub && !ffi->secring->import_key(*expub, true)) {
-                return RNP_ERROR_BAD_PARAMETERS;
-            }
+        ret = ffi_import_key(ffi, key, sec, pub_status, sec_status);
+        if (ret) {
+            return ret;
         }
         // now add key fingerprint to json based on statuses
         rnp_result_t tmpret = add_key_status(jsokeys, &key, pub_status, sec_status);
@@ -1779,6 +1968,121 @@ try {
 }
 FFI_GUARD
 
+namespace {
+struct ffi_key_status_t {
+    pgp_fingerprint_t       fp;
+    pgp_key_import_status_t pub;
+    pgp_key_import_status_t sec;
+};
+} // namespace
+
+/* Import primary key with subkeys or standalone subkeys (if tkey.key is empty) */
+static rnp_result_t
+ffi_import_ts_key(rnp_ffi_t               ffi,
+                  pgp_transferable_key_t &tkey,
+                  bool                    pub,
+                  bool                    sec,
+                  rnp_import_key_cb       cb,
+                  void *                  app_ctx)
+{
+    /* build keys without the lock, reserving space so primary pointer stays valid */
+    std::vector<pgp_key_t> keys;
+    keys.reserve(tkey.subkeys.size() + 1);
+    pgp_key_t *primary = nullptr;
+    if (tkey.key.tag != PGP_PKT_RESERVED) {
+        keys.emplace_back(tkey);
+        primary = &keys.front();
+    }
+    for (auto &subkey : tkey.subkeys) {
+        keys.emplace_back(subkey, primary);
+    }
+
+    std::vector<ffi_key_status_t> statuses;
+    {
+        rnp::WriteLock lock(ffi->lock);
+        for (auto &key : keys) {
+            if (!pub && key.is_public()) {
+                continue;
+            }
+            ffi_key_status_t status = {
+              key.fp(), PGP_KEY_IMPORT_STATUS_UNKNOWN, PGP_KEY_IMPORT_STATUS_UNKNOWN};
+            rnp_result_t ret = ffi_import_key(ffi, key, sec, status.pub, status.sec);
+            if (ret) {
+                return ret;
+            }
+            statuses.push_back(status);
+        }
+    }
+    if (!cb) {
+        return RNP_SUCCESS;
+    }
+    /* callback may call ffi functions, so report statuses once lock is released */
+    for (auto &status : statuses) {
+        char fp[PGP_FINGERPRINT_HEX_SIZE] = {0};
+        if (!rnp::hex_encode(status.fp.fingerprint,
+                             status.fp.length,
+                             fp,
+                             sizeof(fp),
+                             rnp::HexFormat::Uppercase)) {
+            return RNP_ERROR_GENERIC; // LCOV_EXCL_LINE
+        }
+        cb(ffi, app_ctx, fp, key_status_to_str(status.pub), key_status_to_str(status.sec));
+    }
+    return RNP_SUCCESS;
+}
+
+rnp_result_t
+rnp_import_keys_stream(rnp_ffi_t         ffi,
+                       rnp_input_t       input,
+                       uint32_t          flags,
+                       rnp_import_key_cb cb,
+                       void *            app_ctx)
+try {
+    if (!ffi || !input) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    bool sec = extract_flag(flags, RNP_LOAD_SAVE_SECRET_KEYS);
+    bool pub = extract_flag(flags, RNP_LOAD_SAVE_PUBLIC_KEYS);
+    if (!pub && !sec) {
+        FFI_LOG(ffi, "bad flags: need to specify public and/or secret keys");
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    bool skipbad = extract_flag(flags, RNP_LOAD_SAVE_PERMISSIVE);
+    bool base64 = extract_flag(flags, RNP_LOAD_SAVE_BASE64);
+    if (flags) {
+        FFI_LOG(ffi, "unexpected flags remaining: 0x%X", flags);
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+
+    /* check whether input is base64 */
+    if (base64 && input->src.is_base64()) {
+        rnp_result_t ret = rnp_input_dearmor_if_needed(input, true);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    /* transferable subkey, see KeyStore::load_pgp() */
+    if (is_subkey_pkt(stream_pkt_type(input->src))) {
+        pgp_transferable_key_t tkey;
+        tkey.subkeys.emplace_back();
+        rnp_result_t ret = process_pgp_subkey(input->src, tkey.subkeys.front(), skipbad);
+        if (ret) {
+            return ret;
+        }
+        return ffi_import_ts_key(ffi, tkey, pub, sec, cb, app_ctx);
+    }
+
+    /* parse and import keys one by one */
+    return process_pgp_keys(
+      input->src,
+      [&](pgp_transferable_key_t &tkey) {
+          return ffi_import_ts_key(ffi, tkey, pub, sec, cb, app_ctx);
+      },
+      skipbad);
+}
+FFI_GUARD
+
 static const char *
 sig_status_to_str(pgp_sig_import_status_t status)
 {
@@ -1855,6 +2159,7 @@ try {
         return RNP_ERROR_OUT_OF_MEMORY; // LCOV_EXCL_LINE
     }
 
+    rnp::WriteLock lock(ffi->lock);
     for (auto &sig : sigs) {
         pgp_sig_import_status_t pub_status = PGP_SIG_IMPORT_STATUS_UNKNOWN;
         pgp_sig_import_status_t sec_status = PGP_SIG_IMPORT_STATUS_UNKNOWN;
@@ -1874,9 +2179,17 @@ try {
 FFI_GUARD
 
 static bool
-copy_store_keys(rnp_ffi_t ffi, rnp::KeyStore *dest, rnp::KeyStore *src)
+copy_store_keys(rnp_ffi_t ffi, rnp::KeyStore *dest, rnp::KeyStore *src, bool changed)
 {
     for (auto &key : src->keys) {
+        /* copy just changed primary keys with all of their subkeys, and changed subkeys
+         * without the primary key, i.e. secret subkeys of the offline primary key */
+        if (changed) {
+            auto primary = key.is_primary() ? &key : src->primary_key(key);
+            if (primary ? !src->changed(*primary) : !key.dirty()) {
+                continue;
+            }
+        }
         if (!dest->add_key(key)) {
             FFI_LOG(ffi, "failed to add key to the store");
             return false;
@@ -1885,12 +2198,38 @@ copy_store_keys(rnp_ffi_t ffi, rnp::KeyStore *dest, rnp::KeyStore *src)
     return true;
 }
 
+/* Saving to the directory, appending changes to the file or explicit request resets keys'
+ * change state, while export to the file or memory does not. */
+static bool
+save_marks_clean(rnp_output_t output, bool incremental, bool mark_clean)
+{
+    return mark_clean || output->dst_directory ||
+           (incremental && output->append && (output->dst.type == PGP_STREAM_FILE));
+}
+
 static rnp_result_t
 do_save_keys(rnp_ffi_t              ffi,
              rnp_output_t           output,
              pgp_key_store_format_t format,
-             key_type_t             key_type)
-{
+             key_type_t             key_type,
+             bool                   incremental,
+             bool                   mark_clean)
+{
+    bool pub = (key_type == KEY_TYPE_PUBLIC) || (key_type == KEY_TYPE_ANY);
+    bool sec = (key_type == KEY_TYPE_SECRET) || (key_type == KEY_TYPE_ANY);
+    // changes may be only appended to the file
+    if (incremental && !output->dst_directory && (output->dst.type == PGP_STREAM_FILE) &&
+        !output->append) {
+        FFI_LOG(ffi, "Incremental save requires output, opened for appending.");
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    // changes may be appended to the file only if nothing was removed
+    if (incremental && !output->dst_directory &&
+        ((pub && !ffi->pubring->appendable()) || (sec && !ffi->secring->appendable()))) {
+        FFI_LOG(ffi, "Keys were removed or replaced, full save is required.");
+        return RNP_ERROR_BAD_STATE;
+    }
+
     // create a temporary key store to hold the keys
     rnp::KeyStore *tmp_store = nullptr;
     try {
@@ -1908,16 +2247,12 @@ do_save_keys(rnp_ffi_t              ffi,
     }
     std::unique_ptr<rnp::KeyStore> tmp_store_ptr(tmp_store);
     // include the public keys, if desired
-    if (key_type == KEY_TYPE_PUBLIC || key_type == KEY_TYPE_ANY) {
-        if (!copy_store_keys(ffi, tmp_store, ffi->pubring)) {
-            return RNP_ERROR_OUT_OF_MEMORY; // LCOV_EXCL_LINE
-        }
+    if (pub && !copy_store_keys(ffi, tmp_store, ffi->pubring, incremental)) {
+        return RNP_ERROR_OUT_OF_MEMORY; // LCOV_EXCL_LINE
     }
     // include the secret keys, if desired
-    if (key_type == KEY_TYPE_SECRET || key_type == KEY_TYPE_ANY) {
-        if (!copy_store_keys(ffi, tmp_store, ffi->secring)) {
-            return RNP_ERROR_OUT_OF_MEMORY; // LCOV_EXCL_LINE
-        }
+    if (sec && !copy_store_keys(ffi, tmp_store, ffi->secring, incremental)) {
+        return RNP_ERROR_OUT_OF_MEMORY; // LCOV_EXCL_LINE
     }
     // preliminary check on the format
     for (auto &key : tmp_store->keys) {
@@ -1929,18 +2264,30 @@ do_save_keys(rnp_ffi_t              ffi,
     // write
     if (output->dst_directory) {
         tmp_store->path = output->dst_directory;
-        if (!tmp_store->write()) {
+        if (!tmp_store->write(incremental)) {
             return RNP_ERROR_WRITE;
         }
-        return RNP_SUCCESS;
     } else {
-        if (!tmp_store->write(output->dst)) {
+        if (!tmp_store->write(output->dst, incremental)) {
             return RNP_ERROR_WRITE;
         }
         dst_flush(&output->dst);
         output->keep = (output->dst.werr == RNP_SUCCESS);
-        return output->dst.werr;
+        if (output->dst.werr) {
+            return output->dst.werr;
+        }
+    }
+    if (!save_marks_clean(output, incremental, mark_clean)) {
+        return RNP_SUCCESS;
+    }
+    // saved keys are not changed anymore
+    if (pub) {
+        ffi->pubring->mark_clean();
+    }
+    if (sec) {
+        ffi->secring->mark_clean();
     }
+    return RNP_SUCCESS;
 }
 
 rnp_result_t
@@ -1955,6 +2302,8 @@ try {
         FFI_LOG(ffi, "invalid flags - must have public and/or secret keys");
         return RNP_ERROR_BAD_PARAMETERS;
     }
+    bool incremental = extract_flag(flags, RNP_LOAD_SAVE_INCREMENTAL);
+    bool mark_clean = extract_flag(flags, RNP_LOAD_SAVE_MARK_CLEAN);
     // check for any unrecognized flags (not forward-compat, but maybe still a good idea)
     if (flags) {
         FFI_LOG(ffi, "unexpected flags remaining: 0x%X", flags);
@@ -1965,7 +2314,8 @@ try {
         FFI_LOG(ffi, "unknown key store format: %s", format);
         return RNP_ERROR_BAD_PARAMETERS;
     }
-    return do_save_keys(ffi, output, ks_format, type);
+    rnp::RWLockGuard lock(ffi->lock, save_marks_clean(output, incremental, mark_clean));
+    return do_save_keys(ffi, output, ks_format, type, incremental, mark_clean);
 }
 FFI_GUARD
 
@@ -1991,6 +2341,55 @@ try {
 }
 FFI_GUARD
 
+rnp_result_t
+rnp_get_memory_usage(rnp_ffi_t ffi, uint32_t flags, size_t *usage)
+try {
+    if (!ffi || !usage) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (!(flags & (RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_SECRET_KEYS)) ||
+        (flags & ~(RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_SECRET_KEYS))) {
+        FFI_LOG(ffi, "Unknown flags: %" PRIu32, flags);
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+
+    rnp::ReadLock lock(ffi->lock);
+    size_t        res = 0;
+    if (flags & RNP_LOAD_SAVE_PUBLIC_KEYS) {
+        res += ffi->pubring->memory_usage();
+    }
+    if (flags & RNP_LOAD_SAVE_SECRET_KEYS) {
+        res += ffi->secring->memory_usage();
+    }
+    *usage = res;
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_release_memory(rnp_ffi_t ffi, uint32_t flags)
+try {
+    if (!ffi) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (!(flags & (RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_SECRET_KEYS)) ||
+        (flags & ~(RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_SECRET_KEYS))) {
+        FFI_LOG(ffi, "Unknown flags: %" PRIu32, flags);
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+
+    /* caches are used by the concurrent operations, so access must be exclusive */
+    rnp::WriteLock lock(ffi->lock);
+    if (flags & RNP_LOAD_SAVE_PUBLIC_KEYS) {
+        ffi->pubring->release_caches();
+    }
+    if (flags & RNP_LOAD_SAVE_SECRET_KEYS) {
+        ffi->secring->release_caches();
+    }
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
 rnp_input_st::rnp_input_st() : reader(NULL), closer(NULL), app_ctx(NULL)
 {
     memset(&src, 0, sizeof(src));
@@ -2023,9 +2422,9 @@ rnp_input_st::~rnp_input_st()
     }
 }
 
-rnp_result_t
-rnp_input_from_path(rnp_input_t *input, const char *path)
-try {
+static rnp_result_t
+input_from_path(rnp_input_t *input, const char *path, bool mmap)
+{
     if (!input || !path) {
         return RNP_ERROR_NULL_POINTER;
     }
@@ -2038,7 +2437,8 @@ try {
         (void) init_null_src(&ob->src);
     } else {
         // simple input from a file
-        rnp_result_t ret = init_file_src(&ob->src, path);
+        rnp_result_t ret =
+          mmap ? init_mmap_src(&ob->src, path) : init_file_src(&ob->src, path);
         if (ret) {
             delete ob;
             return ret;
@@ -2047,6 +2447,19 @@ try {
     *input = ob;
     return RNP_SUCCESS;
 }
+
+rnp_result_t
+rnp_input_from_path(rnp_input_t *input, const char *path)
+try {
+    return input_from_path(input, path, false);
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_input_from_path_mmap(rnp_input_t *input, const char *path)
+try {
+    return input_from_path(input, path, true);
+}
 FFI_GUARD
 
 rnp_result_t
@@ -2208,7 +2621,8 @@ try {
     }
     bool overwrite = extract_flag(flags, RNP_OUTPUT_FILE_OVERWRITE);
     bool random = extract_flag(flags, RNP_OUTPUT_FILE_RANDOM);
-    if (flags) {
+    bool append = extract_flag(flags, RNP_OUTPUT_FILE_APPEND);
+    if (flags || (append && (overwrite || random))) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
     rnp_output_t res = (rnp_output_t) calloc(1, sizeof(*res));
@@ -2216,7 +2630,10 @@ try {
         return RNP_ERROR_OUT_OF_MEMORY; // LCOV_EXCL_LINE
     }
     rnp_result_t ret = RNP_ERROR_GENERIC;
-    if (random) {
+    res->append = append;
+    if (append) {
+        ret = init_append_dest(&res->dst, path);
+    } else if (random) {
         ret = init_tmpfile_dest(&res->dst, path, overwrite);
     } else {
         ret = init_file_dest(&res->dst, path, overwrite);
@@ -2503,13 +2920,16 @@ rnp_op_set_compression(rnp_ffi_t ffi, rnp_ctx_t &ctx, const char *compression, i
         return RNP_ERROR_NULL_POINTER;
     }
 
+    /* "auto" means default algorithm, used only if data is compressible */
+    bool                   zauto = rnp::str_case_eq(compression, "auto");
     pgp_compression_type_t zalg = PGP_C_UNKNOWN;
-    if (!str_to_compression_alg(compression, &zalg)) {
+    if (!str_to_compression_alg(zauto ? DEFAULT_Z_ALG : compression, &zalg)) {
         FFI_LOG(ffi, "Invalid compression: %s", compression);
         return RNP_ERROR_BAD_PARAMETERS;
     }
     ctx.zalg = (int) zalg;
     ctx.zlevel = level;
+    ctx.zauto = zauto;
     return RNP_SUCCESS;
 }
 
@@ -2794,6 +3214,17 @@ try {
 }
 FFI_GUARD
 
+rnp_result_t
+rnp_op_encrypt_set_threads(rnp_op_encrypt_t op, size_t threads)
+try {
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    op->rnpctx.threads = rnp::ThreadPool::clamp_threads(threads);
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
 rnp_result_t
 rnp_op_encrypt_set_compression(rnp_op_encrypt_t op, const char *compression, int level)
 try {
@@ -2836,6 +3267,17 @@ try {
 }
 FFI_GUARD
 
+rnp_result_t
+rnp_op_sign_set_threads(rnp_op_sign_t op, size_t threads)
+try {
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    op->rnpctx.threads = rnp::ThreadPool::clamp_threads(threads);
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
 static pgp_write_handler_t
 pgp_write_handler(pgp_password_provider_t *pass_provider,
                   rnp_ctx_t *              rnpctx,
@@ -2888,7 +3330,9 @@ try {
     pgp_write_handler_t handler =
       pgp_write_handler(&op->ffi->pass_provider, &op->rnpctx, NULL, &op->ffi->key_provider);
 
-    rnp_result_t ret;
+    /* signing keys are unlocked in place, so signing requires exclusive access */
+    rnp::RWLockGuard lock(op->ffi->lock, !op->signatures.empty());
+    rnp_result_t     ret;
     if (!op->signatures.empty() && (ret = rnp_op_add_signatures(op->signatures, op->rnpctx))) {
         return ret;
     }
@@ -3089,7 +3533,9 @@ try {
     pgp_write_handler_t handler =
       pgp_write_handler(&op->ffi->pass_provider, &op->rnpctx, NULL, &op->ffi->key_provider);
 
-    rnp_result_t ret;
+    /* signing keys are unlocked in place, so signing requires exclusive access */
+    rnp::WriteLock lock(op->ffi->lock);
+    rnp_result_t   ret;
     if ((ret = rnp_op_add_signatures(op->signatures, op->rnpctx))) {
         return ret;
     }
@@ -3361,6 +3807,17 @@ try {
 }
 FFI_GUARD
 
+rnp_result_t
+rnp_op_verify_set_threads(rnp_op_verify_t op, size_t threads)
+try {
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    op->rnpctx.threads = rnp::ThreadPool::clamp_threads(threads);
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
 rnp_result_t
 rnp_op_verify_execute(rnp_op_verify_t op)
 try {
@@ -3386,7 +3843,9 @@ try {
     handler.param = op;
     handler.ctx = &op->rnpctx;
 
-    rnp_result_t ret = process_pgp_source(&handler, op->input->src);
+    /* secret keys are decrypted to the local copies, so shared access is enough */
+    rnp::ReadLock lock(op->ffi->lock);
+    rnp_result_t  ret = process_pgp_source(&handler, op->input->src);
     /* Allow to decrypt data ignoring the signatures check if requested */
     if (op->ignore_sigs && op->validated && (ret == RNP_ERROR_SIGNATURE_INVALID)) {
         ret = RNP_SUCCESS;
@@ -3732,8 +4191,8 @@ static rnp_key_handle_t
 get_signer_handle(rnp_ffi_t ffi, const pgp_signature_t &sig)
 {
     // search the stores
-    pgp_key_t *pub = ffi->pubring->get_signer(sig);
-    pgp_key_t *sec = ffi->secring->get_signer(sig);
+    pgp_key_t *pub = ffi_deferred_key(ffi, ffi->pubring->get_signer(sig));
+    pgp_key_t *sec = ffi_deferred_key(ffi, ffi->secring->get_signer(sig));
     if (!pub && !sec) {
         return nullptr;
     }
@@ -3796,9 +4255,9 @@ rnp_locate_key_int(rnp_ffi_t             ffi,
                    bool                  require_secret = false)
 {
     // search pubring
-    pgp_key_t *pub = ffi->pubring->search(locator);
-    // search secring
-    pgp_key_t *sec = ffi->secring->search(locator);
+    pgp_key_t *pub = find_key(ffi, locator, false, false);
+    // search secring, loading the lazily indexed key if needed
+    pgp_key_t *sec = find_key(ffi, locator, true, false);
 
     if (require_secret && !sec) {
         *handle = nullptr;
@@ -3829,6 +4288,7 @@ try {
     if (!search) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
+    rnp::ReadLock lock(ffi->lock);
     return rnp_locate_key_int(ffi, *search, handle);
 }
 FFI_GUARD
@@ -3848,6 +4308,7 @@ try {
         FFI_LOG(handle->ffi, "Invalid export flags, select only public or secret, not both.");
         return RNP_ERROR_BAD_PARAMETERS;
     }
+    rnp::ReadLock lock(handle->ffi->lock);
 
     // handle flags
     bool           armored = extract_flag(flags, RNP_KEY_EXPORT_ARMORED);
@@ -4117,7 +4578,8 @@ try {
         return RNP_ERROR_BAD_PARAMETERS;
     }
 
-    pgp_key_t *exkey = get_key_prefer_public(key);
+    rnp::WriteLock lock(key->ffi->lock);
+    pgp_key_t *    exkey = get_key_prefer_public(key);
     if (!exkey) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
@@ -4210,6 +4672,7 @@ try {
     if (!pub && !sec) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
+    rnp::WriteLock lock(key->ffi->lock);
     if (sub && get_key_prefer_public(key)->is_subkey()) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
@@ -4357,7 +4820,8 @@ try {
     }
     flags = origflags;
 
-    pgp_key_t *key = get_key_prefer_public(handle);
+    rnp::WriteLock lock(handle->ffi->lock);
+    pgp_key_t *    key = get_key_prefer_public(handle);
     if (!key) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
@@ -5666,6 +6130,7 @@ try {
         return RNP_ERROR_NULL_POINTER;
     }
 
+    rnp::WriteLock          lock(op->ffi->lock);
     rnp_result_t            ret = RNP_ERROR_GENERIC;
     pgp_key_t               pub;
     pgp_key_t               sec;
@@ -5797,7 +6262,7 @@ get_key_require_public(rnp_key_handle_t handle)
         rnp::KeyIDSearch idsrch(handle->sec->keyid());
         handle->pub = handle->ffi->key_provider.request_key(idsrch);
     }
-    return handle->pub;
+    return ffi_deferred_key(handle->ffi, handle->pub);
 }
 
 static pgp_key_t *
@@ -5822,7 +6287,7 @@ get_key_require_secret(rnp_key_handle_t handle)
         rnp::KeyIDSearch idsrch(handle->pub->keyid());
         handle->sec = handle->ffi->key_provider.request_key(idsrch, PGP_OP_UNKNOWN, true);
     }
-    return handle->sec;
+    return ffi_deferred_key(handle->ffi, handle->sec);
 }
 
 static rnp_result_t
@@ -5869,7 +6334,8 @@ try {
     info.primary = primary;
 
     /* obtain and unlok secret key */
-    pgp_key_t *secret_key = get_key_require_secret(handle);
+    rnp::WriteLock lock(handle->ffi->lock);
+    pgp_key_t *    secret_key = get_key_require_secret(handle);
     if (!secret_key || !secret_key->usable_for(PGP_OP_ADD_USERID)) {
         return RNP_ERROR_NO_SUITABLE_KEY;
     }
@@ -5884,6 +6350,11 @@ try {
     }
     /* add and certify userid */
     secret_key->add_uid_cert(info, hash_alg, handle->ffi->context, public_key);
+    /* keep keystore's userid index up to date */
+    handle->ffi->secring->index_uids(*secret_key);
+    if (public_key) {
+        handle->ffi->pubring->index_uids(*public_key);
+    }
     return RNP_SUCCESS;
 }
 FFI_GUARD
@@ -7080,13 +7551,18 @@ try {
         return RNP_ERROR_BAD_PARAMETERS;
     }
 
-    auto ssig = sig->sig;
+    auto          ssig = sig->sig;
+    rnp::ReadLock lock(sig->ffi->lock);
     if (!ssig->validity.validated) {
+        /* validation modifies the key's state so requires exclusive access */
+        rnp::WriteLock wlock(sig->ffi->lock);
         pgp_key_t *signer = sig->ffi->pubring->get_signer(ssig->sig, &sig->ffi->key_provider);
         if (!signer) {
             return RNP_ERROR_KEY_NOT_FOUND;
         }
-        signer->validate_sig(*sig->key, *ssig, sig->ffi->context);
+        if (!ssig->validity.validated) {
+            signer->validate_sig(*sig->key, *ssig, sig->ffi->context);
+        }
     }
 
     if (!ssig->validity.validated) {
@@ -7123,8 +7599,9 @@ try {
     if (sig->own_sig || !sig->sig) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
-    pgp_key_t *pkey = get_key_require_public(key);
-    pgp_key_t *skey = get_key_require_secret(key);
+    rnp::WriteLock lock(key->ffi->lock);
+    pgp_key_t *    pkey = get_key_require_public(key);
+    pgp_key_t *    skey = get_key_require_secret(key);
     if (!pkey && !skey) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
@@ -7147,7 +7624,7 @@ FFI_GUARD
 static rnp_result_t
 write_signature(rnp_signature_handle_t sig, pgp_dest_t &dst)
 {
-    sig->sig->rawpkt.write(dst);
+    sig->sig->sig.write(dst);
     dst_flush(&dst);
     return dst.werr;
 }
@@ -7233,8 +7710,9 @@ try {
     if (!key || !uid) {
         return RNP_ERROR_NULL_POINTER;
     }
-    pgp_key_t *pkey = get_key_require_public(key);
-    pgp_key_t *skey = get_key_require_secret(key);
+    rnp::WriteLock lock(key->ffi->lock);
+    pgp_key_t *    pkey = get_key_require_public(key);
+    pgp_key_t *    skey = get_key_require_secret(key);
     if (!pkey && !skey) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
@@ -7243,13 +7721,11 @@ try {
     }
 
     bool ok = false;
-    if (pkey && (pkey->uid_count() > uid->idx)) {
-        pkey->del_uid(uid->idx);
+    if (pkey && key->ffi->pubring->remove_uid(*pkey, uid->idx)) {
         pkey->revalidate(*key->ffi->pubring);
         ok = true;
     }
-    if (skey && (skey->uid_count() > uid->idx)) {
-        skey->del_uid(uid->idx);
+    if (skey && key->ffi->secring->remove_uid(*skey, uid->idx)) {
         skey->revalidate(*key->ffi->secring);
         ok = true;
     }
@@ -7594,10 +8070,8 @@ try {
     if (!key) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
-    if (!key->validated()) {
-        key->validate(*handle->ffi->pubring);
-    }
-    if (!key->validated()) {
+    rnp::ReadLock lock(handle->ffi->lock);
+    if (!ffi_validate_key(handle->ffi, *key)) {
         return RNP_ERROR_VERIFICATION_FAILED;
     }
     *result = key->valid();
@@ -7638,10 +8112,8 @@ try {
         return RNP_ERROR_BAD_PARAMETERS;
     }
 
-    if (!key->validated()) {
-        key->validate(*handle->ffi->pubring);
-    }
-    if (!key->validated()) {
+    rnp::ReadLock lock(handle->ffi->lock);
+    if (!ffi_validate_key(handle->ffi, *key)) {
         return RNP_ERROR_VERIFICATION_FAILED;
     }
 
@@ -7653,10 +8125,7 @@ try {
             *result = 0;
             return RNP_SUCCESS;
         }
-        if (!primary->validated()) {
-            primary->validate(*handle->ffi->pubring);
-        }
-        if (!primary->validated()) {
+        if (!ffi_validate_key(handle->ffi, *primary)) {
             return RNP_ERROR_VERIFICATION_FAILED;
         }
         *result = key->valid_till();
@@ -7689,7 +8158,8 @@ try {
         return RNP_ERROR_NULL_POINTER;
     }
 
-    pgp_key_t *pkey = get_key_prefer_public(key);
+    rnp::WriteLock lock(key->ffi->lock);
+    pgp_key_t *    pkey = get_key_prefer_public(key);
     if (!pkey) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
@@ -7941,7 +8411,8 @@ try {
     if (handle == NULL)
         return RNP_ERROR_NULL_POINTER;
 
-    pgp_key_t *key = get_key_require_secret(handle);
+    rnp::WriteLock lock(handle->ffi->lock);
+    pgp_key_t *    key = get_key_require_secret(handle);
     if (!key) {
         return RNP_ERROR_NO_SUITABLE_KEY;
     }
@@ -7958,14 +8429,16 @@ try {
     if (!handle) {
         return RNP_ERROR_NULL_POINTER;
     }
-    pgp_key_t *key = get_key_require_secret(handle);
+    rnp::WriteLock lock(handle->ffi->lock);
+    pgp_key_t *    key = get_key_require_secret(handle);
     if (!key) {
         return RNP_ERROR_NO_SUITABLE_KEY;
     }
     bool ok = false;
     if (password) {
         pgp_password_provider_t prov(rnp_password_provider_string,
-                                     reinterpret_cast<void *>(const_cast<char *>(password)));
+                                     reinterpret_cast<void *>(const_cast<char *>(password)),
+                                     &handle->ffi->s2k_cache);
         ok = key->unlock(prov);
     } else {
         ok = key->unlock(handle->ffi->pass_provider);
@@ -8023,7 +8496,8 @@ try {
     protection.iterations = iterations;
 
     // get the key
-    pgp_key_t *key = get_key_require_secret(handle);
+    rnp::WriteLock lock(handle->ffi->lock);
+    pgp_key_t *    key = get_key_require_secret(handle);
     if (!key) {
         return RNP_ERROR_NO_SUITABLE_KEY;
     }
@@ -8052,14 +8526,16 @@ try {
     }
 
     // get the key
-    pgp_key_t *key = get_key_require_secret(handle);
+    rnp::WriteLock lock(handle->ffi->lock);
+    pgp_key_t *    key = get_key_require_secret(handle);
     if (!key) {
         return RNP_ERROR_NO_SUITABLE_KEY;
     }
     bool ok = false;
     if (password) {
         pgp_password_provider_t prov(rnp_password_provider_string,
-                                     reinterpret_cast<void *>(const_cast<char *>(password)));
+                                     reinterpret_cast<void *>(const_cast<char *>(password)),
+                                     &handle->ffi->s2k_cache);
         ok = key->unprotect(prov, handle->ffi->context);
     } else {
         ok = key->unprotect(handle->ffi->pass_provider, handle->ffi->context);
@@ -8212,7 +8688,7 @@ add_json_mpis(json_object *jso, ...)
             ret = RNP_ERROR_BAD_PARAMETERS;
             goto done;
         }
-        if (!json_add_hex(jso, name, val->mpi, val->len)) {
+        if (!json_add_hex(jso, name, val->data(), val->bytes())) {
             ret = RNP_ERROR_OUT_OF_MEMORY;
             goto done;
         }
@@ -9042,6 +9518,345 @@ try {
 }
 FFI_GUARD
 
+#ifndef RNP_USE_STD_REGEX
+/* Convert \xNN escapes, which are not supported by regcomp(), to the characters */
+static std::string
+key_query_unescape(const std::string &src)
+{
+    std::string result;
+    result.reserve(src.length());
+    regex_t    r = {};
+    regmatch_t matches[1];
+    if (regcomp(&r, "\\\\x[0-9a-f]([0-9a-f])?", REG_EXTENDED | REG_ICASE) != 0) {
+        return src; // LCOV_EXCL_LINE
+    }
+
+    int offset = 0;
+    while (regexec(&r, src.c_str() + offset, 1, matches, 0) == 0) {
+        result.append(src, offset, matches[0].rm_so);
+        int         hexoff = matches[0].rm_so + 2;
+        std::string hex;
+        hex.push_back(src[offset + hexoff]);
+        if (hexoff + 1 < matches[0].rm_eo) {
+            hex.push_back(src[offset + hexoff + 1]);
+        }
+        char decoded = stoi(hex, 0, 16);
+        if ((decoded >= 0x7B && decoded <= 0x7D) || (decoded >= 0x24 && decoded <= 0x2E) ||
+            decoded == 0x5C || decoded == 0x5E) {
+            result.push_back('\\');
+            result.push_back(decoded);
+        } else if ((decoded == '[' || decoded == ']') &&
+                   /* not enclosed in [] */ (result.empty() || result.back() != '[')) {
+            result.push_back('[');
+            result.push_back(decoded);
+            result.push_back(']');
+        } else {
+            result.push_back(decoded);
+        }
+        offset += matches[0].rm_eo;
+    }
+    regfree(&r);
+
+    result.append(src.begin() + offset, src.end());
+    return result;
+}
+#endif
+
+namespace {
+/* Key search query, compiled once for all of the keys: hex identifiers are decoded and
+ * compared in binary form, userid regular expression is compiled only once. */
+class KeyQuery {
+    std::vector<uint8_t> id_;    /* decoded keyid, fingerprint or grip */
+    std::string          email_; /* lowercased <email> for the exact email search */
+    bool                 all_{};
+    bool                 re_ok_{};
+#ifndef RNP_USE_STD_REGEX
+    regex_t re_{};
+#else
+    std::regex re_;
+#endif
+
+  public:
+    KeyQuery() = default;
+    KeyQuery(const KeyQuery &) = delete;
+    KeyQuery &operator=(const KeyQuery &) = delete;
+    ~KeyQuery()
+    {
+#ifndef RNP_USE_STD_REGEX
+        if (re_ok_) {
+            regfree(&re_);
+        }
+#endif
+    }
+
+    bool
+    compile(const std::string &query)
+    {
+        if (query.empty()) {
+            all_ = true;
+            return true;
+        }
+        if (rnp::is_hex(query) && (query.length() >= PGP_KEY_ID_SIZE)) {
+            auto hex = rnp::strip_hex(query);
+            switch (hex.length()) {
+            case PGP_KEY_ID_SIZE:
+            case PGP_KEY_ID_SIZE * 2:
+            case PGP_FINGERPRINT_V4_SIZE * 2:
+            case PGP_FINGERPRINT_V5_SIZE * 2:
+                id_ = rnp::hex_to_bin(hex);
+                break;
+            default:
+                break;
+            }
+        }
+        if ((query.size() > 2) && (query.front() == '<') && (query.back() == '>')) {
+            email_ = query;
+            std::transform(email_.begin(), email_.end(), email_.begin(), ::tolower);
+        }
+#ifndef RNP_USE_STD_REGEX
+        re_ok_ = !regcomp(&re_, key_query_unescape(query).c_str(), REG_EXTENDED | REG_ICASE);
+#else
+        try {
+            re_.assign(query, std::regex_constants::ECMAScript | std::regex_constants::icase);
+            re_ok_ = true;
+        } catch (const std::exception &e) {
+            RNP_LOG("Invalid regular expression : %s, error %s.", query.c_str(), e.what());
+        }
+#endif
+        return re_ok_ || !id_.empty();
+    }
+
+    const std::vector<uint8_t> &
+    id() const noexcept
+    {
+        return id_;
+    }
+
+    const std::string &
+    email() const noexcept
+    {
+        return email_;
+    }
+
+    bool
+    matches_id(const pgp_key_t &key) const
+    {
+        size_t len = id_.size();
+        if (!len) {
+            return false;
+        }
+        /* short or long keyid */
+        auto &keyid = key.keyid();
+        if ((len <= keyid.size()) &&
+            !memcmp(keyid.data() + keyid.size() - len, id_.data(), len)) {
+            return true;
+        }
+        if ((len == key.fp().length) && !memcmp(key.fp().fingerprint, id_.data(), len)) {
+            return true;
+        }
+        return (len == key.grip().size()) && !memcmp(key.grip().data(), id_.data(), len);
+    }
+
+    bool
+    matches_uid(const std::string &uid) const
+    {
+        if (!email_.empty()) {
+            std::string luid = uid;
+            std::transform(luid.begin(), luid.end(), luid.begin(), ::tolower);
+            return luid.find(email_) != std::string::npos;
+        }
+        if (!re_ok_) {
+            return false;
+        }
+#ifndef RNP_USE_STD_REGEX
+        return !regexec(&re_, uid.c_str(), 0, NULL, 0);
+#else
+        return std::regex_search(uid, re_);
+#endif
+    }
+
+    bool
+    matches(const pgp_key_t &key) const
+    {
+        if (all_ || matches_id(key)) {
+            return true;
+        }
+        /* no need to check for userid over the subkey */
+        if (key.is_subkey()) {
+            return false;
+        }
+        for (size_t idx = 0; idx < key.uid_count(); idx++) {
+            if (matches_uid(key.get_uid(idx).str)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+} // namespace
+
+static bool
+key_search_flags_match(rnp_ffi_t ffi, const pgp_key_t &key, uint32_t flags)
+{
+    if (key.is_subkey() && !(flags & RNP_KEY_SEARCH_SUBKEYS)) {
+        return false;
+    }
+    return !(flags & RNP_KEY_SEARCH_SECRET) || ffi->secring->get_key(key.fp());
+}
+
+static void
+key_search_add(rnp_key_search_t                      search,
+               std::unordered_set<pgp_fingerprint_t> &added,
+               const pgp_key_t &                      key,
+               uint32_t                               flags)
+{
+    if (!key_search_flags_match(search->ffi, key, flags) || !added.insert(key.fp()).second) {
+        return;
+    }
+    search->fps.push_back(key.fp());
+}
+
+/* Lookup keys via the keystore indexes. Returns false if full scan is needed. */
+static bool
+key_search_indexed(rnp_key_search_t                      search,
+                   const KeyQuery &                       query,
+                   std::unordered_set<pgp_fingerprint_t> &added,
+                   uint32_t                               flags)
+{
+    auto &id = query.id();
+    for (auto store : {search->ffi->pubring, search->ffi->secring}) {
+        if (id.size() == PGP_KEY_ID_SIZE) {
+            pgp_key_id_t keyid;
+            std::copy(id.begin(), id.end(), keyid.begin());
+            auto it = store->keybyid.find(keyid);
+            if (it != store->keybyid.end()) {
+                for (auto &fp : it->second) {
+                    auto key = store->get_key(fp);
+                    if (key) {
+                        key_search_add(search, added, *key, flags);
+                    }
+                }
+            }
+            continue;
+        }
+        if ((id.size() == PGP_FINGERPRINT_V4_SIZE) || (id.size() == PGP_FINGERPRINT_V5_SIZE)) {
+            auto key = store->get_key(pgp_fingerprint_t(id));
+            if (key) {
+                key_search_add(search, added, *key, flags);
+            }
+        }
+        if (id.size() == PGP_KEY_GRIP_SIZE) {
+            pgp_key_grip_t grip;
+            std::copy(id.begin(), id.end(), grip.begin());
+            auto it = store->keybygrip.find(grip);
+            if (it != store->keybygrip.end()) {
+                for (auto &fp : it->second) {
+                    auto key = store->get_key(fp);
+                    if (key) {
+                        key_search_add(search, added, *key, flags);
+                    }
+                }
+            }
+        }
+        auto &email = query.email();
+        if (!email.empty() && (email.find_first_of("<>", 1) == email.size() - 1)) {
+            /* email without angle brackets inside is one of KeyStore::uid_emails() */
+            auto it = store->keybyemail.find(email);
+            if (it != store->keybyemail.end()) {
+                for (auto &fp : it->second) {
+                    auto key = store->get_key(fp);
+                    if (key) {
+                        key_search_add(search, added, *key, flags);
+                    }
+                }
+            }
+        } else if (!email.empty()) {
+            /* userid index has single entry per userid, which is much less then keys */
+            for (auto &uid : store->keybyuid) {
+                if (!query.matches_uid(uid.first)) {
+                    continue;
+                }
+                for (auto &fp : uid.second) {
+                    auto key = store->get_key(fp);
+                    /* index may have stale entries, so check the key */
+                    if (key && query.matches(*key)) {
+                        key_search_add(search, added, *key, flags);
+                    }
+                }
+            }
+        }
+    }
+    /* exact email search never needs the full scan, while hex identifier may be a userid */
+    return !query.email().empty() || !search->fps.empty();
+}
+
+rnp_result_t
+rnp_key_search_create(rnp_ffi_t         ffi,
+                      rnp_key_search_t *search,
+                      const char *      query,
+                      uint32_t          flags)
+try {
+    if (!ffi || !search) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (flags & ~(RNP_KEY_SEARCH_SECRET | RNP_KEY_SEARCH_SUBKEYS)) {
+        FFI_LOG(ffi, "Invalid flags: %" PRIu32, flags);
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    KeyQuery kquery;
+    if (!kquery.compile(query ? query : "")) {
+        FFI_LOG(ffi, "Invalid search query: %s", query);
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+
+    std::unique_ptr<rnp_key_search_st> res(new rnp_key_search_st(ffi));
+    std::unordered_set<pgp_fingerprint_t> added;
+    rnp::ReadLock                         lock(ffi->lock);
+    if ((kquery.id().empty() && kquery.email().empty()) ||
+        !key_search_indexed(res.get(), kquery, added, flags)) {
+        for (auto store : {ffi->pubring, ffi->secring}) {
+            for (auto &key : store->keys) {
+                if (kquery.matches(key)) {
+                    key_search_add(res.get(), added, key, flags);
+                }
+            }
+        }
+    }
+    *search = res.release();
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_key_search_next(rnp_key_search_t search, rnp_key_handle_t *handle)
+try {
+    if (!search || !handle) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    *handle = NULL;
+    rnp::ReadLock lock(search->ffi->lock);
+    /* key may be removed after the search, so skip it then */
+    while (search->idx < search->fps.size()) {
+        auto &fp = search->fps[search->idx++];
+        auto  pub = ffi_deferred_key(search->ffi, search->ffi->pubring->get_key(fp));
+        auto  sec = ffi_deferred_key(search->ffi, search->ffi->secring->get_key(fp));
+        if (pub || sec) {
+            *handle = new rnp_key_handle_st(search->ffi, pub, sec);
+            break;
+        }
+    }
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_key_search_destroy(rnp_key_search_t search)
+try {
+    delete search;
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
 rnp_result_t
 rnp_guess_contents(rnp_input_t input, char **contents)
 try {
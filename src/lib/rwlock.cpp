@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2025 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "rwlock.hpp"
+
+namespace rnp {
+
+void
+RWLock::lock()
+{
+    auto                         self = std::this_thread::get_id();
+    std::unique_lock<std::mutex> guard(lock_);
+    if (wdepth_ && (writer_ == self)) {
+        wdepth_++;
+        return;
+    }
+    /* release our own shared locks to avoid deadlock, they are restored in unlock() */
+    size_t own = 0;
+    auto   it = readers_.find(self);
+    if (it != readers_.end()) {
+        own = it->second;
+        readers_.erase(it);
+        upgrading_++;
+        cond_.notify_all();
+        cond_.wait(guard, [this]() { return !wdepth_ && readers_.empty(); });
+        upgrading_--;
+    } else {
+        /* upgrading threads go first, so data they read stays in place */
+        cond_.wait(guard,
+                   [this]() { return !wdepth_ && readers_.empty() && !upgrading_; });
+    }
+    writer_ = self;
+    wdepth_ = 1;
+    upgraded_ = own;
+}
+
+void
+RWLock::unlock()
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    if (--wdepth_) {
+        return;
+    }
+    if (upgraded_) {
+        readers_[writer_] = upgraded_;
+        upgraded_ = 0;
+    }
+    writer_ = std::thread::id();
+    cond_.notify_all();
+}
+
+void
+RWLock::lock_shared()
+{
+    auto                         self = std::this_thread::get_id();
+    std::unique_lock<std::mutex> guard(lock_);
+    /* exclusive side covers the shared one */
+    if (wdepth_ && (writer_ == self)) {
+        wdepth_++;
+        return;
+    }
+    auto it = readers_.find(self);
+    if (it != readers_.end()) {
+        it->second++;
+        return;
+    }
+    cond_.wait(guard, [this]() { return !wdepth_; });
+    readers_[self] = 1;
+}
+
+void
+RWLock::unlock_shared()
+{
+    auto                        self = std::this_thread::get_id();
+    std::lock_guard<std::mutex> guard(lock_);
+    if (wdepth_ && (writer_ == self)) {
+        wdepth_--;
+        return;
+    }
+    auto it = readers_.find(self);
+    if (it == readers_.end()) {
+        return; // LCOV_EXCL_LINE
+    }
+    if (!--it->second) {
+        readers_.erase(it);
+        cond_.notify_all();
+    }
+}
+
+} // namespace rnp
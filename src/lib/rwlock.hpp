@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2025 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RNP_RWLOCK_HPP_
+#define RNP_RWLOCK_HPP_
+
+#include <cstddef>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace rnp {
+
+/**
+ * @brief Reader/writer lock which protects the shared state (i.e. keyrings of the FFI
+ *        object). Any number of threads may hold the shared side, while exclusive side is
+ *        held by a single thread. Lock is re-entrant on both sides, since application
+ *        callbacks may call back into the library. Exclusive lock request from the thread
+ *        which already holds the shared side temporarily releases the shared side, and
+ *        restores it once exclusive side is released. Such upgrades are served before any
+ *        other exclusive request, so objects seen by the upgrading threads stay in place,
+ *        provided that code, executed under the upgraded lock, only adds or updates data
+ *        (i.e. loads a key or validates it), but never removes it.
+ */
+class RWLock {
+    std::mutex                        lock_;
+    std::condition_variable           cond_;
+    std::map<std::thread::id, size_t> readers_;
+    std::thread::id                   writer_{};
+    size_t                            wdepth_{};
+    size_t                            upgraded_{};
+    size_t                            upgrading_{}; /* threads waiting for the upgrade */
+
+  public:
+    RWLock() = default;
+    RWLock(const RWLock &) = delete;
+    RWLock &operator=(const RWLock &) = delete;
+
+    void lock();
+    void unlock();
+    void lock_shared();
+    void unlock_shared();
+};
+
+/** @brief RAII holder of the shared or exclusive side of RWLock. */
+class RWLockGuard {
+    RWLock &lock_;
+    bool    exclusive_;
+
+  public:
+    RWLockGuard(RWLock &lock, bool exclusive) : lock_(lock), exclusive_(exclusive)
+    {
+        exclusive_ ? lock_.lock() : lock_.lock_shared();
+    }
+    ~RWLockGuard()
+    {
+        exclusive_ ? lock_.unlock() : lock_.unlock_shared();
+    }
+    RWLockGuard(const RWLockGuard &) = delete;
+    RWLockGuard &operator=(const RWLockGuard &) = delete;
+};
+
+class ReadLock : public RWLockGuard {
+  public:
+    ReadLock(RWLock &lock) : RWLockGuard(lock, false){};
+};
+
+class WriteLock : public RWLockGuard {
+  public:
+    WriteLock(RWLock &lock) : RWLockGuard(lock, true){};
+};
+
+} // namespace rnp
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2025 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "thread-pool.hpp"
+
+namespace rnp {
+
+ThreadPool::ThreadPool(size_t threads)
+{
+    if (!threads) {
+        threads = default_threads();
+    }
+    threads = clamp_threads(threads);
+    workers_.reserve(threads);
+    try {
+        for (size_t i = 0; i < threads; i++) {
+            workers_.emplace_back(&ThreadPool::worker, this);
+        }
+    } catch (...) {
+        /* LCOV_EXCL_START */
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            stop_ = true;
+        }
+        cond_.notify_all();
+        for (auto &thread : workers_) {
+            thread.join();
+        }
+        throw;
+        /* LCOV_EXCL_END */
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        stop_ = true;
+    }
+    cond_.notify_all();
+    for (auto &thread : workers_) {
+        thread.join();
+    }
+}
+
+void
+ThreadPool::worker()
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> guard(lock_);
+            cond_.wait(guard, [this]() { return stop_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        /* packaged_task stores exception in the future, so nothing could escape here */
+        task();
+    }
+}
+
+size_t
+ThreadPool::default_threads() noexcept
+{
+    size_t res = std::thread::hardware_concurrency();
+    return res ? res : 1;
+}
+
+size_t
+ThreadPool::max_threads() noexcept
+{
+    /* do not let a bogus value exhaust the process, while allowing all of the cores */
+    return std::max(default_threads(), (size_t) 64);
+}
+
+} // namespace rnp
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2025 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RNP_THREAD_POOL_HPP_
+#define RNP_THREAD_POOL_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rnp {
+
+/**
+ * @brief Fixed-size pool of worker threads. Tasks are picked up in the order of submission,
+ *        results (and exceptions) are delivered via std::future. Destructor waits for all of
+ *        the already submitted tasks to complete.
+ */
+class ThreadPool {
+    std::vector<std::thread>          workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex                        lock_;
+    std::condition_variable           cond_;
+    bool                              stop_{};
+
+    void worker();
+
+  public:
+    /**
+     * @brief Create pool with the specified number of threads.
+     * @param threads number of worker threads. 0 means default value, see default_threads().
+     *                Values above max_threads() are limited to it.
+     */
+    ThreadPool(size_t threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t
+    size() const noexcept
+    {
+        return workers_.size();
+    }
+
+    template <typename F>
+    std::future<decltype(std::declval<F &>()())>
+    submit(F func)
+    {
+        using R = decltype(std::declval<F &>()());
+        auto task = std::make_shared<std::packaged_task<R()>>(std::move(func));
+        auto res = task->get_future();
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            tasks_.emplace_back([task]() { (*task)(); });
+        }
+        cond_.notify_one();
+        return res;
+    }
+
+    /* Number of threads which is used if 0 is passed to the constructor */
+    static size_t default_threads() noexcept;
+
+    /* Maximum number of threads, larger values passed to the constructor are limited to it */
+    static size_t max_threads() noexcept;
+
+    /* Limit the requested number of threads to max_threads() */
+    static size_t
+    clamp_threads(size_t threads) noexcept
+    {
+        return std::min(threads, max_threads());
+    }
+};
+
+} // namespace rnp
+
+#endif
@@ -121,6 +121,19 @@ template <> struct hash<pgp_fingerprint_t> {
     }
 };
 
+template <> struct hash<pgp_key_id_t> {
+    std::size_t
+    operator()(pgp_key_id_t const &keyid) const noexcept
+    {
+        /* keyid is a part of the fingerprint, so its low bytes are random enough */
+        size_t res = 0;
+        static_assert(std::tuple_size<pgp_key_id_t>::value >= sizeof(res),
+                      "pgp_key_id_t size mismatch");
+        std::memcpy(&res, keyid.data(), sizeof(res));
+        return res;
+    }
+};
+
 template <> struct hash<pgp_sig_id_t> {
     std::size_t
     operator()(pgp_sig_id_t const &sigid) const noexcept
@@ -169,19 +182,17 @@ typedef struct pgp_validity_t {
  * Type to keep signature without any openpgp-dependent data.
  */
 typedef struct pgp_signature_material_t {
-    union {
-        pgp_rsa_signature_t rsa;
-        pgp_dsa_signature_t dsa;
-        pgp_ec_signature_t  ecc;
-        pgp_eg_signature_t  eg;
-    };
+    /* mpi is a non-trivial type, so these cannot be members of union */
+    pgp_rsa_signature_t rsa;
+    pgp_dsa_signature_t dsa;
+    pgp_ec_signature_t  ecc;
+    pgp_eg_signature_t  eg;
 #if defined(ENABLE_CRYPTO_REFRESH)
-    pgp_ed25519_signature_t ed25519; // non-trivial type cannot be member in union
+    pgp_ed25519_signature_t ed25519;
 #endif
 #if defined(ENABLE_PQC)
-    pgp_dilithium_exdsa_signature_t
-                                dilithium_exdsa; // non-trivial type cannot be member in union
-    pgp_sphincsplus_signature_t sphincsplus;     // non-trivial type cannot be member in union
+    pgp_dilithium_exdsa_signature_t dilithium_exdsa;
+    pgp_sphincsplus_signature_t     sphincsplus;
 #endif
     pgp_hash_alg_t halg;
 } pgp_signature_material_t;
@@ -190,17 +201,16 @@ typedef struct pgp_signature_material_t {
  * Type to keep pk-encrypted data without any openpgp-dependent data.
  */
 typedef struct pgp_encrypted_material_t {
-    union {
-        pgp_rsa_encrypted_t  rsa;
-        pgp_eg_encrypted_t   eg;
-        pgp_sm2_encrypted_t  sm2;
-        pgp_ecdh_encrypted_t ecdh;
-    };
+    /* mpi is a non-trivial type, so these cannot be members of union */
+    pgp_rsa_encrypted_t  rsa;
+    pgp_eg_encrypted_t   eg;
+    pgp_sm2_encrypted_t  sm2;
+    pgp_ecdh_encrypted_t ecdh;
 #if defined(ENABLE_CRYPTO_REFRESH)
-    pgp_x25519_encrypted_t x25519; // non-trivial type cannot be member in union
+    pgp_x25519_encrypted_t x25519;
 #endif
 #if defined(ENABLE_PQC)
-    pgp_kyber_ecdh_encrypted_t kyber_ecdh; // non-trivial type cannot be member in union
+    pgp_kyber_ecdh_encrypted_t kyber_ecdh;
 #endif
 } pgp_encrypted_material_t;
 
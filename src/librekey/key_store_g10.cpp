@@ -332,15 +332,15 @@ gnupg_sexp_t::add_mpi(const std::string &name, const pgp::mpi &mpi)
     size_t               len = mpi.bytes();
     size_t               idx;
 
-    for (idx = 0; (idx < len) && !mpi.mpi[idx]; idx++)
+    for (idx = 0; (idx < len) && !mpi[idx]; idx++)
         ;
 
     if (idx < len) {
-        if (mpi.mpi[idx] & 0x80) {
+        if (mpi[idx] & 0x80) {
             data.append(0);
-            data.std::basic_string<uint8_t>::append(mpi.mpi + idx, len - idx);
+            data.std::basic_string<uint8_t>::append(mpi.data() + idx, len - idx);
         } else {
-            data.assign(mpi.mpi + idx, mpi.mpi + len);
+            data.assign(mpi.data() + idx, mpi.data() + len);
         }
         value_block->set_string(data);
     }
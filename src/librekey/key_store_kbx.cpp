@@ -692,10 +692,11 @@ kbx_write_x509(const KeyStore &key_store, pgp_dest_t &dst)
 } // namespace
 
 bool
-KeyStore::write_kbx(pgp_dest_t &dst)
+KeyStore::write_kbx(pgp_dest_t &dst, bool changed)
 {
     try {
-        if (!kbx_write_header(*this, dst)) {
+        /* changed keys are appended to the existing file, which already has header */
+        if (!changed && !kbx_write_header(*this, dst)) {
             RNP_LOG("Can't write KBX header");
             return false;
         }
@@ -704,13 +705,16 @@ KeyStore::write_kbx(pgp_dest_t &dst)
             if (!key.is_primary()) {
                 continue;
             }
+            if (changed && !this->changed(key)) {
+                continue;
+            }
             if (!kbx_write_pgp(*this, key, dst)) {
                 RNP_LOG("Can't write PGP blobs for key %p", &key);
                 return false;
             }
         }
 
-        if (!kbx_write_x509(*this, dst)) {
+        if (!changed && !kbx_write_x509(*this, dst)) {
             RNP_LOG("Can't write X509 blobs");
             return false;
         }
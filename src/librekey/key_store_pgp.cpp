@@ -35,6 +35,89 @@
 
 #include "types.h"
 #include "pgp-key.h"
+#include "thread-pool.hpp"
+#include <deque>
+
+namespace {
+/* Transferable key, converted to the key objects with verified self-signatures. This does not
+ * depend on the other keys of the keystore, so may be done on the worker thread. */
+struct PreparedKey {
+    pgp_key_t              key;
+    std::vector<pgp_key_t> subkeys;
+};
+
+std::unique_ptr<PreparedKey>
+prepare_key(const pgp_transferable_key_t &tkey, const rnp::SecurityContext &ctx)
+{
+    std::unique_ptr<PreparedKey> res(new PreparedKey());
+    res->key = pgp_key_t(tkey);
+    res->subkeys.reserve(tkey.subkeys.size());
+    for (auto &tskey : tkey.subkeys) {
+        res->subkeys.emplace_back(tskey, &res->key);
+        res->subkeys.back().validate_self_signatures(res->key, ctx);
+    }
+    res->key.validate_self_signatures(ctx);
+    return res;
+}
+
+bool
+add_prepared_key(rnp::KeyStore &ks, PreparedKey &pkey)
+{
+    /* self-signatures are verified already, so key is validated once with all subkeys */
+    ks.disable_validation = true;
+    pgp_key_t *addkey = ks.add_key(pkey.key);
+    if (!addkey) {
+        ks.disable_validation = false;
+        RNP_LOG("Failed to add key to key store.");
+        return false;
+    }
+    for (auto &subkey : pkey.subkeys) {
+        if (!ks.add_key(subkey)) {
+            RNP_LOG("Failed to add subkey to key store.");
+            ks.disable_validation = false;
+            ks.remove_key(*addkey, false);
+            return false;
+        }
+    }
+    ks.disable_validation = false;
+    if (!ks.lazy_validation) {
+        addkey->revalidate(ks);
+    }
+    return true;
+}
+
+/* Keys are prepared on the worker threads, while the calling one adds them to the keystore in
+ * the original order. */
+bool
+add_keys_parallel(rnp::KeyStore &ks, const std::vector<pgp_transferable_key_t> &tkeys)
+{
+    rnp::ThreadPool pool(ks.threads);
+    /* limit the number of prepared keys, waiting for addition, to keep memory usage low */
+    size_t                                                window = pool.size() * 4;
+    std::deque<std::future<std::unique_ptr<PreparedKey>>> pending;
+    const rnp::SecurityContext &                          ctx = ks.secctx;
+    size_t                                                next = 0;
+
+    while ((next < tkeys.size()) || !pending.empty()) {
+        while ((next < tkeys.size()) && (pending.size() < window)) {
+            auto &tkey = tkeys[next++];
+            pending.push_back(pool.submit([&tkey, &ctx]() { return prepare_key(tkey, ctx); }));
+        }
+        std::unique_ptr<PreparedKey> pkey;
+        try {
+            pkey = pending.front().get();
+        } catch (const std::exception &e) {
+            RNP_LOG("failed to add key: %s", e.what());
+            return false;
+        }
+        pending.pop_front();
+        if (!add_prepared_key(ks, *pkey)) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
 
 namespace rnp {
 bool
@@ -92,7 +175,9 @@ KeyStore::add_ts_key(pgp_transferable_key_t &tkey)
 
     /* now validate/refresh the whole key with subkeys */
     disable_validation = false;
-    addkey->revalidate(*this);
+    if (!lazy_validation) {
+        addkey->revalidate(*this);
+    }
     return true;
 }
 
@@ -139,6 +224,10 @@ KeyStore::load_pgp(pgp_source_t &src, bool skiperrors)
         if (ret) {
             return ret;
         }
+        /* with deferred validation there is nothing to offload to the worker threads */
+        if ((threads > 1) && !lazy_validation && (keys.keys.size() > 1)) {
+            return add_keys_parallel(*this, keys.keys) ? RNP_SUCCESS : RNP_ERROR_BAD_STATE;
+        }
         for (auto &key : keys.keys) {
             if (!add_ts_key(key)) {
                 return RNP_ERROR_BAD_STATE;
@@ -156,7 +245,7 @@ KeyStore::load_pgp(pgp_source_t &src, bool skiperrors)
 
 namespace {
 bool
-do_write(rnp::KeyStore &key_store, pgp_dest_t &dst, bool secret)
+do_write(rnp::KeyStore &key_store, pgp_dest_t &dst, bool secret, bool changed)
 {
     for (auto &key : key_store.keys) {
         if (key.is_secret() != secret) {
@@ -166,6 +255,10 @@ do_write(rnp::KeyStore &key_store, pgp_dest_t &dst, bool secret)
         if (!key.is_primary()) {
             continue;
         }
+        // the whole key is written if it or any of subkeys is changed, to be merged on load
+        if (changed && !key_store.changed(key)) {
+            continue;
+        }
 
         if (key.format != PGP_KEY_STORE_GPG) {
             RNP_LOG("incorrect format (conversions not supported): %d", key.format);
@@ -193,9 +286,9 @@ do_write(rnp::KeyStore &key_store, pgp_dest_t &dst, bool secret)
 
 namespace rnp {
 bool
-KeyStore::write_pgp(pgp_dest_t &dst)
+KeyStore::write_pgp(pgp_dest_t &dst, bool changed)
 {
     // two separate passes (public keys, then secret keys)
-    return do_write(*this, dst, false) && do_write(*this, dst, true);
+    return do_write(*this, dst, false, changed) && do_write(*this, dst, true, changed);
 }
 } // namespace rnp
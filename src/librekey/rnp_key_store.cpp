@@ -42,6 +42,7 @@
 #include <errno.h>
 #include <algorithm>
 #include <stdexcept>
+#include <unordered_set>
 
 #include <rekey/rnp_key_store.h>
 #include <librepgp/stream-packet.h>
@@ -75,7 +76,7 @@ KeyStore::load(const KeyProvider *key_provider)
         while (!((dirname = rnp_readdir_name(dir)).empty())) {
             std::string apath = rnp::path::append(path, dirname);
 
-            if (init_file_src(&src, apath.c_str())) {
+            if (init_mmap_src(&src, apath.c_str())) {
                 RNP_LOG("failed to read file %s", apath.c_str());
                 continue;
             }
@@ -86,11 +87,12 @@ KeyStore::load(const KeyProvider *key_provider)
             src.close();
         }
         rnp_closedir(dir);
+        mark_clean();
         return true;
     }
 
-    /* init file source and load from it */
-    if (init_file_src(&src, path.c_str())) {
+    /* init file source (memory-mapped if possible) and load from it */
+    if (init_mmap_src(&src, path.c_str())) {
         RNP_LOG("failed to read file %s", path.c_str());
         return false;
     }
@@ -100,77 +102,170 @@ KeyStore::load(const KeyProvider *key_provider)
     return rc;
 }
 
+bool
+KeyStore::index_g10(const std::string &dir)
+{
+    auto dirp = rnp_opendir(dir.c_str());
+    if (!dirp) {
+        RNP_LOG("Can't open G10 directory %s: %s", dir.c_str(), strerror(errno));
+        return false;
+    }
+
+    static const std::string ext = ".key";
+    std::string              name;
+    while (!((name = rnp_readdir_name(dirp)).empty())) {
+        /* file name is hex-encoded grip with .key extension */
+        if ((name.size() != PGP_KEY_GRIP_SIZE * 2 + ext.size()) ||
+            !str_case_eq(name.substr(PGP_KEY_GRIP_SIZE * 2), ext)) {
+            continue;
+        }
+        auto bin = rnp::hex_to_bin(name.substr(0, PGP_KEY_GRIP_SIZE * 2));
+        if (bin.size() != PGP_KEY_GRIP_SIZE) {
+            continue;
+        }
+        pgp_key_grip_t grip{};
+        memcpy(grip.data(), bin.data(), grip.size());
+        if (keybygrip.count(grip)) {
+            continue;
+        }
+        lazy_g10_[grip] = rnp::path::append(dir, name);
+    }
+    rnp_closedir(dirp);
+    return true;
+}
+
+pgp_key_t *
+KeyStore::load_lazy(const pgp_key_grip_t &grip, const KeyProvider *key_provider)
+{
+    auto it = lazy_g10_.find(grip);
+    if (it == lazy_g10_.end()) {
+        return nullptr;
+    }
+    /* key file is attempted only once, even if it fails to load */
+    std::string  apath = std::move(it->second);
+    pgp_source_t src = {};
+    lazy_g10_.erase(it);
+
+    if (init_mmap_src(&src, apath.c_str())) {
+        RNP_LOG("failed to read file %s", apath.c_str());
+        return nullptr;
+    }
+    bool res = load_g10(src, key_provider);
+    src.close();
+    if (!res) {
+        RNP_LOG("Can't parse file: %s", apath.c_str());
+        return nullptr;
+    }
+    /* loaded key matches the stored one */
+    pgp_key_t *key = search(KeyGripSearch(grip));
+    if (key) {
+        key->mark_clean();
+    }
+    return key;
+}
+
+size_t
+KeyStore::lazy_count() const
+{
+    return lazy_g10_.size();
+}
+
+bool
+KeyStore::lazy_indexed(const pgp_key_grip_t &grip) const
+{
+    return lazy_g10_.count(grip);
+}
+
 bool
 KeyStore::load(pgp_source_t &src, const KeyProvider *key_provider)
 {
+    bool res = false;
     switch (format) {
     case PGP_KEY_STORE_GPG:
-        return !load_pgp(src);
+        res = !load_pgp(src);
+        break;
     case PGP_KEY_STORE_KBX:
-        return load_kbx(src, key_provider);
+        res = load_kbx(src, key_provider);
+        break;
     case PGP_KEY_STORE_G10:
-        return load_g10(src, key_provider);
+        res = load_g10(src, key_provider);
+        break;
     default:
         RNP_LOG("Unsupported load from memory for key-store format: %d", format);
     }
-
-    return false;
+    /* loaded keys match the stored ones */
+    if (res) {
+        mark_clean();
+    }
+    return res;
 }
 
 bool
-KeyStore::write()
+KeyStore::write_g10(bool incremental)
 {
-    bool       rc;
-    pgp_dest_t keydst = {};
-
-    /* write g10 key store to the directory */
-    if (format == PGP_KEY_STORE_G10) {
-        char chpath[MAXPATHLEN];
+    char chpath[MAXPATHLEN];
 
-        struct stat path_stat;
-        if (rnp_stat(path.c_str(), &path_stat) != -1) {
-            if (!S_ISDIR(path_stat.st_mode)) {
-                RNP_LOG("G10 keystore should be a directory: %s", path.c_str());
-                return false;
-            }
-        } else {
-            if (errno != ENOENT) {
-                RNP_LOG("stat(%s): %s", path.c_str(), strerror(errno));
-                return false;
-            }
-            if (RNP_MKDIR(path.c_str(), S_IRWXU) != 0) {
-                RNP_LOG("mkdir(%s, S_IRWXU): %s", path.c_str(), strerror(errno));
-                return false;
-            }
+    struct stat path_stat;
+    if (rnp_stat(path.c_str(), &path_stat) != -1) {
+        if (!S_ISDIR(path_stat.st_mode)) {
+            RNP_LOG("G10 keystore should be a directory: %s", path.c_str());
+            return false;
+        }
+    } else {
+        if (errno != ENOENT) {
+            RNP_LOG("stat(%s): %s", path.c_str(), strerror(errno));
+            return false;
         }
+        if (RNP_MKDIR(path.c_str(), S_IRWXU) != 0) {
+            RNP_LOG("mkdir(%s, S_IRWXU): %s", path.c_str(), strerror(errno));
+            return false;
+        }
+    }
 
-        for (auto &key : keys) {
-            auto grip = rnp::bin_to_hex(key.grip().data(), key.grip().size());
-            snprintf(chpath, sizeof(chpath), "%s/%s.key", path.c_str(), grip.c_str());
+    for (auto &key : keys) {
+        /* each key is stored in the separate file, so just skip unchanged ones */
+        if (incremental && !key.dirty()) {
+            continue;
+        }
+        auto grip = rnp::bin_to_hex(key.grip().data(), key.grip().size());
+        snprintf(chpath, sizeof(chpath), "%s/%s.key", path.c_str(), grip.c_str());
 
-            if (init_tmpfile_dest(&keydst, chpath, true)) {
-                RNP_LOG("failed to create file");
-                return false;
-            }
+        pgp_dest_t keydst = {};
+        if (init_tmpfile_dest(&keydst, chpath, true)) {
+            RNP_LOG("failed to create file");
+            return false;
+        }
 
-            if (!rnp_key_store_gnupg_sexp_to_dst(&key, &keydst)) {
-                RNP_LOG("failed to write key to file");
-                dst_close(&keydst, true);
-                return false;
-            }
+        if (!rnp_key_store_gnupg_sexp_to_dst(&key, &keydst)) {
+            RNP_LOG("failed to write key to file");
+            dst_close(&keydst, true);
+            return false;
+        }
 
-            rc = dst_finish(&keydst) == RNP_SUCCESS;
-            dst_close(&keydst, !rc);
+        bool rc = dst_finish(&keydst) == RNP_SUCCESS;
+        dst_close(&keydst, !rc);
 
-            if (!rc) {
-                return false;
-            }
+        if (!rc) {
+            return false;
         }
+    }
+    return true;
+}
 
+bool
+KeyStore::write(bool incremental)
+{
+    /* write g10 key store to the directory */
+    if (format == PGP_KEY_STORE_G10) {
+        if (!write_g10(incremental)) {
+            return false;
+        }
+        mark_clean();
         return true;
     }
 
     /* write kbx/gpg store to the single file */
+    pgp_dest_t keydst = {};
     if (init_tmpfile_dest(&keydst, path.c_str(), true)) {
         RNP_LOG("failed to create keystore file");
         return false;
@@ -182,19 +277,22 @@ KeyStore::write()
         return false;
     }
 
-    rc = dst_finish(&keydst) == RNP_SUCCESS;
+    bool rc = dst_finish(&keydst) == RNP_SUCCESS;
     dst_close(&keydst, !rc);
+    if (rc) {
+        mark_clean();
+    }
     return rc;
 }
 
 bool
-KeyStore::write(pgp_dest_t &dst)
+KeyStore::write(pgp_dest_t &dst, bool changed)
 {
     switch (format) {
     case PGP_KEY_STORE_GPG:
-        return write_pgp(dst);
+        return write_pgp(dst, changed);
     case PGP_KEY_STORE_KBX:
-        return write_kbx(dst);
+        return write_kbx(dst, changed);
     default:
         RNP_LOG("Unsupported write to memory for key-store format: %d", format);
     }
@@ -202,12 +300,56 @@ KeyStore::write(pgp_dest_t &dst)
     return false;
 }
 
+bool
+KeyStore::appendable() const
+{
+    if (keys_removed_) {
+        return false;
+    }
+    for (auto &key : keys) {
+        if (key.change() == PGP_KEY_CHANGE_REPLACED) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+KeyStore::changed(const pgp_key_t &primary) const
+{
+    if (primary.dirty()) {
+        return true;
+    }
+    for (auto &fp : primary.subkey_fps()) {
+        auto subkey = get_key(fp);
+        if (subkey && subkey->dirty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+KeyStore::mark_clean()
+{
+    for (auto &key : keys) {
+        key.mark_clean();
+    }
+    keys_removed_ = false;
+}
+
 void
 KeyStore::clear()
 {
+    keys_removed_ = true;
     keybyfp.clear();
+    keybyid.clear();
+    keybygrip.clear();
+    keybyuid.clear();
+    keybyemail.clear();
     keys.clear();
     blobs.clear();
+    lazy_g10_.clear();
 }
 
 size_t
@@ -216,6 +358,72 @@ KeyStore::key_count() const
     return keys.size();
 }
 
+template <typename T>
+static size_t
+index_memory_usage(const T &index)
+{
+    size_t res = 0;
+    for (auto &entry : index) {
+        /* map node keeps the pointer to the next node */
+        res += sizeof(entry) + sizeof(void *) +
+               entry.second.capacity() * sizeof(pgp_fingerprint_t);
+    }
+    return res;
+}
+
+size_t
+KeyStore::memory_usage() const
+{
+    /* list node keeps pointers to the previous and the next nodes */
+    size_t res = keys.size() * 2 * sizeof(void *);
+    for (auto &key : keys) {
+        res += key.memory_usage();
+    }
+    res += keybyfp.size() * (sizeof(pgp_key_fp_map_t::value_type) + sizeof(void *));
+    res += index_memory_usage(keybyid);
+    res += index_memory_usage(keybygrip);
+    for (auto index : {&keybyuid, &keybyemail}) {
+        for (auto &entry : *index) {
+            res += entry.first.size();
+        }
+        res += index_memory_usage(*index);
+    }
+    for (auto &blob : blobs) {
+        res += sizeof(*blob) + blob->image().capacity();
+    }
+    for (auto &entry : lazy_g10_) {
+        res += sizeof(entry) + sizeof(void *) + entry.second.capacity();
+    }
+    return res;
+}
+
+void
+KeyStore::release_caches() const noexcept
+{
+    for (auto &key : keys) {
+        key.release_caches();
+    }
+}
+
+/* drop validity of the whole key, so primary key and all of its subkeys are revalidated
+ * together on the first use */
+void
+KeyStore::reset_validity(pgp_key_t &key)
+{
+    pgp_key_t *primary = key.is_primary() ? &key : primary_key(key);
+    if (!primary) {
+        key.reset_validity();
+        return;
+    }
+    primary->reset_validity();
+    for (auto &fp : primary->subkey_fps()) {
+        pgp_key_t *subkey = get_key(fp);
+        if (subkey) {
+            subkey->reset_validity();
+        }
+    }
+}
+
 bool
 KeyStore::refresh_subkey_grips(pgp_key_t &key)
 {
@@ -296,6 +504,7 @@ KeyStore::add_subkey(pgp_key_t &srckey, pgp_key_t *oldkey)
             oldkey = &keys.back();
             keybyfp[srckey.fp()] = std::prev(keys.end());
             *oldkey = pgp_key_t(srckey);
+            index_key(*oldkey);
             if (primary) {
                 primary->link_subkey_fp(*oldkey);
             }
@@ -305,6 +514,7 @@ KeyStore::add_subkey(pgp_key_t &srckey, pgp_key_t *oldkey)
             RNP_LOG_KEY("primary key is %s", primary);
             RNP_LOG("%s", e.what());
             if (oldkey) {
+                unindex_key(srckey);
                 keys.pop_back();
                 keybyfp.erase(srckey.fp());
             }
@@ -314,7 +524,7 @@ KeyStore::add_subkey(pgp_key_t &srckey, pgp_key_t *oldkey)
     }
 
     /* validate all added keys if not disabled */
-    if (!disable_validation && !oldkey->validated()) {
+    if (!disable_validation && !lazy_validation && !oldkey->validated()) {
         oldkey->validate_subkey(primary, secctx);
     }
     if (!oldkey->refresh_data(primary, secctx)) {
@@ -344,12 +554,15 @@ KeyStore::add_key(pgp_key_t &srckey)
             RNP_LOG_KEY("failed to merge key %s", &srckey);
             return NULL;
         }
+        /* merge could add new userids */
+        index_uids(*added_key);
     } else {
         try {
             keys.emplace_back();
             added_key = &keys.back();
             keybyfp[srckey.fp()] = std::prev(keys.end());
             *added_key = pgp_key_t(srckey);
+            index_key(*added_key);
             /* primary key may be added after subkeys, so let's handle this case correctly */
             if (!refresh_subkey_grips(*added_key)) {
                 RNP_LOG_KEY("failed to refresh subkey grips for %s", added_key);
@@ -359,6 +572,7 @@ KeyStore::add_key(pgp_key_t &srckey)
             RNP_LOG_KEY("key %s copying failed", &srckey);
             RNP_LOG("%s", e.what());
             if (added_key) {
+                unindex_key(srckey);
                 keys.pop_back();
                 keybyfp.erase(srckey.fp());
             }
@@ -368,7 +582,7 @@ KeyStore::add_key(pgp_key_t &srckey)
     }
 
     /* validate all added keys if not disabled or already validated */
-    if (!disable_validation && !added_key->validated()) {
+    if (!disable_validation && !lazy_validation && !added_key->validated()) {
         added_key->revalidate(*this);
     } else if (!added_key->refresh_data(secctx)) {
         RNP_LOG_KEY("Failed to refresh key %s data", &srckey);
@@ -379,6 +593,10 @@ KeyStore::add_key(pgp_key_t &srckey)
         if (&key == added_key) {
             continue;
         }
+        /* not yet validated keys will check designated revocations on the first use */
+        if (lazy_validation && !key.validated()) {
+            continue;
+        }
         if (key.validate_desig_revokes(*this)) {
             key.revalidate(*this);
         }
@@ -446,7 +664,10 @@ KeyStore::import_key(pgp_key_t &srckey, bool pubkey, pgp_key_import_status_t *st
             return nullptr;
         }
         bool changed = exkey->rawpkt_count() > expackets;
-        if (changed || !exkey->validated()) {
+        if (lazy_validation && changed) {
+            /* key will be revalidated with all of its subkeys on the first use */
+            reset_validity(*exkey);
+        } else if (!lazy_validation && (changed || !exkey->validated())) {
             /* this will revalidate primary key with all of its subkeys */
             exkey->revalidate(*this);
         }
@@ -580,6 +801,7 @@ KeyStore::remove_key(const pgp_key_t &key, bool subkeys)
             }
             /* if subkeys are deleted then no need to update grips */
             if (subkeys) {
+                unindex_key(*its->second);
                 keys.erase(its->second);
                 keybyfp.erase(its);
                 continue;
@@ -594,8 +816,10 @@ KeyStore::remove_key(const pgp_key_t &key, bool subkeys)
         }
     }
 
+    unindex_key(key);
     keys.erase(it->second);
     keybyfp.erase(it);
+    keys_removed_ = true;
     return true;
 }
 
@@ -609,6 +833,118 @@ KeyStore::get_key(const pgp_fingerprint_t &fpr) const
     return &*it->second;
 }
 
+void
+KeyStore::index_key(const pgp_key_t &key)
+{
+    keybyid[key.keyid()].push_back(key.fp());
+    keybygrip[key.grip()].push_back(key.fp());
+    index_uids(key);
+}
+
+void
+KeyStore::unindex_key(const pgp_key_t &key)
+{
+    auto unindex = [&key](std::vector<pgp_fingerprint_t> &fps) {
+        fps.erase(std::remove(fps.begin(), fps.end(), key.fp()), fps.end());
+        return fps.empty();
+    };
+    auto idit = keybyid.find(key.keyid());
+    if ((idit != keybyid.end()) && unindex(idit->second)) {
+        keybyid.erase(idit);
+    }
+    auto gripit = keybygrip.find(key.grip());
+    if ((gripit != keybygrip.end()) && unindex(gripit->second)) {
+        keybygrip.erase(gripit);
+    }
+    for (size_t idx = 0; idx < key.uid_count(); idx++) {
+        auto &uid = key.get_uid(idx).str;
+        unindex_fp(keybyuid, uid, key.fp());
+        for (auto &email : uid_emails(uid)) {
+            unindex_fp(keybyemail, email, key.fp());
+        }
+    }
+}
+
+void
+KeyStore::unindex_fp(pgp_key_uid_map_t &       index,
+                     const std::string &       value,
+                     const pgp_fingerprint_t &fp)
+{
+    auto it = index.find(value);
+    if (it == index.end()) {
+        return;
+    }
+    auto &fps = it->second;
+    fps.erase(std::remove(fps.begin(), fps.end(), fp), fps.end());
+    if (fps.empty()) {
+        index.erase(it);
+    }
+}
+
+std::vector<std::string>
+KeyStore::uid_emails(const std::string &uid)
+{
+    std::vector<std::string> res;
+    size_t                   start = uid.find('<');
+    while (start != std::string::npos) {
+        size_t end = uid.find('>', start + 1);
+        if (end == std::string::npos) {
+            break;
+        }
+        std::string email = uid.substr(start, end - start + 1);
+        std::transform(email.begin(), email.end(), email.begin(), ::tolower);
+        res.push_back(std::move(email));
+        start = uid.find('<', start + 1);
+    }
+    return res;
+}
+
+void
+KeyStore::index_uids(const pgp_key_t &key)
+{
+    auto index = [&key](std::vector<pgp_fingerprint_t> &fps) {
+        if (std::find(fps.begin(), fps.end(), key.fp()) == fps.end()) {
+            fps.push_back(key.fp());
+        }
+    };
+    for (size_t idx = 0; idx < key.uid_count(); idx++) {
+        auto &uid = key.get_uid(idx).str;
+        index(keybyuid[uid]);
+        for (auto &email : uid_emails(uid)) {
+            index(keybyemail[email]);
+        }
+    }
+}
+
+bool
+KeyStore::remove_uid(pgp_key_t &key, size_t idx)
+{
+    if (idx >= key.uid_count()) {
+        return false;
+    }
+    std::string uid = key.get_uid(idx).str;
+    key.del_uid(idx);
+    /* the same userid or email may be present more than once */
+    std::unordered_set<std::string> uids;
+    std::unordered_set<std::string> emails;
+    for (size_t i = 0; i < key.uid_count(); i++) {
+        auto &other = key.get_uid(i).str;
+        uids.insert(other);
+        for (auto &email : uid_emails(other)) {
+            emails.insert(email);
+        }
+    }
+    if (!uids.count(uid)) {
+        unindex_fp(keybyuid, uid, key.fp());
+    }
+    for (auto &email : uid_emails(uid)) {
+        if (!emails.count(email)) {
+            unindex_fp(keybyemail, email, key.fp());
+        }
+    }
+    return true;
+}
+
 pgp_key_t *
 KeyStore::get_key(const pgp_fingerprint_t &fpr)
 {
@@ -654,6 +990,32 @@ KeyStore::primary_key(const pgp_key_t &subkey)
     return nullptr;
 }
 
+pgp_key_t *
+KeyStore::search_index(const std::vector<pgp_fingerprint_t> &fps,
+                       const KeySearch &                     search,
+                       pgp_key_t *                           after)
+{
+    auto it = fps.begin();
+    // if after is provided, make sure it is in the list of candidates
+    if (after) {
+        it = std::find(fps.begin(), fps.end(), after->fp());
+        if (it == fps.end()) {
+            RNP_LOG("searching with non-keyrings after param");
+            return nullptr;
+        }
+        it = std::next(it);
+    }
+    while (it != fps.end()) {
+        // key may have been removed or modified bypassing the keystore, so check it anyway
+        pgp_key_t *key = get_key(*it);
+        if (key && search.matches(*key)) {
+            return key;
+        }
+        it = std::next(it);
+    }
+    return nullptr;
+}
+
 pgp_key_t *
 KeyStore::search(const KeySearch &search, pgp_key_t *after)
 {
@@ -670,6 +1032,47 @@ KeyStore::search(const KeySearch &search, pgp_key_t *after)
         return after ? nullptr : key;
     }
 
+    // keyid, grip and userid searches are resolved via the secondary indexes
+    const std::vector<pgp_fingerprint_t> *fps = nullptr;
+    bool                                  indexed = true;
+    switch (search.type()) {
+    case KeySearch::Type::KeyID: {
+        auto idsearch = dynamic_cast<const KeyIDSearch *>(&search);
+        assert(idsearch != nullptr);
+        // hidden (wildcard) keyid matches any key, so it is handled via the full scan
+        if (idsearch->hidden()) {
+            indexed = false;
+            break;
+        }
+        auto it = keybyid.find(idsearch->get_keyid());
+        fps = it != keybyid.end() ? &it->second : nullptr;
+        break;
+    }
+    case KeySearch::Type::Grip: {
+        auto gripsearch = dynamic_cast<const KeyGripSearch *>(&search);
+        assert(gripsearch != nullptr);
+        auto it = keybygrip.find(gripsearch->get_grip());
+        fps = it != keybygrip.end() ? &it->second : nullptr;
+        break;
+    }
+    case KeySearch::Type::UserID: {
+        auto uidsearch = dynamic_cast<const KeyUIDSearch *>(&search);
+        assert(uidsearch != nullptr);
+        auto it = keybyuid.find(uidsearch->get_uid());
+        fps = it != keybyuid.end() ? &it->second : nullptr;
+        break;
+    }
+    default:
+        indexed = false;
+    }
+    if (indexed) {
+        if (after && (get_key(after->fp()) != after)) {
+            RNP_LOG("searching with non-keyrings after param");
+            return nullptr;
+        }
+        return fps ? search_index(*fps, search, after) : nullptr;
+    }
+
     // if after is provided, make sure it is a member of the appropriate list
     auto it = std::find_if(keys.begin(), keys.end(), [after](const pgp_key_t &key) {
         return !after || (after == &key);
@@ -0,0 +1,445 @@
+/*
+ * Copyright (c) 2025 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base64-simd.h"
+#include "cpu-features.hpp"
+#include <cstring>
+#if defined(RNP_X86_SIMD)
+#include <immintrin.h>
+#elif defined(RNP_ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Decoding uses nibble-based lookup tables, as described by W. Mula and D. Lemire in
+ * "Faster Base64 Encoding and Decoding Using AVX2 Instructions": character is valid if
+ * bitmasks, looked up by the low and high nibbles, do not intersect. Then value is obtained by
+ * adding the offset looked up by the high nibble (with separate handling of '/').
+ */
+
+#if defined(RNP_X86_SIMD) || defined(RNP_ARM_NEON)
+static const uint8_t B64_LUT_LO[16] = {
+  0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b,
+  0x1a};
+static const uint8_t B64_LUT_HI[16] = {
+  0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+  0x10};
+/* '/': 47 + 16 = 63, '+': 43 + 19 = 62, digits and letters are selected by the high nibble */
+static const uint8_t B64_LUT_ROLL[16] = {
+  0x00, 0x10, 0x13, 0x04, 0xbf, 0xbf, 0xb9, 0xb9, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00};
+#endif
+
+#if defined(RNP_X86_SIMD)
+/* shuffle which converts 32-bit little-endian values to 3 big-endian bytes */
+static const uint8_t B64_PACK_SHUF[16] = {
+  2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, 0x80, 0x80, 0x80, 0x80};
+/* shuffle which puts bytes 1, 0, 2, 1 of each 3-byte group to the 32-bit lanes */
+static const uint8_t B64_UNPACK_SHUF[16] = {1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10};
+/* offsets to add to the 6-bit value, indexed as described in b64_encode_ssse3_block() */
+static const uint8_t B64_ENC_SHIFT[16] = {
+  0x47, 0xfc, 0xfc, 0xfc, 0xfc, 0xfc, 0xfc, 0xfc, 0xfc, 0xfc, 0xfc, 0xed, 0xf0, 0x41, 0x00,
+  0x00};
+
+#if defined(_MSC_VER) && !defined(__clang__)
+static inline unsigned
+b64_ctz(uint32_t val)
+{
+    unsigned long idx = 0;
+    _BitScanForward(&idx, val);
+    return idx;
+}
+#else
+#define b64_ctz(val) __builtin_ctz(val)
+#endif
+
+RNP_TARGET("ssse3")
+static inline __m128i
+b64_decode_ssse3_block(__m128i src, int &mask)
+{
+    const __m128i lut_lo = _mm_loadu_si128((const __m128i *) B64_LUT_LO);
+    const __m128i lut_hi = _mm_loadu_si128((const __m128i *) B64_LUT_HI);
+    const __m128i lut_roll = _mm_loadu_si128((const __m128i *) B64_LUT_ROLL);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+
+    __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(src, 4), nibble);
+    __m128i lo_nibbles = _mm_and_si128(src, nibble);
+    __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+    __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+    /* bit is set for each valid character */
+    mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128()));
+    __m128i eq_slash = _mm_cmpeq_epi8(src, _mm_set1_epi8('/'));
+    __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_slash, hi_nibbles));
+    return _mm_add_epi8(src, roll);
+}
+
+RNP_TARGET("ssse3")
+static size_t
+b64_decode_ssse3(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t pos = 0;
+    while (len - pos >= 16) {
+        int     mask = 0;
+        __m128i src = _mm_loadu_si128((const __m128i *) (in + pos));
+        _mm_storeu_si128((__m128i *) (out + pos), b64_decode_ssse3_block(src, mask));
+        if (mask != 0xffff) {
+            return pos + b64_ctz(~mask);
+        }
+        pos += 16;
+    }
+    return pos;
+}
+
+/* load 16-byte table to the both lanes of the 256-bit register */
+RNP_TARGET("avx2")
+static inline __m256i
+b64_load_avx2(const uint8_t *table)
+{
+    return _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) table));
+}
+
+RNP_TARGET("avx2")
+static size_t
+b64_decode_avx2(const uint8_t *in, size_t len, uint8_t *out)
+{
+    const __m256i lut_lo = b64_load_avx2(B64_LUT_LO);
+    const __m256i lut_hi = b64_load_avx2(B64_LUT_HI);
+    const __m256i lut_roll = b64_load_avx2(B64_LUT_ROLL);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i slash = _mm256_set1_epi8('/');
+
+    size_t pos = 0;
+    while (len - pos >= 32) {
+        __m256i src = _mm256_loadu_si256((const __m256i *) (in + pos));
+        __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(src, 4), nibble);
+        __m256i lo_nibbles = _mm256_and_si256(src, nibble);
+        __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+        __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+        __m256i eq_slash = _mm256_cmpeq_epi8(src, slash);
+        __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_slash, hi_nibbles));
+        _mm256_storeu_si256((__m256i *) (out + pos), _mm256_add_epi8(src, roll));
+        uint32_t mask = (uint32_t) _mm256_movemask_epi8(
+          _mm256_cmpeq_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256()));
+        if (mask != 0xffffffff) {
+            return pos + b64_ctz(~mask);
+        }
+        pos += 32;
+    }
+    /* process the tail with 16-byte vectors */
+    return pos + b64_decode_ssse3(in + pos, len - pos, out + pos);
+}
+
+RNP_TARGET("ssse3")
+static inline __m128i
+b64_pack_ssse3_block(__m128i src)
+{
+    /* 00aaaaaa 00bbbbbb 00cccccc 00dddddd -> 0000aaaa aabbbbbb 0000cccc ccdddddd */
+    __m128i ab_cd = _mm_maddubs_epi16(src, _mm_set1_epi32(0x01400140));
+    /* -> 00000000 aaaaaabb bbbbcccc ccdddddd */
+    __m128i abcd = _mm_madd_epi16(ab_cd, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(abcd, _mm_loadu_si128((const __m128i *) B64_PACK_SHUF));
+}
+
+RNP_TARGET("ssse3")
+static size_t
+b64_pack_ssse3(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t pos = 0;
+    /* 16 bytes are stored while only 12 are meaningful, so check for the output space */
+    while (len - pos >= 24) {
+        __m128i src = _mm_loadu_si128((const __m128i *) (in + pos));
+        _mm_storeu_si128((__m128i *) out, b64_pack_ssse3_block(src));
+        pos += 16;
+        out += 12;
+    }
+    return pos;
+}
+
+RNP_TARGET("avx2")
+static size_t
+b64_pack_avx2(const uint8_t *in, size_t len, uint8_t *out)
+{
+    const __m256i shuf = b64_load_avx2(B64_PACK_SHUF);
+    const __m256i perm = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+
+    size_t pos = 0;
+    /* 32 bytes are stored while only 24 are meaningful */
+    while (len - pos >= 44) {
+        __m256i src = _mm256_loadu_si256((const __m256i *) (in + pos));
+        __m256i ab_cd = _mm256_maddubs_epi16(src, _mm256_set1_epi32(0x01400140));
+        __m256i abcd = _mm256_madd_epi16(ab_cd, _mm256_set1_epi32(0x00011000));
+        abcd = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(abcd, shuf), perm);
+        _mm256_storeu_si256((__m256i *) out, abcd);
+        pos += 32;
+        out += 24;
+    }
+    return pos + b64_pack_ssse3(in + pos, len - pos, out);
+}
+/* expand 12 input bytes to 16 6-bit values, one per byte */
+RNP_TARGET("ssse3")
+static inline __m128i
+b64_unpack_ssse3_block(__m128i src)
+{
+    /* bytes 1, 0, 2, 1 of each 3-byte group to the 32-bit lane */
+    src = _mm_shuffle_epi8(src, _mm_loadu_si128((const __m128i *) B64_UNPACK_SHUF));
+    /* aaaaaa and cccccc to the low bits of 16-bit words */
+    __m128i ac = _mm_mulhi_epu16(_mm_and_si128(src, _mm_set1_epi32(0x0fc0fc00)),
+                                 _mm_set1_epi32(0x04000040));
+    /* bbbbbb and dddddd to the high bytes of 16-bit words */
+    __m128i bd = _mm_mullo_epi16(_mm_and_si128(src, _mm_set1_epi32(0x003f03f0)),
+                                 _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(ac, bd);
+}
+
+/* map 6-bit values to the base64 alphabet characters */
+RNP_TARGET("ssse3")
+static inline __m128i
+b64_encode_ssse3_block(__m128i idx)
+{
+    /* 0..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12, and 13 for 0..25 */
+    __m128i shift = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+    __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), idx);
+    shift = _mm_or_si128(shift, _mm_and_si128(upper, _mm_set1_epi8(13)));
+    shift = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) B64_ENC_SHIFT), shift);
+    return _mm_add_epi8(idx, shift);
+}
+
+RNP_TARGET("ssse3")
+static size_t
+b64_encode_ssse3(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t pos = 0;
+    /* 16 bytes are loaded while only 12 are used, so check for the input length */
+    while (len - pos >= 16) {
+        __m128i src = _mm_loadu_si128((const __m128i *) (in + pos));
+        _mm_storeu_si128((__m128i *) out, b64_encode_ssse3_block(b64_unpack_ssse3_block(src)));
+        pos += 12;
+        out += 16;
+    }
+    /* short lines would have a noticeable tail otherwise */
+    if (len - pos >= 12) {
+        uint8_t tmp[16] = {0};
+        memcpy(tmp, in + pos, 12);
+        __m128i src = _mm_loadu_si128((const __m128i *) tmp);
+        _mm_storeu_si128((__m128i *) out, b64_encode_ssse3_block(b64_unpack_ssse3_block(src)));
+        pos += 12;
+    }
+    return pos;
+}
+
+RNP_TARGET("avx2")
+static size_t
+b64_encode_avx2(const uint8_t *in, size_t len, uint8_t *out)
+{
+    const __m256i shuf = b64_load_avx2(B64_UNPACK_SHUF);
+    const __m256i shift_lut = b64_load_avx2(B64_ENC_SHIFT);
+
+    size_t pos = 0;
+    /* each lane gets 12 bytes, with 16 bytes loaded, so 28 bytes must be available */
+    while (len - pos >= 28) {
+        __m256i src = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) (in + pos))),
+          _mm_loadu_si128((const __m128i *) (in + pos + 12)),
+          1);
+        src = _mm256_shuffle_epi8(src, shuf);
+        __m256i ac = _mm256_mulhi_epu16(_mm256_and_si256(src, _mm256_set1_epi32(0x0fc0fc00)),
+                                        _mm256_set1_epi32(0x04000040));
+        __m256i bd = _mm256_mullo_epi16(_mm256_and_si256(src, _mm256_set1_epi32(0x003f03f0)),
+                                        _mm256_set1_epi32(0x01000010));
+        __m256i idx = _mm256_or_si256(ac, bd);
+        __m256i shift = _mm256_subs_epu8(idx, _mm256_set1_epi8(51));
+        __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), idx);
+        shift = _mm256_or_si256(shift, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+        shift = _mm256_shuffle_epi8(shift_lut, shift);
+        _mm256_storeu_si256((__m256i *) out, _mm256_add_epi8(idx, shift));
+        pos += 24;
+        out += 32;
+    }
+    return pos + b64_encode_ssse3(in + pos, len - pos, out);
+}
+#endif
+
+#if defined(RNP_ARM_NEON)
+static const uint8_t B64_ALPHABET[64] = {
+  'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R',
+  'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j',
+  'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', '0', '1',
+  '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'};
+
+static size_t
+b64_decode_neon(const uint8_t *in, size_t len, uint8_t *out)
+{
+    const uint8x16_t lut_lo = vld1q_u8(B64_LUT_LO);
+    const uint8x16_t lut_hi = vld1q_u8(B64_LUT_HI);
+    const uint8x16_t lut_roll = vld1q_u8(B64_LUT_ROLL);
+    const uint8x16_t slash = vdupq_n_u8('/');
+
+    size_t pos = 0;
+    while (len - pos >= 16) {
+        uint8x16_t src = vld1q_u8(in + pos);
+        uint8x16_t hi_nibbles = vshrq_n_u8(src, 4);
+        uint8x16_t lo_nibbles = vandq_u8(src, vdupq_n_u8(0x0f));
+        uint8x16_t lo = vqtbl1q_u8(lut_lo, lo_nibbles);
+        uint8x16_t hi = vqtbl1q_u8(lut_hi, hi_nibbles);
+        /* 0xff for each invalid character */
+        uint8x16_t invalid = vtstq_u8(lo, hi);
+        uint8x16_t eq_slash = vceqq_u8(src, slash);
+        uint8x16_t roll = vqtbl1q_u8(lut_roll, vaddq_u8(eq_slash, hi_nibbles));
+        vst1q_u8(out + pos, vaddq_u8(src, roll));
+        if (vmaxvq_u8(invalid)) {
+            /* 4 bits of mask per each byte */
+            uint8x8_t bits = vshrn_n_u16(vreinterpretq_u16_u8(invalid), 4);
+            uint64_t  mask = vget_lane_u64(vreinterpret_u64_u8(bits), 0);
+            return pos + (__builtin_ctzll(mask) >> 2);
+        }
+        pos += 16;
+    }
+    return pos;
+}
+
+static size_t
+b64_pack_neon(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t pos = 0;
+    while (len - pos >= 64) {
+        uint8x16x4_t src = vld4q_u8(in + pos);
+        uint8x16x3_t dst;
+        dst.val[0] = vorrq_u8(vshlq_n_u8(src.val[0], 2), vshrq_n_u8(src.val[1], 4));
+        dst.val[1] = vorrq_u8(vshlq_n_u8(src.val[1], 4), vshrq_n_u8(src.val[2], 2));
+        dst.val[2] = vorrq_u8(vshlq_n_u8(src.val[2], 6), src.val[3]);
+        vst3q_u8(out, dst);
+        pos += 64;
+        out += 48;
+    }
+    return pos;
+}
+static size_t
+b64_encode_neon(const uint8_t *in, size_t len, uint8_t *out)
+{
+    const uint8x16_t mask = vdupq_n_u8(0x3f);
+    uint8x16x4_t     alphabet;
+    for (int i = 0; i < 4; i++) {
+        alphabet.val[i] = vld1q_u8(B64_ALPHABET + 16 * i);
+    }
+
+    size_t pos = 0;
+    while (len - pos >= 48) {
+        uint8x16x3_t src = vld3q_u8(in + pos);
+        uint8x16_t   ab = vorrq_u8(vshlq_n_u8(src.val[0], 4), vshrq_n_u8(src.val[1], 4));
+        uint8x16_t   bc = vorrq_u8(vshlq_n_u8(src.val[1], 2), vshrq_n_u8(src.val[2], 6));
+        uint8x16x4_t idx;
+        idx.val[0] = vshrq_n_u8(src.val[0], 2);
+        idx.val[1] = vandq_u8(ab, mask);
+        idx.val[2] = vandq_u8(bc, mask);
+        idx.val[3] = vandq_u8(src.val[2], mask);
+        uint8x16x4_t dst;
+        for (int i = 0; i < 4; i++) {
+            dst.val[i] = vqtbl4q_u8(alphabet, idx.val[i]);
+        }
+        vst4q_u8(out, dst);
+        pos += 48;
+        out += 64;
+    }
+    return pos;
+}
+#endif
+
+static size_t
+b64_none(const uint8_t *in, size_t len, uint8_t *out)
+{
+    return 0;
+}
+
+typedef size_t b64_func_t(const uint8_t *in, size_t len, uint8_t *out);
+
+static b64_func_t *
+b64_select_decode()
+{
+#if defined(RNP_X86_SIMD)
+    if (rnp::cpu::has_avx2()) {
+        return b64_decode_avx2;
+    }
+    if (rnp::cpu::has_ssse3()) {
+        return b64_decode_ssse3;
+    }
+#elif defined(RNP_ARM_NEON)
+    return b64_decode_neon;
+#endif
+    return b64_none;
+}
+
+static b64_func_t *
+b64_select_pack()
+{
+#if defined(RNP_X86_SIMD)
+    if (rnp::cpu::has_avx2()) {
+        return b64_pack_avx2;
+    }
+    if (rnp::cpu::has_ssse3()) {
+        return b64_pack_ssse3;
+    }
+#elif defined(RNP_ARM_NEON)
+    return b64_pack_neon;
+#endif
+    return b64_none;
+}
+
+static b64_func_t *
+b64_select_encode()
+{
+#if defined(RNP_X86_SIMD)
+    if (rnp::cpu::has_avx2()) {
+        return b64_encode_avx2;
+    }
+    if (rnp::cpu::has_ssse3()) {
+        return b64_encode_ssse3;
+    }
+#elif defined(RNP_ARM_NEON)
+    return b64_encode_neon;
+#endif
+    return b64_none;
+}
+
+size_t
+base64_decode_simd(const uint8_t *in, size_t len, uint8_t *out)
+{
+    static b64_func_t *const func = b64_select_decode();
+    return func(in, len, out);
+}
+
+size_t
+base64_pack_simd(const uint8_t *in, size_t len, uint8_t *out)
+{
+    static b64_func_t *const func = b64_select_pack();
+    return func(in, len, out);
+}
+
+size_t
+base64_encode_simd(const uint8_t *in, size_t len, uint8_t *out)
+{
+    static b64_func_t *const func = b64_select_encode();
+    return func(in, len, out);
+}
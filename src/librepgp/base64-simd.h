@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2025 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BASE64_SIMD_H_
+#define BASE64_SIMD_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Vectorized base64 decoding: map characters from the standard base64 alphabet to
+ *        their 6-bit values, stopping at the first character which is not from it
+ *        (whitespace, eol, padding or anything else). Tail which is shorter than the vector
+ *        size is left for the caller as well.
+ *        Implementation is selected at runtime depending on the CPU capabilities, if there is
+ *        no suitable one then 0 is always returned.
+ *
+ * @param in input characters.
+ * @param len number of characters in the input.
+ * @param out output buffer, must have space for at least len bytes. Bytes after the returned
+ *            number may be overwritten.
+ * @return number of characters which were processed, and 6-bit values written to the out.
+ */
+size_t base64_decode_simd(const uint8_t *in, size_t len, uint8_t *out);
+
+/**
+ * @brief Vectorized packing of 6-bit values, decoded by base64_decode_simd(), to the bytes:
+ *        each 4 values are converted to 3 bytes. Tail which is shorter than the vector size
+ *        is left for the caller.
+ *
+ * @param in input 6-bit values.
+ * @param len number of the input values, must be a multiple of 4.
+ * @param out output buffer, must have space for at least len / 4 * 3 bytes which is never
+ *            exceeded.
+ * @return number of the input values which were processed, result / 4 * 3 bytes are written.
+ */
+size_t base64_pack_simd(const uint8_t *in, size_t len, uint8_t *out);
+
+/**
+ * @brief Vectorized base64 encoding of the whole 3-byte groups, without any line breaks or
+ *        padding. Tail which is shorter than the vector size is left for the caller.
+ *
+ * @param in input data.
+ * @param len length of the input data.
+ * @param out output buffer, must have space for at least len / 3 * 4 characters which is never
+ *            exceeded.
+ * @return number of the input bytes which were processed (multiple of 3), result / 3 * 4
+ *         characters are written.
+ */
+size_t base64_encode_simd(const uint8_t *in, size_t len, uint8_t *out);
+
+#endif
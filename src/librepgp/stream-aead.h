@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2025 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef STREAM_AEAD_H_
+#define STREAM_AEAD_H_
+
+#include "config.h"
+#include <deque>
+#include <future>
+#include <memory>
+#include <vector>
+#include "crypto/symmetric.h"
+#include "thread-pool.hpp"
+
+#if defined(ENABLE_AEAD)
+/* Messages with larger chunks are decrypted on the caller's thread only */
+#define PGP_AEAD_MT_MAX_CHUNK_LEN (4 * 1024 * 1024)
+
+/* AEAD chunk, encrypted or decrypted on the thread pool */
+typedef struct pgp_aead_chunk_t {
+    pgp_crypt_t          crypt{};                        /* chunk's own crypto */
+    std::vector<uint8_t> data;                           /* input, replaced with output */
+    size_t               len{};                          /* input length */
+    uint8_t              ad[PGP_AEAD_MAX_AD_LEN]{};      /* additional data */
+    size_t               adlen{};                        /* length of the additional data */
+    uint8_t              nonce[PGP_AEAD_MAX_NONCE_LEN]{}; /* chunk's nonce */
+    size_t               nlen{};                         /* length of the nonce */
+    bool                 last{};                         /* final tag, without data */
+    std::future<bool>    res;                            /* processing result */
+
+    pgp_aead_chunk_t() = default;
+    pgp_aead_chunk_t(const pgp_aead_chunk_t &) = delete;
+    pgp_aead_chunk_t &operator=(const pgp_aead_chunk_t &) = delete;
+    ~pgp_aead_chunk_t()
+    {
+        pgp_cipher_aead_destroy(&crypt);
+    }
+
+    /* Encrypt or decrypt len bytes of data in place, adding or checking the tag */
+    bool
+    process()
+    {
+        uint8_t *buf = data.data();
+        return pgp_cipher_aead_set_ad(&crypt, ad, adlen) &&
+               pgp_cipher_aead_start(&crypt, nonce, nlen) &&
+               pgp_cipher_aead_finish(&crypt, buf, buf, len);
+    }
+} pgp_aead_chunk_t;
+
+/* State of the multithreaded AEAD processing. Chunks are prepared on the caller's thread,
+ * processed on the pool and then consumed strictly in order. */
+typedef struct pgp_aead_mt_t {
+    rnp::secure_vector<uint8_t>                    key;      /* data encryption key */
+    std::deque<std::unique_ptr<pgp_aead_chunk_t>>  queue;    /* chunks in flight, in order */
+    std::vector<std::unique_ptr<pgp_aead_chunk_t>> spare;    /* processed chunks to reuse */
+    std::unique_ptr<pgp_aead_chunk_t>              cur;      /* chunk being read or filled */
+    size_t                                         curpos{}; /* read position in cur */
+    size_t                                         depth{};  /* max chunks in flight */
+    size_t                                         chunks{}; /* number of data chunks */
+    uint64_t                                       total{};  /* number of data bytes */
+    bool                                           eof{};    /* final tag was queued */
+    /* must be destroyed first, so all the chunks are processed before deallocation */
+    std::unique_ptr<rnp::ThreadPool> pool;
+
+    pgp_aead_mt_t(const uint8_t *enckey, size_t keylen, size_t threads)
+        : key(enckey, enckey + keylen), pool(new rnp::ThreadPool(threads))
+    {
+        depth = 2 * pool->size();
+    }
+
+    /* Get a chunk to fill, with initialized crypto and buffer of the size bytes */
+    std::unique_ptr<pgp_aead_chunk_t>
+    get_chunk(pgp_symm_alg_t ealg, pgp_aead_alg_t aalg, size_t size, bool decrypt)
+    {
+        if (!spare.empty()) {
+            auto chunk = std::move(spare.back());
+            spare.pop_back();
+            return chunk;
+        }
+        std::unique_ptr<pgp_aead_chunk_t> chunk(new pgp_aead_chunk_t());
+        if (!pgp_cipher_aead_init(&chunk->crypt, ealg, aalg, key.data(), decrypt)) {
+            return nullptr; // LCOV_EXCL_LINE
+        }
+        chunk->data.resize(size);
+        return chunk;
+    }
+
+    void
+    submit(std::unique_ptr<pgp_aead_chunk_t> chunk)
+    {
+        auto ptr = chunk.get();
+        chunk->res = pool->submit([ptr]() { return ptr->process(); });
+        queue.push_back(std::move(chunk));
+    }
+
+    /* Wait for the first chunk in the queue, returning the processing result */
+    bool
+    pop(std::unique_ptr<pgp_aead_chunk_t> &chunk)
+    {
+        chunk = std::move(queue.front());
+        queue.pop_front();
+        return chunk->res.get();
+    }
+} pgp_aead_mt_t;
+#endif
+
+#endif
@@ -36,6 +36,7 @@
 #include <algorithm>
 #include "stream-def.h"
 #include "stream-armor.h"
+#include "base64-simd.h"
 #include "stream-packet.h"
 #include "str-utils.h"
 #include "crypto/hash.hpp"
@@ -286,10 +287,11 @@ static bool
 armored_src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
 {
     pgp_source_armored_param_t *param = (pgp_source_armored_param_t *) src->param;
-    uint8_t  b64buf[ARMORED_BLOCK_SIZE];     /* input base64 data with spaces and so on */
-    uint8_t  decbuf[ARMORED_BLOCK_SIZE + 4]; /* decoded 6-bit values */
-    uint8_t *bufptr = (uint8_t *) buf;       /* for better readability below */
-    uint8_t *bptr, *bend;                    /* pointer to input data in b64buf */
+    const uint8_t *b64buf;                         /* input base64 data, spaces and so on */
+    uint8_t        decbuf[ARMORED_BLOCK_SIZE + 4]; /* decoded 6-bit values */
+    uint8_t *      bufptr = (uint8_t *) buf;       /* for better readability below */
+    uint8_t *      crcptr = (uint8_t *) buf; /* decoded data which is not added to crc yet */
+    const uint8_t *bptr, *bend;              /* pointer to input data in b64buf */
     uint8_t *dptr, *dend, *pend; /* pointers to decoded data in decbuf: working pointer, last
                                     available byte, last byte to process */
     uint8_t  bval;
@@ -332,7 +334,9 @@ armored_src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
     dend = decbuf + param->brestlen;
 
     do {
-        if (!param->readsrc->peek(b64buf, sizeof(b64buf), &read)) {
+        /* source cache or mapped file contents, no need to copy */
+        b64buf = param->readsrc->peek_ptr(ARMORED_BLOCK_SIZE, &read);
+        if (!b64buf) {
             return false;
         }
         if (!read) {
@@ -345,6 +349,13 @@ armored_src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
         bend = b64buf + read;
         /* checking input data, stripping away whitespaces, checking for end of the b64 data */
         while (bptr < bend) {
+            /* vectorized decoding stops on anything which requires attention */
+            size_t vlen = base64_decode_simd(bptr, bend - bptr, dptr);
+            bptr += vlen;
+            dptr += vlen;
+            if (bptr >= bend) {
+                break;
+            }
             if ((bval = B64DEC[*(bptr++)]) < 64) {
                 *(dptr++) = bval;
             } else if (bval == 0xfe) {
@@ -376,6 +387,9 @@ armored_src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
         }
 
         /* this one would the most performance-consuming part for large chunks */
+        size_t vlen = base64_pack_simd(dptr, pend - dptr, bufptr);
+        dptr += vlen;
+        bufptr += vlen / 4 * 3;
         while (dptr < pend) {
             b24 = *dptr++ << 18;
             b24 |= *dptr++ << 12;
@@ -385,6 +399,11 @@ armored_src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
             *bufptr++ = b24 >> 8;
             *bufptr++ = b24 & 0xff;
         }
+        /* update crc while decoded data is still in the cache */
+        if (!armored_update_crc(param, crcptr, bufptr - crcptr)) {
+            return false;
+        }
+        crcptr = bufptr;
 
         /* moving rest to the beginning of decbuf */
         memmove(decbuf, dptr, dend - dptr);
@@ -434,19 +453,15 @@ armored_src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
 
     dptr = decbuf;
     pend = decbuf + (dend - decbuf) / 4 * 4;
-    bptr = param->rest;
+    uint8_t *rptr = param->rest;
     while (dptr < pend) {
         b24 = *dptr++ << 18;
         b24 |= *dptr++ << 12;
         b24 |= *dptr++ << 6;
         b24 |= *dptr++;
-        *bptr++ = b24 >> 16;
-        *bptr++ = b24 >> 8;
-        *bptr++ = b24 & 0xff;
-    }
-
-    if (!armored_update_crc(param, buf, bufptr - (uint8_t *) buf)) {
-        return false;
+        *rptr++ = b24 >> 16;
+        *rptr++ = b24 >> 8;
+        *rptr++ = b24 & 0xff;
     }
 
     if (param->eofb64) {
@@ -457,14 +472,14 @@ armored_src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
 
         if (eqcount == 1) {
             b24 = (*dptr << 10) | (*(dptr + 1) << 4) | (*(dptr + 2) >> 2);
-            *bptr++ = b24 >> 8;
-            *bptr++ = b24 & 0xff;
+            *rptr++ = b24 >> 8;
+            *rptr++ = b24 & 0xff;
         } else if (eqcount == 2) {
-            *bptr++ = (*dptr << 2) | (*(dptr + 1) >> 4);
+            *rptr++ = (*dptr << 2) | (*(dptr + 1) >> 4);
         }
 
         /* Calculate CRC after reading whole input stream */
-        if (!armored_update_crc(param, param->rest, bptr - param->rest, true)) {
+        if (!armored_update_crc(param, param->rest, rptr - param->rest, true)) {
             return false;
         }
     } else {
@@ -475,7 +490,7 @@ armored_src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
         param->brestlen = dend - dptr;
     }
 
-    param->restlen = bptr - param->rest;
+    param->restlen = rptr - param->rest;
 
     /* check whether we have some bytes to add */
     if ((left > 0) && (param->restlen > 0)) {
@@ -604,20 +619,12 @@ rnp_armor_guess_type(pgp_source_t *src)
 static pgp_armored_msg_t
 rnp_armored_guess_type_by_readahead(pgp_source_t *src)
 {
-    if (!src->cache) {
-        return PGP_ARMORED_UNKNOWN;
-    }
-
     pgp_source_t armorsrc = {0};
     pgp_source_t memsrc = {0};
-    size_t       read;
+    size_t       read = 0;
     // peek as much as the cache can take
-    bool cache_res = src->peek(NULL, sizeof(src->cache->buf), &read);
-    if (!cache_res || !read ||
-        init_mem_src(&memsrc,
-                     src->cache->buf + src->cache->pos,
-                     src->cache->len - src->cache->pos,
-                     false)) {
+    const uint8_t *data = src->peek_ptr(PGP_INPUT_CACHE_SIZE, &read);
+    if (!data || !read || init_mem_src(&memsrc, data, read, false)) {
         return PGP_ARMORED_UNKNOWN;
     }
     rnp_result_t res = init_armored_src(&armorsrc, &memsrc);
@@ -985,7 +992,10 @@ armored_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
             param->lout = 0;
         }
 
-        /* processing one line */
+        /* processing one line, vectorized encoder leaves only a short tail */
+        size_t vlen = base64_encode_simd(bufptr, inlend - bufptr, encptr);
+        bufptr += vlen;
+        encptr += vlen / 3 * 4;
         while (bufptr < inlend) {
             uint32_t t = (bufptr[0] << 16) | (bufptr[1] << 8) | (bufptr[2]);
             bufptr += 3;
@@ -42,6 +42,13 @@
 #ifdef HAVE_LIMITS_H
 #include <limits.h>
 #endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#endif
 #include <rnp/rnp_def.h>
 #include "rnp.h"
 #include "stream-common.h"
@@ -74,6 +81,12 @@ pgp_source_t::read(void *buf, size_t len, size_t *readres)
         readahead = false;
     }
 
+    // Directly addressable source, i.e. memory-mapped file
+    if (mem) {
+        memcpy(buf, mem + readb, len);
+        goto finish;
+    }
+
     // Check whether we have cache and there is data inside
     if (cache && (cache->len > cache->pos)) {
         read = cache->len - cache->pos;
@@ -149,6 +162,13 @@ pgp_source_t::peek(void *buf, size_t len, size_t *peeked)
     if (error_) {
         return false;
     }
+    if (mem) {
+        *peeked = std::min((uint64_t) len, size - readb);
+        if (buf) {
+            memcpy(buf, mem + readb, *peeked);
+        }
+        return true;
+    }
     if (!cache || (len > sizeof(cache->buf))) {
         return false;
     }
@@ -214,9 +234,31 @@ pgp_source_t::peek_eq(void *buf, size_t len)
     return peek(buf, len, &res) && (res == len);
 }
 
+const uint8_t *
+pgp_source_t::peek_ptr(size_t len, size_t *peeked)
+{
+    if (mem) {
+        if (error_) {
+            return NULL;
+        }
+        *peeked = std::min((uint64_t) len, size - readb);
+        return mem + readb;
+    }
+    len = std::min(len, (size_t) PGP_INPUT_CACHE_SIZE);
+    if (!peek(NULL, len, peeked)) {
+        return NULL;
+    }
+    return &cache->buf[cache->pos];
+}
+
 void
 pgp_source_t::skip(size_t len)
 {
+    if (mem) {
+        readb += std::min((uint64_t) len, size - readb);
+        eof_ = readb == size;
+        return;
+    }
     if (cache && (cache->len - cache->pos >= len)) {
         readb += len;
         cache->pos += len;
@@ -456,6 +498,118 @@ init_file_src(pgp_source_t *src, const char *path)
     return ret;
 }
 
+typedef struct pgp_source_mmap_param_t {
+    void * addr;
+    size_t len;
+} pgp_source_mmap_param_t;
+
+static bool
+mmap_src_read(pgp_source_t *src, void *buf, size_t len, size_t *read)
+{
+    /* pgp_source_t::read() serves directly addressable sources by itself */
+    return false;
+}
+
+static void
+mmap_src_close(pgp_source_t *src)
+{
+    pgp_source_mmap_param_t *param = (pgp_source_mmap_param_t *) src->param;
+    if (!param) {
+        return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(param->addr);
+#elif defined(HAVE_SYS_MMAN_H)
+    munmap(param->addr, param->len);
+#endif
+    free(src->param);
+    src->param = NULL;
+    src->mem = NULL;
+}
+
+static void *
+mmap_file(int fd, size_t len)
+{
+#if defined(_WIN32)
+    HANDLE map = CreateFileMappingA(
+      (HANDLE) _get_osfhandle(fd), NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!map) {
+        return NULL;
+    }
+    void *addr = MapViewOfFile(map, FILE_MAP_READ, 0, 0, len);
+    /* view keeps the mapping object referenced */
+    CloseHandle(map);
+    return addr;
+#elif defined(HAVE_SYS_MMAN_H)
+    void *addr = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        return NULL;
+    }
+#ifdef MADV_SEQUENTIAL
+    (void) madvise(addr, len, MADV_SEQUENTIAL);
+#endif
+    return addr;
+#else
+    return NULL;
+#endif
+}
+
+rnp_result_t
+init_mmap_src(pgp_source_t *src, const char *path)
+{
+    struct stat st;
+    if (rnp_stat(path, &st) || !S_ISREG(st.st_mode) || !st.st_size ||
+        ((uint64_t) st.st_size > SIZE_MAX)) {
+        return init_file_src(src, path);
+    }
+
+    int flags = O_RDONLY;
+#ifdef HAVE_O_BINARY
+    flags |= O_BINARY;
+#else
+#ifdef HAVE__O_BINARY
+    flags |= _O_BINARY;
+#endif
+#endif
+    int fd = rnp_open(path, flags, 0);
+    if (fd < 0) {
+        RNP_LOG("can't open '%s'", path);
+        return RNP_ERROR_READ;
+    }
+    size_t len = st.st_size;
+    void * addr = mmap_file(fd, len);
+    /* mapping stays valid after the descriptor is closed */
+    close(fd);
+    if (!addr) {
+        return init_file_src(src, path);
+    }
+
+    memset(src, 0, sizeof(*src));
+    pgp_source_mmap_param_t *param =
+      (pgp_source_mmap_param_t *) calloc(1, sizeof(pgp_source_mmap_param_t));
+    if (!param) {
+        /* LCOV_EXCL_START */
+        RNP_LOG("param allocation failed");
+#if defined(_WIN32)
+        UnmapViewOfFile(addr);
+#elif defined(HAVE_SYS_MMAN_H)
+        munmap(addr, len);
+#endif
+        return RNP_ERROR_OUT_OF_MEMORY;
+        /* LCOV_EXCL_END */
+    }
+    param->addr = addr;
+    param->len = len;
+    src->param = param;
+    src->mem = (const uint8_t *) addr;
+    src->raw_read = mmap_src_read;
+    src->raw_close = mmap_src_close;
+    src->type = PGP_STREAM_MMAP;
+    src->size = len;
+    src->knownsize = true;
+    return RNP_SUCCESS;
+}
+
 rnp_result_t
 init_stdin_src(pgp_source_t *src)
 {
@@ -569,6 +723,16 @@ read_mem_src(pgp_source_t *src, pgp_source_t *readsrc)
     rnp_result_t ret = RNP_ERROR_GENERIC;
     size_t       sz = 0;
 
+    /* no need to copy the mapped data, just reference it */
+    if (readsrc->mem) {
+        sz = readsrc->size - readsrc->readb;
+        if ((ret = init_mem_src(src, readsrc->mem + readsrc->readb, sz, false))) {
+            return ret;
+        }
+        readsrc->skip(sz);
+        return RNP_SUCCESS;
+    }
+
     if ((ret = init_mem_dest(&dst, NULL, 0))) {
         return ret;
     }
@@ -711,6 +875,7 @@ typedef struct pgp_dest_file_param_t {
     int         fd;
     int         errcode;
     bool        overwrite;
+    bool        append;
     std::string path;
 } pgp_dest_file_param_t;
 
@@ -746,7 +911,8 @@ file_dst_close(pgp_dest_t *dst, bool discard)
 
     if (dst->type == PGP_STREAM_FILE) {
         close(param->fd);
-        if (discard) {
+        /* never remove the existing file we were appending to */
+        if (discard && !param->append) {
             rnp_unlink(param->path.c_str());
         }
     }
@@ -820,6 +986,32 @@ init_file_dest(pgp_dest_t *dst, const char *path, bool overwrite)
     return res;
 }
 
+rnp_result_t
+init_append_dest(pgp_dest_t *dst, const char *path)
+{
+    int flags = O_WRONLY | O_APPEND;
+#ifdef HAVE_O_BINARY
+    flags |= O_BINARY;
+#else
+#ifdef HAVE__O_BINARY
+    flags |= _O_BINARY;
+#endif
+#endif
+    int fd = rnp_open(path, flags, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        RNP_LOG("failed to open file '%s' for appending. Error %d.", path, errno);
+        return RNP_ERROR_WRITE;
+    }
+
+    rnp_result_t res = init_fd_dest(dst, fd, path);
+    if (res) {
+        close(fd);
+        return res;
+    }
+    ((pgp_dest_file_param_t *) dst->param)->append = true;
+    return RNP_SUCCESS;
+}
+
 #define TMPDST_SUFFIX ".rnp-tmp.XXXXXX"
 
 static rnp_result_t
@@ -41,6 +41,7 @@ typedef enum {
     PGP_STREAM_NULL,
     PGP_STREAM_FILE,
     PGP_STREAM_MEMORY,
+    PGP_STREAM_MMAP,
     PGP_STREAM_STDIN,
     PGP_STREAM_STDOUT,
     PGP_STREAM_PACKET,
@@ -83,6 +84,7 @@ typedef struct pgp_source_t {
     uint64_t readb; /* number of bytes read from the stream via src_read. Do not confuse with
                        number of bytes as returned via the read since data may be cached */
     pgp_source_cache_t *cache; /* cache if used */
+    const uint8_t *     mem;   /* whole contents if directly addressable, then no cache used */
     void *              param; /* source-specific additional data */
 
     bool eof_;      /* end of data as reported by read and empty cache */
@@ -123,6 +125,16 @@ typedef struct pgp_source_t {
      */
     bool peek_eq(void *buf, size_t len);
 
+    /** @brief peek up to len bytes without copying them out of the source.
+     *         For directly addressable sources (see init_mmap_src()) pointer to the mapped
+     *         contents is returned and len is not limited, otherwise peek() limits apply.
+     *  @param len number of bytes to peek
+     *  @param read number of bytes available at the returned pointer. Cannot be NULL.
+     *  @return pointer to the data, valid until the next read/skip/peek call, or NULL on
+     *          error
+     */
+    const uint8_t *peek_ptr(size_t len, size_t *read);
+
     /** @brief skip up to len bytes.
      *         Note: use read() if you want to check error condition/get number of bytes
      * skipped.
@@ -200,6 +212,14 @@ bool init_src_common(pgp_source_t *src, size_t paramsize);
  **/
 rnp_result_t init_file_src(pgp_source_t *src, const char *path);
 
+/** @brief init memory-mapped file source. Falls back to the init_file_src() if file is not
+ *         a regular one, is empty or cannot be mapped.
+ *  @param src pre-allocated source structure
+ *  @param path path to the file
+ *  @return RNP_SUCCESS or error code
+ **/
+rnp_result_t init_mmap_src(pgp_source_t *src, const char *path);
+
 /** @brief init stdin source
  *  @param src pre-allocated source structure
  *  @return RNP_SUCCESS or error code
@@ -222,6 +242,8 @@ rnp_result_t init_mem_src(pgp_source_t *src, const void *mem, size_t len, bool f
 rnp_result_t init_null_src(pgp_source_t *src);
 
 /** @brief init memory source with contents of other source
+ *         If readsrc is directly addressable (i.e. memory-mapped) then data is not copied and
+ *         readsrc must outlive src.
  *  @param src pre-allocated source structure
  *  @param readsrc opened source with data
  *  @return RNP_SUCCESS or error code
@@ -308,6 +330,14 @@ void dst_flush(pgp_dest_t *dst);
  **/
 rnp_result_t init_file_dest(pgp_dest_t *dst, const char *path, bool overwrite);
 
+/** @brief init file destination, appending to the end of the existing file. File is not
+ *         removed if destination is closed with discard flag.
+ *  @param dst pre-allocated dest structure
+ *  @param path path to the existing file
+ *  @return RNP_SUCCESS or error code
+ **/
+rnp_result_t init_append_dest(pgp_dest_t *dst, const char *path);
+
 /** @brief init file destination, using the temporary file name, based on path.
  *         Once writing is over, dst_finish() will attempt to rename to the desired name.
  *  @param dst pre-allocated dest structure
@@ -65,6 +65,7 @@ typedef struct rnp_symmetric_pass_info_t {
  *  For operations with OpenPGP embedded data (i.e. encrypted data and attached signatures):
  *  - filename, filemtime : to specify information about the contents of literal data packet
  *  - zalg, zlevel : compression algorithm and level, zlevel = 0 to disable compression
+ *  - zauto : compress data only if the first input bytes look compressible
  *
  *  For encryption operation (including encrypt-and-sign):
  *  - halg : hash algorithm used during key derivation for password-based encryption
@@ -89,6 +90,8 @@ typedef struct rnp_symmetric_pass_info_t {
  *
  *  For data decryption and/or verification there is not much of fields:
  *  - discard: discard the output data (i.e. just decrypt and/or verify signatures)
+ *  - threads : number of threads used to process AEAD chunks, ZIP/ZLIB blocks and to
+ *    calculate different hashes, 0 or 1 to use the caller's thread only
  *
  */
 
@@ -103,11 +106,13 @@ typedef struct rnp_ctx_t {
     pgp_symm_alg_t ealg{};      /* encryption algorithm */
     int            zalg{};      /* compression algorithm used */
     int            zlevel{};    /* compression level */
+    bool           zauto{};     /* skip compression of incompressible data */
     pgp_aead_alg_t aalg{};      /* non-zero to use AEAD */
     int            abits{};     /* AEAD chunk bits */
     bool           overwrite{}; /* allow to overwrite output file if exists */
     bool           armor{};     /* whether to use ASCII armor on output */
     bool           no_wrap{};   /* do not wrap source in literal data packet */
+    size_t         threads{};   /* number of threads for AEAD, deflate and hashing */
 #if defined(ENABLE_CRYPTO_REFRESH)
     bool enable_pkesk_v6{}; /* allows pkesk v6 if list of recipients is suitable */
 #endif
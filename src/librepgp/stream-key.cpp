@@ -215,16 +215,33 @@ process_pgp_key_auto(pgp_source_t &          src,
 
 rnp_result_t
 process_pgp_keys(pgp_source_t &src, pgp_key_sequence_t &keys, bool skiperrors)
+{
+    keys.keys.clear();
+    rnp_result_t ret = process_pgp_keys(
+      src,
+      [&keys](pgp_transferable_key_t &key) {
+          keys.keys.emplace_back(std::move(key));
+          return RNP_SUCCESS;
+      },
+      skiperrors);
+    if (ret) {
+        keys.keys.clear();
+    }
+    return ret;
+}
+
+rnp_result_t
+process_pgp_keys(pgp_source_t &src, const pgp_key_handler_t &handler, bool skiperrors)
 {
     bool has_secret = false;
     bool has_public = false;
 
-    keys.keys.clear();
     /* create maybe-armored stream */
     rnp::ArmoredSource armor(
       src, rnp::ArmoredSource::AllowBinary | rnp::ArmoredSource::AllowMultiple);
 
     /* read sequence of transferable OpenPGP keys as described in RFC 4880, 11.1 - 11.2 */
+    pgp_transferable_key_t curkey;
     while (!armor.error()) {
         /* Allow multiple armored messages in a single stream */
         if (armor.eof() && armor.multiple()) {
@@ -234,10 +251,8 @@ process_pgp_keys(pgp_source_t &src, pgp_key_sequence_t &keys, bool skiperrors)
             break;
         }
         /* Attempt to read the next key */
-        pgp_transferable_key_t curkey;
         rnp_result_t ret = process_pgp_key_auto(armor.src(), curkey, false, skiperrors);
         if (ret && (!skiperrors || (ret != RNP_ERROR_BAD_FORMAT))) {
-            keys.keys.clear();
             return ret;
         }
         /* check whether we actually read any key or just skipped erroneous packets */
@@ -247,7 +262,10 @@ process_pgp_keys(pgp_source_t &src, pgp_key_sequence_t &keys, bool skiperrors)
         has_secret |= (curkey.key.tag == PGP_PKT_SECRET_KEY);
         has_public |= (curkey.key.tag == PGP_PKT_PUBLIC_KEY);
 
-        keys.keys.emplace_back(std::move(curkey));
+        ret = handler(curkey);
+        if (ret) {
+            return ret;
+        }
     }
 
     if (has_secret && has_public) {
@@ -255,7 +273,6 @@ process_pgp_keys(pgp_source_t &src, pgp_key_sequence_t &keys, bool skiperrors)
     }
 
     if (armor.error()) {
-        keys.keys.clear();
         return RNP_ERROR_READ;
     }
     return RNP_SUCCESS;
@@ -463,7 +480,7 @@ parse_secret_key_mpis(pgp_key_pkt_t &key, const uint8_t *mpis, size_t len)
 }
 
 rnp_result_t
-decrypt_secret_key(pgp_key_pkt_t *key, const char *password)
+decrypt_secret_key(pgp_key_pkt_t *key, const char *password, rnp::S2KCache *cache)
 {
     if (!key) {
         return RNP_ERROR_NULL_POINTER;
@@ -498,7 +515,7 @@ decrypt_secret_key(pgp_key_pkt_t *key, const char *password)
     rnp::secure_array<uint8_t, PGP_MAX_KEY_SIZE> keybuf;
     size_t keysize = pgp_key_size(key->sec_protection.symm_alg);
     if (!keysize ||
-        !pgp_s2k_derive_key(&key->sec_protection.s2k, password, keybuf.data(), keysize)) {
+        !pgp_s2k_derive_key(&key->sec_protection.s2k, password, keybuf.data(), keysize, cache)) {
         RNP_LOG("failed to derive key");
         return RNP_ERROR_BAD_PARAMETERS;
     }
@@ -540,7 +557,12 @@ decrypt_secret_key(pgp_key_pkt_t *key, const char *password)
             return ret;
         }
 
-        return parse_secret_key_mpis(*key, decdata.data(), key->sec_len);
+        ret = parse_secret_key_mpis(*key, decdata.data(), key->sec_len);
+        /* cache derived key only once it is known to be correct */
+        if (!ret && cache) {
+            cache->put(key->sec_protection.s2k, password, keybuf.data(), keysize);
+        }
+        return ret;
     } catch (const std::exception &e) {
         RNP_LOG("%s", e.what());
         return RNP_ERROR_GENERIC;
@@ -30,6 +30,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <sys/types.h>
+#include <functional>
 #include "rnp.h"
 #include "stream-common.h"
 #include "stream-sig.h"
@@ -127,13 +128,25 @@ rnp_result_t process_pgp_key_auto(pgp_source_t &          src,
 
 rnp_result_t process_pgp_keys(pgp_source_t &src, pgp_key_sequence_t &keys, bool skiperrors);
 
+/* Handler for the streamed transferable keys. Key may be moved out by the handler. Any result
+   other than RNP_SUCCESS stops the processing and is returned to the caller. */
+typedef std::function<rnp_result_t(pgp_transferable_key_t &key)> pgp_key_handler_t;
+
+/* Process armored or binary sequence of transferable keys, passing them one by one to the
+   handler, so only a single key is kept in memory at a time. */
+rnp_result_t process_pgp_keys(pgp_source_t &           src,
+                              const pgp_key_handler_t &handler,
+                              bool                     skiperrors);
+
 rnp_result_t process_pgp_key(pgp_source_t &src, pgp_transferable_key_t &key, bool skiperrors);
 
 rnp_result_t process_pgp_subkey(pgp_source_t &             src,
                                 pgp_transferable_subkey_t &subkey,
                                 bool                       skiperrors);
 
-rnp_result_t decrypt_secret_key(pgp_key_pkt_t *key, const char *password);
+rnp_result_t decrypt_secret_key(pgp_key_pkt_t *key,
+                                const char *    password,
+                                rnp::S2KCache * cache = NULL);
 
 rnp_result_t encrypt_secret_key(pgp_key_pkt_t *key, const char *password, rnp::RNG &rng);
 
@@ -591,12 +591,18 @@ pgp_packet_body_t::get(pgp::mpi &val) noexcept
         RNP_LOG("0 mpi");
         return false;
     }
-    if (!get(val.mpi, len)) {
+    try {
+        val.resize(len);
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what()); // LCOV_EXCL_LINE
+        return false;            // LCOV_EXCL_LINE
+    }
+    if (!get(val.data(), len)) {
         RNP_LOG("failed to read mpi body");
+        val.forget();
         return false;
     }
     /* check the mpi bit count */
-    val.len = len;
     size_t mbits = val.bits();
     if (mbits != bits) {
         RNP_LOG(
@@ -744,17 +750,17 @@ pgp_packet_body_t::add(const pgp_key_id_t &val)
 void
 pgp_packet_body_t::add(const pgp::mpi &val)
 {
-    if (!val.len) {
+    if (!val.bytes()) {
         throw rnp::rnp_exception(RNP_ERROR_BAD_PARAMETERS);
     }
 
     unsigned idx = 0;
-    while ((idx < val.len - 1) && (!val.mpi[idx])) {
+    while ((idx < val.bytes() - 1) && (!val[idx])) {
         idx++;
     }
 
-    unsigned bits = (val.len - idx - 1) << 3;
-    unsigned hibyte = val.mpi[idx];
+    unsigned bits = (val.bytes() - idx - 1) << 3;
+    unsigned hibyte = val[idx];
     while (hibyte) {
         bits++;
         hibyte = hibyte >> 1;
@@ -762,7 +768,7 @@ pgp_packet_body_t::add(const pgp::mpi &val)
 
     uint8_t hdr[2] = {(uint8_t)(bits >> 8), (uint8_t)(bits & 0xff)};
     add(hdr, 2);
-    add(val.mpi + idx, val.len - idx);
+    add(val.data() + idx, val.bytes() - idx);
 }
 
 void
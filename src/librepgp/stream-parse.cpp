@@ -41,6 +41,7 @@
 #include "stream-armor.h"
 #include "stream-packet.h"
 #include "stream-sig.h"
+#include "stream-aead.h"
 #include "str-utils.h"
 #include "types.h"
 #include "crypto/s2k.h"
@@ -108,6 +109,9 @@ typedef struct pgp_source_encrypted_param_t {
 #ifdef ENABLE_CRYPTO_REFRESH
     pgp_seipdv2_hdr_t seipdv2_hdr; /* SEIPDv2 encryption parameters */
 #endif
+#if defined(ENABLE_AEAD)
+    std::unique_ptr<pgp_aead_mt_t> aead_mt; /* multithreaded AEAD decryption, if enabled */
+#endif
 
     pgp_source_encrypted_param_t() : auth_type(rnp::AuthType::None), salg(PGP_SA_UNKNOWN)
     {
@@ -677,6 +681,224 @@ encrypted_src_read_aead_part(pgp_source_encrypted_param_t *param)
     param->auth_validated = true;
     return true;
 }
+
+/* build additional data for the chunk, without relying on the param->aead_ad state */
+static size_t
+encrypted_aead_chunk_ad(const pgp_source_encrypted_param_t *param,
+                        uint8_t *                           ad,
+                        size_t                              idx,
+                        bool                                last,
+                        uint64_t                            total)
+{
+    size_t adlen = 0;
+#ifdef ENABLE_CRYPTO_REFRESH
+    if (param->is_v2_seipd()) {
+        ad[0] = PGP_PKT_SE_IP_DATA | PGP_PTAG_ALWAYS_SET | PGP_PTAG_NEW_FORMAT;
+        ad[1] = param->seipdv2_hdr.version;
+        ad[2] = param->seipdv2_hdr.cipher_alg;
+        ad[3] = param->seipdv2_hdr.aead_alg;
+        ad[4] = param->seipdv2_hdr.chunk_size_octet;
+        adlen = 5;
+    } else
+#endif
+    {
+        memcpy(ad, param->aead_ad, 5);
+        write_uint64(ad + 5, idx);
+        adlen = 13;
+    }
+    if (last) {
+        write_uint64(ad + adlen, total);
+        adlen += 8;
+    }
+    return adlen;
+}
+
+static void
+encrypted_aead_mt_submit(pgp_source_encrypted_param_t *    param,
+                         std::unique_ptr<pgp_aead_chunk_t> chunk,
+                         bool                              last)
+{
+    auto & mt = *param->aead_mt;
+    size_t idx = last ? mt.chunks : mt.chunks++;
+    if (!last) {
+        mt.total += chunk->len - pgp_cipher_aead_tag_len(param->aead_hdr.aalg);
+    }
+    chunk->last = last;
+    chunk->adlen = encrypted_aead_chunk_ad(param, chunk->ad, idx, last, mt.total);
+    chunk->nlen =
+      pgp_cipher_aead_nonce(param->aead_hdr.aalg, param->aead_hdr.iv, chunk->nonce, idx);
+    mt.submit(std::move(chunk));
+}
+
+static std::unique_ptr<pgp_aead_chunk_t>
+encrypted_aead_mt_get_chunk(pgp_source_encrypted_param_t *param)
+{
+    /* room for the chunk with its tag, followed by the final tag */
+    size_t size = param->chunklen + 2 * pgp_cipher_aead_tag_len(param->aead_hdr.aalg);
+    return param->aead_mt->get_chunk(param->aead_hdr.ealg, param->aead_hdr.aalg, size, true);
+}
+
+/* read ahead chunks from the source, scheduling them for decryption */
+static bool
+encrypted_aead_mt_fill(pgp_source_encrypted_param_t *param)
+{
+    auto & mt = *param->aead_mt;
+    size_t taglen = pgp_cipher_aead_tag_len(param->aead_hdr.aalg);
+    size_t fulllen = param->chunklen + taglen;
+
+    while (!mt.eof && (mt.queue.size() < mt.depth)) {
+        auto chunk = encrypted_aead_mt_get_chunk(param);
+        if (!chunk) {
+            return false; // LCOV_EXCL_LINE
+        }
+        uint8_t *data = chunk->data.data();
+        size_t   read = 0;
+        if (!param->pkt.readsrc->read(data, fulllen, &read)) {
+            return false;
+        }
+        /* Full chunk is followed either by more chunks or by the final tag only. The final
+         * chunk may be shorter than taglen bytes, so peek one byte more to distinguish. */
+        if (read == fulllen) {
+            uint8_t ahead[PGP_AEAD_MAX_TAG_LEN + 1];
+            size_t  peeked = 0;
+            if (!param->pkt.readsrc->peek(ahead, taglen + 1, &peeked)) {
+                return false;
+            }
+            if (peeked > taglen) {
+                chunk->len = read;
+                encrypted_aead_mt_submit(param, std::move(chunk), false);
+                continue;
+            }
+            size_t tail = 0;
+            if (!param->pkt.readsrc->read(data + read, peeked, &tail) || (tail != peeked)) {
+                return false;
+            }
+            read += tail;
+        }
+        /* end of the stream: data chunk (if any) followed by the final tag */
+        if ((read != taglen) && (read < 2 * taglen)) {
+            RNP_LOG("unexpected end of data");
+            return false;
+        }
+        mt.eof = true;
+        if (read == taglen) {
+            chunk->len = taglen;
+            encrypted_aead_mt_submit(param, std::move(chunk), true);
+            break;
+        }
+        auto tag = encrypted_aead_mt_get_chunk(param);
+        if (!tag) {
+            return false; // LCOV_EXCL_LINE
+        }
+        memcpy(tag->data.data(), data + read - taglen, taglen);
+        tag->len = taglen;
+        chunk->len = read - taglen;
+        encrypted_aead_mt_submit(param, std::move(chunk), false);
+        encrypted_aead_mt_submit(param, std::move(tag), true);
+    }
+    return true;
+}
+
+/* get the next decrypted chunk to read data from, in order */
+static bool
+encrypted_aead_mt_next(pgp_source_encrypted_param_t *param)
+{
+    auto & mt = *param->aead_mt;
+    size_t taglen = pgp_cipher_aead_tag_len(param->aead_hdr.aalg);
+
+    if (mt.cur) {
+        mt.spare.push_back(std::move(mt.cur));
+        mt.curpos = 0;
+    }
+
+    while (!param->auth_validated) {
+        if (!encrypted_aead_mt_fill(param)) {
+            return false;
+        }
+        if (mt.queue.empty()) {
+            RNP_LOG("unexpected end of data"); // LCOV_EXCL_LINE
+            return false;                      // LCOV_EXCL_LINE
+        }
+        std::unique_ptr<pgp_aead_chunk_t> chunk;
+        if (!mt.pop(chunk)) {
+            if (chunk->last) {
+                RNP_LOG("wrong last chunk");
+            } else {
+                RNP_LOG("failed to finalize aead chunk");
+            }
+            return false;
+        }
+        if (chunk->last) {
+            param->auth_validated = true;
+            mt.spare.push_back(std::move(chunk));
+            break;
+        }
+        chunk->len -= taglen;
+        if (chunk->len) {
+            mt.cur = std::move(chunk);
+            return true;
+        }
+        mt.spare.push_back(std::move(chunk));
+    }
+    return true;
+}
+
+static bool
+encrypted_src_read_aead_mt(pgp_source_encrypted_param_t *param,
+                           void *                        buf,
+                           size_t                        len,
+                           size_t *                      read)
+{
+    auto & mt = *param->aead_mt;
+    size_t left = len;
+
+    try {
+        while (left > 0) {
+            if (!mt.cur || (mt.curpos == mt.cur->len)) {
+                if (!encrypted_aead_mt_next(param)) {
+                    return false;
+                }
+                if (!mt.cur) {
+                    break;
+                }
+            }
+            size_t cbytes = std::min(left, mt.cur->len - mt.curpos);
+            memcpy(buf, mt.cur->data.data() + mt.curpos, cbytes);
+            mt.curpos += cbytes;
+            buf = (uint8_t *) buf + cbytes;
+            left -= cbytes;
+        }
+    } catch (const std::exception &e) {
+        /* LCOV_EXCL_START */
+        RNP_LOG("aead processing failed: %s", e.what());
+        return false;
+        /* LCOV_EXCL_END */
+    }
+    *read = len - left;
+    return true;
+}
+
+static bool
+encrypted_start_aead_mt(pgp_source_encrypted_param_t *param, const uint8_t *key)
+{
+    if (!param->handler || !param->handler->ctx || (param->handler->ctx->threads < 2)) {
+        return true;
+    }
+    /* chunk size comes from the message, so do not buffer a number of huge chunks */
+    if (param->chunklen > PGP_AEAD_MT_MAX_CHUNK_LEN) {
+        return true;
+    }
+    try {
+        param->aead_mt.reset(new pgp_aead_mt_t(
+          key, pgp_key_size(param->aead_hdr.ealg), param->handler->ctx->threads));
+        return true;
+    } catch (const std::exception &e) {
+        /* LCOV_EXCL_START */
+        RNP_LOG("failed to start aead threads: %s", e.what());
+        return false;
+        /* LCOV_EXCL_END */
+    }
+}
 #endif
 
 static bool
@@ -685,7 +907,10 @@ encrypted_src_read_aead(pgp_source_t *src, void *buf, size_t len, size_t *read)
 #if !defined(ENABLE_AEAD)
     return false;
 #else
-    auto   param = (pgp_source_encrypted_param_t *) src->param;
+    auto param = (pgp_source_encrypted_param_t *) src->param;
+    if (param->aead_mt) {
+        return encrypted_src_read_aead_mt(param, buf, len, read);
+    }
     size_t left = len;
 
     do {
@@ -856,6 +1081,13 @@ add_hash_for_sig(pgp_source_signed_param_t *param, pgp_sig_type_t stype, pgp_has
         param->txt_hashes.add_alg(halg);
     }
     param->hashes.add_alg(halg);
+    /* update hashes on separate threads if there is more than one of them, sharing the
+     * configured number of threads between binary and text-mode hashes */
+    rnp_ctx_t *ctx = param->handler ? param->handler->ctx : NULL;
+    size_t     threads = ctx ? ctx->threads : 0;
+    size_t     bthreads = std::min(threads, param->hashes.hashes.size());
+    param->hashes.set_threads(bthreads);
+    param->txt_hashes.set_threads(threads - bthreads);
 }
 
 static const rnp::Hash *
@@ -917,18 +1149,6 @@ signed_validate_signature(pgp_source_signed_param_t &param, pgp_signature_info_t
     }
 }
 
-static long
-stripped_line_len(uint8_t *begin, uint8_t *end)
-{
-    uint8_t *stripped_end = end;
-
-    while (stripped_end >= begin && (*stripped_end == CH_CR || *stripped_end == CH_LF)) {
-        stripped_end--;
-    }
-
-    return stripped_end - begin + 1;
-}
-
 static void
 signed_src_set_literal_hdr(pgp_source_t &src, const pgp_literal_hdr_t &hdr)
 {
@@ -960,70 +1180,46 @@ signed_src_update(pgp_source_t *src, const void *buf, size_t len)
         return;
     }
 
-    uint8_t *ch = (uint8_t *) buf;
-    uint8_t *linebeg = ch;
-    uint8_t *end = (uint8_t *) buf + len;
-    /* we support LF and CRLF line endings */
-    while (ch < end) {
-        /* continue if not reached LF */
-        if (*ch != CH_LF) {
-            if (*ch != CH_CR && param->stripped_crs > 0) {
-                while (param->stripped_crs--) {
-                    try {
-                        param->txt_hashes.add(ST_CR, 1);
-                    } catch (const std::exception &e) {
-                        RNP_LOG("%s", e.what()); // LCOV_EXCL_LINE
-                    }
+    const uint8_t *ch = (const uint8_t *) buf;
+    const uint8_t *end = ch + len;
+    try {
+        /* we support LF and CRLF line endings, so look for LF and strip CRs before it */
+        while (ch < end) {
+            const uint8_t *eol = (const uint8_t *) memchr(ch, CH_LF, end - ch);
+            const uint8_t *lend = eol ? eol : end;
+            const uint8_t *stripped = lend;
+            while ((stripped > ch) && (*(stripped - 1) == CH_CR)) {
+                stripped--;
+            }
+            if (stripped > ch) {
+                /* CRs from the previous chunk were not followed by the LF */
+                for (; param->stripped_crs > 0; param->stripped_crs--) {
+                    param->txt_hashes.add(ST_CR, 1);
                 }
-                param->stripped_crs = 0;
+                param->txt_hashes.add(ch, stripped - ch);
             }
 
-            if (!param->max_line_warn && param->text_line_len >= MAXIMUM_GNUPG_LINELEN) {
+            param->text_line_len += lend - ch;
+            if (!param->max_line_warn && (param->text_line_len > MAXIMUM_GNUPG_LINELEN)) {
                 RNP_LOG("Canonical text document signature: line is too long, may cause "
                         "incompatibility with other implementations. Consider using binary "
                         "signature instead.");
                 param->max_line_warn = true;
             }
 
-            ch++;
-            param->text_line_len++;
-            continue;
-        }
-        /* reached eol: dump line contents */
-        param->stripped_crs = 0;
-        param->text_line_len = 0;
-        if (ch > linebeg) {
-            long stripped_len = stripped_line_len(linebeg, ch);
-            if (stripped_len > 0) {
-                try {
-                    param->txt_hashes.add(linebeg, stripped_len);
-                } catch (const std::exception &e) {
-                    RNP_LOG("%s", e.what()); // LCOV_EXCL_LINE
-                }
+            if (!eol) {
+                /* trailing CRs may be followed by LF in the next chunk */
+                param->stripped_crs += lend - stripped;
+                break;
             }
-        }
-        /* dump EOL */
-        try {
+            /* dump EOL */
+            param->stripped_crs = 0;
+            param->text_line_len = 0;
             param->txt_hashes.add(ST_CRLF, 2);
-        } catch (const std::exception &e) {
-            RNP_LOG("%s", e.what()); // LCOV_EXCL_LINE
-        }
-        ch++;
-        linebeg = ch;
-    }
-    /* check if we have undumped line contents */
-    if (linebeg < end) {
-        long stripped_len = stripped_line_len(linebeg, end - 1);
-        if (stripped_len < end - linebeg) {
-            param->stripped_crs = end - linebeg - stripped_len;
-        }
-        if (stripped_len > 0) {
-            try {
-                param->txt_hashes.add(linebeg, stripped_len);
-            } catch (const std::exception &e) {
-                RNP_LOG("%s", e.what()); // LCOV_EXCL_LINE
-            }
+            ch = eol + 1;
         }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what()); // LCOV_EXCL_LINE
     }
 }
 
@@ -1381,24 +1577,25 @@ cleartext_src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
         }
 
         /* processing data line by line, eol could be \n or \r\n */
-        for (cur = srcb, bg = srcb, en = cur + read; cur < en; cur++) {
-            if ((*cur == CH_LF) ||
-                ((*cur == CH_CR) && (cur + 1 < en) && (*(cur + 1) == CH_LF))) {
-                cleartext_process_line(src, bg, cur - bg, true);
-                /* processing eol */
-                if (param->clr_eod) {
-                    break;
-                }
+        bg = srcb;
+        en = srcb + read;
+        while ((cur = (uint8_t *) memchr(bg, CH_LF, en - bg))) {
+            if ((cur > bg) && (*(cur - 1) == CH_CR)) {
+                cur--;
+            }
+            cleartext_process_line(src, bg, cur - bg, true);
+            if (param->clr_eod) {
+                break;
+            }
 
-                /* processing eol */
-                param->clr_fline = false;
-                param->clr_mline = false;
-                if (*cur == CH_CR) {
-                    param->out[param->outlen++] = *cur++;
-                }
-                param->out[param->outlen++] = *cur;
-                bg = cur + 1;
+            /* processing eol */
+            param->clr_fline = false;
+            param->clr_mline = false;
+            if (*cur == CH_CR) {
+                param->out[param->outlen++] = *cur++;
             }
+            param->out[param->outlen++] = *cur;
+            bg = cur + 1;
         }
 
         /* if line is larger then 4k then just dump it out */
@@ -1534,7 +1731,7 @@ encrypted_start_aead(pgp_source_encrypted_param_t *param, pgp_symm_alg_t alg, ui
         return false;
     }
 
-    return encrypted_start_aead_chunk(param, 0, false);
+    return encrypted_start_aead_chunk(param, 0, false) && encrypted_start_aead_mt(param, key);
 #endif
 }
 
@@ -1571,16 +1768,17 @@ do_enforce_aes_v3pkesk(pgp_pubkey_alg_t alg)
 static bool
 encrypted_try_key(pgp_source_encrypted_param_t *param,
                   pgp_pk_sesskey_t &            sesskey,
-                  pgp_key_t &                   seckey,
+                  const pgp_key_t &             seckey,
+                  pgp::KeyMaterial *            material,
                   rnp::SecurityContext &        ctx)
 {
     pgp_encrypted_material_t encmaterial;
     try {
-        if (!sesskey.parse_material(encmaterial) || !seckey.material()) {
+        if (!sesskey.parse_material(encmaterial) || !material) {
             return false;
         }
-        seckey.material()->validate(ctx, false);
-        if (!seckey.material()->valid()) {
+        material->validate(ctx, false);
+        if (!material->valid()) {
             RNP_LOG("Attempt to decrypt using the key with invalid material.");
             return false;
         }
@@ -1627,7 +1825,7 @@ encrypted_try_key(pgp_source_encrypted_param_t *param,
     if (sesskey.alg == PGP_PKA_ECDH) {
         encmaterial.ecdh.fp = &seckey.fp();
     }
-    auto err = seckey.pkt().material->decrypt(ctx, decbuf.data(), declen, encmaterial);
+    auto err = material->decrypt(ctx, decbuf.data(), declen, encmaterial);
     if (err) {
         return false;
     }
@@ -1742,17 +1940,23 @@ encrypted_sesk_set_ad(pgp_crypt_t *crypt, pgp_sk_sesskey_t *skey)
 #endif
 
 static int
-encrypted_try_password(pgp_source_encrypted_param_t *param, const char *password)
+encrypted_try_password(pgp_source_encrypted_param_t *param,
+                       const char *                  password,
+                       rnp::S2KCache *               cache)
 {
     bool keyavail = false; /* tried password at least once */
 
     for (auto &skey : param->symencs) {
         rnp::secure_array<uint8_t, PGP_MAX_KEY_SIZE + 1> keybuf;
+        rnp::secure_array<uint8_t, PGP_MAX_KEY_SIZE>     s2kkey;
         /* deriving symmetric key from password */
-        size_t keysize = pgp_key_size(skey.alg);
-        if (!keysize || !pgp_s2k_derive_key(&skey.s2k, password, keybuf.data(), keysize)) {
+        size_t s2ksize = pgp_key_size(skey.alg);
+        if (!s2ksize ||
+            !pgp_s2k_derive_key(&skey.s2k, password, s2kkey.data(), s2ksize, cache)) {
             continue;
         }
+        size_t keysize = s2ksize;
+        memcpy(keybuf.data(), s2kkey.data(), s2ksize);
         pgp_crypt_t    crypt;
         pgp_symm_alg_t alg;
 
@@ -1834,6 +2038,10 @@ encrypted_try_password(pgp_source_encrypted_param_t *param, const char *password
         }
 
         param->salg = param->use_cfb() ? alg : param->aead_hdr.ealg;
+        /* cache derived key only once it is known to be correct */
+        if (cache) {
+            cache->put(skey.s2k, password, s2kkey.data(), s2ksize);
+        }
         /* inform handler that we used this symenc */
         if (param->handler->on_decryption_start) {
             param->handler->on_decryption_start(NULL, &skey, param->handler->param);
@@ -2399,16 +2607,29 @@ init_encrypted_src(pgp_parse_handler_t *handler, pgp_source_t *src, pgp_source_t
             if (hidden && seckey->alg() != pubenc.alg) {
                 continue;
             }
-            /* Decrypt key */
-            rnp::KeyLocker seclock(*seckey);
-            if (!seckey->unlock(*handler->password_provider, PGP_OP_DECRYPT)) {
-                errcode = RNP_ERROR_BAD_PASSWORD;
-                continue;
+            /* Decrypt key to the local copy, so key from the keyring is not modified and
+             * may be used by the concurrent operations */
+            auto                           material = seckey->material();
+            std::unique_ptr<pgp_key_pkt_t> decrypted;
+            if (seckey->is_locked()) {
+                pgp_password_ctx_t keyctx(PGP_OP_DECRYPT, seckey);
+                if (seckey->usable_for(PGP_OP_UNLOCK)) {
+                    decrypted.reset(
+                      pgp_decrypt_seckey(*seckey, *handler->password_provider, keyctx));
+                }
+                if (!decrypted) {
+                    errcode = RNP_ERROR_BAD_PASSWORD;
+                    continue;
+                }
+                /* decryption resets validity, so reuse the stored one instead of validating
+                 * key material on each decryption */
+                decrypted->material->set_validity(seckey->material()->validity());
+                material = decrypted->material.get();
             }
 
             /* Try to initialize the decryption */
             rnp::LogStop logstop(hidden);
-            if (encrypted_try_key(param, pubenc, *seckey, *handler->ctx->ctx)) {
+            if (encrypted_try_key(param, pubenc, *seckey, material, *handler->ctx->ctx)) {
                 have_key = true;
                 /* inform handler that we used this pubenc */
                 if (handler->on_decryption_start) {
@@ -2429,7 +2650,8 @@ init_encrypted_src(pgp_parse_handler_t *handler, pgp_source_t *src, pgp_source_t
             goto finish;
         }
 
-        int intres = encrypted_try_password(param, password.data());
+        auto cache = handler->password_provider->s2k_cache;
+        int  intres = encrypted_try_password(param, password.data(), cache);
         if (intres > 0) {
             have_key = true;
         } else if (intres < 0) {
@@ -121,11 +121,90 @@ signature_hash_userid(const pgp_userid_pkt_t &uid, rnp::Hash &hash, pgp_version_
     hash.add(uid.uid, uid.uid_len);
 }
 
+namespace rnp {
+std::unique_ptr<Hash>
+SigHashCache::prefix(const pgp_signature_t & sig,
+                     const pgp_key_pkt_t &   key,
+                     const pgp_userid_pkt_t *uid)
+{
+    /* v6 signatures are salted so there is no common prefix */
+    bool cacheable = !!key.hashed_data;
+#if defined(ENABLE_CRYPTO_REFRESH)
+    cacheable = cacheable && (key.version != PGP_V6);
+#endif
+    if (!cacheable) {
+        auto hash = signature_init(key, sig);
+        signature_hash_key(key, *hash, sig.version);
+        if (uid) {
+            signature_hash_userid(*uid, *hash, sig.version);
+        }
+        return hash;
+    }
+
+    if ((key_.size() != key.hashed_len) ||
+        memcmp(key_.data(), key.hashed_data, key.hashed_len)) {
+        clear();
+        key_.assign(key.hashed_data, key.hashed_data + key.hashed_len);
+    }
+    std::vector<uint8_t> uidval;
+    if (uid) {
+        uidval.reserve(uid->uid_len + 1);
+        uidval.push_back(uid->tag);
+        uidval.insert(uidval.end(), uid->uid, uid->uid + uid->uid_len);
+    }
+    for (auto &entry : entries_) {
+        if ((entry.halg == sig.halg) && (entry.version == sig.version) &&
+            (entry.uid == uidval)) {
+            return entry.hash->clone();
+        }
+    }
+
+    std::unique_ptr<Hash> hash;
+    if (uid) {
+        hash = prefix(sig, key, NULL);
+        signature_hash_userid(*uid, *hash, sig.version);
+    } else {
+        hash = signature_init(key, sig);
+        signature_hash_key(key, *hash, sig.version);
+    }
+    if (entries_.size() >= MAX_ENTRIES) {
+        entries_.erase(entries_.begin());
+    }
+    entries_.push_back({sig.halg, sig.version, std::move(uidval), hash->clone()});
+    return hash;
+}
+
+std::unique_ptr<Hash>
+SigHashCache::key(const pgp_signature_t &sig, const pgp_key_pkt_t &key)
+{
+    return prefix(sig, key, NULL);
+}
+
+std::unique_ptr<Hash>
+SigHashCache::userid(const pgp_signature_t & sig,
+                     const pgp_key_pkt_t &   key,
+                     const pgp_userid_pkt_t &uid)
+{
+    return prefix(sig, key, &uid);
+}
+
+void
+SigHashCache::clear()
+{
+    key_.clear();
+    entries_.clear();
+}
+} // namespace rnp
+
 std::unique_ptr<rnp::Hash>
 signature_hash_certification(const pgp_signature_t & sig,
                              const pgp_key_pkt_t &   key,
-                             const pgp_userid_pkt_t &userid)
+                             const pgp_userid_pkt_t &userid,
+                             rnp::SigHashCache *     cache)
 {
+    if (cache) {
+        return cache->userid(sig, key, userid);
+    }
     auto hash = signature_init(key, sig);
     signature_hash_key(key, *hash, sig.version);
     signature_hash_userid(userid, *hash, sig.version);
@@ -135,17 +214,25 @@ signature_hash_certification(const pgp_signature_t & sig,
 std::unique_ptr<rnp::Hash>
 signature_hash_binding(const pgp_signature_t &sig,
                        const pgp_key_pkt_t &  key,
-                       const pgp_key_pkt_t &  subkey)
+                       const pgp_key_pkt_t &  subkey,
+                       rnp::SigHashCache *    cache)
 {
-    auto hash = signature_init(key, sig);
-    signature_hash_key(key, *hash, sig.version);
+    auto hash = cache ? cache->key(sig, key) : signature_init(key, sig);
+    if (!cache) {
+        signature_hash_key(key, *hash, sig.version);
+    }
     signature_hash_key(subkey, *hash, sig.version);
     return hash;
 }
 
 std::unique_ptr<rnp::Hash>
-signature_hash_direct(const pgp_signature_t &sig, const pgp_key_pkt_t &key)
+signature_hash_direct(const pgp_signature_t &sig,
+                      const pgp_key_pkt_t &  key,
+                      rnp::SigHashCache *    cache)
 {
+    if (cache) {
+        return cache->key(sig, key);
+    }
     auto hash = signature_init(key, sig);
     signature_hash_key(key, *hash, sig.version);
     return hash;
@@ -454,16 +454,61 @@ void signature_hash_key(const pgp_key_pkt_t &key, rnp::Hash &hash, pgp_version_t
 
 void signature_hash_userid(const pgp_userid_pkt_t &uid, rnp::Hash &hash, pgp_version_t sigver);
 
+namespace rnp {
+/**
+ * @brief Cache of the hash states after hashing of the key packet, or key and userid packets,
+ *        so each of the key's signatures doesn't need to hash the same prefix again.
+ *        Entries are looked up by the hash algorithm, signature version and contents of the
+ *        hashed packets. Cache lives for a single validation pass only, see
+ *        pgp_key_t::validate_self_signatures().
+ */
+class SigHashCache {
+    struct Entry {
+        pgp_hash_alg_t        halg;
+        pgp_version_t         version;
+        std::vector<uint8_t>  uid; /* userid tag and contents, empty for key-only prefix */
+        std::unique_ptr<Hash> hash;
+    };
+
+    static const size_t  MAX_ENTRIES = 16;
+    std::vector<uint8_t> key_;
+    std::vector<Entry>   entries_;
+
+    std::unique_ptr<Hash> prefix(const pgp_signature_t & sig,
+                                 const pgp_key_pkt_t &   key,
+                                 const pgp_userid_pkt_t *uid);
+
+  public:
+    SigHashCache() = default;
+    SigHashCache(const SigHashCache &) = delete;
+    SigHashCache &operator=(const SigHashCache &) = delete;
+
+    /** @brief Get the hash initialized for the signature and fed with the key packet. */
+    std::unique_ptr<Hash> key(const pgp_signature_t &sig, const pgp_key_pkt_t &key);
+
+    /** @brief Get the hash initialized for the signature and fed with the key and userid
+     *         packets. */
+    std::unique_ptr<Hash> userid(const pgp_signature_t & sig,
+                                 const pgp_key_pkt_t &   key,
+                                 const pgp_userid_pkt_t &uid);
+
+    void clear();
+};
+} // namespace rnp
+
 std::unique_ptr<rnp::Hash> signature_hash_certification(const pgp_signature_t & sig,
                                                         const pgp_key_pkt_t &   key,
-                                                        const pgp_userid_pkt_t &userid);
+                                                        const pgp_userid_pkt_t &userid,
+                                                        rnp::SigHashCache *     cache = NULL);
 
 std::unique_ptr<rnp::Hash> signature_hash_binding(const pgp_signature_t &sig,
                                                   const pgp_key_pkt_t &  key,
-                                                  const pgp_key_pkt_t &  subkey);
+                                                  const pgp_key_pkt_t &  subkey,
+                                                  rnp::SigHashCache *    cache = NULL);
 
 std::unique_ptr<rnp::Hash> signature_hash_direct(const pgp_signature_t &sig,
-                                                 const pgp_key_pkt_t &  key);
+                                                 const pgp_key_pkt_t &  key,
+                                                 rnp::SigHashCache *    cache = NULL);
 
 /**
  * @brief Parse stream with signatures to the signatures list.
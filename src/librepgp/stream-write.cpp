@@ -49,6 +49,7 @@
 #include "stream-packet.h"
 #include "stream-armor.h"
 #include "stream-sig.h"
+#include "stream-aead.h"
 #include "pgp-key.h"
 #include "fingerprint.h"
 #include "types.h"
@@ -75,6 +76,94 @@ typedef struct pgp_dest_packet_param_t {
     size_t      hdrlen;                   /* number of bytes in hdr */
 } pgp_dest_packet_param_t;
 
+/* input block size and dictionary size (deflate window) for multithreaded compression */
+#define PGP_DEFLATE_MT_BLOCK_SIZE (128 * 1024)
+#define PGP_DEFLATE_MT_DICT_SIZE (32 * 1024)
+/* number of first input bytes used to decide whether data is compressible */
+#define PGP_COMPRESS_SAMPLE_SIZE (64 * 1024)
+
+/* Input block of the ZIP/ZLIB stream, compressed on the thread pool */
+typedef struct pgp_deflate_block_t {
+    std::vector<uint8_t> dict;    /* tail of the previous block's input */
+    std::vector<uint8_t> in;      /* input data */
+    std::vector<uint8_t> out;     /* raw deflate output, ending at the byte boundary */
+    uLong                adler{}; /* Adler-32 of the input */
+    bool                 last{};  /* last block, finishing the deflate stream */
+    std::future<bool>    res;     /* processing result */
+
+    /* Compress input as the part of the raw deflate stream */
+    bool
+    process(int level)
+    {
+        z_stream z = {};
+        if (deflateInit2(&z, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return false; // LCOV_EXCL_LINE
+        }
+        bool ok = dict.empty() || (deflateSetDictionary(&z, dict.data(), dict.size()) == Z_OK);
+        z.next_in = in.data();
+        z.avail_in = in.size();
+        out.resize(deflateBound(&z, in.size()) + 16);
+        size_t pos = 0;
+        /* sync flush aligns output to the byte boundary without finishing the stream */
+        while (ok) {
+            if (pos == out.size()) {
+                out.resize(out.size() * 2);
+            }
+            z.next_out = out.data() + pos;
+            z.avail_out = out.size() - pos;
+            int zret = deflate(&z, last ? Z_FINISH : Z_SYNC_FLUSH);
+            pos = out.size() - z.avail_out;
+            if (zret == Z_STREAM_ERROR) {
+                ok = false; // LCOV_EXCL_LINE
+            } else if (last ? (zret == Z_STREAM_END) : (z.avail_out > 0)) {
+                break;
+            }
+        }
+        deflateEnd(&z);
+        out.resize(pos);
+        adler = adler32(adler32(0, Z_NULL, 0), in.data(), in.size());
+        return ok;
+    }
+} pgp_deflate_block_t;
+
+/* State of the multithreaded ZIP/ZLIB compression. Input is split to the fixed-size blocks,
+ * each one is compressed independently, using the previous block's tail as dictionary, and
+ * output is written strictly in order. */
+typedef struct pgp_deflate_mt_t {
+    std::deque<std::unique_ptr<pgp_deflate_block_t>> queue;   /* blocks in flight, in order */
+    std::unique_ptr<pgp_deflate_block_t>             cur;     /* block being filled */
+    std::vector<uint8_t>                             dict;    /* dictionary for the next block */
+    uLong                                            adler{}; /* Adler-32 of the whole input */
+    size_t                                           depth{}; /* max blocks in flight */
+    int                                              level{}; /* compression level */
+    /* must be destroyed first, so all the blocks are processed before deallocation */
+    std::unique_ptr<rnp::ThreadPool> pool;
+
+    pgp_deflate_mt_t(int zlevel, size_t threads)
+        : adler(adler32(0, Z_NULL, 0)), level(zlevel), pool(new rnp::ThreadPool(threads))
+    {
+        depth = 2 * pool->size();
+    }
+
+    void
+    submit(bool last)
+    {
+        auto block = std::move(cur);
+        if (!block) {
+            block.reset(new pgp_deflate_block_t());
+        }
+        block->last = last;
+        block->dict = dict;
+        size_t tail = std::min<size_t>(block->in.size(), PGP_DEFLATE_MT_DICT_SIZE);
+        dict.assign(block->in.end() - tail, block->in.end());
+
+        auto ptr = block.get();
+        int  lvl = level;
+        block->res = pool->submit([ptr, lvl]() { return ptr->process(lvl); });
+        queue.push_back(std::move(block));
+    }
+} pgp_deflate_mt_t;
+
 typedef struct pgp_dest_compressed_param_t {
     pgp_dest_packet_param_t pkt;
     pgp_compression_type_t  alg;
@@ -82,9 +171,14 @@ typedef struct pgp_dest_compressed_param_t {
         z_stream  z;
         bz_stream bz;
     };
-    bool    zstarted;                        /* whether we initialize zlib/bzip2  */
-    uint8_t cache[PGP_INPUT_CACHE_SIZE / 2]; /* pre-allocated cache for compression */
-    size_t  len;                             /* number of bytes cached */
+    rnp_ctx_t *       ctx;                             /* operation context */
+    bool              zstarted;                        /* whether we initialize zlib/bzip2  */
+    pgp_deflate_mt_t *zmt;                             /* multithreaded ZIP/ZLIB, if enabled */
+    uint8_t *         sample;    /* first input bytes, until it is decided whether to compress */
+    size_t            samplelen; /* number of bytes in sample */
+    bool              bypass;    /* data looks incompressible, so it is written as is */
+    uint8_t           cache[PGP_INPUT_CACHE_SIZE / 2]; /* pre-allocated cache for compression */
+    size_t            len;                             /* number of bytes cached */
 } pgp_dest_compressed_param_t;
 
 typedef struct pgp_dest_encrypted_param_t {
@@ -105,6 +199,9 @@ typedef struct pgp_dest_encrypted_param_t {
 #ifdef ENABLE_CRYPTO_REFRESH
     std::array<uint8_t, PGP_SEIPDV2_SALT_LEN> v2_seipd_salt; /* SEIPDv2 salt value */
 #endif
+#if defined(ENABLE_AEAD)
+    std::unique_ptr<pgp_aead_mt_t> aead_mt; /* multithreaded AEAD encryption, if enabled */
+#endif
 
     bool
     is_aead_auth()
@@ -432,6 +529,149 @@ encrypted_start_aead_chunk(pgp_dest_encrypted_param_t *param, size_t idx, bool l
 
     return res ? RNP_SUCCESS : RNP_ERROR_BAD_PARAMETERS;
 }
+
+/* build additional data for the chunk, without relying on the param->ad state */
+static size_t
+encrypted_aead_chunk_ad(const pgp_dest_encrypted_param_t *param,
+                        uint8_t *                         ad,
+                        size_t                            idx,
+                        bool                              last,
+                        uint64_t                          total)
+{
+    memcpy(ad, param->ad, 5);
+    size_t adlen = 5;
+    if (param->auth_type == rnp::AuthType::AEADv1) {
+        write_uint64(ad + 5, idx);
+        adlen = 13;
+    }
+    if (last) {
+        write_uint64(ad + adlen, total);
+        adlen += 8;
+    }
+    return adlen;
+}
+
+static rnp_result_t
+encrypted_aead_mt_submit(pgp_dest_encrypted_param_t *param, bool last)
+{
+    auto & mt = *param->aead_mt;
+    auto   chunk = std::move(mt.cur);
+    size_t idx = last ? mt.chunks : mt.chunks++;
+    if (last) {
+        size_t size = param->chunklen + pgp_cipher_aead_tag_len(param->aalg);
+        chunk = mt.get_chunk(param->ctx->ealg, param->ctx->aalg, size, false);
+        if (!chunk) {
+            return RNP_ERROR_BAD_STATE; // LCOV_EXCL_LINE
+        }
+        chunk->len = 0;
+    } else {
+        mt.total += chunk->len;
+    }
+    chunk->last = last;
+    chunk->adlen = encrypted_aead_chunk_ad(param, chunk->ad, idx, last, mt.total);
+    chunk->nlen = pgp_cipher_aead_nonce(param->aalg, param->iv, chunk->nonce, idx);
+    mt.submit(std::move(chunk));
+    return RNP_SUCCESS;
+}
+
+/* write out encrypted chunks, in order, until at most left of them are in flight */
+static rnp_result_t
+encrypted_aead_mt_flush(pgp_dest_encrypted_param_t *param, size_t left)
+{
+    auto & mt = *param->aead_mt;
+    size_t taglen = pgp_cipher_aead_tag_len(param->aalg);
+
+    while (mt.queue.size() > left) {
+        std::unique_ptr<pgp_aead_chunk_t> chunk;
+        if (!mt.pop(chunk)) {
+            RNP_LOG("failed to encrypt aead chunk");
+            return RNP_ERROR_BAD_STATE;
+        }
+        dst_write(param->pkt.writedst, chunk->data.data(), chunk->len + taglen);
+        mt.spare.push_back(std::move(chunk));
+    }
+    return RNP_SUCCESS;
+}
+
+static rnp_result_t
+encrypted_dst_write_aead_mt(pgp_dest_encrypted_param_t *param, const void *buf, size_t len)
+{
+    auto &       mt = *param->aead_mt;
+    size_t       size = param->chunklen + pgp_cipher_aead_tag_len(param->aalg);
+    rnp_result_t res = RNP_SUCCESS;
+
+    try {
+        while (len > 0) {
+            if (!mt.cur) {
+                mt.cur = mt.get_chunk(param->ctx->ealg, param->ctx->aalg, size, false);
+                if (!mt.cur) {
+                    return RNP_ERROR_BAD_STATE; // LCOV_EXCL_LINE
+                }
+                mt.cur->len = 0;
+            }
+            size_t sz = std::min(len, param->chunklen - mt.cur->len);
+            memcpy(mt.cur->data.data() + mt.cur->len, buf, sz);
+            mt.cur->len += sz;
+            len -= sz;
+            buf = (uint8_t *) buf + sz;
+
+            if (mt.cur->len < param->chunklen) {
+                continue;
+            }
+            if ((res = encrypted_aead_mt_submit(param, false)) ||
+                (res = encrypted_aead_mt_flush(param, mt.depth))) {
+                return res;
+            }
+        }
+    } catch (const std::exception &e) {
+        /* LCOV_EXCL_START */
+        RNP_LOG("aead processing failed: %s", e.what());
+        return RNP_ERROR_BAD_STATE;
+        /* LCOV_EXCL_END */
+    }
+    return RNP_SUCCESS;
+}
+
+static rnp_result_t
+encrypted_dst_finish_aead_mt(pgp_dest_encrypted_param_t *param)
+{
+    auto &       mt = *param->aead_mt;
+    rnp_result_t res = RNP_SUCCESS;
+
+    try {
+        /* empty chunk is not written, only the final tag */
+        if (mt.cur && mt.cur->len && (res = encrypted_aead_mt_submit(param, false))) {
+            return res;
+        }
+        if ((res = encrypted_aead_mt_submit(param, true))) {
+            return res;
+        }
+        return encrypted_aead_mt_flush(param, 0);
+    } catch (const std::exception &e) {
+        /* LCOV_EXCL_START */
+        RNP_LOG("aead processing failed: %s", e.what());
+        return RNP_ERROR_BAD_STATE;
+        /* LCOV_EXCL_END */
+    }
+}
+
+static rnp_result_t
+encrypted_start_aead_mt(pgp_dest_encrypted_param_t *param, const uint8_t *enckey)
+{
+    if (param->ctx->threads < 2) {
+        return RNP_SUCCESS;
+    }
+    try {
+        param->aead_mt.reset(
+          new pgp_aead_mt_t(enckey, pgp_key_size(param->ctx->ealg), param->ctx->threads));
+        return RNP_SUCCESS;
+    } catch (const std::exception &e) {
+        /* LCOV_EXCL_START */
+        RNP_LOG("failed to start aead threads: %s", e.what());
+        return RNP_ERROR_OUT_OF_MEMORY;
+        /* LCOV_EXCL_END */
+    }
+}
 #endif
 
 static rnp_result_t
@@ -458,6 +698,10 @@ encrypted_dst_write_aead(pgp_dest_t *dst, const void *buf, size_t len)
         return RNP_SUCCESS;
     }
 
+    if (param->aead_mt) {
+        return encrypted_dst_write_aead_mt(param, buf, len);
+    }
+
     /* because of botan's FFI granularity we need to make things a bit complicated */
     gran = pgp_cipher_aead_granularity(&param->encrypt);
 
@@ -517,13 +761,17 @@ encrypted_dst_finish(pgp_dest_t *dst)
         RNP_LOG("AEAD is not enabled.");
         rnp_result_t res = RNP_ERROR_NOT_IMPLEMENTED;
 #else
-        size_t chunks = param->chunkidx;
-        /* if we didn't write anything in current chunk then discard it and restart */
-        if (param->chunkout || param->cachelen) {
-            chunks++;
+        rnp_result_t res;
+        if (param->aead_mt) {
+            res = encrypted_dst_finish_aead_mt(param);
+        } else {
+            size_t chunks = param->chunkidx;
+            /* if we didn't write anything in current chunk then discard it and restart */
+            if (param->chunkout || param->cachelen) {
+                chunks++;
+            }
+            res = encrypted_start_aead_chunk(param, chunks, true);
         }
-
-        rnp_result_t res = encrypted_start_aead_chunk(param, chunks, true);
         pgp_cipher_aead_destroy(&param->encrypt);
 #endif
         if (res) {
@@ -945,7 +1193,8 @@ encrypted_start_aead(pgp_dest_encrypted_param_t *param, uint8_t *enckey)
         return RNP_ERROR_BAD_PARAMETERS;
     }
 
-    return encrypted_start_aead_chunk(param, 0, false);
+    rnp_result_t res = encrypted_start_aead_chunk(param, 0, false);
+    return res ? res : encrypted_start_aead_mt(param, enckey);
 #endif
 }
 
@@ -1168,19 +1417,11 @@ cleartext_dst_writeline(pgp_dest_signed_param_t *param,
 static size_t
 cleartext_dst_scanline(const uint8_t *buf, size_t len, bool *eol)
 {
-    for (const uint8_t *ptr = buf, *end = buf + len; ptr < end; ptr++) {
-        if (*ptr == CH_LF) {
-            if (eol) {
-                *eol = true;
-            }
-            return ptr - buf + 1;
-        }
-    }
-
+    const uint8_t *ptr = (const uint8_t *) memchr(buf, CH_LF, len);
     if (eol) {
-        *eol = false;
+        *eol = !!ptr;
     }
-    return len;
+    return ptr ? ptr - buf + 1 : len;
 }
 
 static rnp_result_t
@@ -1537,6 +1778,8 @@ init_signed_dst(pgp_write_handler_t *handler, pgp_dest_t *dst, pgp_dest_t *write
         ret = RNP_ERROR_BAD_PARAMETERS;
         goto finish;
     }
+    /* update hashes on separate threads if there is more than one of them */
+    param->hashes.set_threads(param->ctx->threads);
 
     /* Writing headers for cleartext signed document */
     if (param->ctx->clearsign) {
@@ -1564,14 +1807,92 @@ finish:
     return ret;
 }
 
+/* write out compressed blocks, in order, until at most left of them are in flight */
 static rnp_result_t
-compressed_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
+compressed_mt_flush(pgp_dest_compressed_param_t *param, size_t left)
 {
-    pgp_dest_compressed_param_t *param = (pgp_dest_compressed_param_t *) dst->param;
+    auto &mt = *param->zmt;
 
-    if (!param) {
-        RNP_LOG("wrong param");
-        return RNP_ERROR_BAD_PARAMETERS;
+    while (mt.queue.size() > left) {
+        auto block = std::move(mt.queue.front());
+        mt.queue.pop_front();
+        if (!block->res.get()) {
+            /* LCOV_EXCL_START */
+            RNP_LOG("failed to compress block");
+            return RNP_ERROR_BAD_STATE;
+            /* LCOV_EXCL_END */
+        }
+        mt.adler = adler32_combine(mt.adler, block->adler, block->in.size());
+        dst_write(param->pkt.writedst, block->out.data(), block->out.size());
+    }
+    return param->pkt.writedst->werr;
+}
+
+static rnp_result_t
+compressed_dst_write_mt(pgp_dest_compressed_param_t *param, const void *buf, size_t len)
+{
+    auto &       mt = *param->zmt;
+    rnp_result_t res = RNP_SUCCESS;
+
+    try {
+        while (len > 0) {
+            if (!mt.cur) {
+                mt.cur.reset(new pgp_deflate_block_t());
+                mt.cur->in.reserve(PGP_DEFLATE_MT_BLOCK_SIZE);
+            }
+            auto & in = mt.cur->in;
+            size_t sz = std::min<size_t>(len, PGP_DEFLATE_MT_BLOCK_SIZE - in.size());
+            in.insert(in.end(), (const uint8_t *) buf, (const uint8_t *) buf + sz);
+            len -= sz;
+            buf = (const uint8_t *) buf + sz;
+
+            if (in.size() < PGP_DEFLATE_MT_BLOCK_SIZE) {
+                continue;
+            }
+            mt.submit(false);
+            if ((res = compressed_mt_flush(param, mt.depth))) {
+                return res;
+            }
+        }
+    } catch (const std::exception &e) {
+        /* LCOV_EXCL_START */
+        RNP_LOG("compression failed: %s", e.what());
+        return RNP_ERROR_BAD_STATE;
+        /* LCOV_EXCL_END */
+    }
+    return RNP_SUCCESS;
+}
+
+static rnp_result_t
+compressed_dst_finish_mt(pgp_dest_compressed_param_t *param)
+{
+    auto &       mt = *param->zmt;
+    rnp_result_t res = RNP_SUCCESS;
+
+    try {
+        mt.submit(true);
+        if ((res = compressed_mt_flush(param, 0))) {
+            return res;
+        }
+    } catch (const std::exception &e) {
+        /* LCOV_EXCL_START */
+        RNP_LOG("compression failed: %s", e.what());
+        return RNP_ERROR_BAD_STATE;
+        /* LCOV_EXCL_END */
+    }
+    if (param->alg == PGP_C_ZLIB) {
+        uint8_t trailer[4];
+        write_uint32(trailer, mt.adler);
+        dst_write(param->pkt.writedst, trailer, sizeof(trailer));
+    }
+    return RNP_SUCCESS;
+}
+
+static rnp_result_t
+compressed_dst_compress(pgp_dest_compressed_param_t *param, const void *buf, size_t len)
+{
+    if (param->zmt) {
+        return compressed_dst_write_mt(param, buf, len);
     }
 
     if ((param->alg == PGP_C_ZIP) || (param->alg == PGP_C_ZLIB)) {
@@ -1633,13 +1954,185 @@ compressed_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
     }
 }
 
+static rnp_result_t
+init_compressed_mt(pgp_dest_compressed_param_t *param, int zlevel, size_t threads)
+{
+    try {
+        param->zmt = new pgp_deflate_mt_t(zlevel, threads);
+    } catch (const std::exception &e) {
+        /* LCOV_EXCL_START */
+        RNP_LOG("failed to start compression threads: %s", e.what());
+        return RNP_ERROR_OUT_OF_MEMORY;
+        /* LCOV_EXCL_END */
+    }
+    if (param->alg != PGP_C_ZLIB) {
+        return RNP_SUCCESS;
+    }
+    /* RFC 1950 header: deflate with 32K window, compression level hint, no dictionary */
+    int     level = (zlevel == Z_DEFAULT_COMPRESSION) ? 6 : zlevel;
+    uint8_t flevel = (level < 2) ? 0 : (level < 6) ? 1 : (level == 6) ? 2 : 3;
+    uint8_t hdr[2] = {0x78, (uint8_t)(flevel << 6)};
+    hdr[1] += 31 - ((hdr[0] << 8) + hdr[1]) % 31;
+    dst_write(param->pkt.writedst, hdr, sizeof(hdr));
+    return RNP_SUCCESS;
+}
+
+/* Start the compressed packet: write header and initialize compression */
+static rnp_result_t
+compressed_dst_start(pgp_dest_compressed_param_t *param)
+{
+    rnp_ctx_t *ctx = param->ctx;
+    uint8_t    buf;
+    int        zret;
+
+    /* initializing partial length or indeterminate packet, writing header */
+    if (!init_streamed_packet(&param->pkt, param->pkt.origdst)) {
+        /* LCOV_EXCL_START */
+        RNP_LOG("failed to init streamed packet");
+        return RNP_ERROR_BAD_PARAMETERS;
+        /* LCOV_EXCL_END */
+    }
+
+    /* compression algorithm */
+    buf = param->alg;
+    dst_write(param->pkt.writedst, &buf, 1);
+
+    /* initializing compression */
+    switch (param->alg) {
+    case PGP_C_ZIP:
+    case PGP_C_ZLIB:
+        if (ctx->threads > 1) {
+            return init_compressed_mt(param, ctx->zlevel, ctx->threads);
+        }
+        (void) memset(&param->z, 0x0, sizeof(param->z));
+        if (param->alg == PGP_C_ZIP) {
+            zret = deflateInit2(&param->z, ctx->zlevel, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+        } else {
+            zret = deflateInit(&param->z, ctx->zlevel);
+        }
+
+        if (zret != Z_OK) {
+            RNP_LOG("failed to init zlib, error %d", zret);
+            return RNP_ERROR_NOT_SUPPORTED;
+        }
+        break;
+#ifdef HAVE_BZLIB_H
+    case PGP_C_BZIP2:
+        (void) memset(&param->bz, 0x0, sizeof(param->bz));
+        zret = BZ2_bzCompressInit(&param->bz, ctx->zlevel, 0, 0);
+        if (zret != BZ_OK) {
+            RNP_LOG("failed to init bz, error %d", zret);
+            return RNP_ERROR_NOT_SUPPORTED;
+        }
+        break;
+#endif
+    default:
+        RNP_LOG("unknown compression algorithm");
+        return RNP_ERROR_NOT_SUPPORTED;
+    }
+    param->zstarted = true;
+    return RNP_SUCCESS;
+}
+
+/* Trial deflate of the sample with the fastest level, estimating whether compression is worth
+ * the effort. Data which saves less than 1/32 of its size is considered incompressible. */
+static bool
+compressed_sample_compressible(const uint8_t *buf, size_t len)
+{
+    z_stream z = {};
+    if (!len || (deflateInit2(&z, 1, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)) {
+        return false;
+    }
+    std::unique_ptr<uint8_t[]> out(new (std::nothrow) uint8_t[len]);
+    size_t                     limit = len - len / 32;
+    int                        zret = Z_STREAM_ERROR;
+    if (out) {
+        z.next_in = (unsigned char *) buf;
+        z.avail_in = len;
+        z.next_out = out.get();
+        z.avail_out = limit;
+        /* output buffer is limited, so if it is not enough then data is incompressible */
+        zret = deflate(&z, Z_FINISH);
+    }
+    deflateEnd(&z);
+    return zret == Z_STREAM_END;
+}
+
+/* Decide, basing on the sample, whether to compress data or to write it as is */
+static rnp_result_t
+compressed_dst_sampled(pgp_dest_compressed_param_t *param)
+{
+    uint8_t *    sample = param->sample;
+    size_t       len = param->samplelen;
+    rnp_result_t ret = RNP_SUCCESS;
+
+    param->sample = NULL;
+    param->samplelen = 0;
+    if (!compressed_sample_compressible(sample, len)) {
+        param->bypass = true;
+        dst_write(param->pkt.origdst, sample, len);
+        ret = param->pkt.origdst->werr;
+    } else if (!(ret = compressed_dst_start(param))) {
+        ret = compressed_dst_compress(param, sample, len);
+    }
+    free(sample);
+    return ret;
+}
+
+static rnp_result_t
+compressed_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
+{
+    pgp_dest_compressed_param_t *param = (pgp_dest_compressed_param_t *) dst->param;
+
+    if (!param) {
+        RNP_LOG("wrong param");
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+
+    if (param->sample) {
+        size_t sz = std::min<size_t>(len, PGP_COMPRESS_SAMPLE_SIZE - param->samplelen);
+        memcpy(param->sample + param->samplelen, buf, sz);
+        param->samplelen += sz;
+        buf = (const uint8_t *) buf + sz;
+        len -= sz;
+        if (param->samplelen < PGP_COMPRESS_SAMPLE_SIZE) {
+            return RNP_SUCCESS;
+        }
+        rnp_result_t ret = compressed_dst_sampled(param);
+        if (ret || !len) {
+            return ret;
+        }
+    }
+
+    if (param->bypass) {
+        dst_write(param->pkt.origdst, buf, len);
+        return param->pkt.origdst->werr;
+    }
+    return compressed_dst_compress(param, buf, len);
+}
+
 static rnp_result_t
 compressed_dst_finish(pgp_dest_t *dst)
 {
     int                          zret;
     pgp_dest_compressed_param_t *param = (pgp_dest_compressed_param_t *) dst->param;
 
-    if ((param->alg == PGP_C_ZIP) || (param->alg == PGP_C_ZLIB)) {
+    if (param->sample) {
+        rnp_result_t ret = compressed_dst_sampled(param);
+        if (ret) {
+            return ret;
+        }
+    }
+    if (param->bypass) {
+        return param->pkt.origdst->werr;
+    }
+
+    if (param->zmt) {
+        rnp_result_t ret = compressed_dst_finish_mt(param);
+        if (ret) {
+            return ret;
+        }
+    } else if ((param->alg == PGP_C_ZIP) || (param->alg == PGP_C_ZLIB)) {
         param->z.next_in = Z_NULL;
         param->z.avail_in = 0;
         param->z.next_out = param->cache + param->len;
@@ -1717,8 +2210,13 @@ compressed_dst_close(pgp_dest_t *dst, bool discard)
         }
 #endif
     }
+    delete param->zmt;
+    free(param->sample);
 
-    close_streamed_packet(&param->pkt, discard);
+    /* packet is not started if data was not compressed */
+    if (param->pkt.writedst) {
+        close_streamed_packet(&param->pkt, discard);
+    }
     free(param);
     dst->param = NULL;
 }
@@ -1727,9 +2225,7 @@ static rnp_result_t
 init_compressed_dst(pgp_write_handler_t *handler, pgp_dest_t *dst, pgp_dest_t *writedst)
 {
     pgp_dest_compressed_param_t *param;
-    rnp_result_t                 ret = RNP_ERROR_GENERIC;
-    uint8_t                      buf;
-    int                          zret;
+    rnp_result_t                 ret = RNP_SUCCESS;
 
     if (!init_dst_common(dst, sizeof(*param))) {
         return RNP_ERROR_OUT_OF_MEMORY; // LCOV_EXCL_LINE
@@ -1740,65 +2236,26 @@ init_compressed_dst(pgp_write_handler_t *handler, pgp_dest_t *dst, pgp_dest_t *w
     dst->finish = compressed_dst_finish;
     dst->close = compressed_dst_close;
     dst->type = PGP_STREAM_COMPRESSED;
+    param->ctx = handler->ctx;
     param->alg = (pgp_compression_type_t) handler->ctx->zalg;
     param->pkt.partial = true;
     param->pkt.indeterminate = false;
     param->pkt.tag = PGP_PKT_COMPRESSED;
+    param->pkt.origdst = writedst;
 
-    /* initializing partial length or indeterminate packet, writing header */
-    if (!init_streamed_packet(&param->pkt, writedst)) {
-        /* LCOV_EXCL_START */
-        RNP_LOG("failed to init streamed packet");
-        ret = RNP_ERROR_BAD_PARAMETERS;
-        goto finish;
-        /* LCOV_EXCL_END */
-    }
-
-    /* compression algorithm */
-    buf = param->alg;
-    dst_write(param->pkt.writedst, &buf, 1);
-
-    /* initializing compression */
-    switch (param->alg) {
-    case PGP_C_ZIP:
-    case PGP_C_ZLIB:
-        (void) memset(&param->z, 0x0, sizeof(param->z));
-        if (param->alg == PGP_C_ZIP) {
-            zret = deflateInit2(
-              &param->z, handler->ctx->zlevel, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
-        } else {
-            zret = deflateInit(&param->z, handler->ctx->zlevel);
-        }
-
-        if (zret != Z_OK) {
-            RNP_LOG("failed to init zlib, error %d", zret);
-            ret = RNP_ERROR_NOT_SUPPORTED;
-            goto finish;
-        }
-        break;
-#ifdef HAVE_BZLIB_H
-    case PGP_C_BZIP2:
-        (void) memset(&param->bz, 0x0, sizeof(param->bz));
-        zret = BZ2_bzCompressInit(&param->bz, handler->ctx->zlevel, 0, 0);
-        if (zret != BZ_OK) {
-            RNP_LOG("failed to init bz, error %d", zret);
-            ret = RNP_ERROR_NOT_SUPPORTED;
-            goto finish;
+    /* packet is not started until it is known whether data is compressible */
+    if (handler->ctx->zauto) {
+        param->sample = (uint8_t *) malloc(PGP_COMPRESS_SAMPLE_SIZE);
+        if (!param->sample) {
+            ret = RNP_ERROR_OUT_OF_MEMORY; // LCOV_EXCL_LINE
         }
-        break;
-#endif
-    default:
-        RNP_LOG("unknown compression algorithm");
-        ret = RNP_ERROR_NOT_SUPPORTED;
-        goto finish;
+    } else {
+        ret = compressed_dst_start(param);
     }
-    param->zstarted = true;
-    ret = RNP_SUCCESS;
-finish:
+
     if (ret != RNP_SUCCESS) {
         compressed_dst_close(dst, true);
     }
-
     return ret;
 }
 
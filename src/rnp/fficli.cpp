@@ -63,12 +63,6 @@
 #include "time-utils.h"
 #include "defaults.h"
 
-#ifndef RNP_USE_STD_REGEX
-#include <regex.h>
-#else
-#include <regex>
-#endif
-
 #ifdef HAVE_SYS_RESOURCE_H
 /* When system resource consumption limit controls are available this
  * can be used to attempt to disable core dumps which may leak
@@ -736,7 +730,7 @@ cli_rnp_t::load_keyring(bool secret)
     }
 
     rnp_input_t keyin = NULL;
-    if (rnp_input_from_path(&keyin, path.c_str())) {
+    if (rnp_input_from_path_mmap(&keyin, path.c_str())) {
         ERR_MSG("Warning: failed to open keyring at path '%s' for reading.", path.c_str());
         return true;
     }
@@ -1245,48 +1239,6 @@ cli_rnp_set_cipher(rnp_cfg &cfg, const std::string &cipher)
     return true;
 }
 
-#ifndef RNP_USE_STD_REGEX
-static std::string
-cli_rnp_unescape_for_regcomp(const std::string &src)
-{
-    std::string result;
-    result.reserve(src.length());
-    regex_t    r = {};
-    regmatch_t matches[1];
-    if (regcomp(&r, "\\\\x[0-9a-f]([0-9a-f])?", REG_EXTENDED | REG_ICASE) != 0)
-        return src;
-
-    int offset = 0;
-    while (regexec(&r, src.c_str() + offset, 1, matches, 0) == 0) {
-        result.append(src, offset, matches[0].rm_so);
-        int         hexoff = matches[0].rm_so + 2;
-        std::string hex;
-        hex.push_back(src[offset + hexoff]);
-        if (hexoff + 1 < matches[0].rm_eo) {
-            hex.push_back(src[offset + hexoff + 1]);
-        }
-        char decoded = stoi(hex, 0, 16);
-        if ((decoded >= 0x7B && decoded <= 0x7D) || (decoded >= 0x24 && decoded <= 0x2E) ||
-            decoded == 0x5C || decoded == 0x5E) {
-            result.push_back('\\');
-            result.push_back(decoded);
-        } else if ((decoded == '[' || decoded == ']') &&
-                   /* not enclosed in [] */ (result.empty() || result.back() != '[')) {
-            result.push_back('[');
-            result.push_back(decoded);
-            result.push_back(']');
-        } else {
-            result.push_back(decoded);
-        }
-        offset += matches[0].rm_eo;
-    }
-
-    result.append(src.begin() + offset, src.end());
-
-    return result;
-}
-#endif
-
 /* Convert key algorithm constant to one displayed to the user */
 static const char *
 cli_rnp_normalize_key_alg(const char *alg)
@@ -1521,10 +1473,19 @@ cli_rnp_save_keyrings(cli_rnp_t *rnp)
         }
     }
 
+    // G10 stores each key in a separate file, so write only the changed ones
+    uint32_t pub_flags = RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_MARK_CLEAN;
+    if (rnp->pubformat() == "G10") {
+        pub_flags |= RNP_LOAD_SAVE_INCREMENTAL;
+    }
+    uint32_t sec_flags = RNP_LOAD_SAVE_SECRET_KEYS | RNP_LOAD_SAVE_MARK_CLEAN;
+    if (rnp->secformat() == "G10") {
+        sec_flags |= RNP_LOAD_SAVE_INCREMENTAL;
+    }
+
     // public keyring
     if (!(pub_ret = rnp_output_to_path(&output, ppath.c_str()))) {
-        pub_ret =
-          rnp_save_keys(rnp->ffi, rnp->pubformat().c_str(), output, RNP_LOAD_SAVE_PUBLIC_KEYS);
+        pub_ret = rnp_save_keys(rnp->ffi, rnp->pubformat().c_str(), output, pub_flags);
         rnp_output_destroy(output);
     }
     if (pub_ret) {
@@ -1533,8 +1494,7 @@ cli_rnp_save_keyrings(cli_rnp_t *rnp)
 
     // secret keyring
     if (!(sec_ret = rnp_output_to_path(&output, spath.c_str()))) {
-        sec_ret =
-          rnp_save_keys(rnp->ffi, rnp->secformat().c_str(), output, RNP_LOAD_SAVE_SECRET_KEYS);
+        sec_ret = rnp_save_keys(rnp->ffi, rnp->secformat().c_str(), output, sec_flags);
         rnp_output_destroy(output);
     }
     if (sec_ret) {
@@ -1770,90 +1730,6 @@ done:
     return res;
 }
 
-static bool
-key_matches_string(rnpffi::Key &key, const std::string &str)
-{
-    if (str.empty()) {
-        return true;
-    }
-    if (rnp::is_hex(str) && (str.length() >= RNP_KEYID_SIZE)) {
-        std::string hexstr = rnp::strip_hex(str);
-        size_t      len = hexstr.length();
-
-        /* check whether it's key id */
-        if ((len == RNP_KEYID_SIZE * 2) || (len == RNP_KEYID_SIZE)) {
-            auto keyid = key.keyid();
-            if (keyid.size() < len) {
-                return false;
-            }
-            if (!strncasecmp(hexstr.c_str(), keyid.c_str() + keyid.size() - len, len)) {
-                return true;
-            }
-        }
-
-        /* check fingerprint */
-        auto keyfp = key.fprint();
-        if ((len == keyfp.size()) && !strncasecmp(hexstr.c_str(), keyfp.c_str(), len)) {
-            return true;
-        }
-
-        /* check grip */
-        auto grip = key.grip();
-        if (len == grip.size()) {
-            if (!strncasecmp(hexstr.c_str(), grip.c_str(), len)) {
-                return true;
-            }
-        }
-        /* let then search for hex userid */
-    }
-
-    /* no need to check for userid over the subkey */
-    if (key.is_sub()) {
-        return false;
-    }
-    auto uid_count = key.uid_count();
-    if (!uid_count) {
-        return false;
-    }
-
-#ifndef RNP_USE_STD_REGEX
-    regex_t r = {};
-    /* match on full name or email address as a NOSUB, ICASE regexp */
-    if (regcomp(&r, cli_rnp_unescape_for_regcomp(str).c_str(), REG_EXTENDED | REG_ICASE) !=
-        0) {
-        return false;
-    }
-#else
-    std::regex re;
-    try {
-        re.assign(str, std::regex_constants::ECMAScript | std::regex_constants::icase);
-    } catch (const std::exception &e) {
-        ERR_MSG("Invalid regular expression : %s, error %s.", str.c_str(), e.what());
-        return false;
-    }
-#endif
-
-    bool matches = false;
-    for (size_t idx = 0; idx < uid_count; idx++) {
-        auto uid = key.uid_at(idx);
-#ifndef RNP_USE_STD_REGEX
-        if (regexec(&r, uid.c_str(), 0, NULL, 0) == 0) {
-            matches = true;
-            break;
-        }
-#else
-        if (std::regex_search(uid, re)) {
-            matches = true;
-            break;
-        }
-#endif
-    }
-#ifndef RNP_USE_STD_REGEX
-    regfree(&r);
-#endif
-    return matches;
-}
-
 static bool
 key_matches_flags(rnpffi::Key &key, int flags)
 {
@@ -1940,19 +1816,22 @@ cli_rnp_t::keys_matching(std::vector<rnp_key_handle_t> &keys,
 {
     rnpffi::FFI ffiobj(ffi, false);
 
-    /* iterate through the keys */
-    auto it = ffiobj.iterator_create("fingerprint");
-    if (!it) {
+    /* search string is compiled once, and keystore indexes are used where possible */
+    uint32_t sflags = 0;
+    if (flags & CLI_SEARCH_SECRET) {
+        sflags |= RNP_KEY_SEARCH_SECRET;
+    }
+    if (flags & CLI_SEARCH_SUBKEYS) {
+        sflags |= RNP_KEY_SEARCH_SUBKEYS;
+    }
+    auto search = ffiobj.search_create(str, sflags);
+    if (!search) {
+        /* invalid regular expression: caller reports that key is not found */
         return false;
     }
 
-    std::string fp;
-    while (it->next(fp)) {
-        auto key = ffiobj.locate_key("fingerprint", fp);
-        if (!key) {
-            continue;
-        }
-        if (!key_matches_flags(*key, flags) || !key_matches_string(*key, str)) {
+    while (auto key = search->next()) {
+        if (!key_matches_flags(*key, flags)) {
             continue;
         }
         if (!add_key_to_array(ffi, keys, key->handle(), flags)) {
@@ -2157,7 +2036,10 @@ is_stdinout_spec(const std::string &spec)
 }
 
 rnp_input_t
-cli_rnp_input_from_specifier(cli_rnp_t &rnp, const std::string &spec, bool *is_path)
+cli_rnp_input_from_specifier(cli_rnp_t &        rnp,
+                             const std::string &spec,
+                             bool *             is_path,
+                             bool               mmap)
 {
     rnp_input_t  input = NULL;
     rnp_result_t res = RNP_ERROR_GENERIC;
@@ -2175,7 +2057,8 @@ cli_rnp_input_from_specifier(cli_rnp_t &rnp, const std::string &spec, bool *is_p
         res = rnp_input_from_memory(&input, (const uint8_t *) envval, strlen(envval), true);
     } else {
         /* input from path */
-        res = rnp_input_from_path(&input, spec.c_str());
+        res = mmap ? rnp_input_from_path_mmap(&input, spec.c_str()) :
+                     rnp_input_from_path(&input, spec.c_str());
         path = true;
     }
 
@@ -2520,7 +2403,9 @@ cli_rnp_t::init_io(Operation op, rnp_input_t *input, rnp_output_t *output)
     const std::string &in = cfg().get_str(CFG_INFILE);
     bool               is_pathin = true;
     if (input) {
-        *input = cli_rnp_input_from_specifier(*this, in, &is_pathin);
+        /* decryption/verification doesn't modify input so may read it directly */
+        bool mmap = op == Operation::Verify;
+        *input = cli_rnp_input_from_specifier(*this, in, &is_pathin, mmap);
         if (!*input) {
             return false;
         }
@@ -2694,6 +2579,9 @@ cli_rnp_sign(const rnp_cfg &cfg, cli_rnp_t *rnp, rnp_input_t input, rnp_output_t
         goto done;
     }
     rnp_op_sign_set_creation_time(op, cfg.get_sig_creation());
+    if (cfg.has(CFG_THREADS) && rnp_op_sign_set_threads(op, cfg.get_int(CFG_THREADS))) {
+        goto done;
+    }
     {
         uint32_t expiration = 0;
         if (cfg.get_expiration(CFG_EXPIRATION, expiration)) {
@@ -2779,6 +2667,9 @@ cli_rnp_encrypt_and_sign(const rnp_cfg &cfg,
     if (cfg.has(CFG_NOWRAP) && rnp_op_encrypt_set_flags(op, RNP_ENCRYPT_NOWRAP)) {
         goto done;
     }
+    if (cfg.has(CFG_THREADS) && rnp_op_encrypt_set_threads(op, cfg.get_int(CFG_THREADS))) {
+        goto done;
+    }
 
     /* adding passwords if password-based encryption is used */
     if (cfg.get_bool(CFG_ENCRYPT_SK)) {
@@ -3122,7 +3013,7 @@ cli_rnp_process_file(cli_rnp_t *rnp)
             /* cannot fail as we checked for extension previously */
             strip_extension(src);
         }
-        source = cli_rnp_input_from_specifier(*rnp, src, NULL);
+        source = cli_rnp_input_from_specifier(*rnp, src, NULL, true);
         if (!source) {
             ERR_MSG("Failed to open source for detached signature verification.");
             goto done;
@@ -3154,6 +3045,9 @@ cli_rnp_process_file(cli_rnp_t *rnp)
             }
             ret = rnp_op_verify_set_flags(verify, flags);
         }
+        if (!ret && rnp->cfg().has(CFG_THREADS)) {
+            ret = rnp_op_verify_set_threads(verify, rnp->cfg().get_int(CFG_THREADS));
+        }
     }
     if (ret) {
         ERR_MSG("Failed to initialize verification/decryption operation.");
@@ -199,11 +199,13 @@ bool cli_cfg_set_keystore_info(rnp_cfg &cfg);
  * @param is_path optional parameter. If specifier is path (not stdin, env variable), then true
  *                will be stored here, false otherwise. May be NULL if this information is not
  *                needed.
+ * @param mmap memory-map the file if specifier is a path to the regular file.
  * @return rnp_input_t object or NULL if operation failed.
  */
 rnp_input_t cli_rnp_input_from_specifier(cli_rnp_t &        rnp,
                                          const std::string &spec,
-                                         bool *             is_path);
+                                         bool *             is_path,
+                                         bool               mmap = false);
 
 /**
  * @brief Create output object from the specifier, which may represent:
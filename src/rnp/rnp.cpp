@@ -70,6 +70,8 @@ static const char *usage =
   "    --[zip,zlib,bzip]     Use the corresponding compression algorithm.\n"
   "    --armor               Apply ASCII armor to the encryption/signing output.\n"
   "    --no-wrap             Do not wrap the output in a literal data packet.\n"
+  "    --threads num         Use the specified number of threads for AEAD, ZIP/ZLIB\n"
+  "                          compression and hashing.\n"
   "  -c, --symmetric         Encrypt data using the password(s).\n"
   "    --passwords num       Encrypt to the specified number of passwords.\n"
   "  -s, --sign              Sign data. May be combined with encryption.\n"
@@ -169,6 +171,7 @@ enum optdefs {
     OPT_ALLOW_HIDDEN,
     OPT_S2K_ITER,
     OPT_S2K_MSEC,
+    OPT_THREADS,
 
     /* debug */
     OPT_DEBUG
@@ -239,6 +242,7 @@ static struct option options[] = {
   {"allow-hidden", no_argument, NULL, OPT_ALLOW_HIDDEN},
   {"s2k-iterations", required_argument, NULL, OPT_S2K_ITER},
   {"s2k-msec", required_argument, NULL, OPT_S2K_MSEC},
+  {"threads", required_argument, NULL, OPT_THREADS},
   {"allow-weak-hash", no_argument, NULL, OPT_ALLOW_WEAK_HASH},
   {"allow-sha1-key-sigs", no_argument, NULL, OPT_ALLOW_SHA1},
 
@@ -553,6 +557,15 @@ setoption(rnp_cfg &cfg, int val, const char *arg)
         cfg.set_int(CFG_S2K_MSEC, msec);
         return true;
     }
+    case OPT_THREADS: {
+        int threads = 0;
+        if (!rnp::str_to_int(arg, threads) || (threads < 1)) {
+            ERR_MSG("Wrong threads value: %s", arg);
+            return false;
+        }
+        cfg.set_int(CFG_THREADS, threads);
+        return true;
+    }
     case OPT_DEBUG:
         ERR_MSG("Option --debug is deprecated, ignoring.");
         return true;
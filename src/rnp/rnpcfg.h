@@ -99,6 +99,7 @@
 #define CFG_NOWRAP "no-wrap"            /* do not wrap the output in a literal data packet */
 #define CFG_CURTIME "curtime"           /* date or timestamp to override the system's time */
 #define CFG_ALLOW_HIDDEN "allow-hidden" /* allow hidden recipients */
+#define CFG_THREADS "threads"           /* number of threads for AEAD processing */
 
 /* rnp keyring setup variables */
 #define CFG_KR_PUB_FORMAT "kr-pub-format"
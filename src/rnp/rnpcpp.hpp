@@ -374,6 +374,44 @@ class IdentifierIterator {
     }
 };
 
+class KeySearch {
+    rnp_key_search_t handle_;
+
+  public:
+    KeySearch() = delete;
+    KeySearch(const KeySearch &) = delete;
+    KeySearch(KeySearch &&) = delete;
+    KeySearch &operator=(const KeySearch &) = delete;
+    KeySearch &operator=(KeySearch &&) = delete;
+
+    KeySearch(rnp_key_search_t handle)
+    {
+        if (!handle) {
+            throw std::invalid_argument("handle");
+        }
+        handle_ = handle;
+    }
+
+    ~KeySearch()
+    {
+        rnp_key_search_destroy(handle_);
+    }
+
+    std::unique_ptr<Key>
+    next()
+    {
+        rnp_key_handle_t handle = NULL;
+        if (rnp_key_search_next(handle_, &handle) || !handle) {
+            return nullptr;
+        }
+        auto res = new (std::nothrow) Key(handle);
+        if (!res) {
+            rnp_key_handle_destroy(handle);
+        }
+        return std::unique_ptr<Key>(res);
+    }
+};
+
 class FFI {
     rnp_ffi_t handle_;
     bool      own_;
@@ -429,6 +467,20 @@ class FFI {
         return std::unique_ptr<IdentifierIterator>(res);
     }
 
+    std::unique_ptr<KeySearch>
+    search_create(const std::string &query, uint32_t flags)
+    {
+        rnp_key_search_t search = NULL;
+        if (rnp_key_search_create(handle_, &search, query.c_str(), flags)) {
+            return nullptr;
+        }
+        auto res = new (std::nothrow) KeySearch(search);
+        if (!res) {
+            rnp_key_search_destroy(search);
+        }
+        return std::unique_ptr<KeySearch>(res);
+    }
+
     bool
     request_password(Key &key, const std::string &ctx, String &password)
     {
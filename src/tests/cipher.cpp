@@ -88,6 +88,251 @@ TEST_F(rnp_tests, hash_test_success)
     }
 }
 
+static uint32_t
+crc24_bitwise(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint32_t) buf[i] << 16;
+        for (int bit = 0; bit < 8; bit++) {
+            crc <<= 1;
+            if (crc & 0x1000000) {
+                crc ^= 0x1864cfb;
+            }
+        }
+    }
+    return crc & 0xffffff;
+}
+
+TEST_F(rnp_tests, crc24_test_success)
+{
+    /* check value */
+    auto crc = rnp::CRC24::create();
+    crc->add("123456789", 9);
+    auto res = crc->finish();
+    assert_true(bin_eq_hex(res.data(), res.size(), "21CF02"));
+
+    /* carry-less multiplication kernel is used for the longer inputs */
+    std::vector<uint8_t> data(10000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (uint8_t)(i * 31 + (i >> 5));
+    }
+    for (size_t len : {0, 1, 15, 16, 17, 63, 64, 65, 127, 128, 1000, 10000}) {
+        uint32_t expected = crc24_bitwise(0xb704ce, data.data(), len);
+        for (size_t chunk : {1, 17, 100, 10000}) {
+            crc = rnp::CRC24::create();
+            for (size_t pos = 0; pos < len; pos += chunk) {
+                crc->add(data.data() + pos, std::min(chunk, len - pos));
+            }
+            res = crc->finish();
+            assert_int_equal((res[0] << 16) | (res[1] << 8) | res[2], expected);
+        }
+    }
+}
+
+static std::vector<uint8_t>
+hash_list_digest(const rnp::HashList &list, pgp_hash_alg_t alg)
+{
+    auto                 hash = list.get(alg)->clone();
+    std::vector<uint8_t> res(hash->size());
+    hash->finish(res.data());
+    return res;
+}
+
+TEST_F(rnp_tests, hash_list_concurrent)
+{
+    std::vector<uint8_t> data(300000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (uint8_t)(i * 7 + (i >> 9));
+    }
+    const pgp_hash_alg_t algs[] = {PGP_HASH_SHA256, PGP_HASH_SHA512, PGP_HASH_SHA1};
+
+    /* fewer threads than hashes makes each thread update a few of them */
+    for (size_t threads : {2, 4, 100}) {
+        for (size_t chunk : {1, 1000, 65536, 300000}) {
+            SCOPED_TRACE("threads " + std::to_string(threads) + ", chunk " +
+                         std::to_string(chunk));
+            rnp::HashList single;
+            rnp::HashList multi;
+            multi.set_threads(threads);
+            for (auto alg : algs) {
+                single.add_alg(alg);
+                multi.add_alg(alg);
+            }
+            /* digests must match at any point, not only at the end */
+            for (size_t pos = 0; pos < data.size(); pos += chunk) {
+                size_t len = std::min(chunk, data.size() - pos);
+                single.add(data.data() + pos, len);
+                multi.add(data.data() + pos, len);
+                if (pos == 100 * chunk) {
+                    assert_true(hash_list_digest(single, PGP_HASH_SHA1) ==
+                                hash_list_digest(multi, PGP_HASH_SHA1));
+                }
+            }
+            /* adding algorithm restarts the workers */
+            single.add_alg(PGP_HASH_SHA384);
+            multi.add_alg(PGP_HASH_SHA384);
+            single.add(data.data(), 1000);
+            multi.add(data.data(), 1000);
+            multi.set_threads(0);
+            multi.add(data.data(), 10);
+            single.add(data.data(), 10);
+            for (auto alg :
+                 {PGP_HASH_SHA256, PGP_HASH_SHA512, PGP_HASH_SHA1, PGP_HASH_SHA384}) {
+                assert_true(hash_list_digest(single, alg) == hash_list_digest(multi, alg));
+            }
+        }
+    }
+}
+
+TEST_F(rnp_tests, s2k_iterated_known_answer)
+{
+    /* 32-byte key out of 20/16-byte digests needs two output blocks, which are derived on
+     * separate threads starting from 65536 iterations */
+    struct {
+        pgp_hash_alg_t alg;
+        const char *   password;
+        size_t         iterations;
+        const char *   key;
+    } vectors[] = {
+      {PGP_HASH_SHA1,
+       "password",
+       1,
+       "91DDD4CCE4618E7DA014CBC81825FA43E5ECA62F746E836CEF2DBC1E5A28CEE3"},
+      {PGP_HASH_SHA1,
+       "password",
+       1024,
+       "BF017B22BEF28B692EAA0B9074F8CD3017F4FF9F2B6DF781F1A55C143864DEE8"},
+      {PGP_HASH_SHA1,
+       "password",
+       65536,
+       "19FADB83496D201EB48E03E4EE94EF72F0A4FB704163F5E4F3B0277FDC86B973"},
+      {PGP_HASH_SHA1,
+       "long password",
+       1048583,
+       "6A280B4D50A438294C29F88AF56F9A4726C27A99AE49C715077E6726A34C49D0"},
+      {PGP_HASH_MD5,
+       "password",
+       65011712,
+       "28B9399F20E508424646E6B5A9959498932BD6E15AD5C12943011A41719E7BA8"},
+    };
+    const uint8_t salt[PGP_SALT_SIZE] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+    for (auto &vec : vectors) {
+        SCOPED_TRACE(std::to_string(vec.iterations));
+        uint8_t key[32] = {0};
+        assert_int_equal(
+          pgp_s2k_iterated(vec.alg, key, sizeof(key), vec.password, salt, vec.iterations), 0);
+        assert_true(bin_eq_hex(key, sizeof(key), vec.key));
+    }
+}
+
+TEST_F(rnp_tests, s2k_cache)
+{
+    pgp_s2k_t s2k{};
+    s2k.specifier = PGP_S2KS_ITERATED_AND_SALTED;
+    s2k.hash_alg = PGP_HASH_SHA256;
+    s2k.iterations = 96;
+    memset(s2k.salt, 0x11, PGP_SALT_SIZE);
+
+    uint8_t key[32] = {0};
+    uint8_t cached[32] = {0};
+    assert_true(pgp_s2k_derive_key(&s2k, "password", key, sizeof(key)));
+
+    /* disabled by default */
+    rnp::S2KCache cache;
+    cache.put(s2k, "password", key, sizeof(key));
+    assert_false(cache.get(s2k, "password", cached, sizeof(cached)));
+
+    cache.set_limits(2, 0, global_ctx.rng);
+    /* derivation only looks up the cache, key is put there once it is known to be correct */
+    assert_true(pgp_s2k_derive_key(&s2k, "password", cached, sizeof(cached), &cache));
+    assert_int_equal(memcmp(key, cached, sizeof(key)), 0);
+    assert_false(cache.get(s2k, "password", cached, sizeof(cached)));
+    cache.put(s2k, "password", key, sizeof(key));
+    memset(cached, 0, sizeof(cached));
+    assert_true(cache.get(s2k, "password", cached, sizeof(cached)));
+    assert_true(pgp_s2k_derive_key(&s2k, "password", cached, sizeof(cached), &cache));
+    assert_int_equal(memcmp(key, cached, sizeof(key)), 0);
+    /* password, salt and key size must match */
+    assert_false(cache.get(s2k, "passw0rd", cached, sizeof(cached)));
+    assert_false(cache.get(s2k, "password", cached, 16));
+    pgp_s2k_t s2k2 = s2k;
+    s2k2.salt[0] ^= 1;
+    assert_false(cache.get(s2k2, "password", cached, sizeof(cached)));
+    /* simple S2K is not cached */
+    pgp_s2k_t simple = s2k;
+    simple.specifier = PGP_S2KS_SIMPLE;
+    cache.put(simple, "password", key, sizeof(key));
+    assert_false(cache.get(simple, "password", cached, sizeof(cached)));
+    /* least recently used entry is evicted */
+    assert_true(pgp_s2k_derive_key(&s2k2, "password", cached, sizeof(cached)));
+    cache.put(s2k2, "password", cached, sizeof(cached));
+    assert_true(cache.get(s2k, "password", cached, sizeof(cached)));
+    assert_true(pgp_s2k_derive_key(&s2k, "passw0rd", cached, sizeof(cached)));
+    cache.put(s2k, "passw0rd", cached, sizeof(cached));
+    assert_true(cache.get(s2k, "password", cached, sizeof(cached)));
+    assert_false(cache.get(s2k2, "password", cached, sizeof(cached)));
+    assert_true(cache.get(s2k, "passw0rd", cached, sizeof(cached)));
+    /* flush */
+    cache.clear();
+    assert_false(cache.get(s2k, "password", cached, sizeof(cached)));
+    assert_false(cache.get(s2k, "passw0rd", cached, sizeof(cached)));
+}
+
+TEST_F(rnp_tests, mpi_storage)
+{
+    uint8_t buf[PGP_MPINT_SIZE + 1];
+    for (size_t i = 0; i < sizeof(buf); i++) {
+        buf[i] = (uint8_t)(i + 1);
+    }
+    /* inline value */
+    pgp::mpi small;
+    assert_int_equal(small.bytes(), 0);
+    assert_true(small.from_mem(buf, 33));
+    assert_int_equal(small.bytes(), 33);
+    assert_int_equal(memcmp(small.data(), buf, 33), 0);
+    /* heap value */
+    pgp::mpi large;
+    assert_true(large.from_mem(buf, 512));
+    assert_int_equal(large.bits(), 512 * 8 - 7);
+    assert_false(large.from_mem(buf, sizeof(buf)));
+    assert_throw(large.resize(sizeof(buf)));
+    assert_int_equal(large.bytes(), 512);
+    /* copy and move */
+    pgp::mpi copy(large);
+    assert_true(copy == large);
+    assert_int_equal(memcmp(copy.data(), buf, 512), 0);
+    pgp::mpi moved(std::move(copy));
+    assert_int_equal(copy.bytes(), 0);
+    assert_true(moved == large);
+    copy = small;
+    assert_true(copy == small);
+    moved = std::move(copy);
+    assert_true(moved == small);
+    assert_int_equal(copy.bytes(), 0);
+    /* resize keeps contents and zeroes new bytes, both ways between inline and heap */
+    large.resize(10);
+    assert_int_equal(memcmp(large.data(), buf, 10), 0);
+    large.resize(100);
+    assert_int_equal(memcmp(large.data(), buf, 10), 0);
+    assert_int_equal(large[10], 0);
+    assert_int_equal(large[99], 0);
+    large.resize(PGP_MPINT_SIZE);
+    large.resize(5);
+    assert_int_equal(large.bytes(), 5);
+    assert_int_equal(memcmp(large.data(), buf, 5), 0);
+    /* leading zeroes are ignored in comparison */
+    pgp::mpi zlarge;
+    zlarge.resize(6);
+    memcpy(&zlarge[1], buf, 5);
+    assert_true(zlarge == large);
+    /* forget clears everything */
+    small.forget();
+    assert_true(mpi_empty(small));
+    large.forget();
+    assert_true(mpi_empty(large));
+}
+
 TEST_F(rnp_tests, cipher_test_success)
 {
     const uint8_t  key[16] = {0};
@@ -128,7 +373,7 @@ TEST_F(rnp_tests, pkcs1_rsa_test_success)
 
     pgp_encrypted_material_t enc;
     assert_rnp_success(seckey.material->encrypt(global_ctx, enc, ptext, 3));
-    assert_int_equal(enc.rsa.m.len, 1024 / 8);
+    assert_int_equal(enc.rsa.m.bytes(), 1024 / 8);
 
     memset(dec, 0, sizeof(dec));
     size_t dec_size = 0;
@@ -137,6 +382,40 @@ TEST_F(rnp_tests, pkcs1_rsa_test_success)
     assert_int_equal(dec_size, 3);
 }
 
+TEST_F(rnp_tests, rsa_key_material_cache)
+{
+    rnp_keygen_crypto_params_t key_desc;
+    key_desc.key_alg = PGP_PKA_RSA;
+    key_desc.hash_alg = PGP_HASH_SHA256;
+    key_desc.rsa.modulus_bit_len = 1024;
+    key_desc.ctx = &global_ctx;
+    pgp_key_pkt_t seckey1;
+    pgp_key_pkt_t seckey2;
+    assert_true(pgp_generate_seckey(key_desc, seckey1, true));
+    assert_true(pgp_generate_seckey(key_desc, seckey2, true));
+
+    rnp::secure_vector<uint8_t> hash(32);
+    global_ctx.rng.get(hash.data(), hash.size());
+    pgp_signature_material_t sig = {};
+    sig.halg = PGP_HASH_SHA256;
+    /* Repeated operations should reuse the loaded key */
+    for (size_t i = 0; i < 3; i++) {
+        assert_rnp_success(seckey1.material->sign(global_ctx, sig, hash));
+        assert_rnp_success(seckey1.material->verify(global_ctx, sig, hash));
+        assert_rnp_failure(seckey2.material->verify(global_ctx, sig, hash));
+    }
+    /* Cloned material must not share the cached objects */
+    auto clone = seckey1.material->clone();
+    assert_rnp_success(clone->verify(global_ctx, sig, hash));
+    clone->clear_secret();
+    assert_rnp_failure(clone->sign(global_ctx, sig, hash));
+    assert_rnp_success(seckey1.material->sign(global_ctx, sig, hash));
+    /* Secret key must not be available after the clear_secret() call */
+    seckey1.material->clear_secret();
+    assert_rnp_failure(seckey1.material->sign(global_ctx, sig, hash));
+    assert_rnp_success(seckey1.material->verify(global_ctx, sig, hash));
+}
+
 TEST_F(rnp_tests, rnp_test_eddsa)
 {
     rnp_keygen_crypto_params_t key_desc;
@@ -176,10 +455,10 @@ TEST_F(rnp_tests, rnp_test_x25519)
     assert_true(pgp_generate_seckey(key_desc, seckey, true));
     /* check for length and correctly tweaked bits */
     auto &ec = dynamic_cast<pgp::ECKeyMaterial &>(*seckey.material);
-    assert_int_equal(ec.x().len, 32);
-    assert_int_equal(ec.x().mpi[31] & 7, 0);
-    assert_int_equal(ec.x().mpi[0] & 128, 0);
-    assert_int_equal(ec.x().mpi[0] & 64, 64);
+    assert_int_equal(ec.x().bytes(), 32);
+    assert_int_equal(ec.x()[31] & 7, 0);
+    assert_int_equal(ec.x()[0] & 128, 0);
+    assert_int_equal(ec.x()[0] & 64, 64);
     /* encrypt */
     pgp_fingerprint_t fp = {};
     assert_rnp_success(pgp_fingerprint(fp, seckey));
@@ -188,8 +467,8 @@ TEST_F(rnp_tests, rnp_test_x25519)
     enc.ecdh.fp = &fp;
     assert_rnp_success(seckey.material->encrypt(global_ctx, enc, in, sizeof(in)));
     assert_true(enc.ecdh.mlen > 16);
-    assert_int_equal(enc.ecdh.p.mpi[0], 0x40);
-    assert_int_equal(enc.ecdh.p.len, 33);
+    assert_int_equal(enc.ecdh.p[0], 0x40);
+    assert_int_equal(enc.ecdh.p.bytes(), 33);
     /* decrypt */
     uint8_t out[16] = {};
     size_t  outlen = sizeof(out);
@@ -197,14 +476,14 @@ TEST_F(rnp_tests, rnp_test_x25519)
     assert_int_equal(outlen, 16);
     assert_int_equal(memcmp(in, out, 16), 0);
     /* negative cases */
-    enc.ecdh.p.mpi[16] ^= 0xff;
+    enc.ecdh.p[16] ^= 0xff;
     assert_rnp_failure(seckey.material->decrypt(global_ctx, out, outlen, enc));
 
-    enc.ecdh.p.mpi[16] ^= 0xff;
-    enc.ecdh.p.mpi[0] = 0x04;
+    enc.ecdh.p[16] ^= 0xff;
+    enc.ecdh.p[0] = 0x04;
     assert_rnp_failure(seckey.material->decrypt(global_ctx, out, outlen, enc));
 
-    enc.ecdh.p.mpi[0] = 0x40;
+    enc.ecdh.p[0] = 0x40;
     enc.ecdh.mlen--;
     assert_rnp_failure(seckey.material->decrypt(global_ctx, out, outlen, enc));
 
@@ -216,7 +495,7 @@ static void
 elgamal_roundtrip(pgp_eg_key_t *key, rnp::RNG &rng)
 {
     const uint8_t      in_b[] = {0x01, 0x02, 0x03, 0x04, 0x17};
-    pgp_eg_encrypted_t enc = {{{0}}};
+    pgp_eg_encrypted_t enc{};
     uint8_t            res[1024];
     size_t             res_len = 0;
 
@@ -269,6 +548,13 @@ TEST_F(rnp_tests, ecdsa_signverify_success)
         // Fails because of different key used
         assert_rnp_failure(seckey2.material->verify(global_ctx, sig, hash));
 
+        // Fails because of truncated public point
+        auto &       ecmat = dynamic_cast<pgp::ECKeyMaterial &>(*seckey1.material);
+        pgp_ec_key_t trunc{};
+        trunc.curve = curves[i].id;
+        assert_true(trunc.p.from_mem(ecmat.p().data(), ecmat.p().bytes() - 1));
+        assert_rnp_failure(pgp::ECDSAKeyMaterial(trunc).verify(global_ctx, sig, hash));
+
         // Fails because message won't verify
         hash[0] = ~hash[0];
         assert_rnp_failure(seckey1.material->verify(global_ctx, sig, hash));
@@ -372,6 +658,15 @@ TEST_F(rnp_tests, ecdh_decryptionNegativeCases)
       dynamic_cast<pgp::ECDHKeyMaterial &>(*ecdh_key1.material));
     key1_mod.set_key_wrap_alg(PGP_SA_IDEA);
     assert_int_equal(key1_mod.decrypt(global_ctx, res, res_len, enc), RNP_ERROR_NOT_SUPPORTED);
+
+    /* truncated public point */
+    pgp::ECDHTestKeyMaterial key1_trunc(
+      dynamic_cast<pgp::ECDHKeyMaterial &>(*ecdh_key1.material));
+    auto &ecmat = dynamic_cast<pgp::ECKeyMaterial &>(*ecdh_key1.material);
+    assert_true(key1_trunc.ec().p.from_mem(ecmat.p().data(), ecmat.p().bytes() - 1));
+    pgp_encrypted_material_t enc2;
+    enc2.ecdh.fp = &ecdh_key1_fpr;
+    assert_rnp_failure(key1_trunc.encrypt(global_ctx, enc2, in, in_len));
 }
 
 #if defined(ENABLE_SM2)
@@ -668,6 +963,47 @@ TEST_F(rnp_tests, dilithium_exdsa_signverify_success)
     }
 }
 
+TEST_F(rnp_tests, pqc_key_object_reuse)
+{
+    rnp_keygen_crypto_params_t key_desc;
+    key_desc.key_alg = PGP_PKA_KYBER768_X25519;
+    key_desc.hash_alg = PGP_HASH_SHA512;
+    key_desc.ctx = &global_ctx;
+    pgp_key_pkt_t enckey;
+    assert_true(pgp_generate_seckey(key_desc, enckey, true));
+
+    uint8_t in[32] = {0};
+    global_ctx.rng.get(in, sizeof(in));
+    /* Repeated encryption to the same key reuses decoded key and encryptor */
+    for (size_t i = 0; i < 3; i++) {
+        uint8_t                  res[36] = {0};
+        size_t                   res_len = sizeof(res);
+        pgp_encrypted_material_t enc;
+        assert_rnp_success(enckey.material->encrypt(global_ctx, enc, in, sizeof(in)));
+        assert_rnp_success(enckey.material->decrypt(global_ctx, res, res_len, enc));
+        assert_int_equal(res_len, sizeof(in));
+        assert_int_equal(memcmp(in, res, res_len), 0);
+    }
+
+    key_desc.key_alg = PGP_PKA_DILITHIUM3_ED25519;
+    pgp_key_pkt_t sigkey;
+    assert_true(pgp_generate_seckey(key_desc, sigkey, true));
+    rnp::secure_vector<uint8_t> hash(64);
+    global_ctx.rng.get(hash.data(), hash.size());
+    pgp_signature_material_t sig;
+    sig.halg = PGP_HASH_SHA512;
+    assert_rnp_success(sigkey.material->sign(global_ctx, sig, hash));
+    /* Failed verification must not break the cached verifier */
+    for (size_t i = 0; i < 3; i++) {
+        assert_rnp_success(sigkey.material->verify(global_ctx, sig, hash));
+        hash[0] = ~hash[0];
+        assert_rnp_failure(sigkey.material->verify(global_ctx, sig, hash));
+        hash[0] = ~hash[0];
+    }
+    auto clone = sigkey.material->clone();
+    assert_rnp_success(clone->verify(global_ctx, sig, hash));
+}
+
 TEST_F(rnp_tests, sphincsplus_signverify_success)
 {
     uint8_t                 message[64];
@@ -780,6 +1116,25 @@ read_key_pkt(pgp_key_pkt_t *key, const char *path)
     return res;
 }
 
+TEST_F(rnp_tests, s2k_cache_secret_key)
+{
+    pgp_key_pkt_t key;
+    assert_true(read_key_pkt(&key, "data/keyrings/1/secring.gpg"));
+    auto &        s2k = key.sec_protection.s2k;
+    size_t        keysize = pgp_key_size(key.sec_protection.symm_alg);
+    uint8_t       cached[PGP_MAX_KEY_SIZE] = {0};
+    rnp::S2KCache cache;
+    cache.set_limits(10, 0, global_ctx.rng);
+    /* key derived from the wrong password must not be cached */
+    assert_rnp_failure(decrypt_secret_key(&key, "wrong", &cache));
+    assert_false(cache.get(s2k, "wrong", cached, keysize));
+    assert_rnp_success(decrypt_secret_key(&key, "password", &cache));
+    assert_true(cache.get(s2k, "password", cached, keysize));
+    assert_rnp_success(decrypt_secret_key(&key, "password", &cache));
+    assert_rnp_failure(decrypt_secret_key(&key, "wrong", &cache));
+    assert_false(cache.get(s2k, "wrong", cached, keysize));
+}
+
 namespace pgp {
 class RSATestKeyMaterial : public RSAKeyMaterial {
   public:
@@ -859,11 +1214,11 @@ TEST_F(rnp_tests, test_validate_key_material)
     key.material->validate(global_ctx);
     assert_true(key.material->valid());
     pgp::RSATestKeyMaterial rkey(dynamic_cast<pgp::RSAKeyMaterial &>(*key.material));
-    rkey.rsa().n.mpi[rkey.rsa().n.len - 1] &= ~1;
+    rkey.rsa().n[rkey.rsa().n.bytes() - 1] &= ~1;
     rkey.validate(global_ctx);
     assert_false(rkey.valid());
-    rkey.rsa().n.mpi[rkey.rsa().n.len - 1] |= 1;
-    rkey.rsa().e.mpi[rkey.rsa().e.len - 1] &= ~1;
+    rkey.rsa().n[rkey.rsa().n.bytes() - 1] |= 1;
+    rkey.rsa().e[rkey.rsa().e.bytes() - 1] &= ~1;
     rkey.validate(global_ctx);
     assert_false(rkey.valid());
     key = pgp_key_pkt_t();
@@ -872,11 +1227,11 @@ TEST_F(rnp_tests, test_validate_key_material)
     key.material->validate(global_ctx);
     assert_true(key.material->valid());
     rkey = pgp::RSATestKeyMaterial(dynamic_cast<pgp::RSAKeyMaterial &>(*key.material));
-    rkey.rsa().n.mpi[rkey.rsa().n.len - 1] &= ~1;
+    rkey.rsa().n[rkey.rsa().n.bytes() - 1] &= ~1;
     rkey.validate(global_ctx);
     assert_false(rkey.valid());
-    rkey.rsa().n.mpi[rkey.rsa().n.len - 1] |= 1;
-    rkey.rsa().e.mpi[rkey.rsa().e.len - 1] &= ~1;
+    rkey.rsa().n[rkey.rsa().n.bytes() - 1] |= 1;
+    rkey.rsa().e[rkey.rsa().e.bytes() - 1] &= ~1;
     rkey.validate(global_ctx);
     assert_false(rkey.valid());
     key = pgp_key_pkt_t();
@@ -894,18 +1249,18 @@ TEST_F(rnp_tests, test_validate_key_material)
     key.material->validate(global_ctx);
     assert_true(key.material->valid());
     rkey = pgp::RSATestKeyMaterial(dynamic_cast<pgp::RSAKeyMaterial &>(*key.material));
-    rkey.rsa().e.mpi[rkey.rsa().e.len - 1] += 1;
+    rkey.rsa().e[rkey.rsa().e.bytes() - 1] += 1;
     rkey.validate(global_ctx);
     assert_false(rkey.valid());
-    rkey.rsa().e.mpi[rkey.rsa().e.len - 1] -= 1;
-    rkey.rsa().p.mpi[rkey.rsa().p.len - 1] += 2;
+    rkey.rsa().e[rkey.rsa().e.bytes() - 1] -= 1;
+    rkey.rsa().p[rkey.rsa().p.bytes() - 1] += 2;
     rkey.validate(global_ctx);
     assert_false(rkey.valid());
-    rkey.rsa().p.mpi[rkey.rsa().p.len - 1] -= 2;
-    rkey.rsa().q.mpi[rkey.rsa().q.len - 1] += 2;
+    rkey.rsa().p[rkey.rsa().p.bytes() - 1] -= 2;
+    rkey.rsa().q[rkey.rsa().q.bytes() - 1] += 2;
     rkey.validate(global_ctx);
     assert_false(rkey.valid());
-    rkey.rsa().q.mpi[rkey.rsa().q.len - 1] -= 2;
+    rkey.rsa().q[rkey.rsa().q.bytes() - 1] -= 2;
     rkey.validate(global_ctx);
     assert_true(rkey.valid());
     key = pgp_key_pkt_t();
@@ -916,18 +1271,18 @@ TEST_F(rnp_tests, test_validate_key_material)
     key.material->validate(global_ctx);
     assert_true(key.material->valid());
     rkey = pgp::RSATestKeyMaterial(dynamic_cast<pgp::RSAKeyMaterial &>(*key.material));
-    rkey.rsa().e.mpi[rkey.rsa().e.len - 1] += 1;
+    rkey.rsa().e[rkey.rsa().e.bytes() - 1] += 1;
     rkey.validate(global_ctx);
     assert_false(rkey.valid());
-    rkey.rsa().e.mpi[rkey.rsa().e.len - 1] -= 1;
-    rkey.rsa().p.mpi[rkey.rsa().p.len - 1] += 2;
+    rkey.rsa().e[rkey.rsa().e.bytes() - 1] -= 1;
+    rkey.rsa().p[rkey.rsa().p.bytes() - 1] += 2;
     rkey.validate(global_ctx);
     assert_false(rkey.valid());
-    rkey.rsa().p.mpi[rkey.rsa().p.len - 1] -= 2;
-    rkey.rsa().q.mpi[rkey.rsa().q.len - 1] += 2;
+    rkey.rsa().p[rkey.rsa().p.bytes() - 1] -= 2;
+    rkey.rsa().q[rkey.rsa().q.bytes() - 1] += 2;
     rkey.validate(global_ctx);
     assert_false(rkey.valid());
-    rkey.rsa().q.mpi[rkey.rsa().q.len - 1] -= 2;
+    rkey.rsa().q[rkey.rsa().q.bytes() - 1] -= 2;
     rkey.validate(global_ctx);
     assert_true(rkey.valid());
     key = pgp_key_pkt_t();
@@ -935,23 +1290,23 @@ TEST_F(rnp_tests, test_validate_key_material)
     /* DSA-ElGamal key */
     assert_true(read_key_pkt(&key, KEYS "dsa-sec.pgp"));
     pgp::DSATestKeyMaterial dkey(dynamic_cast<pgp::DSAKeyMaterial &>(*key.material));
-    dkey.dsa().q.mpi[dkey.dsa().q.len - 1] += 2;
+    dkey.dsa().q[dkey.dsa().q.bytes() - 1] += 2;
     dkey.validate(global_ctx);
     assert_false(dkey.valid());
-    dkey.dsa().q.mpi[dkey.dsa().q.len - 1] -= 2;
+    dkey.dsa().q[dkey.dsa().q.bytes() - 1] -= 2;
     assert_rnp_success(decrypt_secret_key(&key, NULL));
     assert_true(key.material->secret());
     key.material->validate(global_ctx);
     assert_true(key.material->valid());
     dkey = pgp::DSATestKeyMaterial(dynamic_cast<pgp::DSAKeyMaterial &>(*key.material));
-    dkey.dsa().y.mpi[dkey.dsa().y.len - 1] += 2;
+    dkey.dsa().y[dkey.dsa().y.bytes() - 1] += 2;
     dkey.validate(global_ctx);
     assert_false(dkey.valid());
-    dkey.dsa().y.mpi[dkey.dsa().y.len - 1] -= 2;
-    dkey.dsa().p.mpi[dkey.dsa().p.len - 1] += 2;
+    dkey.dsa().y[dkey.dsa().y.bytes() - 1] -= 2;
+    dkey.dsa().p[dkey.dsa().p.bytes() - 1] += 2;
     dkey.validate(global_ctx);
     assert_false(dkey.valid());
-    dkey.dsa().p.mpi[dkey.dsa().p.len - 1] -= 2;
+    dkey.dsa().p[dkey.dsa().p.bytes() - 1] -= 2;
     /* since Botan calculates y from x on key load we do not check x vs y */
     dkey.dsa().x = dkey.dsa().q;
     dkey.validate(global_ctx);
@@ -960,19 +1315,19 @@ TEST_F(rnp_tests, test_validate_key_material)
 
     assert_true(read_key_pkt(&key, KEYS "eg-sec.pgp"));
     pgp::EGTestKeyMaterial gkey(dynamic_cast<pgp::EGKeyMaterial &>(*key.material));
-    gkey.eg().p.mpi[gkey.eg().p.len - 1] += 2;
+    gkey.eg().p[gkey.eg().p.bytes() - 1] += 2;
     gkey.validate(global_ctx);
     assert_false(gkey.valid());
-    gkey.eg().p.mpi[gkey.eg().p.len - 1] -= 2;
+    gkey.eg().p[gkey.eg().p.bytes() - 1] -= 2;
     assert_rnp_success(decrypt_secret_key(&key, NULL));
     assert_true(key.material->secret());
     gkey = pgp::EGTestKeyMaterial(dynamic_cast<pgp::EGKeyMaterial &>(*key.material));
     gkey.validate(global_ctx);
     assert_true(gkey.valid());
-    gkey.eg().p.mpi[gkey.eg().p.len - 1] += 2;
+    gkey.eg().p[gkey.eg().p.bytes() - 1] += 2;
     gkey.validate(global_ctx);
     assert_false(gkey.valid());
-    gkey.eg().p.mpi[gkey.eg().p.len - 1] -= 2;
+    gkey.eg().p[gkey.eg().p.bytes() - 1] -= 2;
     /* since Botan calculates y from x on key load we do not check x vs y */
     gkey.eg().x = gkey.eg().p;
     gkey.validate(global_ctx);
@@ -999,14 +1354,14 @@ TEST_F(rnp_tests, test_validate_key_material)
     pgp::ECDSATestKeyMaterial ekey(dynamic_cast<pgp::ECDSAKeyMaterial &>(*key.material));
     ekey.validate(global_ctx);
     assert_true(ekey.valid());
-    ekey.ec().p.mpi[0] += 2;
+    ekey.ec().p[0] += 2;
     ekey.validate(global_ctx);
     assert_false(ekey.valid());
-    ekey.ec().p.mpi[0] -= 2;
-    ekey.ec().p.mpi[10] += 2;
+    ekey.ec().p[0] -= 2;
+    ekey.ec().p[10] += 2;
     ekey.validate(global_ctx);
     assert_false(ekey.valid());
-    ekey.ec().p.mpi[10] -= 2;
+    ekey.ec().p[10] -= 2;
     assert_rnp_success(decrypt_secret_key(&key, NULL));
     assert_true(key.material->secret());
     key = pgp_key_pkt_t();
@@ -1016,14 +1371,14 @@ TEST_F(rnp_tests, test_validate_key_material)
     key.material->validate(global_ctx);
     assert_true(key.material->valid());
     pgp::ECDHTestKeyMaterial ehkey(dynamic_cast<pgp::ECDHKeyMaterial &>(*key.material));
-    ehkey.ec().p.mpi[0] += 2;
+    ehkey.ec().p[0] += 2;
     ehkey.validate(global_ctx);
     assert_false(ehkey.valid());
-    ehkey.ec().p.mpi[0] -= 2;
-    ehkey.ec().p.mpi[10] += 2;
+    ehkey.ec().p[0] -= 2;
+    ehkey.ec().p[10] += 2;
     ehkey.validate(global_ctx);
     assert_false(ehkey.valid());
-    ehkey.ec().p.mpi[10] -= 2;
+    ehkey.ec().p[10] -= 2;
     assert_rnp_success(decrypt_secret_key(&key, NULL));
     assert_true(key.material->secret());
     key = pgp_key_pkt_t();
@@ -1033,10 +1388,10 @@ TEST_F(rnp_tests, test_validate_key_material)
     key.material->validate(global_ctx);
     assert_true(key.material->valid());
     pgp::EDDSATestKeyMaterial edkey(dynamic_cast<pgp::EDDSAKeyMaterial &>(*key.material));
-    edkey.ec().p.mpi[0] += 2;
+    edkey.ec().p[0] += 2;
     edkey.validate(global_ctx);
     assert_false(edkey.valid());
-    edkey.ec().p.mpi[0] -= 2;
+    edkey.ec().p[0] -= 2;
     key = pgp_key_pkt_t();
 
     /* x25519 key, same as the previous - botan calculates pub key from the secret one */
@@ -1044,10 +1399,10 @@ TEST_F(rnp_tests, test_validate_key_material)
     key.material->validate(global_ctx);
     assert_true(key.material->valid());
     ehkey = pgp::ECDHTestKeyMaterial(dynamic_cast<pgp::ECDHKeyMaterial &>(*key.material));
-    ehkey.ec().p.mpi[0] += 2;
+    ehkey.ec().p[0] += 2;
     ehkey.validate(global_ctx);
     assert_false(ehkey.valid());
-    ehkey.ec().p.mpi[0] -= 2;
+    ehkey.ec().p[0] -= 2;
     key = pgp_key_pkt_t();
 }
 
@@ -4484,6 +4484,28 @@ class Encryption(unittest.TestCase):
             rnp_decrypt_file(enc, dst)
         remove_files(src, dst, enc)
 
+    def test_aead_threads(self):
+        if not RNP_AEAD:
+            print('AEAD is not available for RNP - skipping.')
+            return
+        src, dst, enc = reg_workfiles('cleartext', '.txt', '.rnp', '.enc')
+        ret, _, err = run_proc(RNP, ['--homedir', RNPDIR, '--password', PASSWORD, '--threads', '0', '-c', src])
+        self.assertEqual(ret, 2)
+        self.assertRegex(err, r'(?s)^.*Wrong threads value: 0')
+        aead = '--aead=ocb' if RNP_AEAD_OCB else '--aead=eax'
+        for size in [0, 1, 256, 1000, 100000]:
+            random_text(src, size)
+            # Encrypt with multiple threads, decrypt with and without threads
+            ret, _, _ = run_proc(RNP, ['--homedir', RNPDIR, '--password', PASSWORD, '--output', enc, aead, '--aead-chunk-bits', '2', '-z', '0', '--threads', '4', '-c', src])
+            self.assertEqual(ret, 0)
+            rnp_decrypt_file(enc, dst)
+            compare_files(src, dst, RNP_DATA_DIFFERS)
+            remove_files(dst)
+            ret, _, _ = run_proc(RNP, ['--homedir', RNPDIR, '--password', PASSWORD, '--threads', '4', '-d', enc, '--output', dst])
+            self.assertEqual(ret, 0)
+            compare_files(src, dst, RNP_DATA_DIFFERS)
+            remove_files(src, dst, enc)
+
     def fill_aeads(self, runs):
         aead = [None, [None]]
         if RNP_AEAD_EAX:
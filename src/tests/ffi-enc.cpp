@@ -27,6 +27,8 @@
 #include <fstream>
 #include <vector>
 #include <string>
+#include <thread>
+#include <atomic>
 
 #include <rnp/rnp.h>
 #include "rnp_tests.h"
@@ -155,6 +157,9 @@ TEST_F(rnp_tests, test_ffi_encrypt_pass)
     assert_rnp_failure(rnp_input_from_path(NULL, "noexist"));
     assert_rnp_failure(rnp_input_from_path(&input, NULL));
     assert_rnp_failure(rnp_input_from_path(&input, "noexist"));
+    assert_rnp_failure(rnp_input_from_path_mmap(NULL, "noexist"));
+    assert_rnp_failure(rnp_input_from_path_mmap(&input, NULL));
+    assert_rnp_failure(rnp_input_from_path_mmap(&input, "noexist"));
     assert_null(input);
     assert_rnp_failure(rnp_output_to_path(&output, ""));
     assert_null(output);
@@ -271,8 +276,8 @@ TEST_F(rnp_tests, test_ffi_encrypt_pass)
     assert_string_equal(file_to_str("decrypted").c_str(), plaintext);
     unlink("decrypted");
 
-    // decrypt (pass2)
-    assert_rnp_success(rnp_input_from_path(&input, "encrypted"));
+    // decrypt (pass2), using the memory-mapped input
+    assert_rnp_success(rnp_input_from_path_mmap(&input, "encrypted"));
     assert_non_null(input);
     assert_rnp_success(rnp_output_to_path(&output, "decrypted"));
     assert_non_null(output);
@@ -1785,3 +1790,365 @@ TEST_F(rnp_tests, test_ffi_mimemode_signature)
     rnp_output_destroy(output);
     rnp_ffi_destroy(ffi);
 }
+
+static bool
+aead_encrypt_data(rnp_ffi_t                   ffi,
+                  const std::vector<uint8_t> &data,
+                  const char *                aead,
+                  size_t                      threads,
+                  std::vector<uint8_t> &      enc)
+{
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    uint8_t *        buf = NULL;
+    size_t           len = 0;
+
+    /* use 64-byte chunks */
+    bool res = !rnp_input_from_memory(&input, data.data(), data.size(), false) &&
+               !rnp_output_to_memory(&output, 0) &&
+               !rnp_op_encrypt_create(&op, ffi, input, output) &&
+               !rnp_op_encrypt_add_password(op, "password", NULL, 1024, "AES256") &&
+               !rnp_op_encrypt_set_aead(op, aead) && !rnp_op_encrypt_set_aead_bits(op, 0) &&
+               !rnp_op_encrypt_set_compression(op, "Uncompressed", 0) &&
+               !rnp_op_encrypt_set_threads(op, threads) && !rnp_op_encrypt_execute(op) &&
+               !rnp_output_memory_get_buf(output, &buf, &len, false);
+    if (res) {
+        enc.assign(buf, buf + len);
+    }
+    rnp_op_encrypt_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+static bool
+aead_decrypt_data(rnp_ffi_t                   ffi,
+                  const std::vector<uint8_t> &enc,
+                  size_t                      threads,
+                  std::vector<uint8_t> &      data)
+{
+    rnp_input_t     input = NULL;
+    rnp_output_t    output = NULL;
+    rnp_op_verify_t verify = NULL;
+    uint8_t *       buf = NULL;
+    size_t          len = 0;
+
+    bool res = !rnp_input_from_memory(&input, enc.data(), enc.size(), false) &&
+               !rnp_output_to_memory(&output, 0) &&
+               !rnp_op_verify_create(&verify, ffi, input, output) &&
+               !rnp_op_verify_set_threads(verify, threads) && !rnp_op_verify_execute(verify) &&
+               !rnp_output_memory_get_buf(output, &buf, &len, false);
+    if (res) {
+        data.assign(buf, buf + len);
+    }
+    rnp_op_verify_destroy(verify);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+TEST_F(rnp_tests, test_ffi_aead_threads)
+{
+    if (!aead_eax_enabled() && !aead_ocb_enabled()) {
+        return;
+    }
+    const char *aead = aead_ocb_enabled() ? "OCB" : "EAX";
+    rnp_ffi_t   ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+    assert_rnp_failure(rnp_op_verify_set_threads(NULL, 4));
+    assert_rnp_failure(rnp_op_encrypt_set_threads(NULL, 4));
+    assert_rnp_failure(rnp_op_sign_set_threads(NULL, 4));
+
+    /* empty data, partial and full last chunks, many chunks. Literal packet adds a few bytes
+     * so range around 64 covers last chunks which are within the tag length of the full. */
+    std::vector<size_t> sizes = {0, 1, 128, 1000, 10000};
+    for (size_t size = 32; size <= 72; size++) {
+        sizes.push_back(size);
+    }
+    std::vector<uint8_t> enc;
+    std::vector<uint8_t> dec;
+    for (size_t size : sizes) {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; i++) {
+            data[i] = (uint8_t)(i * 7 + size);
+        }
+        for (size_t threads : {1, 4}) {
+            assert_true(aead_encrypt_data(ffi, data, aead, threads, enc));
+            assert_true(aead_decrypt_data(ffi, enc, 4, dec));
+            assert_true(dec == data);
+            assert_true(aead_decrypt_data(ffi, enc, 1, dec));
+            assert_true(dec == data);
+        }
+    }
+    /* corrupted chunk must not be accepted */
+    std::vector<uint8_t> data(1000, 'x');
+    /* bogus number of threads is limited */
+    assert_true(aead_encrypt_data(ffi, data, aead, SIZE_MAX, enc));
+    assert_true(aead_decrypt_data(ffi, enc, SIZE_MAX, dec));
+    assert_true(dec == data);
+    assert_true(aead_encrypt_data(ffi, data, aead, 4, enc));
+    enc[enc.size() - 300] ^= 0x01;
+    assert_false(aead_decrypt_data(ffi, enc, 4, dec));
+    /* as well as the truncated final tag */
+    assert_true(aead_encrypt_data(ffi, data, aead, 4, enc));
+    enc.resize(enc.size() - 1);
+    assert_false(aead_decrypt_data(ffi, enc, 4, dec));
+
+    rnp_ffi_destroy(ffi);
+}
+
+static bool
+compress_encrypt_data(rnp_ffi_t                   ffi,
+                      const std::vector<uint8_t> &data,
+                      const char *                zalg,
+                      int                         zlevel,
+                      size_t                      threads,
+                      std::vector<uint8_t> &      enc)
+{
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    uint8_t *        buf = NULL;
+    size_t           len = 0;
+
+    bool res = !rnp_input_from_memory(&input, data.data(), data.size(), false) &&
+               !rnp_output_to_memory(&output, 0) &&
+               !rnp_op_encrypt_create(&op, ffi, input, output) &&
+               !rnp_op_encrypt_add_password(op, "password", NULL, 1024, "AES256") &&
+               !rnp_op_encrypt_set_compression(op, zalg, zlevel) &&
+               !rnp_op_encrypt_set_threads(op, threads) && !rnp_op_encrypt_execute(op) &&
+               !rnp_output_memory_get_buf(output, &buf, &len, false);
+    if (res) {
+        enc.assign(buf, buf + len);
+    }
+    rnp_op_encrypt_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+TEST_F(rnp_tests, test_ffi_compression_threads)
+{
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+
+    /* empty data, single block, block boundaries and many blocks */
+    std::vector<uint8_t> enc;
+    std::vector<uint8_t> dec;
+    for (size_t size : {0, 1, 1000, 131071, 131072, 131073, 1000000}) {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; i++) {
+            data[i] = "compressible text, "[i % 19] + (uint8_t)((i / 5000) % 7);
+        }
+        for (auto zalg : {"ZIP", "ZLIB"}) {
+            for (int zlevel : {1, 6, 9}) {
+                assert_true(compress_encrypt_data(ffi, data, zalg, zlevel, 4, enc));
+                assert_true(aead_decrypt_data(ffi, enc, 1, dec));
+                assert_true(dec == data);
+            }
+        }
+    }
+
+    rnp_ffi_destroy(ffi);
+}
+
+TEST_F(rnp_tests, test_ffi_compression_auto)
+{
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+
+    std::vector<uint8_t> enc;
+    std::vector<uint8_t> raw;
+    std::vector<uint8_t> dec;
+    for (size_t size : {0, 1000, 65535, 65536, 200000}) {
+        /* incompressible data is written as is */
+        std::vector<uint8_t> data(size);
+        uint32_t             rnd = 12345;
+        for (size_t i = 0; i < size; i++) {
+            rnd = rnd * 1103515245 + 12345;
+            data[i] = (uint8_t)(rnd >> 24);
+        }
+        for (size_t threads : {1, 4}) {
+            assert_true(compress_encrypt_data(ffi, data, "auto", 6, threads, enc));
+            assert_true(compress_encrypt_data(ffi, data, "Uncompressed", 0, threads, raw));
+            assert_int_equal(enc.size(), raw.size());
+            assert_true(aead_decrypt_data(ffi, enc, 1, dec));
+            assert_true(dec == data);
+        }
+        if (size < 1000) {
+            continue;
+        }
+        /* while text is compressed */
+        for (size_t i = 0; i < size; i++) {
+            data[i] = "compressible text, "[i % 19];
+        }
+        for (size_t threads : {1, 4}) {
+            assert_true(compress_encrypt_data(ffi, data, "auto", 6, threads, enc));
+            assert_true(compress_encrypt_data(ffi, data, "Uncompressed", 0, threads, raw));
+            assert_true(enc.size() < raw.size() / 4);
+            assert_true(aead_decrypt_data(ffi, enc, 1, dec));
+            assert_true(dec == data);
+        }
+    }
+    assert_rnp_failure(rnp_op_encrypt_set_compression(NULL, "auto", 6));
+
+    rnp_ffi_destroy(ffi);
+}
+
+TEST_F(rnp_tests, test_ffi_s2k_cache)
+{
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_failure(rnp_ffi_set_s2k_cache(NULL, 10, 60));
+    assert_rnp_failure(rnp_ffi_flush_s2k_cache(NULL));
+    assert_rnp_success(rnp_ffi_set_s2k_cache(ffi, 10, 60));
+    assert_true(
+      load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg", "data/keyrings/1/secring.gpg"));
+
+    /* cached key must not be used for the wrong password */
+    rnp_key_handle_t key = NULL;
+    assert_rnp_success(rnp_locate_key(ffi, "userid", "key0-uid0", &key));
+    for (size_t i = 0; i < 3; i++) {
+        assert_rnp_failure(rnp_key_unlock(key, "wrong"));
+        assert_rnp_success(rnp_key_unlock(key, "password"));
+        assert_rnp_success(rnp_key_lock(key));
+    }
+    assert_rnp_success(rnp_ffi_flush_s2k_cache(ffi));
+    assert_rnp_failure(rnp_key_unlock(key, "wrong"));
+    assert_rnp_success(rnp_key_unlock(key, "password"));
+    assert_rnp_success(rnp_key_lock(key));
+    rnp_key_handle_destroy(key);
+
+    /* password-based decryption */
+    std::vector<uint8_t> data(1000, 'x');
+    std::vector<uint8_t> enc;
+    std::vector<uint8_t> dec;
+    assert_true(compress_encrypt_data(ffi, data, "ZIP", 6, 1, enc));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "wrong"));
+    assert_false(aead_decrypt_data(ffi, enc, 1, dec));
+    for (size_t i = 0; i < 3; i++) {
+        assert_rnp_success(
+          rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+        assert_true(aead_decrypt_data(ffi, enc, 1, dec));
+        assert_true(dec == data);
+        assert_rnp_success(
+          rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "wrong"));
+        assert_false(aead_decrypt_data(ffi, enc, 1, dec));
+    }
+    /* disabling cache */
+    assert_rnp_success(rnp_ffi_set_s2k_cache(ffi, 0, 0));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+    assert_true(aead_decrypt_data(ffi, enc, 1, dec));
+    assert_true(dec == data);
+
+    rnp_ffi_destroy(ffi);
+}
+
+static bool
+encrypt_sign_data(rnp_ffi_t ffi, const std::vector<uint8_t> &data, std::vector<uint8_t> &enc)
+{
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    rnp_key_handle_t key = NULL;
+    uint8_t *        buf = NULL;
+    size_t           len = 0;
+
+    bool res = !rnp_input_from_memory(&input, data.data(), data.size(), false) &&
+               !rnp_output_to_memory(&output, 0) &&
+               !rnp_op_encrypt_create(&op, ffi, input, output) &&
+               !rnp_locate_key(ffi, "userid", "key0-uid2", &key) &&
+               !rnp_op_encrypt_add_recipient(op, key) &&
+               !rnp_op_encrypt_add_signature(op, key, NULL) && !rnp_op_encrypt_execute(op) &&
+               !rnp_output_memory_get_buf(output, &buf, &len, false);
+    if (res) {
+        enc.assign(buf, buf + len);
+    }
+    rnp_key_handle_destroy(key);
+    rnp_op_encrypt_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+TEST_F(rnp_tests, test_ffi_concurrent_ops)
+{
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_true(
+      load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg", "data/keyrings/1/secring.gpg"));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+
+    std::vector<uint8_t> data(10000, 'x');
+    std::vector<uint8_t> enc;
+    assert_true(encrypt_sign_data(ffi, data, enc));
+
+    /* readers decrypt and verify, while keys are imported meanwhile */
+    std::atomic<size_t>      failed(0);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < 4; i++) {
+        threads.emplace_back([&]() {
+            for (size_t j = 0; j < 5; j++) {
+                rnp_key_handle_t key = NULL;
+                bool             valid = false;
+                if (rnp_locate_key(ffi, "userid", "key0-uid0", &key) || !key ||
+                    rnp_key_is_valid(key, &valid) || !valid) {
+                    failed++;
+                }
+                rnp_key_handle_destroy(key);
+                std::vector<uint8_t> dec;
+                if (!aead_decrypt_data(ffi, enc, 1, dec) || (dec != data)) {
+                    failed++;
+                }
+            }
+        });
+    }
+    threads.emplace_back([&]() {
+        for (size_t j = 0; j < 5; j++) {
+            rnp_key_handle_t key = NULL;
+            if (!import_pub_keys(ffi, "data/keyrings/2/pubring.gpg") ||
+                rnp_locate_key(ffi, "userid", "key0-uid0", &key) || !key) {
+                failed++;
+            }
+            rnp_key_handle_destroy(key);
+        }
+    });
+    /* key modifications are serialized as well */
+    threads.emplace_back([&]() {
+        rnp_key_handle_t key = NULL;
+        if (rnp_locate_key(ffi, "userid", "key0-uid0", &key) || !key) {
+            failed++;
+            return;
+        }
+        for (size_t j = 0; j < 5; j++) {
+            rnp_uid_handle_t uid = NULL;
+            size_t           count = 0;
+            if (rnp_key_unlock(key, "password") ||
+                rnp_key_add_uid(key, "temp-uid", NULL, 0, 0, false) || rnp_key_lock(key) ||
+                rnp_key_get_uid_count(key, &count) ||
+                rnp_key_get_uid_handle_at(key, count - 1, &uid) || rnp_uid_remove(key, uid)) {
+                failed++;
+            }
+            rnp_uid_handle_destroy(uid);
+        }
+        rnp_key_handle_destroy(key);
+    });
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    assert_int_equal(failed.load(), 0);
+    /* signing is serialized with the other operations */
+    assert_true(encrypt_sign_data(ffi, data, enc));
+
+    rnp_ffi_destroy(ffi);
+}
@@ -2507,6 +2507,97 @@ TEST_F(rnp_tests, test_ffi_key_iter)
     rnp_ffi_destroy(ffi);
 }
 
+static std::vector<std::string>
+search_keyids(rnp_ffi_t ffi, const char *query, uint32_t flags)
+{
+    std::vector<std::string> res;
+    rnp_key_search_t         search = NULL;
+    if (rnp_key_search_create(ffi, &search, query, flags)) {
+        return res;
+    }
+    rnp_key_handle_t key = NULL;
+    while (!rnp_key_search_next(search, &key) && key) {
+        char *keyid = NULL;
+        if (!rnp_key_get_keyid(key, &keyid)) {
+            res.push_back(keyid);
+        }
+        rnp_buffer_destroy(keyid);
+        rnp_key_handle_destroy(key);
+    }
+    rnp_key_search_destroy(search);
+    return res;
+}
+
+TEST_F(rnp_tests, test_ffi_key_search)
+{
+    rnp_ffi_t        ffi = NULL;
+    rnp_key_search_t search = NULL;
+    rnp_key_handle_t key = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+
+    assert_rnp_failure(rnp_key_search_create(NULL, &search, NULL, 0));
+    assert_rnp_failure(rnp_key_search_create(ffi, NULL, NULL, 0));
+    assert_rnp_failure(rnp_key_search_create(ffi, &search, NULL, 1U << 10));
+    assert_null(search);
+    /* invalid regular expression */
+    assert_rnp_failure(rnp_key_search_create(ffi, &search, "key0-uid[", 0));
+    assert_null(search);
+    /* empty keyring */
+    assert_rnp_success(rnp_key_search_create(ffi, &search, NULL, RNP_KEY_SEARCH_SUBKEYS));
+    assert_rnp_failure(rnp_key_search_next(NULL, &key));
+    assert_rnp_failure(rnp_key_search_next(search, NULL));
+    assert_rnp_success(rnp_key_search_next(search, &key));
+    assert_null(key);
+    assert_rnp_success(rnp_key_search_destroy(search));
+    assert_rnp_success(rnp_key_search_destroy(NULL));
+
+    assert_true(
+      load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg", "data/keyrings/1/secring.gpg"));
+    /* all keys */
+    std::vector<std::string> primaries = {"7BC6709B15C23A4A", "2FCADF05FFA501BB"};
+    assert_true(search_keyids(ffi, NULL, 0) == primaries);
+    assert_true(search_keyids(ffi, "", RNP_KEY_SEARCH_SECRET) == primaries);
+    assert_int_equal(search_keyids(ffi, NULL, RNP_KEY_SEARCH_SUBKEYS).size(), 7);
+    /* keyid, short keyid, fingerprint and grip */
+    std::vector<std::string> key0 = {"7BC6709B15C23A4A"};
+    assert_true(search_keyids(ffi, "7BC6709B15C23A4A", 0) == key0);
+    assert_true(search_keyids(ffi, "0x7bc6709b 15c23a4a", 0) == key0);
+    assert_true(search_keyids(ffi, "15C23A4A", 0) == key0);
+    assert_true(search_keyids(ffi, "E95A3CBF583AA80A2CCC53AA7BC6709B15C23A4A", 0) == key0);
+    assert_true(search_keyids(ffi, "66D6A0800A3FACDE0C0EB60B16B3669ED380FDFA", 0) == key0);
+    assert_true(search_keyids(ffi, "1ED63EE56FADC34D", 0).empty());
+    std::vector<std::string> sub0 = {"1ED63EE56FADC34D"};
+    assert_true(search_keyids(ffi, "1ED63EE56FADC34D", RNP_KEY_SEARCH_SUBKEYS) == sub0);
+    assert_true(search_keyids(ffi,
+                              "D9839D61EDAF0B3974E0A4A341D6E95F3479B9B7",
+                              RNP_KEY_SEARCH_SUBKEYS) == sub0);
+    assert_true(search_keyids(ffi, "0000000000000000", 0).empty());
+    /* userids */
+    assert_true(search_keyids(ffi, "key0-uid", 0) == key0);
+    assert_true(search_keyids(ffi, "KEY0-UID1", RNP_KEY_SEARCH_SUBKEYS) == key0);
+    assert_true(search_keyids(ffi, "key.-uid2", 0) == primaries);
+    assert_true(search_keyids(ffi, "^key1-uid1$", 0) ==
+                std::vector<std::string>({"2FCADF05FFA501BB"}));
+    assert_true(search_keyids(ffi, "key2", 0).empty());
+    /* exact email */
+    assert_true(import_pub_keys(ffi, "data/test_key_validity/alice-pub.asc"));
+    std::vector<std::string> alice = {"0451409669FFDE3C"};
+    assert_true(search_keyids(ffi, "<ALICE@rnp>", 0) == alice);
+    assert_true(search_keyids(ffi, "<alice@rnp>", RNP_KEY_SEARCH_SECRET).empty());
+    assert_true(search_keyids(ffi, "<alice@rn>", 0).empty());
+    assert_true(search_keyids(ffi, "alice@rnp", 0) == alice);
+    /* key removed after the search is skipped */
+    assert_rnp_success(rnp_key_search_create(ffi, &search, "alice", 0));
+    assert_rnp_success(rnp_locate_key(ffi, "keyid", "0451409669FFDE3C", &key));
+    assert_rnp_success(rnp_key_remove(key, RNP_KEY_REMOVE_PUBLIC));
+    rnp_key_handle_destroy(key);
+    assert_rnp_success(rnp_key_search_next(search, &key));
+    assert_null(key);
+    rnp_key_search_destroy(search);
+
+    rnp_ffi_destroy(ffi);
+}
+
 void
 check_loaded_keys(const char *                    format,
                   bool                            armored,
@@ -3405,6 +3496,89 @@ TEST_F(rnp_tests, test_ffi_iterated_key_import)
     rnp_ffi_destroy(ffi);
 }
 
+static void
+import_key_status_cb(rnp_ffi_t   ffi,
+                     void *      app_ctx,
+                     const char *fingerprint,
+                     const char *public_status,
+                     const char *secret_status)
+{
+    auto statuses = static_cast<std::vector<std::string> *>(app_ctx);
+    statuses->push_back(std::string(fingerprint) + " " + public_status + " " + secret_status);
+}
+
+TEST_F(rnp_tests, test_ffi_stream_key_import)
+{
+    rnp_ffi_t   ffi = NULL;
+    rnp_input_t input = NULL;
+    uint32_t    flags = RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_SECRET_KEYS;
+
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    std::vector<std::string> statuses;
+    /* edge cases */
+    assert_rnp_success(rnp_input_from_path(&input, "data/keyrings/1/pubring.gpg"));
+    assert_rnp_failure(rnp_import_keys_stream(NULL, input, flags, NULL, NULL));
+    assert_rnp_failure(rnp_import_keys_stream(ffi, NULL, flags, NULL, NULL));
+    assert_rnp_failure(rnp_import_keys_stream(ffi, input, 0, NULL, NULL));
+    assert_rnp_failure(
+      rnp_import_keys_stream(ffi, input, flags | RNP_LOAD_SAVE_SINGLE, NULL, NULL));
+    /* two primary keys with attached subkeys in binary keyring */
+    assert_rnp_success(
+      rnp_import_keys_stream(ffi, input, flags, import_key_status_cb, &statuses));
+    rnp_input_destroy(input);
+    std::vector<std::string> expected = {
+      "E95A3CBF583AA80A2CCC53AA7BC6709B15C23A4A new none",
+      "E332B27CAF4742A11BAA677F1ED63EE56FADC34D new none",
+      "C5B15209940A7816A7AF3FB51D7E8A5393C997A8 new none",
+      "5CD46D2A0BD0B8CFE0B130AE8A05B89FAD5ADED1 new none",
+      "BE1C4AB951F4C2F6B604C7F82FCADF05FFA501BB new none",
+      "A3E94DE61A8CB229413D348E54505A936A4A970E new none",
+      "57F8ED6E5C197DB63C60FFAF326EF111425D14A5 new none"};
+    assert_true(statuses == expected);
+    size_t keycount = 0;
+    assert_rnp_success(rnp_get_public_key_count(ffi, &keycount));
+    assert_int_equal(keycount, 7);
+    assert_rnp_success(rnp_get_secret_key_count(ffi, &keycount));
+    assert_int_equal(keycount, 0);
+    /* import the same keyring, armored, without callback */
+    assert_rnp_success(rnp_input_from_path(&input, "data/keyrings/1/pubring.gpg.asc"));
+    assert_rnp_success(rnp_import_keys_stream(ffi, input, flags, NULL, NULL));
+    rnp_input_destroy(input);
+    assert_rnp_success(rnp_get_public_key_count(ffi, &keycount));
+    assert_int_equal(keycount, 7);
+
+    /* public and secret key, armored separately */
+    statuses.clear();
+    assert_rnp_success(rnp_input_from_path(&input, "data/test_stream_key_merge/key-both.asc"));
+    assert_rnp_success(
+      rnp_import_keys_stream(ffi, input, flags, import_key_status_cb, &statuses));
+    rnp_input_destroy(input);
+    expected = {"090BD712A1166BE572252C3C9747D2A6B3A63124 new none",
+                "51B45A4C74917272E4E34180AF1114A47F5F5B28 new none",
+                "5FE514A54816E1B331686C2C16CD16F267CCDD4F new none",
+                "090BD712A1166BE572252C3C9747D2A6B3A63124 unchanged new",
+                "51B45A4C74917272E4E34180AF1114A47F5F5B28 unchanged new",
+                "5FE514A54816E1B331686C2C16CD16F267CCDD4F unchanged new"};
+    assert_true(statuses == expected);
+    assert_rnp_success(rnp_get_public_key_count(ffi, &keycount));
+    assert_int_equal(keycount, 10);
+    assert_rnp_success(rnp_get_secret_key_count(ffi, &keycount));
+    assert_int_equal(keycount, 3);
+
+    /* standalone subkey */
+    assert_rnp_success(rnp_unload_keys(ffi, RNP_KEY_UNLOAD_PUBLIC | RNP_KEY_UNLOAD_SECRET));
+    statuses.clear();
+    assert_rnp_success(rnp_input_from_path(
+      &input, "data/test_stream_key_merge/key-pub-just-subkey-1.pgp"));
+    assert_rnp_success(
+      rnp_import_keys_stream(ffi, input, flags, import_key_status_cb, &statuses));
+    rnp_input_destroy(input);
+    expected = {"51B45A4C74917272E4E34180AF1114A47F5F5B28 new none"};
+    assert_true(statuses == expected);
+
+    rnp_ffi_destroy(ffi);
+}
+
 TEST_F(rnp_tests, test_ffi_stripped_keys_import)
 {
     rnp_ffi_t   ffi = NULL;
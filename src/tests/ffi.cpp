@@ -30,6 +30,8 @@
 #include <set>
 #include <utility>
 #include <cstdint>
+#include <thread>
+#include <atomic>
 
 #include <rnp/rnp.h>
 #include "rnp_tests.h"
@@ -43,6 +45,7 @@
 #include <librepgp/stream-ctx.h>
 #include "pgp-key.h"
 #include "ffi-priv-types.h"
+#include "thread-pool.hpp"
 
 TEST_F(rnp_tests, test_ffi_homedir)
 {
@@ -352,6 +355,214 @@ TEST_F(rnp_tests, test_ffi_load_keys)
     ffi = NULL;
 }
 
+TEST_F(rnp_tests, test_ffi_load_keys_threads)
+{
+    const char *keyrings[] = {"data/keyrings/1/pubring.gpg",
+                              "data/keyrings/1/secring.gpg",
+                              "data/test_key_validity/case2/pubring.gpg",
+                              "data/test_key_validity/case5/pubring.gpg",
+                              NULL};
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_failure(rnp_ffi_set_load_threads(NULL, 4));
+    assert_rnp_success(rnp_ffi_set_load_threads(ffi, 4));
+    assert_rnp_failure(rnp_ffi_set_load_threads(ffi, (size_t) -1));
+    assert_rnp_success(rnp_ffi_set_load_threads(ffi, 100000));
+    assert_int_equal(ffi->load_threads, rnp::ThreadPool::max_threads());
+    rnp_ffi_destroy(ffi);
+
+    for (size_t i = 0; keyrings[i]; i++) {
+        SCOPED_TRACE(keyrings[i]);
+        // load keyring on the single thread and on the multiple ones
+        rnp_ffi_t mtffi = NULL;
+        assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+        assert_rnp_success(rnp_ffi_create(&mtffi, "GPG", "GPG"));
+        assert_rnp_success(rnp_ffi_set_load_threads(mtffi, 4));
+        assert_true(load_keys_gpg(ffi, keyrings[i]));
+        assert_true(load_keys_gpg(mtffi, keyrings[i]));
+        size_t count = 0;
+        size_t mtcount = 0;
+        assert_rnp_success(rnp_get_public_key_count(ffi, &count));
+        assert_rnp_success(rnp_get_public_key_count(mtffi, &mtcount));
+        assert_int_equal(count, mtcount);
+        assert_int_not_equal(count, 0);
+        // keys, their order and validity must be the same
+        rnp_identifier_iterator_t it = NULL;
+        rnp_identifier_iterator_t mtit = NULL;
+        assert_rnp_success(rnp_identifier_iterator_create(ffi, &it, "fingerprint"));
+        assert_rnp_success(rnp_identifier_iterator_create(mtffi, &mtit, "fingerprint"));
+        const char *fp = NULL;
+        const char *mtfp = NULL;
+        while (!rnp_identifier_iterator_next(it, &fp) && fp) {
+            assert_rnp_success(rnp_identifier_iterator_next(mtit, &mtfp));
+            assert_non_null(mtfp);
+            assert_string_equal(fp, mtfp);
+            rnp_key_handle_t key = NULL;
+            rnp_key_handle_t mtkey = NULL;
+            assert_rnp_success(rnp_locate_key(ffi, "fingerprint", fp, &key));
+            assert_rnp_success(rnp_locate_key(mtffi, "fingerprint", fp, &mtkey));
+            bool valid = false;
+            bool mtvalid = true;
+            assert_rnp_success(rnp_key_is_valid(key, &valid));
+            assert_rnp_success(rnp_key_is_valid(mtkey, &mtvalid));
+            assert_int_equal(valid, mtvalid);
+            uint32_t till = 0;
+            uint32_t mttill = 1;
+            assert_rnp_success(rnp_key_valid_till(key, &till));
+            assert_rnp_success(rnp_key_valid_till(mtkey, &mttill));
+            assert_int_equal(till, mttill);
+            char *json = NULL;
+            char *mtjson = NULL;
+            assert_rnp_success(rnp_key_to_json(key, RNP_JSON_SIGNATURES, &json));
+            assert_rnp_success(rnp_key_to_json(mtkey, RNP_JSON_SIGNATURES, &mtjson));
+            assert_string_equal(json, mtjson);
+            rnp_buffer_destroy(json);
+            rnp_buffer_destroy(mtjson);
+            rnp_key_handle_destroy(key);
+            rnp_key_handle_destroy(mtkey);
+        }
+        assert_rnp_success(rnp_identifier_iterator_next(mtit, &mtfp));
+        assert_null(mtfp);
+        rnp_identifier_iterator_destroy(it);
+        rnp_identifier_iterator_destroy(mtit);
+        rnp_ffi_destroy(ffi);
+        rnp_ffi_destroy(mtffi);
+    }
+}
+
+static void
+check_lazy_keys(rnp_ffi_t ffi, rnp_ffi_t lazyffi)
+{
+    rnp_identifier_iterator_t it = NULL;
+    assert_rnp_success(rnp_identifier_iterator_create(ffi, &it, "fingerprint"));
+    const char *fp = NULL;
+    size_t      count = 0;
+    while (!rnp_identifier_iterator_next(it, &fp) && fp) {
+        rnp_key_handle_t key = NULL;
+        rnp_key_handle_t lazykey = NULL;
+        assert_rnp_success(rnp_locate_key(ffi, "fingerprint", fp, &key));
+        assert_rnp_success(rnp_locate_key(lazyffi, "fingerprint", fp, &lazykey));
+        assert_non_null(lazykey);
+        bool valid = false;
+        bool lazyvalid = true;
+        assert_rnp_success(rnp_key_is_valid(key, &valid));
+        assert_rnp_success(rnp_key_is_valid(lazykey, &lazyvalid));
+        assert_int_equal(valid, lazyvalid);
+        uint32_t till = 0;
+        uint32_t lazytill = 1;
+        assert_rnp_success(rnp_key_valid_till(key, &till));
+        assert_rnp_success(rnp_key_valid_till(lazykey, &lazytill));
+        assert_int_equal(till, lazytill);
+        char *json = NULL;
+        char *lazyjson = NULL;
+        assert_rnp_success(rnp_key_to_json(key, RNP_JSON_SIGNATURES, &json));
+        assert_rnp_success(rnp_key_to_json(lazykey, RNP_JSON_SIGNATURES, &lazyjson));
+        assert_string_equal(json, lazyjson);
+        rnp_buffer_destroy(json);
+        rnp_buffer_destroy(lazyjson);
+        rnp_key_handle_destroy(key);
+        rnp_key_handle_destroy(lazykey);
+        count++;
+    }
+    assert_int_not_equal(count, 0);
+    rnp_identifier_iterator_destroy(it);
+}
+
+TEST_F(rnp_tests, test_ffi_lazy_validation)
+{
+    rnp_ffi_t ffi = NULL;
+    rnp_ffi_t lazyffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_success(rnp_ffi_create(&lazyffi, "GPG", "GPG"));
+    assert_rnp_failure(rnp_ffi_set_lazy_validation(NULL, true));
+    assert_rnp_success(rnp_ffi_set_lazy_validation(lazyffi, true));
+    assert_true(load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg"));
+    assert_true(load_keys_gpg(lazyffi, "data/keyrings/1/pubring.gpg"));
+
+    /* signer is validated once it is requested via the key provider */
+    rnp_input_t  input = NULL;
+    rnp_output_t output = NULL;
+    assert_rnp_success(rnp_input_from_path(&input, "data/test_messages/message.txt.signed"));
+    assert_rnp_success(rnp_output_to_null(&output));
+    rnp_op_verify_t verify = NULL;
+    assert_rnp_success(rnp_op_verify_create(&verify, lazyffi, input, output));
+    assert_rnp_success(rnp_op_verify_execute(verify));
+    rnp_op_verify_destroy(verify);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+
+    /* other keys are validated on the first access */
+    check_lazy_keys(ffi, lazyffi);
+    rnp_ffi_destroy(lazyffi);
+
+    /* keys are validated concurrently, while readers use the already validated ones */
+    std::vector<std::pair<std::string, bool>> expected;
+    rnp_identifier_iterator_t                 it = NULL;
+    assert_rnp_success(rnp_identifier_iterator_create(ffi, &it, "fingerprint"));
+    const char *fp = NULL;
+    while (!rnp_identifier_iterator_next(it, &fp) && fp) {
+        rnp_key_handle_t key = NULL;
+        bool             valid = false;
+        assert_rnp_success(rnp_locate_key(ffi, "fingerprint", fp, &key));
+        assert_rnp_success(rnp_key_is_valid(key, &valid));
+        rnp_key_handle_destroy(key);
+        expected.emplace_back(fp, valid);
+    }
+    rnp_identifier_iterator_destroy(it);
+    assert_rnp_success(rnp_ffi_create(&lazyffi, "GPG", "GPG"));
+    assert_rnp_success(rnp_ffi_set_lazy_validation(lazyffi, true));
+    assert_true(load_keys_gpg(lazyffi, "data/keyrings/1/pubring.gpg"));
+    std::atomic<size_t>      failed(0);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < 4; i++) {
+        threads.emplace_back([&, i]() {
+            for (size_t j = 0; j < expected.size(); j++) {
+                /* each thread goes through the keys in its own order */
+                auto &           exp = expected[(i + j) % expected.size()];
+                rnp_key_handle_t key = NULL;
+                bool             valid = !exp.second;
+                if (rnp_locate_key(lazyffi, "fingerprint", exp.first.c_str(), &key) ||
+                    !key || rnp_key_is_valid(key, &valid) || (valid != exp.second)) {
+                    failed++;
+                }
+                rnp_key_handle_destroy(key);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    assert_int_equal(failed.load(), 0);
+    check_lazy_keys(ffi, lazyffi);
+    /* validation is published, so subsequent lookups do not take the mutex */
+    for (auto &exp : expected) {
+        rnp_key_handle_t key = NULL;
+        assert_rnp_success(rnp_locate_key(lazyffi, "fingerprint", exp.first.c_str(), &key));
+        assert_true(key->pub->validity_published());
+        rnp_key_handle_destroy(key);
+    }
+    rnp_ffi_destroy(lazyffi);
+
+    /* imported keys */
+    assert_rnp_success(rnp_ffi_create(&lazyffi, "GPG", "GPG"));
+    assert_rnp_success(rnp_ffi_set_lazy_validation(lazyffi, true));
+    assert_true(import_pub_keys(lazyffi, "data/keyrings/1/pubring.gpg"));
+    check_lazy_keys(ffi, lazyffi);
+    /* keys with invalid signatures and subkeys */
+    const char *cases[] = {"data/test_key_validity/case2/pubring.gpg",
+                           "data/test_key_validity/case5/pubring.gpg",
+                           "data/test_key_validity/case7/pubring.gpg",
+                           NULL};
+    for (size_t i = 0; cases[i]; i++) {
+        SCOPED_TRACE(cases[i]);
+        assert_true(import_pub_keys(ffi, cases[i]));
+        assert_true(import_pub_keys(lazyffi, cases[i]));
+        check_lazy_keys(ffi, lazyffi);
+    }
+    rnp_ffi_destroy(lazyffi);
+    rnp_ffi_destroy(ffi);
+}
+
 TEST_F(rnp_tests, test_ffi_clear_keys)
 {
     rnp_ffi_t ffi = NULL;
@@ -404,6 +615,94 @@ TEST_F(rnp_tests, test_ffi_clear_keys)
     ffi = NULL;
 }
 
+TEST_F(rnp_tests, test_ffi_memory_usage)
+{
+    rnp_ffi_t ffi = NULL;
+    size_t    pub_usage = 0;
+    size_t    sec_usage = 0;
+    size_t    usage = 0;
+
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    // empty keyrings
+    assert_rnp_success(rnp_get_memory_usage(ffi, RNP_LOAD_SAVE_PUBLIC_KEYS, &usage));
+    assert_int_equal(usage, 0);
+    // wrong parameters
+    assert_rnp_failure(rnp_get_memory_usage(NULL, RNP_LOAD_SAVE_PUBLIC_KEYS, &usage));
+    assert_rnp_failure(rnp_get_memory_usage(ffi, RNP_LOAD_SAVE_PUBLIC_KEYS, NULL));
+    assert_rnp_failure(rnp_get_memory_usage(ffi, 0, &usage));
+    assert_rnp_failure(rnp_get_memory_usage(ffi, RNP_LOAD_SAVE_PERMISSIVE, &usage));
+    assert_rnp_failure(rnp_release_memory(NULL, RNP_LOAD_SAVE_PUBLIC_KEYS));
+    assert_rnp_failure(rnp_release_memory(ffi, 0));
+    assert_rnp_failure(rnp_release_memory(ffi, 255));
+    // load keys
+    assert_true(
+      load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg", "data/keyrings/1/secring.gpg"));
+    assert_rnp_success(rnp_get_memory_usage(ffi, RNP_LOAD_SAVE_PUBLIC_KEYS, &pub_usage));
+    assert_true(pub_usage > 0);
+    assert_rnp_success(rnp_get_memory_usage(ffi, RNP_LOAD_SAVE_SECRET_KEYS, &sec_usage));
+    assert_true(sec_usage > pub_usage);
+    assert_rnp_success(rnp_get_memory_usage(
+      ffi, RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_SECRET_KEYS, &usage));
+    assert_int_equal(usage, pub_usage + sec_usage);
+    // caches are not counted, and keys remain usable after the release
+    rnp_key_handle_t key = NULL;
+    assert_rnp_success(rnp_locate_key(ffi, "keyid", "7bc6709b15c23a4a", &key));
+    assert_rnp_success(
+      rnp_release_memory(ffi, RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_SECRET_KEYS));
+    assert_rnp_success(rnp_get_memory_usage(ffi, RNP_LOAD_SAVE_PUBLIC_KEYS, &usage));
+    assert_int_equal(usage, pub_usage);
+    bool valid = false;
+    assert_rnp_success(rnp_key_is_valid(key, &valid));
+    assert_true(valid);
+    rnp_input_t  input = NULL;
+    rnp_output_t output = NULL;
+    assert_rnp_success(rnp_input_from_memory(&input, (uint8_t *) "data", 4, false));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    rnp_op_sign_t op = NULL;
+    assert_rnp_success(rnp_op_sign_create(&op, ffi, input, output));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+    assert_rnp_success(rnp_op_sign_add_signature(op, key, NULL));
+    assert_rnp_success(rnp_op_sign_execute(op));
+    rnp_op_sign_destroy(op);
+    rnp_input_destroy(input);
+    rnp_key_handle_destroy(key);
+    // verification loads backend key object, which is released then
+    auto cached = [ffi]() {
+        size_t res = 0;
+        for (auto &pkey : ffi->pubring->keys) {
+            res += pkey.material()->cached();
+        }
+        return res;
+    };
+    uint8_t *buf = NULL;
+    size_t   len = 0;
+    assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+    assert_rnp_success(rnp_input_from_memory(&input, buf, len, false));
+    rnp_output_t    verout = NULL;
+    rnp_op_verify_t verify = NULL;
+    assert_rnp_success(rnp_output_to_null(&verout));
+    assert_rnp_success(rnp_op_verify_create(&verify, ffi, input, verout));
+    assert_rnp_success(rnp_op_verify_execute(verify));
+    rnp_op_verify_destroy(verify);
+    rnp_input_destroy(input);
+    rnp_output_destroy(verout);
+    rnp_output_destroy(output);
+    assert_true(cached() > 0);
+    assert_rnp_success(rnp_release_memory(ffi, RNP_LOAD_SAVE_SECRET_KEYS));
+    assert_true(cached() > 0);
+    assert_rnp_success(rnp_release_memory(ffi, RNP_LOAD_SAVE_PUBLIC_KEYS));
+    assert_int_equal(cached(), 0);
+    // unload keys
+    assert_rnp_success(rnp_unload_keys(ffi, RNP_KEY_UNLOAD_PUBLIC));
+    assert_rnp_success(rnp_get_memory_usage(ffi, RNP_LOAD_SAVE_PUBLIC_KEYS, &usage));
+    assert_int_equal(usage, 0);
+    assert_rnp_success(rnp_get_memory_usage(ffi, RNP_LOAD_SAVE_SECRET_KEYS, &usage));
+    assert_int_equal(usage, sec_usage);
+
+    rnp_ffi_destroy(ffi);
+}
+
 TEST_F(rnp_tests, test_ffi_save_keys)
 {
     rnp_ffi_t ffi = NULL;
@@ -533,6 +832,186 @@ TEST_F(rnp_tests, test_ffi_save_keys)
     free(temp_dir);
 }
 
+TEST_F(rnp_tests, test_ffi_save_keys_incremental)
+{
+    rnp_ffi_t ffi = NULL;
+    char *    temp_dir = make_temp_dir();
+    auto      pub_path = rnp::path::append(temp_dir, "pubring.gpg");
+    // save just a primary key first
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_true(import_pub_keys(ffi, "data/test_stream_key_merge/key-pub-just-key.pgp"));
+    rnp_output_t output = NULL;
+    assert_rnp_failure(rnp_output_to_file(&output, pub_path.c_str(), RNP_OUTPUT_FILE_APPEND));
+    assert_rnp_success(rnp_output_to_path(&output, pub_path.c_str()));
+    assert_rnp_success(rnp_save_keys(
+      ffi, "GPG", output, RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_MARK_CLEAN));
+    assert_rnp_success(rnp_output_destroy(output));
+    off_t size = file_size(pub_path.c_str());
+    assert_true(size > 0);
+    // changes may be only appended to the file
+    auto exp_path = rnp::path::append(temp_dir, "export.gpg");
+    assert_rnp_success(rnp_output_to_file(&output, exp_path.c_str(), 0));
+    assert_int_equal(rnp_save_keys(ffi,
+                                   "GPG",
+                                   output,
+                                   RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_INCREMENTAL),
+                     RNP_ERROR_BAD_PARAMETERS);
+    assert_rnp_success(rnp_output_destroy(output));
+    // nothing is changed, so nothing is appended
+    assert_rnp_failure(rnp_output_to_file(
+      &output, pub_path.c_str(), RNP_OUTPUT_FILE_APPEND | RNP_OUTPUT_FILE_OVERWRITE));
+    assert_rnp_success(rnp_output_to_file(&output, pub_path.c_str(), RNP_OUTPUT_FILE_APPEND));
+    assert_rnp_success(rnp_save_keys(
+      ffi, "GPG", output, RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_INCREMENTAL));
+    assert_rnp_success(rnp_output_destroy(output));
+    assert_int_equal(file_size(pub_path.c_str()), size);
+    // updated key is appended and merged on load, export doesn't mark it as saved
+    assert_true(import_pub_keys(ffi, "data/test_stream_key_merge/key-pub.pgp"));
+    assert_rnp_success(rnp_output_to_file(&output, exp_path.c_str(), RNP_OUTPUT_FILE_OVERWRITE));
+    assert_rnp_success(rnp_save_keys(ffi, "GPG", output, RNP_LOAD_SAVE_PUBLIC_KEYS));
+    assert_rnp_success(rnp_output_destroy(output));
+    assert_rnp_success(rnp_output_to_file(&output, pub_path.c_str(), RNP_OUTPUT_FILE_APPEND));
+    assert_rnp_success(rnp_save_keys(
+      ffi, "GPG", output, RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_INCREMENTAL));
+    assert_rnp_success(rnp_output_destroy(output));
+    assert_true(file_size(pub_path.c_str()) > size);
+    size = file_size(pub_path.c_str());
+    // new key is appended as well, without the unchanged one
+    assert_true(import_pub_keys(ffi, "data/test_stream_key_load/ecc-p256-pub.asc"));
+    assert_rnp_success(rnp_output_to_file(&output, pub_path.c_str(), RNP_OUTPUT_FILE_APPEND));
+    assert_rnp_success(rnp_save_keys(
+      ffi, "GPG", output, RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_INCREMENTAL));
+    assert_rnp_success(rnp_output_destroy(output));
+    assert_true(file_size(pub_path.c_str()) - size < size);
+    size = file_size(pub_path.c_str());
+    size_t count = 0;
+    assert_rnp_success(rnp_get_public_key_count(ffi, &count));
+    rnp_ffi_destroy(ffi);
+    // reload and check
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_true(load_keys_gpg(ffi, pub_path));
+    size_t loaded = 0;
+    assert_rnp_success(rnp_get_public_key_count(ffi, &loaded));
+    assert_int_equal(loaded, count);
+    rnp_key_handle_t key = NULL;
+    assert_rnp_success(rnp_locate_key(ffi, "keyid", "9747D2A6B3A63124", &key));
+    size_t uids = 0;
+    assert_rnp_success(rnp_key_get_uid_count(key, &uids));
+    assert_int_equal(uids, 2);
+    size_t subkeys = 0;
+    assert_rnp_success(rnp_key_get_subkey_count(key, &subkeys));
+    assert_int_equal(subkeys, 2);
+    // removal cannot be appended, so full save is required
+    assert_rnp_success(rnp_key_remove(key, RNP_KEY_REMOVE_PUBLIC | RNP_KEY_REMOVE_SUBKEYS));
+    rnp_key_handle_destroy(key);
+    assert_rnp_success(rnp_output_to_file(&output, pub_path.c_str(), RNP_OUTPUT_FILE_APPEND));
+    assert_int_equal(rnp_save_keys(ffi,
+                                   "GPG",
+                                   output,
+                                   RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_INCREMENTAL),
+                     RNP_ERROR_BAD_STATE);
+    assert_rnp_success(rnp_output_destroy(output));
+    assert_int_equal(file_size(pub_path.c_str()), size);
+    assert_rnp_success(rnp_output_to_path(&output, pub_path.c_str()));
+    assert_rnp_success(rnp_save_keys(
+      ffi, "GPG", output, RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_MARK_CLEAN));
+    assert_rnp_success(rnp_output_destroy(output));
+    assert_true(file_size(pub_path.c_str()) < size);
+    size = file_size(pub_path.c_str());
+    // now changes may be appended again
+    assert_rnp_success(rnp_output_to_file(&output, pub_path.c_str(), RNP_OUTPUT_FILE_APPEND));
+    assert_rnp_success(rnp_save_keys(
+      ffi, "GPG", output, RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_INCREMENTAL));
+    assert_rnp_success(rnp_output_destroy(output));
+    assert_int_equal(file_size(pub_path.c_str()), size);
+    rnp_ffi_destroy(ffi);
+
+    // G10: only files of the changed keys are written
+    assert_rnp_success(rnp_ffi_create(&ffi, "KBX", "G10"));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+    assert_true(load_keys_kbx_g10(
+      ffi, "data/keyrings/3/pubring.kbx", "data/keyrings/3/private-keys-v1.d"));
+    auto sec_path = rnp::path::append(temp_dir, "private-keys-v1.d");
+    assert_int_equal(0, RNP_MKDIR(sec_path.c_str(), S_IRWXU));
+    auto key1 = rnp::path::append(sec_path, "63E59092E4B1AE9F8E675B2F98AA2B8BD9F4EA59.key");
+    auto key2 = rnp::path::append(sec_path, "7EAB41A2F46257C36F2892696F5A2F0432499AD3.key");
+    // keys were just loaded, so nothing is written
+    assert_rnp_success(rnp_output_to_path(&output, sec_path.c_str()));
+    assert_rnp_success(rnp_save_keys(
+      ffi, "G10", output, RNP_LOAD_SAVE_SECRET_KEYS | RNP_LOAD_SAVE_INCREMENTAL));
+    assert_rnp_success(rnp_output_destroy(output));
+    assert_false(rnp::path::exists(key1));
+    assert_false(rnp::path::exists(key2));
+    // change just the primary key
+    assert_rnp_success(rnp_locate_key(ffi, "keyid", "4BE147BB22DF1E60", &key));
+    uint32_t creation = 0;
+    assert_rnp_success(rnp_key_get_creation(key, &creation));
+    assert_rnp_success(rnp_key_set_expiration(key, time(NULL) - creation + 10000));
+    rnp_key_handle_destroy(key);
+    assert_rnp_success(rnp_output_to_path(&output, sec_path.c_str()));
+    assert_rnp_success(rnp_save_keys(
+      ffi, "G10", output, RNP_LOAD_SAVE_SECRET_KEYS | RNP_LOAD_SAVE_INCREMENTAL));
+    assert_rnp_success(rnp_output_destroy(output));
+    assert_true(rnp::path::exists(key1) != rnp::path::exists(key2));
+    // full save writes everything
+    assert_rnp_success(rnp_output_to_path(&output, sec_path.c_str()));
+    assert_rnp_success(rnp_save_keys(ffi, "G10", output, RNP_LOAD_SAVE_SECRET_KEYS));
+    assert_rnp_success(rnp_output_destroy(output));
+    assert_true(rnp::path::exists(key1));
+    assert_true(rnp::path::exists(key2));
+    rnp_ffi_destroy(ffi);
+
+    // G10: secret subkey without the secret primary key is written as well
+    assert_rnp_success(rnp_ffi_create(&ffi, "KBX", "G10"));
+    rnp_op_generate_t op = NULL;
+    rnp_key_handle_t  sub = NULL;
+    assert_rnp_success(rnp_op_generate_create(&op, ffi, "ECDSA"));
+    assert_rnp_success(rnp_op_generate_set_curve(op, "NIST P-256"));
+    assert_rnp_success(rnp_op_generate_execute(op));
+    assert_rnp_success(rnp_op_generate_get_key(op, &key));
+    rnp_op_generate_destroy(op);
+    assert_rnp_success(rnp_op_generate_subkey_create(&op, ffi, key, "ECDH"));
+    assert_rnp_success(rnp_op_generate_set_curve(op, "NIST P-256"));
+    assert_rnp_success(rnp_op_generate_execute(op));
+    assert_rnp_success(rnp_op_generate_get_key(op, &sub));
+    rnp_op_generate_destroy(op);
+    char *grip = NULL;
+    assert_rnp_success(rnp_key_get_grip(sub, &grip));
+    std::string subgrip = grip;
+    rnp_buffer_destroy(grip);
+    rnp_key_handle_destroy(sub);
+    assert_rnp_success(rnp_key_remove(key, RNP_KEY_REMOVE_SECRET));
+    rnp_key_handle_destroy(key);
+    sec_path = rnp::path::append(temp_dir, "private-keys-sub.d");
+    assert_int_equal(0, RNP_MKDIR(sec_path.c_str(), S_IRWXU));
+    assert_rnp_success(rnp_output_to_path(&output, sec_path.c_str()));
+    assert_rnp_success(rnp_save_keys(
+      ffi, "G10", output, RNP_LOAD_SAVE_SECRET_KEYS | RNP_LOAD_SAVE_INCREMENTAL));
+    assert_rnp_success(rnp_output_destroy(output));
+    assert_true(rnp::path::exists(rnp::path::append(sec_path, subgrip + ".key")));
+    pub_path = rnp::path::append(temp_dir, "pubring-sub.kbx");
+    assert_rnp_success(rnp_output_to_path(&output, pub_path.c_str()));
+    assert_rnp_success(rnp_save_keys(ffi, "KBX", output, RNP_LOAD_SAVE_PUBLIC_KEYS));
+    assert_rnp_success(rnp_output_destroy(output));
+    rnp_ffi_destroy(ffi);
+    // reload and check that subkey's secret part is here
+    assert_rnp_success(rnp_ffi_create(&ffi, "KBX", "G10"));
+    assert_true(load_keys_kbx_g10(ffi, pub_path.c_str(), sec_path.c_str()));
+    count = 0;
+    assert_rnp_success(rnp_get_secret_key_count(ffi, &count));
+    assert_int_equal(count, 1);
+    assert_rnp_success(rnp_locate_key(ffi, "grip", subgrip.c_str(), &sub));
+    bool secret = false;
+    assert_rnp_success(rnp_key_have_secret(sub, &secret));
+    assert_true(secret);
+    rnp_key_handle_destroy(sub);
+    rnp_ffi_destroy(ffi);
+
+    clean_temp_dir(temp_dir);
+    free(temp_dir);
+}
+
 TEST_F(rnp_tests, test_ffi_load_save_keys_to_utf8_path)
 {
     const char kbx_pubring_utf8_filename[] = "pubring_\xC2\xA2.kbx";
@@ -1701,6 +2180,112 @@ TEST_F(rnp_tests, test_ffi_signatures_detached_memory_g10)
     rnp_ffi_destroy(ffi);
 }
 
+TEST_F(rnp_tests, test_ffi_load_keys_g10_lazy)
+{
+    rnp_ffi_t   ffi = NULL;
+    rnp_input_t input = NULL;
+    size_t      count = 0;
+
+    assert_rnp_success(rnp_ffi_create(&ffi, "KBX", "G10"));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+    assert_true(load_keys_kbx_g10(ffi, "data/keyrings/3/pubring.kbx", ""));
+    // wrong parameters
+    assert_rnp_success(rnp_input_from_path(&input, "data/keyrings/3/private-keys-v1.d"));
+    assert_rnp_failure(rnp_load_keys(
+      ffi, "G10", input, RNP_LOAD_SAVE_PUBLIC_KEYS | RNP_LOAD_SAVE_LAZY));
+    assert_rnp_failure(rnp_load_keys(
+      ffi, "GPG", input, RNP_LOAD_SAVE_SECRET_KEYS | RNP_LOAD_SAVE_LAZY));
+    rnp_input_destroy(input);
+    assert_rnp_success(rnp_input_from_path(&input, "data/keyrings/1/secring.gpg"));
+    assert_rnp_failure(rnp_load_keys(
+      ffi, "G10", input, RNP_LOAD_SAVE_SECRET_KEYS | RNP_LOAD_SAVE_LAZY));
+    rnp_input_destroy(input);
+    // encrypt message to the key, while secret keys are not indexed yet
+    rnp_key_handle_t key = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t openc = NULL;
+    assert_rnp_success(rnp_locate_key(ffi, "keyid", "4BE147BB22DF1E60", &key));
+    assert_rnp_success(rnp_input_from_memory(&input, (uint8_t *) "data", 4, false));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    assert_rnp_success(rnp_op_encrypt_create(&openc, ffi, input, output));
+    assert_rnp_success(rnp_op_encrypt_add_recipient(openc, key));
+    assert_rnp_success(rnp_op_encrypt_execute(openc));
+    rnp_op_encrypt_destroy(openc);
+    rnp_input_destroy(input);
+    rnp_key_handle_destroy(key);
+    uint8_t *buf = NULL;
+    size_t   len = 0;
+    assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+    std::vector<uint8_t> encrypted(buf, buf + len);
+    rnp_output_destroy(output);
+    // index directory, decryption loads the secret subkey
+    assert_rnp_success(rnp_input_from_path(&input, "data/keyrings/3/private-keys-v1.d"));
+    assert_rnp_success(
+      rnp_load_keys(ffi, "G10", input, RNP_LOAD_SAVE_SECRET_KEYS | RNP_LOAD_SAVE_LAZY));
+    rnp_input_destroy(input);
+    assert_rnp_success(rnp_get_secret_key_count(ffi, &count));
+    assert_int_equal(count, 0);
+    assert_rnp_success(
+      rnp_input_from_memory(&input, encrypted.data(), encrypted.size(), false));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    assert_rnp_success(rnp_decrypt(ffi, input, output));
+    assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+    assert_int_equal(len, 4);
+    assert_int_equal(memcmp(buf, "data", 4), 0);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    assert_rnp_success(rnp_get_secret_key_count(ffi, &count));
+    assert_int_equal(count, 1);
+    assert_rnp_success(rnp_unload_keys(ffi, RNP_KEY_UNLOAD_SECRET));
+    // index directory, no keys are loaded
+    assert_rnp_success(rnp_input_from_path(&input, "data/keyrings/3/private-keys-v1.d"));
+    assert_rnp_success(
+      rnp_load_keys(ffi, "G10", input, RNP_LOAD_SAVE_SECRET_KEYS | RNP_LOAD_SAVE_LAZY));
+    rnp_input_destroy(input);
+    assert_rnp_success(rnp_get_secret_key_count(ffi, &count));
+    assert_int_equal(count, 0);
+    // secret key is loaded once it is requested
+    assert_rnp_success(rnp_locate_key(ffi, "keyid", "4BE147BB22DF1E60", &key));
+    bool secret = false;
+    assert_rnp_success(rnp_key_have_secret(key, &secret));
+    assert_true(secret);
+    assert_rnp_success(rnp_get_secret_key_count(ffi, &count));
+    assert_int_equal(count, 1);
+    // sign with the loaded key
+    rnp_op_sign_t opsign = NULL;
+    assert_rnp_success(rnp_input_from_memory(&input, (uint8_t *) "data", 4, false));
+    assert_rnp_success(rnp_output_to_null(&output));
+    assert_rnp_success(rnp_op_sign_detached_create(&opsign, ffi, input, output));
+    assert_rnp_success(rnp_op_sign_add_signature(opsign, key, NULL));
+    assert_rnp_success(rnp_op_sign_execute(opsign));
+    rnp_op_sign_destroy(opsign);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    rnp_key_handle_destroy(key);
+    // lookup by grip
+    assert_rnp_success(
+      rnp_locate_key(ffi, "grip", "7EAB41A2F46257C36F2892696F5A2F0432499AD3", &key));
+    assert_rnp_success(rnp_key_have_secret(key, &secret));
+    assert_true(secret);
+    rnp_key_handle_destroy(key);
+    assert_rnp_success(rnp_get_secret_key_count(ffi, &count));
+    assert_int_equal(count, 2);
+    // unloading secret keys drops the index as well
+    assert_rnp_success(rnp_unload_keys(ffi, RNP_KEY_UNLOAD_SECRET));
+    assert_rnp_success(rnp_input_from_path(&input, "data/keyrings/3/private-keys-v1.d"));
+    assert_rnp_success(
+      rnp_load_keys(ffi, "G10", input, RNP_LOAD_SAVE_SECRET_KEYS | RNP_LOAD_SAVE_LAZY));
+    rnp_input_destroy(input);
+    assert_rnp_success(rnp_unload_keys(ffi, RNP_KEY_UNLOAD_SECRET));
+    assert_rnp_success(rnp_locate_key(ffi, "keyid", "4BE147BB22DF1E60", &key));
+    assert_rnp_success(rnp_key_have_secret(key, &secret));
+    assert_false(secret);
+    rnp_key_handle_destroy(key);
+
+    rnp_ffi_destroy(ffi);
+}
+
 TEST_F(rnp_tests, test_ffi_enarmor_dearmor)
 {
     std::string data;
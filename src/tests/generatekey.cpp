@@ -1043,8 +1043,8 @@ TEST_F(rnp_tests, test_generated_key_sigs)
         assert_int_not_equal(psig->material_buf.size(), 0);
         assert_int_not_equal(ssig->material_buf.size(), 0);
         // make sure we're targeting the right packet
-        assert_int_equal(PGP_PKT_SIGNATURE, pub.get_sig(0).rawpkt.tag);
-        assert_int_equal(PGP_PKT_SIGNATURE, sec.get_sig(0).rawpkt.tag);
+        assert_int_equal(PGP_PKT_SIGNATURE, pub.get_sig(0).rawpkt().tag);
+        assert_int_equal(PGP_PKT_SIGNATURE, sec.get_sig(0).rawpkt().tag);
 
         // validate the userid self-sig
 
@@ -1173,8 +1173,8 @@ TEST_F(rnp_tests, test_generated_key_sigs)
         assert_int_not_equal(psig->material_buf.size(), 0);
         assert_int_not_equal(ssig->material_buf.size(), 0);
         // make sure we're targeting the right packet
-        assert_int_equal(PGP_PKT_SIGNATURE, pub.get_sig(0).rawpkt.tag);
-        assert_int_equal(PGP_PKT_SIGNATURE, sec.get_sig(0).rawpkt.tag);
+        assert_int_equal(PGP_PKT_SIGNATURE, pub.get_sig(0).rawpkt().tag);
+        assert_int_equal(PGP_PKT_SIGNATURE, sec.get_sig(0).rawpkt().tag);
         // validate the binding sig
         psiginfo.sig = psig;
         primary_pub->validate_binding(psiginfo, pub, global_ctx);
@@ -234,3 +234,82 @@ TEST_F(rnp_tests, test_key_store_search_by_name)
     delete pub_store;
     delete sec_store;
 }
+
+TEST_F(rnp_tests, test_key_store_search_index)
+{
+    auto store =
+      new rnp::KeyStore(PGP_KEY_STORE_GPG, "data/keyrings/1/pubring.gpg", global_ctx);
+    assert_true(store->load());
+
+    pgp_key_t *key = rnp_tests_get_key_by_id(store, "7BC6709B15C23A4A");
+    assert_non_null(key);
+    assert_true(rnp_tests_get_key_by_grip(store, key->grip()) == key);
+    assert_true(rnp_tests_key_search(store, "key0-uid0") == key);
+    assert_true(rnp_tests_key_search(store, "key0-uid1") == key);
+    /* indexed search must not return anything after the single matching key */
+    rnp::KeyIDSearch idsearch(key->keyid());
+    assert_null(store->search(idsearch, key));
+    /* after param must belong to the keystore */
+    pgp_key_t keycp(*key);
+    assert_null(store->search(idsearch, &keycp));
+
+    /* remove key and make sure it is not found via indexes anymore */
+    pgp_key_id_t   keyid = key->keyid();
+    pgp_key_grip_t grip = key->grip();
+    size_t         count = store->key_count();
+    assert_true(store->remove_key(*key, true));
+    assert_true(store->key_count() < count);
+    assert_null(store->search(*rnp::KeySearch::create(keyid)));
+    assert_null(store->search(*rnp::KeySearch::create(grip)));
+    assert_null(rnp_tests_key_search(store, "key0-uid0"));
+
+    /* add it back */
+    key = store->add_key(keycp);
+    assert_non_null(key);
+    assert_true(store->search(*rnp::KeySearch::create(keyid)) == key);
+    assert_true(store->search(*rnp::KeySearch::create(grip)) == key);
+    assert_true(rnp_tests_key_search(store, "key0-uid0") == key);
+
+    /* userid index must be updated on userid removal and addition */
+    pgp_transferable_userid_t tuid;
+    tuid.uid.tag = PGP_PKT_USER_ID;
+    tuid.uid.uid_len = 9;
+    tuid.uid.uid = (uint8_t *) malloc(tuid.uid.uid_len);
+    assert_non_null(tuid.uid.uid);
+    memcpy(tuid.uid.uid, "key0-new1", tuid.uid.uid_len);
+    key->add_uid(tuid).valid = true;
+    assert_null(rnp_tests_key_search(store, "key0-new1"));
+    store->index_uids(*key);
+    assert_true(rnp_tests_key_search(store, "key0-new1") == key);
+    assert_int_equal(store->keybyuid.count("key0-new1"), 1);
+    assert_true(store->remove_uid(*key, key->uid_count() - 1));
+    assert_null(rnp_tests_key_search(store, "key0-new1"));
+    assert_int_equal(store->keybyuid.count("key0-new1"), 0);
+    assert_false(store->remove_uid(*key, key->uid_count()));
+
+    /* email index is case-insensitive and keeps email while any userid has it */
+    auto emails = rnp::KeyStore::uid_emails("Key <a> <Key0@Example.COM> <b");
+    assert_int_equal(emails.size(), 2);
+    assert_true(emails[0] == "<a>");
+    assert_true(emails[1] == "<key0@example.com>");
+    assert_true(rnp::KeyStore::uid_emails("no email <").empty());
+    for (auto uid : {"Key0 <Key0@Example.COM>", "Other <key0@example.com>"}) {
+        pgp_transferable_userid_t euid;
+        euid.uid.tag = PGP_PKT_USER_ID;
+        euid.uid.uid_len = strlen(uid);
+        euid.uid.uid = (uint8_t *) malloc(euid.uid.uid_len);
+        assert_non_null(euid.uid.uid);
+        memcpy(euid.uid.uid, uid, euid.uid.uid_len);
+        key->add_uid(euid).valid = true;
+    }
+    assert_int_equal(store->keybyemail.count("<key0@example.com>"), 0);
+    store->index_uids(*key);
+    assert_int_equal(store->keybyemail.count("<key0@example.com>"), 1);
+    assert_int_equal(store->keybyemail["<key0@example.com>"].size(), 1);
+    assert_true(store->remove_uid(*key, key->uid_count() - 2));
+    assert_int_equal(store->keybyemail.count("<key0@example.com>"), 1);
+    assert_true(store->remove_uid(*key, key->uid_count() - 1));
+    assert_int_equal(store->keybyemail.count("<key0@example.com>"), 0);
+
+    delete store;
+}
@@ -385,10 +385,10 @@ TEST_F(rnp_tests, test_load_armored_pub_sec)
     assert_true(key->is_secret());
     assert_int_equal(key->rawpkt_count(), 5);
     assert_int_equal(key->rawpkt().tag, PGP_PKT_SECRET_KEY);
-    assert_int_equal(key->get_uid(0).rawpkt.tag, PGP_PKT_USER_ID);
-    assert_int_equal(key->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
-    assert_int_equal(key->get_uid(1).rawpkt.tag, PGP_PKT_USER_ID);
-    assert_int_equal(key->get_sig(1).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_uid(0).rawpkt().tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_uid(1).rawpkt().tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_sig(1).rawpkt().tag, PGP_PKT_SIGNATURE);
 
     assert_non_null(key = rnp_tests_get_key_by_id(key_store, "AF1114A47F5F5B28"));
     assert_true(key->valid());
@@ -396,7 +396,7 @@ TEST_F(rnp_tests, test_load_armored_pub_sec)
     assert_true(key->is_secret());
     assert_int_equal(key->rawpkt_count(), 2);
     assert_int_equal(key->rawpkt().tag, PGP_PKT_SECRET_SUBKEY);
-    assert_int_equal(key->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
 
     assert_non_null(key = rnp_tests_get_key_by_id(key_store, "16CD16F267CCDD4F"));
     assert_true(key->valid());
@@ -404,7 +404,7 @@ TEST_F(rnp_tests, test_load_armored_pub_sec)
     assert_true(key->is_secret());
     assert_int_equal(key->rawpkt_count(), 2);
     assert_int_equal(key->rawpkt().tag, PGP_PKT_SECRET_SUBKEY);
-    assert_int_equal(key->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
 
     /* make sure half of keyid doesn't work */
     assert_null(key = rnp_tests_get_key_by_id(key_store, "0000000016CD16F2"));
@@ -489,7 +489,7 @@ TEST_F(rnp_tests, test_load_merge)
     assert_int_equal(key->uid_count(), 1);
     assert_int_equal(key->rawpkt_count(), 2);
     assert_int_equal(key->rawpkt().tag, PGP_PKT_PUBLIC_KEY);
-    assert_int_equal(key->get_uid(0).rawpkt.tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_uid(0).rawpkt().tag, PGP_PKT_USER_ID);
     assert_null(rnp_tests_key_search(key_store, "key-merge-uid-1"));
     assert_true(key == rnp_tests_get_key_by_id(key_store, "9747D2A6B3A63124"));
 
@@ -502,8 +502,8 @@ TEST_F(rnp_tests, test_load_merge)
     assert_int_equal(key->uid_count(), 1);
     assert_int_equal(key->rawpkt_count(), 3);
     assert_int_equal(key->rawpkt().tag, PGP_PKT_PUBLIC_KEY);
-    assert_int_equal(key->get_uid(0).rawpkt.tag, PGP_PKT_USER_ID);
-    assert_int_equal(key->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_uid(0).rawpkt().tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
     assert_true(key == rnp_tests_key_search(key_store, "key-merge-uid-1"));
 
     /* load key + user id 2 with sigs */
@@ -517,10 +517,10 @@ TEST_F(rnp_tests, test_load_merge)
     assert_int_equal(key->uid_count(), 2);
     assert_int_equal(key->rawpkt_count(), 5);
     assert_int_equal(key->rawpkt().tag, PGP_PKT_PUBLIC_KEY);
-    assert_int_equal(key->get_uid(0).rawpkt.tag, PGP_PKT_USER_ID);
-    assert_int_equal(key->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
-    assert_int_equal(key->get_uid(1).rawpkt.tag, PGP_PKT_USER_ID);
-    assert_int_equal(key->get_sig(1).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_uid(0).rawpkt().tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_uid(1).rawpkt().tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_sig(1).rawpkt().tag, PGP_PKT_SIGNATURE);
     assert_true(key == rnp_tests_key_search(key_store, "key-merge-uid-1"));
     assert_true(key == rnp_tests_key_search(key_store, "key-merge-uid-2"));
 
@@ -537,10 +537,10 @@ TEST_F(rnp_tests, test_load_merge)
     assert_true(check_subkey_fp(key, skey1, 0));
     assert_int_equal(key->rawpkt_count(), 5);
     assert_int_equal(key->rawpkt().tag, PGP_PKT_PUBLIC_KEY);
-    assert_int_equal(key->get_uid(0).rawpkt.tag, PGP_PKT_USER_ID);
-    assert_int_equal(key->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
-    assert_int_equal(key->get_uid(1).rawpkt.tag, PGP_PKT_USER_ID);
-    assert_int_equal(key->get_sig(1).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_uid(0).rawpkt().tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_uid(1).rawpkt().tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_sig(1).rawpkt().tag, PGP_PKT_SIGNATURE);
     assert_int_equal(skey1->uid_count(), 0);
     assert_int_equal(skey1->rawpkt_count(), 1);
     assert_int_equal(skey1->rawpkt().tag, PGP_PKT_PUBLIC_SUBKEY);
@@ -560,14 +560,14 @@ TEST_F(rnp_tests, test_load_merge)
     assert_true(check_subkey_fp(key, skey1, 0));
     assert_int_equal(key->rawpkt_count(), 5);
     assert_int_equal(key->rawpkt().tag, PGP_PKT_PUBLIC_KEY);
-    assert_int_equal(key->get_uid(0).rawpkt.tag, PGP_PKT_USER_ID);
-    assert_int_equal(key->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
-    assert_int_equal(key->get_uid(1).rawpkt.tag, PGP_PKT_USER_ID);
-    assert_int_equal(key->get_sig(1).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_uid(0).rawpkt().tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_uid(1).rawpkt().tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_sig(1).rawpkt().tag, PGP_PKT_SIGNATURE);
     assert_int_equal(skey1->uid_count(), 0);
     assert_int_equal(skey1->rawpkt_count(), 2);
     assert_int_equal(skey1->rawpkt().tag, PGP_PKT_PUBLIC_SUBKEY);
-    assert_int_equal(skey1->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(skey1->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
 
     /* load key + subkey 2 with signature */
     assert_true(load_transferable_key(&tkey, MERGE_PATH "key-pub-subkey-2.pgp"));
@@ -587,18 +587,18 @@ TEST_F(rnp_tests, test_load_merge)
     assert_true(check_subkey_fp(key, skey2, 1));
     assert_int_equal(key->rawpkt_count(), 5);
     assert_int_equal(key->rawpkt().tag, PGP_PKT_PUBLIC_KEY);
-    assert_int_equal(key->get_uid(0).rawpkt.tag, PGP_PKT_USER_ID);
-    assert_int_equal(key->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
-    assert_int_equal(key->get_uid(1).rawpkt.tag, PGP_PKT_USER_ID);
-    assert_int_equal(key->get_sig(1).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_uid(0).rawpkt().tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_uid(1).rawpkt().tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_sig(1).rawpkt().tag, PGP_PKT_SIGNATURE);
     assert_int_equal(skey1->uid_count(), 0);
     assert_int_equal(skey1->rawpkt_count(), 2);
     assert_int_equal(skey1->rawpkt().tag, PGP_PKT_PUBLIC_SUBKEY);
-    assert_int_equal(skey1->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(skey1->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
     assert_int_equal(skey2->uid_count(), 0);
     assert_int_equal(skey2->rawpkt_count(), 2);
     assert_int_equal(skey2->rawpkt().tag, PGP_PKT_PUBLIC_SUBKEY);
-    assert_int_equal(skey2->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(skey2->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
 
     /* load secret key & subkeys */
     assert_true(load_transferable_key(&tkey, MERGE_PATH "key-sec-no-uid-no-sigs.pgp"));
@@ -618,18 +618,18 @@ TEST_F(rnp_tests, test_load_merge)
     assert_true(check_subkey_fp(key, skey2, 1));
     assert_int_equal(key->rawpkt_count(), 5);
     assert_int_equal(key->rawpkt().tag, PGP_PKT_SECRET_KEY);
-    assert_int_equal(key->get_uid(0).rawpkt.tag, PGP_PKT_USER_ID);
-    assert_int_equal(key->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
-    assert_int_equal(key->get_uid(1).rawpkt.tag, PGP_PKT_USER_ID);
-    assert_int_equal(key->get_sig(1).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_uid(0).rawpkt().tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_uid(1).rawpkt().tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_sig(1).rawpkt().tag, PGP_PKT_SIGNATURE);
     assert_int_equal(skey1->uid_count(), 0);
     assert_int_equal(skey1->rawpkt_count(), 2);
     assert_int_equal(skey1->rawpkt().tag, PGP_PKT_SECRET_SUBKEY);
-    assert_int_equal(skey1->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(skey1->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
     assert_int_equal(skey2->uid_count(), 0);
     assert_int_equal(skey2->rawpkt_count(), 2);
     assert_int_equal(skey2->rawpkt().tag, PGP_PKT_SECRET_SUBKEY);
-    assert_int_equal(skey2->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(skey2->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
 
     assert_true(key->unlock(provider));
     assert_true(skey1->unlock(provider));
@@ -653,18 +653,18 @@ TEST_F(rnp_tests, test_load_merge)
     assert_true(check_subkey_fp(key, skey2, 1));
     assert_int_equal(key->rawpkt_count(), 5);
     assert_int_equal(key->rawpkt().tag, PGP_PKT_SECRET_KEY);
-    assert_int_equal(key->get_uid(0).rawpkt.tag, PGP_PKT_USER_ID);
-    assert_int_equal(key->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
-    assert_int_equal(key->get_uid(1).rawpkt.tag, PGP_PKT_USER_ID);
-    assert_int_equal(key->get_sig(1).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_uid(0).rawpkt().tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_uid(1).rawpkt().tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_sig(1).rawpkt().tag, PGP_PKT_SIGNATURE);
     assert_int_equal(skey1->uid_count(), 0);
     assert_int_equal(skey1->rawpkt_count(), 2);
     assert_int_equal(skey1->rawpkt().tag, PGP_PKT_SECRET_SUBKEY);
-    assert_int_equal(skey1->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(skey1->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
     assert_int_equal(skey2->uid_count(), 0);
     assert_int_equal(skey2->rawpkt_count(), 2);
     assert_int_equal(skey2->rawpkt().tag, PGP_PKT_SECRET_SUBKEY);
-    assert_int_equal(skey2->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(skey2->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
     assert_true(key == rnp_tests_key_search(key_store, "key-merge-uid-1"));
     assert_true(key == rnp_tests_key_search(key_store, "key-merge-uid-2"));
 
@@ -745,6 +745,29 @@ TEST_F(rnp_tests, test_load_public_from_secret)
     delete secstore;
 }
 
+TEST_F(rnp_tests, test_load_lazy_validation)
+{
+    rnp::KeyStore key_store(PGP_KEY_STORE_GPG, "data/keyrings/1/pubring.gpg", global_ctx);
+    key_store.lazy_validation = true;
+    assert_true(key_store.load());
+    assert_int_equal(key_store.key_count(), 7);
+    for (auto &key : key_store.keys) {
+        assert_false(key.validated());
+    }
+    /* primary key is validated together with its subkeys */
+    pgp_key_t *key = rnp_tests_get_key_by_id(&key_store, "1ED63EE56FADC34D");
+    assert_non_null(key);
+    assert_true(key->is_subkey());
+    key->revalidate(key_store);
+    assert_true(key->validated());
+    assert_true(key->valid());
+    pgp_key_t *primary = key_store.primary_key(*key);
+    assert_non_null(primary);
+    assert_true(primary->validated());
+    assert_true(primary->valid());
+    assert_false(rnp_tests_get_key_by_id(&key_store, "2FCADF05FFA501BB")->validated());
+}
+
 TEST_F(rnp_tests, test_key_import)
 {
     cli_rnp_t                  rnp = {};
@@ -939,7 +962,7 @@ TEST_F(rnp_tests, test_load_subkey)
     assert_false(skey1->valid());
     assert_int_equal(skey1->rawpkt_count(), 2);
     assert_int_equal(skey1->rawpkt().tag, PGP_PKT_PUBLIC_SUBKEY);
-    assert_int_equal(skey1->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(skey1->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
     assert_false(skey1->has_primary_fp());
 
     /* load second subkey, without signature */
@@ -959,8 +982,8 @@ TEST_F(rnp_tests, test_load_subkey)
     assert_true(key->valid());
     assert_int_equal(key->rawpkt_count(), 3);
     assert_int_equal(key->rawpkt().tag, PGP_PKT_PUBLIC_KEY);
-    assert_int_equal(key->get_uid(0).rawpkt.tag, PGP_PKT_USER_ID);
-    assert_int_equal(key->get_sig(0).rawpkt.tag, PGP_PKT_SIGNATURE);
+    assert_int_equal(key->get_uid(0).rawpkt().tag, PGP_PKT_USER_ID);
+    assert_int_equal(key->get_sig(0).rawpkt().tag, PGP_PKT_SIGNATURE);
     assert_true(skey1 == rnp_tests_get_key_by_id(key_store, sub1id));
     assert_true(skey2 == rnp_tests_get_key_by_id(key_store, sub2id));
     assert_true(skey1->has_primary_fp());
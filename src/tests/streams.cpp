@@ -332,6 +332,96 @@ TEST_F(rnp_tests, test_stream_file)
     assert_int_equal(rnp_unlink(dirname), 0);
 }
 
+static std::vector<uint8_t>
+read_source(pgp_source_t &src, size_t chunk)
+{
+    std::vector<uint8_t> res;
+    uint8_t              buf[4096];
+    size_t               read = 0;
+    while (src.read(buf, std::min(chunk, sizeof(buf)), &read) && read) {
+        res.insert(res.end(), buf, buf + read);
+    }
+    return res;
+}
+
+TEST_F(rnp_tests, test_stream_mmap)
+{
+    const char * filename = "dummyfile.dat";
+    pgp_source_t src = {};
+
+    /* non-existing file, directory and empty file */
+    assert_rnp_failure(init_mmap_src(&src, filename));
+    assert_rnp_failure(init_mmap_src(&src, "data"));
+    str_to_file(filename, "");
+    assert_rnp_success(init_mmap_src(&src, filename));
+    assert_int_equal(src.type, PGP_STREAM_FILE);
+    assert_true(src.eof());
+    src.close();
+
+    /* regular file: compare with the file source */
+    std::vector<uint8_t> data(100000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (i * 7 + i / 251) & 0xff;
+    }
+    pgp_dest_t dst = {};
+    assert_rnp_success(init_file_dest(&dst, filename, true));
+    dst_write(&dst, data.data(), data.size());
+    dst_close(&dst, false);
+    assert_rnp_success(init_mmap_src(&src, filename));
+    assert_int_equal(src.type, PGP_STREAM_MMAP);
+    assert_true(src.knownsize);
+    assert_int_equal(src.size, data.size());
+    /* peek is not limited by the cache size */
+    size_t         read = 0;
+    const uint8_t *ptr = src.peek_ptr(data.size() + 10, &read);
+    assert_non_null(ptr);
+    assert_int_equal(read, data.size());
+    assert_int_equal(memcmp(ptr, data.data(), data.size()), 0);
+    uint8_t buf[16] = {0};
+    assert_true(src.peek_eq(buf, sizeof(buf)));
+    assert_int_equal(memcmp(buf, data.data(), sizeof(buf)), 0);
+    src.skip(1000);
+    assert_true(src.read_eq(buf, sizeof(buf)));
+    assert_int_equal(memcmp(buf, data.data() + 1000, sizeof(buf)), 0);
+    assert_true(src.read(buf, sizeof(buf), &read));
+    assert_int_equal(read, sizeof(buf));
+    assert_int_equal(src.readb, 1000 + 2 * sizeof(buf));
+    /* memory source created from mmap source should reference the mapping */
+    pgp_source_t memsrc = {};
+    assert_rnp_success(read_mem_src(&memsrc, &src));
+    assert_true(src.eof());
+    assert_true(mem_src_get_memory(&memsrc) == ptr + 1000 + 2 * sizeof(buf));
+    assert_int_equal(memsrc.size, data.size() - 1000 - 2 * sizeof(buf));
+    memsrc.close();
+    src.close();
+    /* read with different chunks */
+    for (size_t chunk : {1, 17, 4096}) {
+        assert_rnp_success(init_mmap_src(&src, filename));
+        assert_true(read_source(src, chunk) == data);
+        assert_true(src.eof());
+        src.close();
+    }
+    assert_int_equal(rnp_unlink(filename), 0);
+
+    /* dearmoring of the mapped file */
+    const char * armored = "data/test_stream_key_load/rsa-rsa-pub.asc";
+    pgp_source_t armsrc = {};
+    pgp_source_t fsrc = {};
+    assert_rnp_success(init_file_src(&fsrc, armored));
+    assert_rnp_success(init_armored_src(&armsrc, &fsrc));
+    auto expected = read_source(armsrc, 4096);
+    armsrc.close();
+    fsrc.close();
+    assert_false(expected.empty());
+    assert_rnp_success(init_mmap_src(&src, armored));
+    assert_int_equal(src.type, PGP_STREAM_MMAP);
+    assert_true(src.is_armored());
+    assert_rnp_success(init_armored_src(&armsrc, &src));
+    assert_true(read_source(armsrc, 4096) == expected);
+    armsrc.close();
+    src.close();
+}
+
 TEST_F(rnp_tests, test_stream_signatures)
 {
     pgp_signature_t sig;
@@ -415,6 +505,88 @@ TEST_F(rnp_tests, test_stream_signatures)
     delete secring;
 }
 
+namespace {
+struct byte_reader_t {
+    const std::string &data;
+    size_t             pos;
+};
+
+/* return data by a single byte, so input is read in the smallest possible chunks */
+bool
+byte_reader(void *app_ctx, void *buf, size_t len, size_t *read)
+{
+    auto reader = static_cast<byte_reader_t *>(app_ctx);
+    *read = 0;
+    if (len && (reader->pos < reader->data.size())) {
+        *(uint8_t *) buf = reader->data[reader->pos++];
+        *read = 1;
+    }
+    return true;
+}
+} // namespace
+
+TEST_F(rnp_tests, test_stream_signatures_text_cr_chunks)
+{
+    /* data source is read in PGP_INPUT_CACHE_SIZE blocks, so long CR runs make blocks, which
+     * consist of CRs only. CRs before LF are stripped, while others must be preserved. */
+    std::string crs(3 * PGP_INPUT_CACHE_SIZE + 7, '\r');
+    std::string data = "first line" + crs + "\nsecond line" + crs + "third line\n\r\rend\n";
+    std::string canonical =
+      "first line\r\nsecond line" + crs + "third line\r\n\r\rend\r\n";
+
+    /* sign canonical text with the text-mode signature */
+    pgp_signature_t sig;
+    pgp_source_t    sigsrc;
+    assert_rnp_success(init_file_src(&sigsrc, "data/test_stream_signatures/source.txt.sig"));
+    assert_rnp_success(sig.parse(sigsrc));
+    sigsrc.close();
+    rnp::KeyStore secring(PGP_KEY_STORE_GPG, "data/test_stream_signatures/sec.asc", global_ctx);
+    assert_true(secring.load());
+    pgp_key_t *key = secring.get_signer(sig);
+    assert_non_null(key);
+    pgp_password_provider_t pswd_prov(rnp_password_provider_string, (void *) "password");
+    assert_true(key->unlock(pswd_prov));
+    pgp_hash_alg_t halg = sig.halg;
+    sig = {};
+    sig.version = PGP_V4;
+    sig.halg = halg;
+    sig.palg = key->alg();
+    sig.set_type(PGP_SIG_TEXT);
+    sig.set_keyfp(key->fp());
+    sig.set_keyid(key->keyid());
+    sig.set_creation(time(NULL));
+    sig.fill_hashed_data();
+    auto hash = rnp::Hash::create(halg);
+    hash->add(canonical.data(), canonical.size());
+    signature_calculate(sig, *key->material(), *hash, global_ctx);
+    rnp::MemoryDest sigdst;
+    sig.write(sigdst.dst());
+    auto sigdata = sigdst.to_vector();
+
+    /* verify it, feeding data by a single byte */
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_true(load_keys_gpg(ffi, "data/test_stream_signatures/pub.asc"));
+    for (auto &src : {data, canonical}) {
+        byte_reader_t   reader = {src, 0};
+        rnp_input_t     source = NULL;
+        rnp_input_t     input = NULL;
+        rnp_op_verify_t verify = NULL;
+        assert_rnp_success(rnp_input_from_callback(&source, byte_reader, NULL, &reader));
+        assert_rnp_success(
+          rnp_input_from_memory(&input, sigdata.data(), sigdata.size(), false));
+        assert_rnp_success(rnp_op_verify_detached_create(&verify, ffi, source, input));
+        assert_rnp_success(rnp_op_verify_execute(verify));
+        rnp_op_verify_signature_t vsig = NULL;
+        assert_rnp_success(rnp_op_verify_get_signature_at(verify, 0, &vsig));
+        assert_rnp_success(rnp_op_verify_signature_get_status(vsig));
+        rnp_op_verify_destroy(verify);
+        rnp_input_destroy(source);
+        rnp_input_destroy(input);
+    }
+    rnp_ffi_destroy(ffi);
+}
+
 TEST_F(rnp_tests, test_stream_signatures_revoked_key)
 {
     pgp_signature_t sig = {};
@@ -1036,6 +1208,7 @@ TEST_F(rnp_tests, test_stream_key_signatures)
 
     /* check key signatures */
     for (auto &keyref : keyseq.keys) {
+        rnp::SigHashCache cache;
         for (auto &uid : keyref.userids) {
             /* userid certifications */
             for (auto &sig : uid.signatures) {
@@ -1048,10 +1221,17 @@ TEST_F(rnp_tests, test_stream_key_signatures)
                 auto hash = signature_hash_certification(sig, keyref.key, uid.uid);
                 assert_rnp_success(
                   signature_validate(sig, *pkey->material(), *hash, global_ctx));
+                /* hash prefix from the cache, second call should use cached state */
+                for (int i = 0; i < 2; i++) {
+                    pkey->validate_cert(sinfo, keyref.key, uid.uid, global_ctx, &cache);
+                    assert_true(sinfo.valid);
+                }
                 /* modify userid and check signature */
                 uid.uid.uid[2] = '?';
                 pkey->validate_cert(sinfo, keyref.key, uid.uid, global_ctx);
                 assert_false(sinfo.valid);
+                pkey->validate_cert(sinfo, keyref.key, uid.uid, global_ctx, &cache);
+                assert_false(sinfo.valid);
                 hash = signature_hash_certification(sig, keyref.key, uid.uid);
                 assert_rnp_failure(
                   signature_validate(sig, *pkey->material(), *hash, global_ctx));
@@ -1076,6 +1256,9 @@ TEST_F(rnp_tests, test_stream_key_signatures)
             hash = signature_hash_binding(sig, keyref.key, subkey.subkey);
             pkey->validate_sig(sinfo, *hash, global_ctx);
             assert_true(sinfo.valid);
+            hash = signature_hash_binding(sig, keyref.key, subkey.subkey, &cache);
+            pkey->validate_sig(sinfo, *hash, global_ctx);
+            assert_true(sinfo.valid);
         }
     }
 
@@ -1602,6 +1785,99 @@ TEST_F(rnp_tests, test_stream_dearmor_edge_cases)
     assert_true(try_dearmor(msg, len));
 }
 
+static std::vector<uint8_t>
+armor_buffer(const std::vector<uint8_t> &data, size_t llen, size_t chunk = 0)
+{
+    rnp::MemoryDest dst;
+    {
+        rnp::ArmoredDest armored(dst.dst(), PGP_ARMORED_MESSAGE);
+        if (armored_dst_set_line_length(&armored.dst(), llen)) {
+            return {};
+        }
+        /* writing by small chunks without caching goes via the scalar encoding code */
+        armored.dst().no_cache = chunk > 0;
+        for (size_t pos = 0; pos < data.size(); pos += chunk ? chunk : data.size()) {
+            size_t len = std::min(data.size() - pos, chunk ? chunk : data.size());
+            armored.write(data.data() + pos, len);
+        }
+        if (armored.werr()) {
+            return {};
+        }
+    }
+    return dst.to_vector();
+}
+
+static bool
+dearmor_buffer(const std::string &armored, std::vector<uint8_t> &data)
+{
+    rnp::MemorySource src(armored.data(), armored.size(), false);
+    rnp::MemoryDest   dst;
+    if (rnp_dearmor_source(&src.src(), &dst.dst())) {
+        return false;
+    }
+    data = dst.to_vector();
+    return true;
+}
+
+TEST_F(rnp_tests, test_stream_dearmor_line_lengths)
+{
+    /* base64 decoding is vectorized, so check different lengths and line/vector alignments */
+    std::vector<uint8_t> data(10000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (uint8_t)(i * 7 + (i >> 8));
+    }
+    for (size_t len : {1, 2, 3, 47, 48, 100, 1000, 4095, 10000}) {
+        std::vector<uint8_t> src(data.begin(), data.begin() + len);
+        for (size_t llen : {16, 17, 63, 64, 76}) {
+            auto armored = armor_buffer(src, llen);
+            assert_false(armored.empty());
+            std::string          msg(armored.begin(), armored.end());
+            std::vector<uint8_t> dec;
+            assert_true(dearmor_buffer(msg, dec));
+            assert_true(dec == src);
+            /* \r\n line endings */
+            std::string crlf;
+            for (auto ch : msg) {
+                crlf += ch == '\n' ? std::string("\r\n") : std::string(1, ch);
+            }
+            assert_true(dearmor_buffer(crlf, dec));
+            assert_true(dec == src);
+            if (len < 100) {
+                continue;
+            }
+            /* invalid character in the middle of the base64 data */
+            size_t pos = msg.find("\n\n") + 2 + len / 2;
+            for (char ch : {'?', '\x80', '\0', '-'}) {
+                std::string bad = msg;
+                bad[pos] = ch;
+                assert_false(dearmor_buffer(bad, dec));
+            }
+        }
+    }
+}
+
+TEST_F(rnp_tests, test_stream_armor_line_lengths)
+{
+    /* vectorized base64 encoding must give exactly the same output */
+    std::vector<uint8_t> data(5000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (uint8_t)(i * 13 + (i >> 7));
+    }
+    for (size_t len : {1, 2, 3, 11, 12, 13, 28, 100, 1000, 5000}) {
+        std::vector<uint8_t> src(data.begin(), data.begin() + len);
+        for (size_t llen : {16, 17, 20, 63, 64, 76}) {
+            auto armored = armor_buffer(src, llen);
+            assert_false(armored.empty());
+            assert_true(armored == armor_buffer(src, llen, 1));
+            assert_true(armored == armor_buffer(src, llen, 7));
+            std::string          msg(armored.begin(), armored.end());
+            std::vector<uint8_t> dec;
+            assert_true(dearmor_buffer(msg, dec));
+            assert_true(dec == src);
+        }
+    }
+}
+
 static void
 add_openpgp_layers(
   const char *msg, pgp_dest_t &pgpdst, int compr, int encr, rnp::SecurityContext &global_ctx)
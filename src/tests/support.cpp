@@ -398,8 +398,9 @@ test_ffi_init(rnp_ffi_t *ffi)
 bool
 mpi_empty(const pgp::mpi &val)
 {
-    pgp::mpi zero{};
-    return (val.len == 0) && !memcmp(val.mpi, zero.mpi, PGP_MPINT_SIZE);
+    /* empty mpi uses inline storage, which must be cleared as well */
+    uint8_t zero[pgp::mpi::INLINE_SIZE] = {0};
+    return !val.bytes() && !memcmp(val.data(), zero, sizeof(zero));
 }
 
 bool